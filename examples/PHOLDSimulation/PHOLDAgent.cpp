@@ -106,6 +106,45 @@ PHOLDAgent::setLocalAgentRange(const muse::AgentID min, const muse::AgentID max,
     }
 }
 
+bool
+PHOLDAgent::serialize(std::ostream& os) const {
+    const PholdState* const state =
+        dynamic_cast<const PholdState*>(getState());
+    ASSERT(state != NULL);
+    os << X << ' ' << Y << ' ' << N << ' ' << delay << ' ' << delayType
+       << ' ' << lookAhead << ' ' << selfEvents << ' ' << granularity
+       << ' ' << receiverRange << ' ' << receiverDistType << ' '
+       << extraEventSize << ' ' << seed << ' ' << localAgentRange.first
+       << ' ' << localAgentRange.second << ' ' << remoteEvents << ' '
+       << state->getIndex() << ' ' << rng;
+    return true;
+}
+
+PHOLDAgent*
+PHOLDAgent::deserialize(muse::AgentID id, std::istream& is) {
+    int x, y, n, d, type, lookAhead, recvrRange, recvrType, extraEventSize;
+    int minID, maxID, index;
+    double selfEvents, remoteEvts;
+    size_t granularity;
+    unsigned int seed;
+    is >> x >> y >> n >> d >> type >> lookAhead >> selfEvents
+       >> granularity >> recvrRange >> recvrType >> extraEventSize >> seed
+       >> minID >> maxID >> remoteEvts >> index;
+    PholdState* state = new PholdState();
+    state->setIndex(index);
+    PHOLDAgent* agent = new PHOLDAgent(id, state, x, y, n, d, lookAhead,
+                                       selfEvents, granularity,
+                                       DelayType(type), recvrRange,
+                                       DelayType(recvrType), extraEventSize);
+    agent->setLocalAgentRange(minID, maxID, remoteEvts);
+    // Restore values that may differ from those set by constructors
+    agent->receiverRange = recvrRange;
+    agent->seed          = seed;
+    // The extraction operator for engines does not skip whitespace.
+    is >> std::ws >> agent->rng;
+    return agent;
+}
+
 int
 PHOLDAgent::getDelay(const DelayType delType, const int genParam) {
     switch (delType) {
@@ -116,6 +116,35 @@ public:
     void setLocalAgentRange(const muse::AgentID min, const muse::AgentID max,
                             const double remoteEvtFrac = 0.0);
 
+    /** Write the information needed to recreate this agent on another
+        process.
+
+        This method is called by the kernel to migrate this agent to
+        another process.  The information is written as text and is
+        read back by the deserialize method.
+
+        \param[out] os The output stream to which the information is
+        to be written.
+
+        \return This method always returns true.
+    */
+    bool serialize(std::ostream& os) const override;
+
+    /** Recreate an agent migrated from another process.
+
+        This method is registered as the agent factory (via
+        muse::Simulation::setAgentFactory) in
+        PHOLDSimulation::createAgents.
+
+        \param[in] id The ID of the agent being recreated.
+
+        \param[in] is The input stream from where the information
+        written by the serialize method is to be read.
+
+        \return The newly created agent.
+    */
+    static PHOLDAgent* deserialize(muse::AgentID id, std::istream& is);
+
 protected:
     /** Simulate some granularity (i.e., CPU usage) for the event.
 
@@ -58,6 +58,8 @@ PHOLDSimulation::PHOLDSimulation() {
     recvrDistrib   = "uniform";
     extraEventSize = 0;
     remoteEvents   = 0;
+    graphPartition = false;
+    consAgentGap   = 0;
 }
 
 PHOLDSimulation::~PHOLDSimulation() {}
@@ -98,6 +100,10 @@ PHOLDSimulation::processArgs(int argc, char** argv) {
          &extraEventSize, ArgParser::INTEGER},
         {"--remote-events", "%remote events when recvr-distrib is local_remote",
          &remoteEvents, ArgParser::DOUBLE},     
+        {"--graph-partition", "Have kernel partition agents to reduce remote "
+         "events", &graphPartition, ArgParser::BOOLEAN},
+        {"--cons-agent-gap", "Make every n-th agent conservative",
+         &consAgentGap, ArgParser::INTEGER},
         {"", "", NULL, ArgParser::INVALID}
     };
 
@@ -141,6 +147,17 @@ PHOLDSimulation::processArgs(int argc, char** argv) {
                   << "reverse_exponential.\n";
         return false;
     }    
+    if ((consAgentGap > 0) && (lookAhead < 1)) {
+        std::cerr << "Conservative agents (--cons-agent-gap) require a "
+                  << "positive --lookahead.\n";
+        return false;
+    }
+    // Local/remote receivers require contiguous blocks of agents.
+    if (graphPartition && (delayType == PHOLDAgent::LOCAL_REMOTE)) {
+        std::cerr << "The local_remote recvr distribution cannot be used "
+                  << "with --graph-partition.\n";
+        return false;
+    }
     // Everything went well.
     return true;
 }
@@ -152,6 +169,10 @@ PHOLDSimulation::cumlSum(const int val, const double scale) const {
 
 void
 PHOLDSimulation::createAgents() {
+    if (graphPartition) {
+        createPartitionedAgents();
+        return;
+    }
     muse::Simulation* kernel = muse::Simulation::getSimulator();    
     const int max_agents     = rows * cols;
     const int max_nodes      = kernel->getNumberOfProcesses();
@@ -166,6 +187,13 @@ PHOLDSimulation::createAgents() {
     const int agentStartID   = (agentsPerNode * rank) + cumlSum(rank, factor);
     const int agentEndID     = (rank == max_nodes - 1) ? max_agents :
         ((agentsPerNode * (rank + 1)) + cumlSum(rank + 1, factor));
+    // Without imbalance, agents are partitioned in contiguous blocks.
+    // Declaring it enables kernel to skip exchanging agent lists.
+    if (skewAgents == 0) {
+        kernel->setAgentPartition(muse::BLOCK_PARTITION, max_agents);
+    }
+    // Enable kernel to recreate agents migrated from other processes.
+    kernel->setAgentFactory(PHOLDAgent::deserialize);
     // Converte distribution types from string to suitable enumeration.
     const PHOLDAgent::DelayType delayType =
         PHOLDAgent::toDelayType(delayDistrib);
@@ -182,6 +210,9 @@ PHOLDSimulation::createAgents() {
                                            lookAhead, selfEvents, granularity,
                                            delayType, receiverRange,
                                            recvrType, extraEventSize);
+        if ((consAgentGap > 0) && (i % consAgentGap == 0)) {
+            agent->setConservative(lookAhead);
+        }
         // Setup range of local agents based on per-thread values.
         const int thrEndAgent = (currThread == threadsPerNode - 1) ?
             agentEndID : (thrStartAgent + agentsPerThread);
@@ -204,6 +235,64 @@ PHOLDSimulation::createAgents() {
               << agentEndID      << " agents.\n";
 }
 
+void
+PHOLDSimulation::createPartitionedAgents() {
+    muse::Simulation* kernel = muse::Simulation::getSimulator();
+    const int max_agents     = rows * cols;
+    if (imbalance > 0) {
+        std::cout << "Warning: --imbalance is ignored with "
+                  << "--graph-partition.\n";
+    }
+    // Declare all the agents and the neighbors to which each agent
+    // sends events.  By default, events are sent to the 4 adjacent
+    // agents in the torus.  Otherwise events are sent to agents
+    // within receiverRange.
+    for (int i = 0; (i < max_agents); i++) {
+        kernel->declareAgent(i);
+    }
+    for (int i = 0; (i < max_agents); i++) {
+        if (receiverRange == 0) {
+            kernel->declareEdge(i, (i + 1) % max_agents);
+            kernel->declareEdge(i, (i + cols) % max_agents);
+        } else {
+            for (int dist = 1; (dist <= receiverRange / 2); dist++) {
+                kernel->declareEdge(i, (i + dist) % max_agents);
+            }
+        }
+    }
+    kernel->partitionAgents();
+    // Enable kernel to recreate agents migrated from other processes.
+    kernel->setAgentFactory(PHOLDAgent::deserialize);
+    // Create and register the agents assigned to this process.
+    const PHOLDAgent::DelayType delayType =
+        PHOLDAgent::toDelayType(delayDistrib);
+    const PHOLDAgent::DelayType recvrType =
+        PHOLDAgent::toDelayType(recvrDistrib);
+    int numAgents = 0;
+    for (int i = 0; (i < max_agents); i++) {
+        if (kernel->getAssignedRank(i) != rank) {
+            continue;  // Agent is on another process.
+        }
+        PholdState* state = new PholdState();
+        PHOLDAgent* agent = new PHOLDAgent(i, state, rows, cols, events, delay,
+                                           lookAhead, selfEvents, granularity,
+                                           delayType, receiverRange,
+                                           recvrType, extraEventSize);
+        if ((consAgentGap > 0) && (i % consAgentGap == 0)) {
+            agent->setConservative(lookAhead);
+        }
+        agent->setLocalAgentRange(i, i + 1, remoteEvents);
+        kernel->registerAgent(agent);
+        // Have the first agent print the delay histogram
+        if (delayHist && (numAgents == 0)) {
+            agent->printDelayDistrib(std::cout);
+        }
+        numAgents++;
+    }
+    std::cout << "Rank " << rank << ": Registered " << numAgents
+              << " agents.\n";
+}
+
 void
 PHOLDSimulation::simulate() {
     // Convenient local reference to simulation kernel
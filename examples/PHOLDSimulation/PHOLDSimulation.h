@@ -117,6 +117,17 @@ protected:
         kernel has already been initialized.
     */
     void createAgents();
+
+    /** Create agents partitioned by the simulation kernel.
+
+        This method is used by createAgents when the \c
+        --graph-partition command-line argument is specified.  It
+        declares all the agents and the neighbors to which each agent
+        sends events (based on receiverRange) to the simulation
+        kernel.  The agents assigned to this process by the kernel
+        are then created and registered.
+    */
+    void createPartitionedAgents();
     
     /**
        Convenience method to setup time duration for simulation and
@@ -273,6 +284,27 @@ private:
         local_remote.  The default value is 0.
     */
     double remoteEvents;
+
+    /** Flag to indicate if agents must be partitioned by the kernel
+        based on the communication between agents.
+
+        This command-line argument (\c --graph-partition) causes the
+        agents to be partitioned via
+        muse::Simulation::partitionAgents rather than in contiguous
+        blocks.  The default value is false.
+    */
+    bool graphPartition;
+
+    /** Interval between agents that are declared to be conservative.
+
+        This command-line argument (\c --cons-agent-gap) causes every
+        n-th agent (that is, agents whose ID is a multiple of this
+        value) to be declared conservative (see
+        muse::Agent::setConservative) with the lookahead set via \c
+        --lookahead.  The remaining agents are optimistic.  The
+        default value is 0 to indicate all agents are optimistic.
+    */
+    int consAgentGap;
 };
 
 #endif
@@ -27,6 +27,9 @@
 #include <exception>
 #include <deque>
 #include <cmath>
+#include <functional>
+#include <mutex>
+#include <utility>
 #include "DataTypes.h"
 #include "Event.h"
 #include "State.h"
@@ -39,6 +42,10 @@
 // Forward declaration for insertion operator for Event
 extern std::ostream& operator<<(std::ostream&, const muse::Agent&);
 
+// Forward declaration for the lock-free queue used by ThreeTierSkipMTQueue
+template <class K, class V, class Compare>
+class LockFreePQ;
+
 BEGIN_NAMESPACE(muse);
 
 // Forward declare here
@@ -48,10 +55,12 @@ class BinaryHeap;
 class EventQueue;
 class Tier2Entry;
 class HOETier2Entry;
+class HOETier2EntryMT;
 class EventComp;
 class TwoTierHeapAdapter;
 class Simulation;
 class OclSimulation;
+class HCCpuSimulation;
 
 /** \typedef std::deque<T> List<T>
 
@@ -85,7 +94,12 @@ class Agent {
     friend class TwoTierHeapEventQueue;
     friend class TwoTierHeapOfVectorsEventQueue;
     friend class ThreeTierHeapEventQueue;
+    friend class ThreeTierSkipMTQueue;
+    friend class MultiThreadedScheduler;
+    friend class MultiThreadedSimulationManager;
+    friend class AgentMigrator;
     friend class OclSimulation;
+    friend class HCCpuSimulation;
 public:    
     /** enum for return Time.
         when agent ask for time via getTime()
@@ -167,6 +181,31 @@ public:
         not really used.
     */
     virtual void runHCkernel(const int kernelID = 0) { hcKernel = kernelID; }
+
+    /** Method for derived classes to enable migration of this agent
+        to another process.
+
+        Agents are migrated between processes (to balance load) only
+        if the \c --migrate-interval command-line argument is used.
+        Prior to migration, the kernel rolls back the agent to GVT
+        and then calls this method to obtain the information needed
+        to recreate the agent, including its current state (see
+        getState), on another process.  The agent is recreated on the
+        destination process via the factory registered through
+        Simulation::setAgentFactory.  The kernel moves the agent's
+        LVT, pending events, and statistics.
+
+        \param[out] os The output stream to which the information
+        needed to recreate this agent is to be written.
+
+        \return This method must return true if the agent was
+        serialized.  The base class method returns false indicating
+        that the agent cannot be migrated.
+    */
+    virtual bool serialize(std::ostream& os) const {
+        UNUSED_PARAM(os);
+        return false;
+    }
     
     //------------Provided by muse----below-----------------//
     
@@ -289,6 +328,41 @@ public:
     */
     inline State* getState() const { return myState; }
 
+    /** Declare this agent to be a conservative agent.
+
+        A conservative agent is never rolled back and never saves
+        state, even when the remaining agents in the simulation are
+        processed optimistically.  The scheduler processes the events
+        of a conservative agent only when they are safe -- that is,
+        their receive time is below lookahead + the minimum of GVT
+        and the sent time of events still in transit (see
+        GVTManagerBase::getSendTimeBound).  Stragglers or
+        anti-messages can no longer arrive below this time.  Other
+        agents continue to be processed optimistically while the
+        events of a conservative agent are held back.  This reduces
+        rollback and state saving overheads for agents (such as
+        infrastructure nodes) that receive events with a large,
+        stable delay.
+
+        \note This method must be called prior to registering the
+        agent with the simulation kernel (typically from the
+        constructor of the derived class).
+
+        \param[in] lookahead The minimum difference between the
+        receive and sent times of events received by this agent
+        (except events sent when agents are initialized).  This value
+        must be positive.  The simulation aborts if an event violates
+        this lookahead.
+    */
+    void setConservative(const Time lookahead);
+
+    /** Determine if this agent is a conservative agent.
+
+        \return True if this agent has been declared to be a
+        conservative agent via setConservative.
+    */
+    inline bool isConservative() const { return (lookahead > 0); }
+
 protected:
     /** The oSimStream type oss.
         
@@ -641,6 +715,25 @@ private:
         \note This ought to be moved into schedRef union below.
     */
     std::deque<HOETier2Entry*>* tier2;
+
+    /** Reference used by ThreeTierSkipMTQueue (used by the mpi-mt-shm
+        kernel).  This lock-free list consists of tier-2 entries,
+        sorted on receive time, that are to be delivered to this
+        agent.
+    */
+    LockFreePQ<Time, HOETier2EntryMT*, std::less<Time> >* tier2MT;
+
+    /** The key, that is: <i>(time of next event, agent ID)</i>,
+        associated with this agent in the top-tier of
+        ThreeTierSkipMTQueue.  This value is changed only while
+        holding restructureMutex.
+    */
+    std::pair<Time, AgentID> mtKey;
+
+    /** Mutex used by ThreeTierSkipMTQueue to serialize changes to the
+        position (mtKey) of this agent in its top-tier.
+    */
+    std::mutex restructureMutex;
         
     union {
         /** The TwoTierHeapAdapter for TwoTierHeapEventQueue.
@@ -706,9 +799,29 @@ private:
         This flag is overridden by Simluation::registerAgent() class.
         It is set to false if only one MPI process is being used for
         simulation.  A user may force state saving using the
-        --must-save-state command-line parameter.
+        --must-save-state command-line parameter.  It is always false
+        for conservative agents (see setConservative).
     */
     bool mustSaveState;
+
+    /** The lookahead of events received by a conservative agent.
+
+        This value is zero for optimistic agents (the default).  It is
+        set via the setConservative method.
+    */
+    Time lookahead;
+
+    /** The rollback epoch of this agent.
+
+        This value is incremented at the end of each rollback and is
+        stamped on every event (and anti-message) sent by this agent.
+        It enables kernels that do not deliver events in FIFO order
+        to distinguish events canceled by an anti-message from events
+        resent after the rollback.
+
+        \see EventAdapter::isCanceledBy
+    */
+    unsigned int epoch;
     
     ////////////////////////////////////////////////////////
     
@@ -89,6 +89,19 @@ typedef std::vector<Agent*> AgentContainer;
 */
 typedef std::vector<SimStream*> SimStreamContainer;
 
+/** The AgentPartition type.
+
+    Models may use this enumeration to declare how agents are
+    distributed across processes (see Simulation::setAgentPartition).
+    With BLOCK_PARTITION, process <i>p</i> has a contiguous block of
+    (numAgents / numProcesses) agents starting at ID <i>p *
+    blockSize</i>, with the last process having any remaining agents.
+    With CYCLIC_PARTITION, agent <i>id</i> is on process <i>id %
+    numProcesses</i>.  ANY_PARTITION (the default) indicates an
+    arbitrary distribution.
+*/
+enum AgentPartition {ANY_PARTITION, BLOCK_PARTITION, CYCLIC_PARTITION};
+
 
 /** \def INFINITY
     
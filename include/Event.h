@@ -276,7 +276,7 @@ public:
     explicit inline Event(const AgentID  receiverID, const Time  receiveTime) :
         receiveTime(receiveTime), receiverAgentID(receiverID), 
         senderAgentID(-1), sentTime(TIME_INFINITY),  antiMessage(false),
-        referenceCount(1), color('*'), inputRefCount(0) {
+        referenceCount(1), color('*'), inputRefCount(0), epoch(0) {
         // Nothing else to be done in the constructor.
     }
 
@@ -442,6 +442,23 @@ private:
         used.
     */
     char inputRefCount;
+
+    /** \brief The rollback epoch of the sending agent when this event
+        (or anti-message) was sent.
+
+        Each agent increments its epoch after every rollback.  An
+        anti-message only cancels events from the same sender that
+        were sent on-or-after the anti-message's sent time <u>and</u>
+        in an epoch that is not later than the anti-message's epoch.
+        This enables kernels that do not deliver events in FIFO order
+        (such as the mpi-mt-shm kernel) to distinguish canceled events
+        from valid events resent after a rollback.  This value
+        occupies padding at the end of the event and does not change
+        the size of an event.
+
+        \see EventAdapter::isCanceledBy
+    */
+    unsigned int epoch;
 };
 
 END_NAMESPACE(muse);
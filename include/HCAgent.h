@@ -85,6 +85,7 @@ BEGIN_NAMESPACE(muse);
 class HCAgent : public muse::Agent {
     friend class muse::OclSimulation;
     friend class muse::Simulation;
+    friend class muse::HCCpuSimulation;
 public:
     /** The constructor.
 
@@ -297,6 +298,55 @@ protected:
     */
     virtual void executeHCkernel() {}
 
+    /** Convenience method to run the HC kernel on the CPU for a batch
+        of agents of the same type as this agent.
+
+        This method is used by HCCpuSimulation to run the kernels of
+        all agents scheduled at the same LVT in one shot.  The
+        parameters and states of the agents are packed one after
+        another (in the same layout used for OpenCL devices) via the
+        copyToDevice methods.
+
+        \note Typically, this method is automatically generated using
+        HC_KERNEL macro in muse, which runs the kernels using a
+        parallel SIMD loop (see HC_PARALLEL_LOOP).
+
+        \param[in] count The number of agents in the batch.
+
+        \param[in] agentIDs The IDs of the agents in the batch.
+
+        \param[in] params The packed parameters of the agents.
+
+        \param[in,out] states The packed states of the agents.  The
+        kernels update the states in this buffer.
+
+        \param[in,out] rndInfo The random number generators to be
+        used.  The i-th agent uses the i-th generator.
+
+        \param[in] lvt The LVT at which the kernels are run.
+
+        \param[in] gvt The current GVT of the simulation.
+
+        \return This method returns true if the kernels were run.
+        The default implementation returns false, in which case the
+        executeHCkernel method is called for each agent.
+    */
+    virtual bool executeHCkernels(const int count,
+                                  const muse::AgentID* agentIDs,
+                                  const void* params, void* states,
+                                  struct MTrand_Info* rndInfo,
+                                  const muse::Time lvt,
+                                  const muse::Time gvt) {
+        UNUSED_PARAM(count);
+        UNUSED_PARAM(agentIDs);
+        UNUSED_PARAM(params);
+        UNUSED_PARAM(states);
+        UNUSED_PARAM(rndInfo);
+        UNUSED_PARAM(lvt);
+        UNUSED_PARAM(gvt);
+        return false;
+    }
+
     /** The shared random number generator interface.  This pointer is
         initialized with a shared random number generator data.  This
         structure is used on the CPU only (as fallback when OpenCL is
@@ -32,6 +32,21 @@
 // Forward declaration for random number generation
 struct MTrand_Info;
 
+/** \def HC_PARALLEL_LOOP
+
+    \brief Marks the loop that runs HC kernels for a batch of agents
+    on the CPU (see HC_KERNEL) as an OpenMP parallel SIMD loop.
+
+    The loop is run using multiple threads and SIMD lanes when MUSE
+    and the model are compiled with OpenMP.  Otherwise this macro is
+    empty and the loop runs serially.
+*/
+#ifdef _OPENMP
+#define HC_PARALLEL_LOOP _Pragma("omp parallel for simd schedule(static)")
+#else
+#define HC_PARALLEL_LOOP
+#endif
+
 /** \def HC_STATE(x)
     
     \brief A convenience macro for generating subset of state
@@ -249,6 +264,15 @@ struct MTrand_Info;
     /* This is glue method to call the HC kernel directly */   \
     /* when OpenCL is not being used */                        \
     void executeHCkernel() override;                           \
+                                                               \
+    /* Glue method to run HC kernel for a batch of agents */   \
+    bool executeHCkernels(const int count,                     \
+                          const muse::AgentID* agentIDs,       \
+                          const void* params, void* states,    \
+                          struct MTrand_Info* rndInfo,         \
+                          const muse::Time lvt,                \
+                          const muse::Time gvt) override;      \
+                                                               \
     /* Return kernel body for use on GPU */                    \
     std::string getHCkernelDefinition() override;
 
@@ -308,6 +332,26 @@ struct MTrand_Info;
                  getTime(), getTime(GVT));                              \
     }                                                                   \
                                                                         \
+    /* This is glue method to run the HC kernel for a batch of */       \
+    /* agents on the CPU (used by --simulator hc-cpu) */                \
+    bool AgentClass::executeHCkernels(const int count,                  \
+                                      const muse::AgentID* agentIDs,    \
+                                      const void* params, void* states, \
+                                      struct MTrand_Info* rndInfo,      \
+                                      const muse::Time lvt,             \
+                                      const muse::Time gvt) {           \
+        const struct AgentClass::hc* hc_params =                        \
+            static_cast<const struct AgentClass::hc*>(params);          \
+        struct StateClass::hc* hc_states =                              \
+            static_cast<struct StateClass::hc*>(states);                \
+        HC_PARALLEL_LOOP                                                \
+        for (int i = 0; i < count; i++) {                               \
+            hcKernel(agentIDs[i], hc_params + i, hc_states + i,         \
+                     rndInfo + i, lvt, gvt);                            \
+        }                                                               \
+        return true;                                                    \
+    }                                                                   \
+                                                                        \
     /* Return kernel body for use on GPU */                             \
     std::string AgentClass::getHCkernelDefinition()  {                  \
         return                                                          \
@@ -705,6 +705,279 @@ bool MPI_IPROBE(int src, int tag, MPI_STATUS status);
 int MPI_SEND(const void* data, int count, int type, int rank, int tag);
 #endif
 
+/** \def MPI_REQUEST
+
+    \brief A simple, convenience macro to conditionally define
+    MPI_Request data structure.
+
+    <p>This macro provides a convenient mechanism to work with
+    MPI_Request handles used by non-blocking operations.  If MPI is
+    available, then it defaults to MPI_Request.  On the other hand, if
+    MPI is disabled then this macro provides a suitable definition
+    (along with a dummy MPI_REQUEST_NULL) so that the core code base
+    does not get cluttered with unnecessary logic.</p>
+
+    This macro can be used as shown below:
+
+    \code
+
+    #include "MPIHelper.h"
+
+    void someMethod() {
+        // ... some code goes here ..
+        MPI_REQUEST request = MPI_REQUEST_NULL;
+        MPI_ISEND(data, size, MPI_TYPE_CHAR, destRank, EVENT, request);
+        // ... more code goes here ..
+    }
+
+    \endcode
+*/
+#ifdef HAVE_LIBMPI
+#define MPI_REQUEST MPI_Request
+#else
+// We don't have MPI. So provide a suitable definition for MPI_Request
+#define MPI_REQUEST int
+#define MPI_REQUEST_NULL -1
+#endif
+
+/** \def MPI_ISEND
+
+    \brief Macro to map MPI_ISEND to MPI_Isend (if MPI is enabled) or
+    an empty method call if MPI is unavailable.
+
+    <p>This macro provides a convenient, conditionally defined macro
+    to refer to MPI_Isend method. If MPI is available, then MPI_ISEND
+    defaults to MPI_Isend.  On the other hand, if MPI is disabled then
+    this macro simply sets the request to MPI_REQUEST_NULL.</p>
+
+    This macro can be used as shown below:
+
+    \code
+
+    #include "MPIHelper.h"
+
+    int main(int argc, char *argv[]) {
+        // ... some code goes here ..
+        MPI_REQUEST request;
+        MPI_ISEND(&agentList[0], agentListSize, MPI_TYPE_UNSIGNED,
+                  ROOT_KERNEL, AGENT_LIST, request);
+        // ... more code goes here ..
+    }
+    \endcode
+*/
+#ifdef HAVE_LIBMPI
+#define MPI_ISEND(data, count, type, rank, tag, request)                \
+    MPI_Isend(data, count, type, rank, tag, MPI_COMM_WORLD, &request)
+#else
+// MPI is not available
+#define MPI_ISEND(data, count, type, rank, tag, request) \
+    (request = MPI_REQUEST_NULL)
+#endif
+
+/** \def MPI_TESTSOME
+
+    \brief Macro to map MPI_TESTSOME to MPI_Testsome (if MPI is
+    enabled) or an empty method call if MPI is unavailable.
+
+    <p>This macro provides a convenient, conditionally defined macro
+    to refer to MPI_Testsome method. If MPI is available, then
+    MPI_TESTSOME defaults to MPI_Testsome (ignoring statuses).  On the
+    other hand, if MPI is disabled then this macro simply sets
+    outCount to zero.</p>
+
+    \note If all the requests are MPI_REQUEST_NULL then MPI sets
+    outCount to MPI_UNDEFINED.  Hence, callers should only check for
+    outCount > 0.
+    
+    This macro can be used as shown below:
+
+    \code
+
+    #include "MPIHelper.h"
+
+    int main(int argc, char *argv[]) {
+        // ... some code goes here ..
+        int doneCount = 0;
+        MPI_TESTSOME(requests.size(), &requests[0], doneCount, &indexs[0]);
+        for (int i = 0; (i < doneCount); i++) {
+            // Reclaim buffer associated with requests[indexs[i]]
+        }
+        // ... more code goes here ..
+    }
+    \endcode
+*/
+#ifdef HAVE_LIBMPI
+#define MPI_TESTSOME(count, requests, outCount, indexs)                  \
+    MPI_Testsome(count, requests, &outCount, indexs, MPI_STATUSES_IGNORE)
+#else
+// MPI is not available
+#define MPI_TESTSOME(count, requests, outCount, indexs) (outCount = 0)
+#endif
+
+/** \def MPI_WAITSOME
+
+    \brief Macro to map MPI_WAITSOME to MPI_Waitsome (if MPI is
+    enabled) or an empty method call if MPI is unavailable.
+
+    <p>This macro is the blocking counterpart of MPI_TESTSOME.  If MPI
+    is available, then MPI_WAITSOME defaults to MPI_Waitsome (ignoring
+    statuses).  On the other hand, if MPI is disabled then this macro
+    simply sets outCount to zero.</p>
+
+    This macro can be used as shown below:
+
+    \code
+
+    #include "MPIHelper.h"
+
+    int main(int argc, char *argv[]) {
+        // ... some code goes here ..
+        int doneCount = 0;
+        MPI_WAITSOME(requests.size(), &requests[0], doneCount, &indexs[0]);
+        // ... more code goes here ..
+    }
+    \endcode
+*/
+#ifdef HAVE_LIBMPI
+#define MPI_WAITSOME(count, requests, outCount, indexs)                  \
+    MPI_Waitsome(count, requests, &outCount, indexs, MPI_STATUSES_IGNORE)
+#else
+// MPI is not available
+#define MPI_WAITSOME(count, requests, outCount, indexs) (outCount = 0)
+#endif
+
+/** \def MPI_IRECV
+
+    \brief Macro to map MPI_IRECV to MPI_Irecv (if MPI is enabled) or
+    an empty method call if MPI is unavailable.
+
+    <p>This macro provides a convenient, conditionally defined macro
+    to refer to MPI_Irecv method. If MPI is available, then MPI_IRECV
+    defaults to MPI_Irecv.  On the other hand, if MPI is disabled then
+    this macro simply sets the request to MPI_REQUEST_NULL.</p>
+
+    This macro can be used as shown below:
+
+    \code
+
+    #include "MPIHelper.h"
+
+    int main(int argc, char *argv[]) {
+        // ... some code goes here ..
+        MPI_REQUEST request;
+        MPI_IRECV(buffer, maxSize, MPI_TYPE_CHAR, MPI_ANY_SOURCE, EVENT,
+                  request);
+        // ... more code goes here ..
+    }
+    \endcode
+*/
+#ifdef HAVE_LIBMPI
+#define MPI_IRECV(data, count, type, rank, tag, request)                \
+    MPI_Irecv(data, count, type, rank, tag, MPI_COMM_WORLD, &request)
+#else
+// MPI is not available
+#define MPI_IRECV(data, count, type, rank, tag, request) \
+    (request = MPI_REQUEST_NULL)
+#endif
+
+/** \def MPI_TEST
+
+    \brief Macro to map MPI_TEST to MPI_Test (if MPI is enabled) or a
+    method that always returns false if MPI is unavailable.
+
+    <p>This macro provides a convenient, conditionally defined macro
+    to check if a non-blocking operation has completed.  It returns
+    true if the operation has completed, filling-in status.</p>
+
+    This macro can be used as shown below:
+
+    \code
+
+    #include "MPIHelper.h"
+
+    int main(int argc, char *argv[]) {
+        // ... some code goes here ..
+        MPI_STATUS status;
+        if (MPI_TEST(request, status)) {
+            const int size = MPI_GET_COUNT(status, MPI_TYPE_CHAR);
+        }
+        // ... more code goes here ..
+    }
+    \endcode
+*/
+#ifdef HAVE_LIBMPI
+inline bool MPI_TEST(MPI_REQUEST& request, MPI_STATUS& status) {
+    int flag = 0;
+    MPI_Test(&request, &flag, &status);
+    return (flag != 0);
+}
+#else
+// MPI is not available
+#define MPI_TEST(request, status) false
+#endif
+
+/** \def MPI_WAIT
+
+    \brief Macro to map MPI_WAIT to MPI_Wait (if MPI is enabled) or an
+    empty method call if MPI is unavailable.
+
+    <p>This macro provides a convenient, conditionally defined macro
+    to wait for a non-blocking operation to complete, filling-in
+    status.</p>
+
+    This macro can be used as shown below:
+
+    \code
+
+    #include "MPIHelper.h"
+
+    int main(int argc, char *argv[]) {
+        // ... some code goes here ..
+        MPI_STATUS status;
+        MPI_WAIT(request, status);
+        const int size = MPI_GET_COUNT(status, MPI_TYPE_CHAR);
+        // ... more code goes here ..
+    }
+    \endcode
+*/
+#ifdef HAVE_LIBMPI
+#define MPI_WAIT(request, status) MPI_Wait(&request, &status)
+#else
+// MPI is not available
+#define MPI_WAIT(request, status)
+#endif
+
+/** \def MPI_CANCEL
+
+    \brief Macro to map MPI_CANCEL to MPI_Cancel followed by MPI_Wait
+    (if MPI is enabled) or an empty method call if MPI is unavailable.
+
+    <p>This macro is used to cancel a pending non-blocking receive
+    and wait for the cancellation to complete (so that the buffer
+    associated with the request can be safely released).</p>
+
+    This macro can be used as shown below:
+
+    \code
+
+    #include "MPIHelper.h"
+
+    int main(int argc, char *argv[]) {
+        // ... some code goes here ..
+        MPI_CANCEL(request);
+        delete[] buffer;
+        // ... more code goes here ..
+    }
+    \endcode
+*/
+#ifdef HAVE_LIBMPI
+#define MPI_CANCEL(request) { MPI_Cancel(&request);                  \
+        MPI_Wait(&request, MPI_STATUS_IGNORE); }
+#else
+// MPI is not available
+#define MPI_CANCEL(request)
+#endif
+
 /** \def MPI_WTIME
 
     \brief Macro to map MPI_WTIME to MPI::Wtime (if MPI is enabled) or
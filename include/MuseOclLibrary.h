@@ -61,12 +61,22 @@ struct MTrand_Info {
     int seed;
 };
 
-// Prototype declarations for methods provided by this header
+// Prototype declarations for methods provided by this header. The
+// methods are compiled as C code (on the host) for use by HC kernels
+// run on the CPU.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void MTrand_init(struct MTrand_Info* rndGen, unsigned long seed);
 unsigned long MTrand_int32(struct MTrand_Info* rndGen);
 double MTrand_get(struct MTrand_Info* rndGen);
 int MTrand_poisson(struct MTrand_Info* rndGen, const double lambda);
 
+#ifdef __cplusplus
+}
+#endif
+
 
 #ifndef __OPENCL_VERSION__
 // Compiling on the host
@@ -24,7 +24,10 @@
 //
 //---------------------------------------------------------------------------
 
+#include <map>
 #include <set>
+#include <functional>
+#include <istream>
 #include "Agent.h"
 #include "Event.h"
 #include "State.h"
@@ -42,6 +45,21 @@ class Communicator;
 class SimulationListener;
 class OclScheduler;
 class SharedOutBuffer;
+class AgentMigrator;
+class AgentGraph;
+class IdleParker;
+
+/** Factory used to recreate agents migrated from another process.
+
+    The factory is called with the ID of the agent and a stream from
+    which the information written by the agent's Agent::serialize
+    method on the source process can be read.  The factory must
+    return a newly created agent (with the given ID) whose state is
+    restored from the stream.
+
+    \see Simulation::setAgentFactory
+*/
+typedef std::function<Agent*(const AgentID, std::istream&)> AgentFactory;
 
 /** The Simulation Class.
  
@@ -79,6 +97,7 @@ class Simulation {
     friend class Scheduler;
     friend class OclSimulation;
     friend class SharedOutBuffer;
+    friend class AgentMigrator;
 public:
     /** \brief Complete initialization of the Simulation
 
@@ -158,6 +177,19 @@ public:
         simulation).
     */    
     virtual unsigned int getNumberOfThreads() const { return 1; }
+
+    /** \brief Get the memory domain of each thread on this process
+
+        This method is used by partitionAgents to place heavily
+        communicating agents on threads in the same memory domain
+        (NUMA node or L3 cache).  By default this method returns an
+        empty list, indicating that domains are not used.
+
+        \return The domain of each thread on this process.
+    */
+    virtual std::vector<int> getThreadDomains() const {
+        return std::vector<int>();
+    }
     
     /** \brief Register the given Agent to the Simulation
 
@@ -190,6 +222,141 @@ public:
     */
     virtual bool registerAgent(Agent* agent, const int threadRank = -1);
 
+    /** \brief Declare how agents are partitioned across processes.
+
+        Models that distribute agents in a regular manner (for
+        example, a contiguous block of agent IDs on each process) can
+        use this method to declare the partition.  In this case the
+        process on which an agent resides is computed from its ID
+        rather than exchanging and storing lists of agents.  The
+        declaration is verified when agents are registered with all
+        processes and is ignored if the agents are inconsistent with
+        the partition.
+
+        \note This method must be called before the simulation is
+        started.
+
+        \param[in] kind The type of partition (see AgentPartition).
+
+        \param[in] numAgents The total number of agents in the
+        simulation.  Agent IDs must be in the range 0 to numAgents-1.
+    */
+    void setAgentPartition(const AgentPartition kind, const AgentID numAgents);
+
+    /** \brief Register a factory to recreate agents migrated to this
+        process.
+
+        Agents are migrated between processes (to balance load) only
+        if the \c --migrate-interval command-line argument is
+        specified.  In this case, the model must override
+        Agent::serialize and register a factory (on all processes)
+        that recreates an agent from the serialized information.
+
+        \note This method must be called before the simulation is
+        started.
+
+        \param[in] factory The factory to be used to recreate agents.
+    */
+    void setAgentFactory(AgentFactory factory) { agentFactory = factory; }
+
+    /** \brief Declare an agent to be partitioned by the kernel.
+
+        Rather than computing their own assignment of agents to
+        processes and threads, models can declare all the agents in
+        the simulation along with the expected communication between
+        them (see declareEdge) and have the kernel partition the
+        agents (see partitionAgents).  The partition minimizes the
+        volume of events exchanged between processes (and threads)
+        while balancing the cost of agents on each.
+
+        \note All the processes must declare the same agents and
+        edges in the same order.
+
+        \param[in] id The ID of the agent.
+
+        \param[in] cost The expected cost of processing the agent's
+        events relative to other agents.  This value must be positive.
+    */
+    void declareAgent(const AgentID id, const double cost = 1.0);
+
+    /** \brief Declare the expected communication between a pair of
+        agents to be partitioned by the kernel.
+
+        \param[in] src The ID of one of the agents.
+
+        \param[in] dest The ID of the other agent.
+
+        \param[in] weight The expected volume of events exchanged
+        between the agents (in both directions) relative to other
+        pairs of agents.  This value must be positive.
+    */
+    void declareEdge(const AgentID src, const AgentID dest,
+                     const double weight = 1.0);
+
+    /** \brief Declare the lookahead of events sent from one agent to
+        another.
+
+        The lookahead is the minimum difference between the receive
+        time of events sent by the source agent to the destination
+        agent and the time at which they are sent.  This information
+        is used only by the asynchronous conservative simulator (\c
+        --simulator cmb \c --cmb-async) to determine the channels
+        between processes and their lookahead.  If no links are
+        declared, then all processes are connected with the lookahead
+        set via \c --cmbLookahead.  Otherwise, events must be sent
+        only on declared links.
+
+        \note All the processes must declare the same links prior to
+        starting the simulation.
+
+        \param[in] src The ID of the agent sending events.
+
+        \param[in] dest The ID of the agent receiving events.
+
+        \param[in] lookahead The lookahead of events on the link.  This
+        value must be positive.
+    */
+    void declareLookahead(const AgentID src, const AgentID dest,
+                          const Time lookahead);
+
+    /** \brief Partition the agents declared via declareAgent.
+
+        This method must be called after all the agents and edges
+        have been declared and before agents are registered.  The
+        model must then create and register (via registerAgent) only
+        the agents assigned to this process (see getAssignedRank).
+        Agents registered without an explicit thread are registered
+        with the thread to which they have been assigned.
+
+        \param[in] imbalance The permitted imbalance, that is, the
+        cost of agents on any process (or thread) may exceed the
+        average by this fraction.
+    */
+    void partitionAgents(const double imbalance = 0.05);
+
+    /** \brief Obtain the process to which an agent has been assigned
+        by partitionAgents.
+
+        \param[in] id The ID of the agent.
+
+        \return The rank of the process to which the agent has been
+        assigned.  -1 if the agent was not declared or the agents
+        have not been partitioned.
+    */
+    int getAssignedRank(const AgentID id) const;
+
+    /** \brief Obtain the thread to which an agent has been assigned
+        by partitionAgents.
+
+        \param[in] id The ID of the agent.
+
+        \return The zero-based index of the thread (on the process
+        returned by getAssignedRank) to which the agent has been
+        assigned.  -1 if the agent was not declared or the agents
+        have not been partitioned.
+    */
+    int getAssignedThread(const AgentID id) const;
+
 
     /** \brief Get all Agents registered to the simulation
         
@@ -497,6 +664,18 @@ protected:
     */
     virtual void parseCommandLineArgs(int &argc, char* argv[]);
 
+    /** Create the communicator to be used by this simulation.
+
+        This is a convenience method that is used by derived classes
+        (that use one thread per process) to instantiate the
+        communicator based on the transport specified via the
+        --transport command-line argument.
+
+        \return A newly created communicator.  The caller is
+        responsible for initializing it.
+    */
+    static Communicator* createCommunicator();
+
     /** Refactored utility method to report aggregate statistics at
         the end of simulation.
 
@@ -631,6 +810,24 @@ protected:
     */
     virtual int processMpiMsgs();
 
+    /** Park this simulation's thread after it has been idle for a
+        while.
+
+        This method is invoked from the core simulation loop (only if
+        \c --idle-park-usec has been specified) once idleParker
+        reports that the thread has been idle for a number of
+        consecutive iterations.  Prior to parking, this method
+        requests a GVT estimation so that GVT continues to advance
+        while threads are idle.  The thread is not parked if MPI
+        messages arrive or GVT advances in the meantime.  Derived
+        classes override this method to also recheck for events from
+        other threads.
+
+        \return This method returns true if the thread was woken up
+        (or found work) before the park timed out.
+    */
+    virtual bool parkIdleThread();
+
     /** \brief Refactored method to process the next set of events (if
         any) associated with 1 agent.
 
@@ -834,6 +1031,36 @@ protected:
         classes via \c --use-shared-events flag. 
     */
     bool doShareEvents;
+
+    /** The factory used to recreate agents migrated to this process.
+        This value is set via call to setAgentFactory.
+    */
+    AgentFactory agentFactory;
+
+    /** The migrator used to move agents between processes.  This
+        pointer is NULL unless agent migration has been enabled via
+        the \c --migrate-interval command-line argument.
+    */
+    AgentMigrator* migrator;
+
+    /** The communication graph of agents declared by the model (via
+        declareAgent and declareEdge) to be partitioned by the
+        kernel.  This pointer is NULL unless agents are declared.
+    */
+    AgentGraph* agentGraph;
+
+    /** The lookahead of links between agents declared by the model
+        (via declareLookahead).  The key is the pair of source and
+        destination agent IDs.
+    */
+    std::map<std::pair<AgentID, AgentID>, Time> linkLookahead;
+
+    /** The spin-then-park policy used when this simulation's thread
+        has no events to process.  This pointer is NULL unless parking
+        has been enabled via the \c --idle-park-usec command-line
+        argument.
+    */
+    IdleParker* idleParker;
     
     // Debug-only logging purposes.
     DEBUG(std::ofstream*  logFile);
@@ -845,6 +1072,16 @@ protected:
      */
     static std::string simName;
 
+    /** The name of the transport used to exchange events between
+        processes.
+
+        Valid names are "mpi" (the default, two-sided MPI), "rma"
+        (MPI one-sided operations), and "shm" (shared memory between
+        local processes, without MPI).  This value is set via the
+        --transport command-line argument.
+     */
+    static std::string transportName;
+
     /// Keep track of if stats should be dumped this cycle
     bool doDumpStats;
 
@@ -38,6 +38,7 @@ BEGIN_NAMESPACE(muse);
 class State {
     friend class Agent;
     friend class OclAgent;
+    friend class AgentMigrator;
 public:
     /** \brief Default Constructor.
 
@@ -0,0 +1,212 @@
+#ifndef MUSE_AGENT_DIRECTORY_H
+#define MUSE_AGENT_DIRECTORY_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <cstdint>
+#include <vector>
+#include "DataTypes.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** A dense directory of agents used on the per-event path.
+
+    <p>Each event requires several look-ups based on agent IDs -- that
+    is, the scheduler needs the pointer to the receiving agent while
+    the communicator needs the rank (and thread) on which an agent
+    resides.  Rather than using a separate hash map for each look-up,
+    all of this information is stored together in one entry so that
+    all the values are obtained with a single probe.  The directory
+    holds entries only for local agents (and agents that have been
+    migrated) so that its size is proportional to the number of
+    agents on a process.  Owners of other agents are obtained from
+    AgentRangeMap.</p>
+
+    <p>Entries are stored in a flat array.  If agent IDs are compact
+    (which is the common case) the array is directly indexed by agent
+    ID (relative to the smallest ID).  Otherwise, the array is used as
+    an open-addressing (linear probing) hash table.  The layout is
+    chosen automatically as entries are added.</p>
+
+    \note Entries are added (via add) only during registration of
+    agents, prior to the start of simulation.  Pointers returned by
+    find are invalidated when new entries are added.  Once simulation
+    starts, the directory is only read and may be shared (without
+    locks) between multiple threads.
+*/
+class AgentDirectory {
+public:
+    /** The information associated with each agent. */
+    struct Entry {
+        /** The pointer to the agent. This value is NULL if the agent
+            is remote or it has not been added to a scheduler.
+        */
+        Agent* agent;
+
+        /** The ID of the agent.  InvalidAgentID for unused entries. */
+        AgentID id;
+
+        /** The owner of the agent, that is, the rank of the process
+            (or the global thread ID in multi-threaded simulations)
+            on which the agent resides.  This value is -1 until agents
+            have been registered with all processes.
+        */
+        int owner;
+
+        /** The zero-based index of the thread on this process that
+            manages the agent. This value is -1 for remote agents.
+        */
+        int thread;
+    };
+
+    /** \brief Default constructor.
+
+        Creates an empty directory.
+    */
+    AgentDirectory();
+
+    /** \brief Obtain the entry for an agent, adding a new entry if
+        necessary.
+
+        \note This method may relocate all the entries and must not be
+        used once simulation has started.
+
+        \param[in] id The ID of the agent.  This value must be
+        non-negative.
+
+        \return A reference to the entry for the agent.
+    */
+    Entry& add(const AgentID id);
+
+    /** \brief Remove all the entries in this directory. */
+    void clear();
+
+    /** Obtain the number of entries in this directory.
+
+        \return The number of agents in this directory.
+    */
+    size_t size() const { return count; }
+
+    /** Determine if the entries are directly indexed by agent ID.
+
+        \return True if a flat array is used.  False if the entries
+        are stored in a hash table.
+    */
+    bool isDense() const { return dense; }
+
+    /** \brief Find the entry for a given agent.
+
+        \param[in] id The ID of the agent whose entry is desired.
+
+        \return The entry for the agent.  NULL if the agent does not
+        have an entry in this directory.
+    */
+    inline Entry* find(const AgentID id) {
+        return const_cast<Entry*>(static_cast<const AgentDirectory*>
+                                  (this)->find(id));
+    }
+
+    /** \brief Find the entry for a given agent.
+
+        \param[in] id The ID of the agent whose entry is desired.
+
+        \return The entry for the agent.  NULL if the agent does not
+        have an entry in this directory.
+    */
+    inline const Entry* find(const AgentID id) const {
+        if (dense) {
+            const size_t idx = (size_t) ((int64_t) id - baseID);
+            return ((idx < entries.size()) && (entries[idx].id == id) &&
+                    (id != InvalidAgentID)) ? &entries[idx] : NULL;
+        }
+        if (id == InvalidAgentID) {
+            return NULL;  // Can match unused entries.
+        }
+        for (size_t idx = hash(id); true; idx = (idx + 1) & mask) {
+            if (entries[idx].id == id) {
+                return &entries[idx];
+            } else if (entries[idx].id == InvalidAgentID) {
+                return NULL;
+            }
+        }
+    }
+
+    /** \brief Invoke a function on each entry in this directory.
+
+        \param[in] func The function to be invoked.  It is passed a
+        const reference to each entry that is in use.
+    */
+    template<typename Func>
+    void forEach(Func func) const {
+        for (const Entry& entry : entries) {
+            if (entry.id != InvalidAgentID) {
+                func(entry);
+            }
+        }
+    }
+
+protected:
+    /** Compute the initial slot for an agent in the hash table
+        (Fibonacci hashing, using the upper bits of the product).
+    */
+    inline size_t hash(const AgentID id) const {
+        return ((uint32_t) id * 2654435769u) >> shift;
+    }
+
+    /** \brief Rebuild the entries to accommodate a given agent ID.
+
+        This method chooses between a directly indexed (dense) array
+        and a hash table based on the range of IDs and reinserts all
+        the entries.
+
+        \param[in] id The new ID to be accommodated.
+    */
+    void rebuild(const AgentID id);
+
+    /** Insert an existing entry into the hash table without checking
+        for duplicates or resizing.
+    */
+    Entry& insertHashed(const Entry& entry);
+
+private:
+    /** The flat array of entries. */
+    std::vector<Entry> entries;
+
+    /** Flag to indicate if entries are directly indexed by ID. */
+    bool dense;
+
+    /** The ID of the agent at index zero in dense mode. */
+    int64_t baseID;
+
+    /** The mask (capacity - 1) used in hash mode. */
+    size_t mask;
+
+    /** The shift (32 - log2(capacity)) used by the hash method. */
+    int shift;
+
+    /** The number of entries in use. */
+    size_t count;
+};
+
+END_NAMESPACE(muse);
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef MUSE_AGENT_GRAPH_H
+#define MUSE_AGENT_GRAPH_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "DataTypes.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** A communication graph of agents used to partition agents across
+    processes and threads.
+
+    <p>Models declare all the agents in the simulation (along with the
+    expected cost of processing each agent's events) and the expected
+    volume of events exchanged between pairs of agents as weighted
+    edges (see Simulation::declareAgent and Simulation::declareEdge).
+    The partition method then assigns each agent to a process and to
+    a thread on that process such that the total weight of edges
+    between processes (and then between threads) is minimized while
+    the cost of agents on each process (and thread) is balanced.</p>
+
+    <p>The partitioning is hierarchical.  Agents are first partitioned
+    across processes, as events between processes are the most
+    expensive.  Next, the agents on each process are partitioned
+    across its threads.  Each level uses greedy graph growing -- that
+    is, each part is grown from a seed agent by repeatedly adding the
+    agent with the heaviest edges into the part -- followed by a few
+    passes of boundary refinement that move agents to neighboring
+    parts if doing so reduces the cut without violating balance.</p>
+
+    \note The partition is computed independently on each process.
+    Hence, all the processes must declare the same agents and edges
+    in the same order so that they compute identical partitions.
+*/
+class AgentGraph {
+public:
+    /** \brief Default constructor.
+
+        Creates an empty graph.
+    */
+    AgentGraph();
+
+    /** Add an agent to the graph.
+
+        \param[in] id The ID of the agent.  Each agent must be added
+        only once.
+
+        \param[in] agentCost The expected cost of processing the
+        agent's events relative to other agents.  This value must be
+        positive.
+    */
+    void addAgent(const AgentID id, const double agentCost);
+
+    /** Add an edge between a pair of agents.
+
+        Edges are undirected -- that is, the weight is the expected
+        volume of events in both directions.  Repeated edges between
+        the same pair of agents are permitted and their weights are
+        added together.  Edges may be added before the agents.
+
+        \param[in] src The ID of one of the agents.
+
+        \param[in] dest The ID of the other agent.
+
+        \param[in] weight The relative volume of events exchanged
+        between the agents.  This value must be positive.
+    */
+    void addEdge(const AgentID src, const AgentID dest, const double weight);
+
+    /** Assign agents to processes and threads.
+
+        \param[in] numProcs The number of processes to which agents
+        are to be assigned.
+
+        \param[in] numThreads The number of threads on each process.
+
+        \param[in] imbalance The permitted imbalance, that is, the
+        cost of agents in any part may exceed the average by this
+        fraction.
+
+        \param[in] threadDomains The memory domain (NUMA node or L3
+        cache) of each thread on this process.  If the threads span
+        multiple domains (with the same number of threads in each),
+        then the agents on this process are first partitioned across
+        domains and then across the threads in each domain.  This
+        keeps heavily communicating agents within the same domain.
+        If this list is empty, agents are directly partitioned across
+        threads.
+    */
+    void partition(const int numProcs, const int numThreads,
+                   const double imbalance,
+                   const std::vector<int>& threadDomains = {});
+
+    /** Obtain the process to which an agent has been assigned.
+
+        \param[in] id The ID of the agent.
+
+        \return The rank of the process to which the agent has been
+        assigned.  -1 if the agent was not added or the graph has not
+        been partitioned.
+    */
+    int getRank(const AgentID id) const;
+
+    /** Obtain the thread to which an agent has been assigned.
+
+        \param[in] id The ID of the agent.
+
+        \return The zero-based index of the thread (on the process
+        given by getRank) to which the agent has been assigned.  -1 if
+        the agent was not added or the graph has not been partitioned.
+    */
+    int getThread(const AgentID id) const;
+
+    /** Determine if the agents have been partitioned.
+
+        \return True if the partition method has been called.
+    */
+    bool isPartitioned() const { return !rank.empty(); }
+
+    /** Print a brief summary of the quality of the partition.
+
+        \param[out] os The output stream to which the summary is to be
+        written.
+    */
+    void printSummary(std::ostream& os) const;
+
+protected:
+    /** Convert the declared edges to an adjacency list.
+
+        This method validates the edges, merges duplicate edges, and
+        drops self-edges.
+    */
+    void buildAdjacency();
+
+    /** Partition a subset of agents into a given number of parts.
+
+        \param[in] verts The indexes of the agents to be partitioned.
+
+        \param[in] numParts The number of parts.
+
+        \param[in] imbalance The permitted imbalance in cost of each
+        part.
+
+        \return The part assigned to each entry in verts.  Every part
+        has at least one agent if verts has at least numParts agents.
+    */
+    std::vector<int> kwayPartition(const std::vector<int>& verts,
+                                   const int numParts,
+                                   const double imbalance);
+
+    /** Assign agents to parts by greedy graph growing.
+
+        This is a helper method used by kwayPartition.  The local
+        vector must be setup for the agents in verts.
+
+        \param[in] verts The indexes of the agents to be partitioned.
+
+        \param[in] numParts The number of parts.
+
+        \param[out] part The part for each entry in verts.
+    */
+    void growParts(const std::vector<int>& verts, const int numParts,
+                   std::vector<int>& part) const;
+
+    /** Improve a partition by moving agents on the boundary.
+
+        This is a helper method used by kwayPartition.  The local
+        vector must be setup for the agents in verts.
+
+        \param[in] verts The indexes of the agents being partitioned.
+
+        \param[in] numParts The number of parts.
+
+        \param[in] maxCost The maximum permitted cost of each part.
+
+        \param[in,out] part The part for each entry in verts.
+    */
+    void refineParts(const std::vector<int>& verts, const int numParts,
+                     const double maxCost, std::vector<int>& part) const;
+
+    /** Partition the agents on a process across its threads.
+
+        This is a helper method used by the partition method.
+
+        \param[in] verts The indexes of the agents on the process.
+
+        \param[in] domainThreads The indexes of the threads in each
+        memory domain.  Agents are first partitioned across domains
+        and then across threads in each domain.
+
+        \param[in] imbalance The permitted imbalance in cost of each
+        part.
+    */
+    void partitionThreads(const std::vector<int>& verts,
+                          const std::vector<std::vector<int>>& domainThreads,
+                          const double imbalance);
+
+private:
+    /** The index of each agent in the ids and cost vectors. */
+    std::unordered_map<AgentID, int> index;
+
+    /** The IDs of the agents in the order they were added. */
+    std::vector<AgentID> ids;
+
+    /** The cost of each agent (indexed by agent index). */
+    std::vector<double> cost;
+
+    /** The edges as declared by the model.  The edges are converted
+        to adjacency lists when the graph is partitioned.
+    */
+    std::vector<std::pair<std::pair<AgentID, AgentID>, double>> edges;
+
+    /** The neighbors and weight of edges to them for each agent. */
+    std::vector<std::vector<std::pair<int, double>>> adjacency;
+
+    /** The process assigned to each agent (indexed by agent index). */
+    std::vector<int> rank;
+
+    /** The thread assigned to each agent (indexed by agent index). */
+    std::vector<int> thread;
+
+    /** The position of each agent in the subset of agents being
+        partitioned by kwayPartition.  Entries are -1 for agents that
+        are not in the subset.  This vector is reused to avoid
+        reallocating it for each subset.
+    */
+    std::vector<int> local;
+};
+
+END_NAMESPACE(muse);
+
+#endif
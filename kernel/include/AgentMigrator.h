@@ -0,0 +1,367 @@
+#ifndef MUSE_AGENT_MIGRATOR_H
+#define MUSE_AGENT_MIGRATOR_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors:  Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <deque>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "DataTypes.h"
+#include "MigrationMessage.h"
+
+BEGIN_NAMESPACE(muse);
+
+// Forward declarations to keep compile-time dependencies low
+class Simulation;
+class Agent;
+
+/** Migrate agents between MPI processes to balance load.
+
+    This class is used by the default (single-threaded, optimistic)
+    simulator to move agents from the busiest process to the least
+    busy process at runtime.  Migration is enabled via the \c
+    --migrate-interval command-line argument and requires the model
+    to override Agent::serialize and register a factory via
+    Simulation::setAgentFactory.  The migration proceeds as follows:
+
+    <ol>
+
+    <li>Every \c --migrate-interval GVT updates, each process sends a
+    LOAD_REPORT to the root process with the number of events
+    committed and rollbacks since the previous report along with its
+    busiest agents that can be migrated.</li>
+
+    <li>Once reports from all processes have been received, the root
+    compares the commit rates of the busiest and least busy
+    processes.  If the imbalance exceeds \c --migrate-threshold, the
+    root chooses agents to be moved (ties are broken in favor of
+    processes with more rollbacks, which are running ahead) and
+    broadcasts the plan in a FREEZE message.</li>
+
+    <li>On receiving FREEZE, every process stops processing events.
+    The source process rolls back the agents to be moved to GVT so
+    that only their committed state and pending events need to be
+    moved.  The uncommitted history is regenerated at the destination
+    process.</li>
+
+    <li>The root then uses waves of PROBE/COUNTS messages to detect
+    that no events are in flight (all processes report identical
+    counts of events sent and received in two consecutive waves).  At
+    this point no anti-message can overtake its positive event, even
+    though the route to the agents has changed.</li>
+
+    <li>The root broadcasts GO.  Every process updates the owner of
+    the agents in the plan.  The source process serializes each
+    agent (its kernel bookkeeping, the model's data via
+    Agent::serialize, and its pending events) into an AGENT_STATE
+    message.  The destination process recreates the agent via the
+    factory and reports ADOPTED to the root.</li>
+
+    <li>Once all the agents have been adopted the root broadcasts
+    RESUME and all processes resume processing events.</li>
+
+    </ol>
+
+    All the messages are sent via the GVT manager to ensure GVT
+    estimates account for them.  Messages to the local process are
+    queued and handled from the main simulation loop.
+*/
+class AgentMigrator {
+public:
+    /** The constructor.
+
+        \param[in] sim The simulation kernel on whose agents this
+        migrator operates.
+
+        \param[in] interval The number of GVT updates between load
+        reports.  This value must be greater than zero.
+
+        \param[in] threshold The relative imbalance in committed
+        events between the busiest and least busy processes that
+        triggers migration.
+
+        \param[in] maxAgents The maximum number of agents to be
+        migrated in each round.
+    */
+    AgentMigrator(Simulation* sim, const int interval,
+                  const double threshold, const int maxAgents);
+
+    /** Check if migration can be used with the current setup.
+
+        This method must be called just before the simulation starts
+        (after agents have been registered).  It checks that a factory
+        has been registered and that the scheduler's queue supports
+        detaching agents.  If not, a warning is printed.
+
+        \return True if migration can be used.  Otherwise this method
+        returns false and the migrator must not be used.
+    */
+    bool start();
+
+    /** Method called from Simulation::garbageCollect each time GVT
+        is updated.
+
+        \param[in] gvt The updated GVT value.
+    */
+    void gvtUpdated(const Time& gvt);
+
+    /** Perform pending operations (if any) and report if events can
+        be processed.
+
+        This method is called from the main simulation loop.
+
+        \return True if agents are being migrated and events must not
+        be processed.
+    */
+    inline bool processPending() {
+        if (reportDue || !localMsgs.empty()) {
+            doPending();
+        }
+        return frozen;
+    }
+
+    /** Handle a migration message received from another process.
+
+        \param[in] msg The message to be handled.  The caller retains
+        ownership of the message.
+    */
+    void handleMessage(const MigrationMessage* msg);
+
+    /** Track an event sent to another process.  This method is called
+        from Simulation::scheduleEvent.
+    */
+    inline void eventSent() { numEventsSent++; }
+
+    /** Track an event received from another process.  This method is
+        called from Simulation::processMpiMsgs.
+    */
+    inline void eventReceived() { numEventsRecv++; }
+
+    /** Report statistics about agent migration.
+
+        \param[out] os The output stream to which the statistics are
+        to be written.
+    */
+    void reportStats(std::ostream& os) const;
+
+protected:
+    /** Send load report and handle messages queued for this process.
+        This is a helper method used by processPending.
+    */
+    void doPending();
+
+    /** Dispatch a migration message to the specified process.  If
+        the destination is this process, then the message is queued
+        in localMsgs.
+
+        \param[in] kind The kind of message to be sent.
+
+        \param[in] destRank The destination process.
+
+        \param[in] round The round or wave associated with the
+        message.
+
+        \param[in] payload The information to be included.
+
+        \param[in] recvTime The receive time for the message.
+    */
+    void send(const MigrationMessage::Kind kind, const int destRank,
+              const int round, const std::string& payload = "",
+              const Time recvTime = TIME_INFINITY);
+
+    /** Dispatch a message to all the processes (including this
+        process).
+
+        \param[in] kind The kind of message to be sent.
+
+        \param[in] round The round or wave associated with the
+        message.
+
+        \param[in] payload The information to be included.
+    */
+    void broadcast(const MigrationMessage::Kind kind, const int round,
+                   const std::string& payload = "");
+
+    /** Send a load report for this process to the root process. */
+    void sendLoadReport();
+
+    /** Record a load report at the root process and plan migration
+        once reports from all the processes have been received.
+
+        \param[in] msg The LOAD_REPORT message.
+    */
+    void recordLoadReport(const MigrationMessage* msg);
+
+    /** Stop processing events and roll back the outgoing agents.
+
+        \param[in] msg The FREEZE message with the migration plan.
+    */
+    void freeze(const MigrationMessage* msg);
+
+    /** Record counts from a process at the root and start the next
+        wave or broadcast GO when no events are in flight.
+
+        \param[in] msg The COUNTS message.
+    */
+    void recordCounts(const MigrationMessage* msg);
+
+    /** Update owners of agents and ship outgoing agents.  */
+    void migrateAgents();
+
+    /** Serialize an outgoing agent and send it to its destination.
+
+        \param[in] agent The local agent to be sent.
+
+        \param[in] destRank The process to which the agent is moved.
+    */
+    void sendAgent(Agent* agent, const int destRank);
+
+    /** Recreate an agent from an AGENT_STATE message.
+
+        \param[in] msg The AGENT_STATE message.
+    */
+    void adoptAgent(const MigrationMessage* msg);
+
+    /** Obtain a local agent given its ID.
+
+        \param[in] id The ID of the agent.
+
+        \return The local agent.  NULL if the agent is not local.
+    */
+    Agent* findAgent(const AgentID id) const;
+
+private:
+    /** Per-process information in a load report. */
+    struct LoadReport {
+        /// Number of events committed since the previous report.
+        long committed;
+        /// Number of rollbacks since the previous report.
+        long rollbacks;
+        /// Number of agents on the process.
+        int numAgents;
+        /// The busiest agents that can be migrated (ID, commits).
+        std::vector<std::pair<AgentID, long>> hotAgents;
+    };
+
+    /** An entry in the migration plan. */
+    struct Move {
+        AgentID agentID;   ///< The agent to be moved.
+        int srcRank;       ///< The process currently owning the agent.
+        int destRank;      ///< The process to which agent is moved.
+    };
+
+    /** The simulation kernel whose agents are migrated. */
+    Simulation* const sim;
+
+    /** The rank of this process. */
+    const int myRank;
+
+    /** The number of processes in the simulation. */
+    const int numProcs;
+
+    /** The number of GVT updates between load reports. */
+    const int interval;
+
+    /** Relative imbalance in commit rates that triggers migration. */
+    const double threshold;
+
+    /** Maximum number of agents to be moved in each round. */
+    const int maxAgents;
+
+    /** Number of GVT updates since the last load report. */
+    int gvtUpdates;
+
+    /** Flag set when a load report is to be sent. */
+    bool reportDue;
+
+    /** Sequence number of load reports sent by this process. */
+    int reportNum;
+
+    /** Flag set while agents are being migrated. */
+    bool frozen;
+
+    /** The current migration plan.  This plan is set when FREEZE is
+        received.
+    */
+    std::vector<Move> plan;
+
+    /** Messages sent to this process that are yet to be handled. */
+    std::deque<MigrationMessage*> localMsgs;
+
+    /** The committed events and rollbacks of each local agent at the
+        time of the previous load report.
+    */
+    std::unordered_map<AgentID, std::pair<int, int>> lastCounts;
+
+    /** Count of regular events sent to other processes. */
+    long numEventsSent;
+
+    /** Count of regular events received from other processes. */
+    long numEventsRecv;
+
+    // ------[ Instance variables used only on the root process ]-------
+
+    /** Load reports received for each round (indexed by process). */
+    std::unordered_map<int, std::vector<LoadReport>> reports;
+
+    /** Number of load reports received for each round. */
+    std::unordered_map<int, int> reportCount;
+
+    /** Flag set while the root is coordinating a migration. */
+    bool migrating;
+
+    /** The current wave of PROBE messages. */
+    int wave;
+
+    /** Number of COUNTS received in the current wave. */
+    int countsRecv;
+
+    /** Total events sent and received reported in current wave. */
+    std::pair<long, long> waveCounts;
+
+    /** Totals reported in the previous wave. */
+    std::pair<long, long> prevWaveCounts;
+
+    /** Number of ADOPTED messages received in the current round. */
+    size_t numAdopted;
+
+    // ------[ Statistics ]-------
+
+    /** Number of migration rounds this process participated in. */
+    int numRounds;
+
+    /** Number of agents sent to other processes. */
+    int agentsSent;
+
+    /** Number of agents received from other processes. */
+    int agentsRecv;
+
+    /** Number of pending events moved with the agents sent. */
+    long eventsSent;
+};
+
+END_NAMESPACE(muse);
+
+#endif
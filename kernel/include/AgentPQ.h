@@ -144,6 +144,34 @@ public:
     */
     void removeAgent(muse::Agent* agent) override;
 
+    /** Detach an agent along with its pending events.
+
+        This method implements the corresponding API method in the
+        base class.  The agent's node is removed from the Fibonacci
+        heap (and deleted) and its binary heap of events is emptied
+        into the supplied container without changing reference
+        counts.
+
+        \param[in,out] agent The agent to be detached.
+
+        \param[out] events The container to which pending events are
+        added.
+
+        \return This method always returns true.
+    */
+    bool detachAgent(muse::Agent* agent, muse::EventContainer& events) override;
+
+    /** Obtain the number of pending events for a given agent.
+
+        \param[in] agent The agent whose pending event count is
+        desired.
+
+        \return The number of events in the agent's binary heap.
+    */
+    size_t getEventCount(muse::Agent* agent) const override {
+        return agent->schedRef.eventPQ->size();
+    }
+
     /** Determine if the event queue is empty.
 
         This method implements the base class API to report if any
@@ -292,6 +320,7 @@ private:
     void increase(pointer, Agent*);
     void add_root(node* n);
     void cut(node* n);
+    void remove(pointer n);
     void find_min() const;
     mutable node* m_min;
 
@@ -0,0 +1,210 @@
+#ifndef MUSE_AGENT_RANGE_MAP_H
+#define MUSE_AGENT_RANGE_MAP_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <vector>
+#include "DataTypes.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** A compact map from agent IDs to their owners (process ranks or
+    global thread IDs).
+
+    <p>Models typically assign contiguous blocks of agent IDs to each
+    process (or thread).  Rather than storing one entry per agent,
+    this class stores ownership as a sorted list of ranges in the form
+    <i>[startID, endID) &rarr; owner</i> and uses binary search for
+    look-ups.  Lists of agent IDs are compressed into ranges (see
+    encode) before they are exchanged between processes so that the
+    registration cost is proportional to the number of ranges rather
+    than the number of agents.</p>
+
+    <p>If a model declares a block or cyclic partition (see
+    setPartition) then ownership is simply computed from the agent ID
+    and no ranges are needed.</p>
+*/
+class AgentRangeMap {
+public:
+    /** A contiguous range of agent IDs owned by a given owner. */
+    struct Range {
+        AgentID start;  ///< The first agent ID in the range
+        AgentID end;    ///< One past the last agent ID in the range
+        int owner;      ///< The owner of all agents in the range
+    };
+
+    /** \brief Default constructor.
+
+        Creates an empty map that uses ranges (ANY_PARTITION).
+    */
+    AgentRangeMap();
+
+    /** \brief Compress a list of agent IDs into ranges.
+
+        The ranges are appended to the output vector as a flat list of
+        triples, that is: <i>startID, count, owner</i>.  This format
+        is used to exchange ranges between processes.
+
+        \param[in] ids The list of agent IDs.  The IDs need not be
+        sorted.
+
+        \param[in] owner The owner to be associated with the IDs.
+
+        \param[out] ranges The vector to which triples are appended.
+    */
+    static void encode(std::vector<AgentID> ids, const int owner,
+                       std::vector<AgentID>& ranges);
+
+    /** \brief Add ranges (generated by encode) to this map.
+
+        \note The finalize method must be called after all ranges have
+        been added.
+
+        \param[in] ranges Pointer to the flat list of triples.
+
+        \param[in] count The number of values (not triples) in the
+        list.
+    */
+    void add(const AgentID* ranges, const size_t count);
+
+    /** \brief Sort and merge the ranges added to this map.
+
+        This method must be called after all ranges have been added.
+        Adjacent ranges with the same owner are merged.  If ranges
+        overlap (that is, an agent has been registered more than
+        once) then this method reports an error and aborts.
+    */
+    void finalize();
+
+    /** \brief Declare that agents are partitioned in a regular manner.
+
+        \param[in] kind The type of partition.  If this value is
+        ANY_PARTITION, then ranges are used for look-ups.
+
+        \param[in] numAgents The total number of agents in the
+        simulation.  Agent IDs must be in the range 0 to numAgents-1.
+
+        \param[in] numOwners The number of owners (processes) across
+        which the agents are partitioned.
+    */
+    void setPartition(const AgentPartition kind, const AgentID numAgents,
+                      const int numOwners);
+
+    /** Obtain the type of partition used by this map.
+
+        \return The type of partition set via setPartition.
+    */
+    AgentPartition getPartition() const { return partition; }
+
+    /** \brief Check if a list of IDs is exactly the set expected by
+        the declared partition for a given owner.
+
+        \param[in] ids The list of agent IDs on a given owner.
+
+        \param[in] owner The owner to be checked.
+
+        \return True if the IDs are unique, map to the owner, and
+        their count matches the number of agents expected on the
+        owner.
+    */
+    bool checkPartition(std::vector<AgentID> ids, const int owner) const;
+
+    /** \brief Remove all the ranges in this map.
+
+        The partition set via setPartition is retained.
+    */
+    void clear() { ranges.clear(); }
+
+    /** Obtain the number of ranges in this map.
+
+        \return The number of ranges (after merging).
+    */
+    size_t size() const { return ranges.size(); }
+
+    /** Obtain the sorted list of ranges in this map.
+
+        \return The list of ranges.  The list is empty if a block or
+        cyclic partition is being used.
+    */
+    const std::vector<Range>& getRanges() const { return ranges; }
+
+    /** \brief Obtain the owner of a given agent.
+
+        \param[in] id The ID of the agent whose owner is desired.
+
+        \return The owner of the agent.  If the agent ID is not valid,
+        this method returns -1.
+    */
+    inline int find(const AgentID id) const {
+        if (partition == BLOCK_PARTITION) {
+            return ((id < 0) || (id >= numAgents)) ? -1 :
+                std::min(id / blockSize, numOwners - 1);
+        } else if (partition == CYCLIC_PARTITION) {
+            return ((id < 0) || (id >= numAgents)) ? -1 : (id % numOwners);
+        }
+        // Find the first range that starts after the id
+        std::vector<Range>::const_iterator entry =
+            std::upper_bound(ranges.begin(), ranges.end(), id,
+                             [](const AgentID id, const Range& range) {
+                                 return id < range.start; });
+        if (entry == ranges.begin()) {
+            return -1;
+        }
+        --entry;  // The range that could contain id
+        return (id < entry->end) ? entry->owner : -1;
+    }
+
+protected:
+    /** Determine the number of agents that the declared partition
+        places on a given owner.
+
+        \param[in] owner The owner whose agent count is desired.
+
+        \return The number of agents expected on the owner.
+    */
+    AgentID getExpectedCount(const int owner) const;
+
+private:
+    /** The sorted list of ranges. */
+    std::vector<Range> ranges;
+
+    /** The type of partition declared via setPartition. */
+    AgentPartition partition;
+
+    /** The total number of agents (used only for block or cyclic
+        partitions).
+    */
+    AgentID numAgents;
+
+    /** The number of owners (used only for block or cyclic
+        partitions).
+    */
+    int numOwners;
+
+    /** The number of agents on each owner in a block partition. */
+    AgentID blockSize;
+};
+
+END_NAMESPACE(muse);
+
+#endif
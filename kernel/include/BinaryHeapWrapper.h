@@ -146,6 +146,17 @@ public:
         agent is logically removed from a scheduler queue.
     */
     void clear();
+
+    /** Move all events in this heap to a given container.
+
+        This method is used when an agent (along with its pending
+        events) is moved to a different scheduler queue.  Unlike
+        clear, the reference counts of the events are not changed.
+
+        \param[out] events The container to which the events are
+        appended.  After this call this heap is empty.
+    */
+    void moveTo(EventContainer& events);
     
     /** \brief Get the current size of the heap
 
@@ -23,19 +23,12 @@
 //
 //---------------------------------------------------------------------------
 
+#include <vector>
 #include "DataTypes.h"
 #include "MPIHelper.h"
 #include "HashMap.h"
-
-//these are the tag types
-#define AGENT_LIST        0
-#define EVENT             1
-#define GVT_MESSAGE       2
-#define GVT_ESTIMATE_TIME 3
-#define STRING_MESSAGE    4
-
-//these are the source types
-#define ROOT_KERNEL       0
+#include "Transport.h"
+#include "AgentDirectory.h"
 
 BEGIN_NAMESPACE(muse);
 
@@ -47,13 +40,17 @@ public:
     /** \brief Default Constructor.
 
         Initialize the Communicator without a GVTManager.
-        
+
+        \param[in] transport The transport to be used to exchange
+        messages with other processes.  The communicator takes
+        ownership of the transport. If this pointer is NULL, then a
+        MpiTransport is used.
     */
-    Communicator();
+    explicit Communicator(Transport* transport = NULL);
 
     /** \brief Destructor
 
-        Do nothing, since no memory is allocated.
+        Deletes the transport used by this communicator.
     */
     virtual ~Communicator();
 
@@ -87,6 +84,17 @@ public:
     */
     virtual void sendMessage(const GVTMessage *msg, const int destRank);
 
+    /** \brief Ship any outgoing events buffered by the transport.
+
+        This method is invoked by the simulation after it processes
+        events so that batched remote events are not delayed until the
+        next time messages are received (which may be deferred by the
+        polling policy).
+
+        \note This method is not MT-safe.
+    */
+    void flush();
+
     /** \brief Send out a string as a message with a given tag.
 
         This method muse be used to dispatch a generic string as a
@@ -209,6 +217,50 @@ public:
         \see AgentContainer
     */
     virtual void registerAgents(const std::vector<AgentID>& allAgents);
+
+    /** \brief Declare that agents are partitioned across processes
+        in a regular manner.
+
+        If a partition is declared, then registerAgents verifies that
+        the local agents on every process are consistent with the
+        partition.  If so, the owner of an agent is directly computed
+        from its ID and agent lists are not exchanged at all.
+        Otherwise, a warning is printed and the ranges of agents are
+        exchanged as usual.
+
+        \note This method must be called after initialize and before
+        registerAgents.
+
+        \param[in] kind The type of partition used by the model.
+
+        \param[in] numAgents The total number of agents in the
+        simulation.
+    */
+    virtual void setAgentPartition(const AgentPartition kind,
+                                   const AgentID numAgents);
+
+    /** Obtain the directory of agents on this process.
+
+        The directory is shared with the scheduler(s) on this process
+        (see Scheduler::setAgentDirectory).
+
+        \return The directory of agents used by this communicator.
+    */
+    AgentDirectory& getAgentDirectory() { return agentDir; }
+
+    /** \brief Change the process that owns a given agent.
+
+        This method is used by AgentMigrator to record the new owner
+        of an agent that is being migrated between processes.
+        Subsequent events to the agent are sent to the new owner.
+
+        \param[in] id The ID of the agent being migrated.
+
+        \param[in] rank The rank of the process that owns the agent.
+    */
+    void setAgentOwner(const AgentID id, const int rank) {
+        agentDir.add(id).owner = rank;
+    }
     
     /** \brief Check if the given agent is registered locally on the
 	same MPI process.
@@ -257,10 +309,10 @@ public:
         resides.  Otherwise this method returns -1.
     */
     virtual int getOwnerRank(const AgentID& id) const {
-        // Find iterator for given agent id
-        AgentIDSimulatorIDMap::const_iterator entry = agentMap.find(id);
-        // If id is valid then iterator is valid.
-        return (entry != agentMap.end()) ? (int) entry->second : -1;
+        // Remote agents are not in the directory. So use ownerMap.
+        const AgentDirectory::Entry* const entry = agentDir.find(id);
+        return ((entry != NULL) && (entry->owner != -1)) ? entry->owner :
+            ownerMap.find(id);
     }
     
     /** \brief Obtain the thread-based rank of the process on which a
@@ -330,6 +382,106 @@ public:
     */
     void setGVTManager(GVTManagerBase* gvtMgr);
     
+    /** \brief Consume any communicator-specific command-line
+        arguments.
+
+        This method is invoked from Simulation::parseCommandLineArgs
+        to permit derived classes to further configure the
+        communicator.  The base class method lets the transport
+        consume its arguments.
+
+	\param argc[in,out] The number of command line arguments.
+	This value is modifed if command-line arguments are consumed.
+
+	\param argv[in,out] The actual command line arguments.  This
+	list is modifed if command-line arguments are consumed.
+    */
+    virtual void parseCommandLineArgs(int& argc, char* argv[]);
+    
+    /** \brief Set the maximum number of in-flight non-blocking sends.
+
+        This method is typically called from
+        Simulation::parseCommandLineArgs based on the --mpi-send-pool
+        command-line argument. The base class passes the value to the
+        transport (see MpiTransport::setMaxPendingSends).
+
+        \note This method must be called before any events are sent.
+
+        \param[in] count The maximum number of in-flight sends.  If
+        this value is zero, then blocking sends are used.
+    */
+    virtual void setMaxPendingSends(const int count);
+
+    /** \brief Setup a ring of pre-posted receives for events.
+
+        This method is typically called from
+        Simulation::parseCommandLineArgs based on the --mpi-recv-ring
+        and --mpi-recv-size command-line arguments. The base class
+        passes the values to the transport (see
+        MpiTransport::setRecvRing).
+
+        \param[in] count The number of pre-posted receives.  If this
+        value is zero, then only probe-and-receive is used.
+
+        \param[in] maxEventSize The size of each buffer in the ring.
+    */
+    virtual void setRecvRing(const int count, const int maxEventSize);
+
+    /** \brief Wait until all processes have reached this call.
+
+        This method is used by the simulation kernels to synchronize
+        the processes (for example, at the end of simulation).
+    */
+    virtual void barrier();
+
+    /** \brief Compute the minimum of a value across all processes.
+
+        This is a collective operation that must be invoked by all
+        the processes.  This method is used by SimpleGVTManager to
+        compute GVT.
+
+        \param[in] value The local value to be used.
+
+        \return The global minimum of the values from all processes.
+    */
+    virtual Time allReduceMin(const Time value);
+
+    /** \brief Compute the sum of a value across all processes.
+
+        This is a collective operation that must be invoked by all
+        the processes.  This method is used by SimpleGVTManager to
+        detect events that are in transit between processes.
+
+        \param[in] value The local value to be used.
+
+        \return The global sum of the values from all processes.
+    */
+    virtual long allReduceSum(const long value);
+
+    /** \brief Compute the element-wise sum of a list of values across
+        all processes.
+
+        This is a collective operation that must be invoked by all
+        the processes.  This method is used by SimpleGVTManager to
+        compute windows of safe events (see
+        SimpleGVTManager::updateWindow).
+
+        \param[in,out] values The local values to be used.  On return,
+        each entry is the global sum of the corresponding entries.
+    */
+    virtual void allReduceSum(std::vector<Time>& values);
+
+    /** \brief Method to report aggregate statistics.
+
+        This method is invoked at the end of simulation to report
+        statistics about the communicator.  The base class reports
+        statistics from the transport.
+
+        \param[out] os The output stream to which the statistics are
+        to be written.
+    */
+    virtual void reportStats(std::ostream& os);
+    
     /** \brief Clean up after yourself
 
         \param[in] stopMPI If this flag is true, then MPI is finalized
@@ -340,17 +492,63 @@ public:
     virtual void finalize(bool stopMPI = true);
 
 protected:
+    /** \brief Handle a message that has been received.
+
+        This is an internal helper method that is used to process an
+        incoming event or GVT message based on its tag.
+
+        \param[in] data The flat buffer containing the message.
+
+        \param[in] size The size (in bytes) of the message.
+
+        \param[in] tag The tag associated with the message.
+
+        \param[in] srcRank The rank of the process that sent the
+        message.
+
+        \return If the message is an event then this method returns
+        the event.  Otherwise this method returns NULL.
+    */
+    Event* dispatchMessage(char* data, const int size, const int tag,
+                           const int srcRank);
+
+    /** \brief Check if local agents on all processes are consistent
+        with the partition declared via setAgentPartition.
+
+        This is a collective operation that must be invoked by all
+        the processes.
+
+        \param[in] allAgents The list of IDs of local agents.
+
+        \return True if agents on all the processes are consistent
+        with the declared partition.
+    */
+    bool checkAgentPartition(const std::vector<AgentID>& allAgents);
+    
     /** \brief The locations of all agents in the simulation.
-        
-	When simulation starts, all simulation kernels, will perform a
-	bcast and send all agents that they have. Using the agentID as
-	the key, the communicator will be able to know the simulator
-	kernel's ID.
-	
-	\see AgentID
-	\see SimulatorID
+
+	When simulation starts, all simulation kernels exchange the
+	ranges of agent IDs that they have.  Using the agentID as the
+	key, the communicator will be able to know the simulator
+	kernel's ID (or the global thread ID in multi-threaded
+	communicators).
+
+	\see AgentRangeMap
+    */
+    AgentRangeMap ownerMap;
+
+    /** \brief The directory of agents shared with the scheduler(s).
+
+        The scheduler adds entries (with pointers to local agents) as
+        agents are registered.  The communicator records the owner of
+        each local agent (and local thread that manages it) once agents
+        have been registered with all processes.  This enables the
+        per-event look-ups for local agents to be performed with just
+        one probe.  Remote agents do not have entries (except agents
+        that have been migrated) and their owners are looked up in
+        ownerMap.
     */
-    AgentIDSimulatorIDMap agentMap;
+    AgentDirectory agentDir;
 
     /** \brief Instance variable to hold reference to GVT manager.
 
@@ -369,6 +567,12 @@ protected:
         be expensive).
     */
     SimulatorID myMPIrank;
+
+    /** The transport used to exchange messages with other
+        processes.  The transport is set in the constructor and is
+        deleted in the destructor.
+    */
+    Transport* transport;
 };
 
 END_NAMESPACE(muse)
@@ -23,6 +23,8 @@
 //
 //---------------------------------------------------------------------------
 
+#include <string>
+#include <vector>
 #include "Simulation.h"
 
 BEGIN_NAMESPACE(muse);
@@ -41,7 +43,66 @@ protected:
   void preStartInit() override;
   bool processNextEvent() override;
   int processMpiMsgs() override;
+  void reportLocalStatistics(std::ostream& os) override;
+
+  /** Core simulation loop used with \c --cmb-yawns.
+
+      Each iteration of this loop computes GVT (via
+      SimpleGVTManager::updateWindow) with a single collective
+      operation, receives all events sent in the previous window, and
+      then processes all events in the window [GVT, GVT + lookAhead)
+      without any further synchronization.
+  */
+  void runWindows();
+
+  /** Core simulation loop used with \c --cmb-async.
+
+      This loop does not use any collective operations.  Instead, the
+      safe time is the minimum of the clocks of the input channels
+      maintained by NullMessageManager.  After each attempt to process
+      events, null messages are sent on the output channels as
+      permitted by the suppression policy (\c --cmb-nulls).
+  */
+  void runAsync();
+
+  /** Compute the lookahead of the channels to and from this process
+      based on links declared via declareLookahead.  If no links have
+      been declared, then all processes are connected with the
+      lookahead set via \c --cmbLookahead.
+
+      \param[out] outLA The lookahead of the channel to each process.
+
+      \param[out] inLA The lookahead of the channel from each process.
+  */
+  void computeChannels(std::vector<Time>& outLA, std::vector<Time>& inLA);
+
   double lookAhead;
+
+  /** Flag to indicate if window-based synchronization (YAWNS) is to
+      be used instead of updating GVT in each iteration.  This value
+      is set via the \c --cmb-yawns command-line argument.
+  */
+  bool useWindows = false;
+
+  /** The number of windows processed (used only with YAWNS). */
+  size_t numWindows = 0;
+
+  /** Flag to indicate if asynchronous null-message synchronization
+      is to be used.  This value is set via the \c --cmb-async
+      command-line argument.
+  */
+  bool useAsync = false;
+
+  /** The policy for suppressing null messages (lazy or demand) used
+      with \c --cmb-async.  This value is set via the \c --cmb-nulls
+      command-line argument.
+  */
+  std::string nullPolicy = "lazy";
+
+  /** Events with timestamps below this value can be safely processed.
+      This value is updated by each of the core simulation loops.
+  */
+  Time safeTime = 0;
 private:
   ConservativeSimulation();
   ~ConservativeSimulation();
@@ -42,7 +42,12 @@ class EventAdapter {
     friend class GVTManager;
     friend class Agent;
     friend class MultiThreadedSimulation;
-    friend class RedistributionMessage;
+    friend class MigrationMessage;
+    friend class AgentMigrator;
+    friend class Communicator;
+    friend class ThreeTierSkipMTQueue;
+    friend class MultiThreadedShmCommunicator;
+    friend class MultiThreadedScheduler;
 public:
 
     /** \brief Helper to get the size of this Event
@@ -194,6 +199,43 @@ protected:
         event->sentTime      = sentTime;
     }
     
+    /** \brief Set the rollback epoch associated with an event.
+
+        This value is typically set in the Agent::scheduleEvent and
+        Agent::sendAntiMessage methods.
+
+        \param[in,out] event The event whose epoch is to be set.
+
+        \param[in] epoch The current rollback epoch of the sending
+        agent.
+    */
+    static inline void setEpoch(muse::Event* const event,
+                                const unsigned int epoch) {
+        event->epoch = epoch;
+    }
+
+    /** \brief Determine if an event is canceled by an anti-message.
+
+        An event is canceled if it was sent by the same agent as the
+        anti-message, on-or-after the anti-message's sent time, and in
+        the same (or an earlier) rollback epoch.  Epochs are compared
+        using modular arithmetic so that wrap-around is handled.
+
+        \param[in] event The event to be checked.  This pointer cannot
+        be NULL.
+
+        \param[in] antiMsg The anti-message causing cancellations.
+        This pointer cannot be NULL.
+
+        \return True if the event is canceled by the anti-message.
+    */
+    static inline bool isCanceledBy(const muse::Event* const event,
+                                    const muse::Event* const antiMsg) {
+        return ((event->senderAgentID == antiMsg->senderAgentID) &&
+                (event->sentTime >= antiMsg->sentTime) &&
+                ((int) (event->epoch - antiMsg->epoch) <= 0));
+    }
+    
 private:
     /** The only constructor that is intentionally private and
         undefined to ensure that this class is never instantiated.
@@ -81,7 +81,50 @@ public:
         not be deleted by this method.
     */
     virtual void removeAgent(muse::Agent* agent) = 0;
-    
+
+    /** Detach an agent, along with its pending events, from this
+        event queue.
+
+        This method is used to move an agent to a different event
+        queue (for example, when agents are stolen by another thread).
+        Unlike removeAgent, the events are not discarded.  Instead
+        they are placed in the supplied container without changing
+        their reference counts, so that they can be added to another
+        event queue via addAgent and enqueue(agent, events).  The
+        default implementation does not support detaching agents.
+
+        \param[in,out] agent The agent to be detached.  The agent must
+        have been added to this event queue.
+
+        \param[out] events The container to which the pending events
+        of the agent are added.
+
+        \return This method returns true if the agent was detached.
+        If detaching agents is not supported by the event queue, this
+        method returns false and does not modify the queue.
+    */
+    virtual bool detachAgent(muse::Agent* agent, muse::EventContainer& events) {
+        UNUSED_PARAM(agent);
+        UNUSED_PARAM(events);
+        return false;
+    }
+
+    /** Obtain the number of pending events for a given agent.
+
+        This method is used to estimate the backlog of events on a
+        thread when balancing load.  The default implementation
+        returns zero.
+
+        \param[in] agent The agent whose pending event count is
+        desired.  The agent must have been added to this event queue.
+
+        \return The number of events pending for the agent.
+    */
+    virtual size_t getEventCount(muse::Agent* agent) const {
+        UNUSED_PARAM(agent);
+        return 0;
+    }
+
     /** Determine if the event queue is empty.
 
         This method must be implemented by the derived classes to
@@ -176,6 +176,42 @@ public:
     */
     virtual void enqueue(muse::Agent* agent, muse::EventContainer& events) = 0;
 
+    // Make the sender/sentTime version visible alongside the one below
+    using EventQueue::eraseAfter;
+
+    /** Dequeue all events canceled by a given anti-message.
+
+        This method is the multi-threaded counterpart of
+        EventQueue::eraseAfter.  It must be called only by the thread
+        that has popped the destination agent (via popNextAgent).
+
+        \param[in] dest The agent whose scheduled events are to be
+        checked and cleaned-up.  This pointer cannot be NULL.
+
+        \param[in] antiMsg The anti-message whose corresponding events
+        are to be removed.  This pointer cannot be NULL.
+
+        \return This method returns the number of events removed.
+    */
+    virtual int eraseAfter(muse::Agent* dest, const muse::Event* antiMsg) = 0;
+
+    /** Obtain the lowest timestamp of events in this queue.
+
+        This method is not thread safe and must be called only when no
+        other thread is operating on this queue.
+
+        \return The lowest receive time of events in this queue or
+        TIME_INFINITY if the queue is empty.
+    */
+    virtual muse::Time getNextEventTime() = 0;
+
+    /** Reclaim internal entries that were retired by threads.
+
+        This method is not thread safe and must be called only when no
+        other thread is operating on this queue.
+    */
+    virtual void recycleRetiredEntries() = 0;
+
     /** Print full contents of scheduler queue to given output stream.
 
         This is a convenience method that is used primarily for
@@ -22,23 +22,15 @@
 //
 //---------------------------------------------------------------------------
 
-#include <unordered_map>
-#include <stack>
+#include <atomic>
 #include "config.h"
 #include "Event.h"
-#include "NumaMemoryManager.h"
+#include "SlabAllocator.h"
 
 BEGIN_NAMESPACE(muse);
 
 // Forward declaration for some of the classes.
 class MultiThreadedCommunicator;
-/** An unordered map to store free events of different sizes.
-
-    The key into this unordered map is the size of the event being
-    recycled.  For each size a stack is maintained to return the
-    most recently used event to improve cache performance.
-*/
-using RecycleMap = std::unordered_map<int, std::stack<char*>>;
 
 /** A convenience class for enabling/disabling (at compile time) event
     recycling.
@@ -62,11 +54,15 @@ class EventRecycler {
     friend class Simulation;
     friend class ConservativeSimulation;
     friend class GVTMessage;
+    friend class MpiTransport;
     friend class MultiThreadedSimulation;
     friend class MultiThreadedSimulationManager;
+    friend class MultiThreadedCommunicator;
     friend class MultiThreadedShmSimulation;
     friend class MultiThreadedShmSimulationManager;
+    friend class MultiThreadedScheduler;
     friend class OclAgent;
+    friend class AgentMigrator;
 public:
     /** The default NUMA settings for memory management.
 
@@ -220,11 +216,10 @@ protected:
         returns it.</p>
 
         <p>On the other hand, if recycling of events is enabled (via
-        compiler flag RECYCLE_EVENTS), then this method operates as
-        follows.  First it checks to see if EventRecycler has an entry
-        of the specified size.  If so it returns it.  Otherwise it
-        creates a new flat array of characters (using new[] operator)
-        and returns it.</p>
+        compiler flag RECYCLE_EVENTS), then the memory is obtained
+        from the thread-local slab allocator.  The slab allocator
+        recycles a free chunk of the size class for the given size
+        or carves out a new chunk from a slab.</p>
 
         \param[in] size The size of the flat buffer to be allocated
         for storing event information.
@@ -256,15 +251,17 @@ protected:
         deletes the buffer using delete[] operator.</p>
 
         <p>On the other hand, if recycling of events is enabled (via
-        compiler flag RECYCLE_EVENTS), then this method adds the
-        buffer to the appropriate entry in the EventRecycler map in
-        this class.</p>
+        compiler flag RECYCLE_EVENTS), then this method returns the
+        buffer to the thread-local slab allocator.  If the buffer was
+        allocated by a different thread, it is (eventually) returned
+        to that thread.</p>
         
         \param[in] buffer The event buffer previously obtained via
         call to the allocate method in this class.
 
-        \param[in] size The size of the buffer (in bytes).  The size
-        is used to recycle the buffer in future calls to allocate.
+        \param[in] size The size of the buffer (in bytes).  This value
+        is not used when recycling is enabled as the slab allocator
+        records the size class of each buffer.
     */
     static void deallocateDefault(char* buffer, const int size);
 
@@ -366,19 +363,14 @@ protected:
         \note This method is thread safe and can be simultaneously
         called from multiple threads.
         
-        <p>If recycling of events is disabled, this method simply
-        deletes the buffer using delete[] operator.</p>
-
-        <p>On the other hand, if recycling of events is enabled (via
-        compiler flag RECYCLE_EVENTS), then this method adds the
-        buffer to the appropriate entry in the EventRecycler map in
-        this class.</p>
+        <p>The buffer is returned to the slab allocator on the thread
+        that allocated it, so that it is reused for the same NUMA
+        node.</p>
         
         \param[in] buffer The event buffer previously obtained via
         call to the allocate method in this class.
 
-        \param[in] size The size of the buffer (in bytes).  The size
-        is used to recycle the buffer in future calls to allocate.
+        \param[in] size The size of the buffer (in bytes).
     */
     static void deallocateNuma(char* buffer, const int size);
 
@@ -620,8 +612,10 @@ protected:
         until all agents are finalized (and they relinquish references
         to events in their internal queues).  Consequently, at the end
         of the MultiThreadedSimulation::simulate() method, each thread
-        (other than the main thread) adds its pending events to this
-        list.  This list is finally cleaned-up in the main thread.
+        (other than the main thread) adds its pending events
+        (including retired events that have not yet been reclaimed)
+        to this list.  This list is finally cleaned-up in the main
+        thread.
 
         \param[out] mainList The pending deallocation list on the main
         thread.
@@ -653,48 +647,135 @@ protected:
                           const std::vector<int>& numaIDofThread,
                           NumaSetting numa = EventRecycler::NUMA_NONE);
 
-    /** Per-thread method to start thread-local NUMA memory manager.
+    /** Per-thread method to start thread-local memory management.
 
         This method must be called at the beginning of each thread to
-        enable NUMA memory management for each thread.
+        setup the thread-local slab allocator used for events (with
+        or without NUMA-awareness).
 
         \note Unlike the setupNUMA method, this method must be called
         from each thread.
 
-        \param[in] blockSize The size of NUMA memory that should be
-        allocated whenever additional memory is needed.
+        \param[in] blockSize The size of slabs of memory that should
+        be allocated whenever additional memory is needed.  If this
+        value is zero, then the size set via the \c --event-arena-size
+        command-line argument is used.
     */
-    static void startNUMA(const int blockSize = 65536);
-    
-private:
-    /** An unordered map of stacks to recycle events of different
-        sizes.
+    static void startNUMA(const int blockSize = 0);
 
-        This map is used only if RECYCLE_EVENTS macro has been enabled
-        at compile time.  It has thread local storage so that each
-        thread (in case multi-threaded mode is used) get's its own
-        recycler thereby eliminating contention/locking.
-        
-        The key into this unordered map is the size of the event being
-        recycled.  For each size a stack is maintained to return the
-        most recently used event to improve cache performance.
+    /** Setup epoch-based reclamation of events shared between
+        threads.
+
+        This method is invoked from the initialize method of
+        multi-threaded simulation managers to setup the per-thread
+        epochs used to reclaim shared events.
 
-        This map is used by the allocate and deallocate methods in
-        this class.  Typically the Event::create method is the one
+        \note This method must be called only from the main thread,
+        before the threads start processing events.
+
+        \param[in] numThreads The number of threads on this process
+        that share events.
+    */
+    static void setupEpochs(const int numThreads);
+
+    /** Announce that this thread has reached the boundary of its
+        main simulation loop.
+
+        This method is called by each thread at the beginning of each
+        iteration of its main loop, at which point the thread does not
+        hold any transient references to events shared by other
+        threads.  If the global epoch has advanced since the last
+        call, this method records the new epoch for this thread and
+        reclaims events that this thread retired two epochs ago.
+
+        \return The fraction of events retired two epochs ago that
+        were reclaimed.  This method returns -1 if the epoch has not
+        advanced or no events were pending.
+    */
+    static double announceEpoch();
+
+    /** Advance the global epoch if all threads have announced it.
+
+        This method is called once per garbage collection cycle by
+        each thread.  It checks the epochs announced by all threads
+        and advances the global epoch only if all of them have
+        announced the current global epoch.
+    */
+    static void tryAdvanceEpoch();
+    
+private:
+    /** The slab allocator used to allocate and recycle memory for
+        events, with or without NUMA-awareness.
+
+        The allocator is used only if RECYCLE_EVENTS macro has been
+        enabled at compile time.  It has thread local storage so that
+        each thread (in case multi-threaded mode is used) get's its
+        own allocator thereby eliminating contention/locking.  Events
+        deallocated by other threads are returned to this allocator
+        in batches.
+
+        This allocator is used by the allocate and deallocate methods
+        in this class.  Typically the Event::create method is the one
         that is used by applications to create an event.
     */
-    thread_local static RecycleMap Recycler;
+    thread_local static SlabAllocator slabs;
 
     /** A list of events pending to be deallocated/recycled.
 
-        This list is used to hold a temporary list of events that are
-        pending to be recycled.  This list is used only in
-        multi-threaded scenarios when events are directly shared
-        between two threads.  When sending thread is done with events
-        (i.e. referenceCount == 0) but receiving thread is not
-        (i.e. inputRefCount > 0), events are added to this list.
+        This list is used to hold events that are pending to be
+        recycled at the end of the simulation.  This list is used only
+        in multi-threaded scenarios when events are directly shared
+        between two threads.  During simulation, events are retired to
+        the retiredEvents lists instead.  At the end of simulation,
+        any retired events that have not yet been reclaimed are moved
+        to this list so that they can be reclaimed once all the agents
+        have been finalized.
     */
     thread_local static EventContainer pendingDeallocs;
+
+    /** The number of lists of retired events on each thread.  Events
+        retired in epoch e are reclaimed when the global epoch reaches
+        e + 2.  Hence, at most 3 lists are in use at any time.
+    */
+    static constexpr int EpochBuckets = 3;
+
+    /** The epoch announced by a thread.  Each entry is on its own
+        cache-line to avoid false sharing between threads.
+    */
+    struct alignas(64) ThreadEpoch {
+        /// The most recent epoch announced by the thread.
+        std::atomic<size_t> epoch;
+        /// Constructor to initialize the epoch to zero.
+        ThreadEpoch() : epoch(0) {}
+    };
+
+    /** The global reclamation epoch shared by all threads.
+
+        This value is advanced by the tryAdvanceEpoch method once all
+        threads have announced it via the announceEpoch method.
+    */
+    static std::atomic<size_t> globalEpoch;
+
+    /** The epoch announced by each thread.  This array is indexed by
+        threadID and is setup in the setupEpochs method.
+    */
+    static std::vector<ThreadEpoch> threadEpochs;
+
+    /** The epoch last announced by this thread. */
+    thread_local static size_t localEpoch;
+
+    /** Events retired by this thread, indexed by epoch % EpochBuckets.
+
+        When the sending thread is done with a shared event
+        (i.e. referenceCount == 0) but the receiving thread is not
+        (i.e. inputRefCount > 0), the event is added to the list for
+        the current epoch.  The list is checked only once, two epochs
+        later, when all threads are guaranteed to have passed through
+        the boundary of their main loop (and garbage collection)
+        since the event was retired.  Events that are still in use by
+        the receiving thread are retired again in the current epoch.
+    */
+    thread_local static EventContainer retiredEvents[EpochBuckets];
  
     /** The ID/index (zero-based) of the thread associated with this
         event recycler.
@@ -752,58 +833,47 @@ private:
     /** Helper method to check and reclaim events in the
         pendingDeallocs list.
 
-        This method is periodically called in the allocate method and
-        the delteRecycledEvents method to clear out as many events as
-        possible from the pendingDeallocs list.  This method iterates
-        over the events in the pendingDeallocs list and deallocates
-        events for with both reference counters are zero.
+        This method is called from the deleteRecycledEvents method to
+        clear out as many events as possible at the end of simulation.
+        This method first moves all retired events to the
+        pendingDeallocs list.  It then iterates over the events in the
+        pendingDeallocs list and deallocates events for which both
+        reference counters are zero.
         
-        \note This method turns out to be a bit time consuming as a
-        large number of events can be pending and iterating over the
-        list was taking ~65% of the runtime.  So this method is
-        called from MultiThreadedSimulation::garbageCollect only when
-        probability of free events is high.
+        \note This method is not used during simulation because a
+        large number of events can be pending and repeatedly iterating
+        over the list was taking ~65% of the runtime.  Instead, events
+        are reclaimed by the announceEpoch method.
 
-        \see MultiThreadedSimulation::garbageCollect
+        \return The fraction of pending events that were deallocated.
+        This method returns -1 if no events were pending.
     */
     static double processPendingDeallocs();
 
-#if USE_NUMA == 1
-    /** A thread-local NUMA memory manager for managing memory in a
-        NUMA-aware manner.
-
-        This is a thread local numa memory manager that performs the
-        core tasks of managing memory in a NUMA-aware fashion.
-    */
-    thread_local static NumaMemoryManager numaMemMgr;
-#endif
-
-    /** The number of method calls to the allocateDefault method in
-        this class.
-
-        This counter tracks the number of calls to the allocateDefault
-        method.
-    */
-    thread_local static size_t allocCalls;
+    /** Helper method to reclaim a list of retired events.
 
-    /** The number of deallocationDefault method calls.
+        This method is called from the announceEpoch method with the
+        events retired two epochs ago.  Events that are no longer
+        referenced by the receiving thread are deallocated (returning
+        memory to the NUMA node from which it was allocated).  The
+        remaining events are retired again in the current epoch.
 
-        This counter tracks the number of deallocateDefault calls.
+        \param[in,out] retired The list of retired events to be
+        reclaimed.  This list is empty when this method returns.
 
-        \note With events going across threads, the number of allocate
-        vs. deallocate calls will not match-up.  However, the total
-        number across multiple threads should all add-up.
+        \return The fraction of events that were deallocated.  This
+        method returns -1 if the list was empty.
     */
-    thread_local static size_t deallocCalls;
+    static double reclaimRetired(EventContainer& retired);
 
-    /** The number of times memory requests were satisfied from the
-        default event recycler.
+    /** Helper method to move all retired events on this thread to
+        the pendingDeallocs list.
 
-        This counter tracks the number of times an allocationDefault
-        request was satisfied using a recycled memory.  Having a high
-        hit rate is important for efficient NUMA utilization.
+        This method is used at the end of simulation so that retired
+        events that have not yet been reclaimed are cleaned-up along
+        with other pending events.
     */
-    thread_local static size_t recycleHits;
+    static void moveRetiredToPending();
 
 private:    
     /** The only constructor that is intentionally private to ensure
@@ -145,6 +145,22 @@ public:
     */
     inline Time getGVT() { return gvt; }
 
+    /** Obtain a lower bound on the sent time of events that are yet
+        to be received by this process.
+
+        Red events that were in transit when GVT was computed may
+        have been sent at a time below GVT.  Their minimum sent time
+        (see sMin) is accumulated in the control message and broadcast
+        along with GVT.  Events sent in the future are sent at or
+        after GVT.
+
+        \return The minimum of GVT and the sent times of red events
+        that were in transit when GVT was computed.
+    */
+    Time getSendTimeBound() override {
+        return std::min<Time>(gvt, sendTimeBound);
+    }
+
     /** Handle incoming GVT-related messages.
 
 	This method is invoked from the Communicator whenever it
@@ -201,6 +217,31 @@ public:
     */
     void checkWaitingCtrlMsg();
 
+    /** Account for pending events migrated to another thread.
+
+        Agents moved between threads take their pending events with
+        them.  To ensure these events are not missed by an ongoing GVT
+        computation, the move is treated as one logical message from
+        this process to the destination.  Both the sender and receiver
+        must be quiescent (i.e., not processing events) when this
+        method and recvMigration are called.
+
+        \param[in] destRank The thread-based rank of the destination.
+
+        \param[in] minTime The lowest receive time of the events being
+        moved.
+
+        \return The color of the logical message.
+    */
+    int sendMigration(const unsigned int destRank, const Time& minTime);
+
+    /** Account for pending events migrated to this thread.
+
+        \param[in] color The color returned by sendMigration on the
+        source GVT manager.
+    */
+    void recvMigration(const int color);
+
     /** Convenience method to override MPI rank with a thread-based
         rank.
 
@@ -352,6 +393,23 @@ private:
     */
     Time tMin;
 
+    /** Instance variable to maintain minimum sent time of outgoing
+        red events.
+
+        This instance variable is updated and reset along with tMin.
+        It tracks the minimum value of \c sentTime values in all
+        outgoing \i red events dispatched by this process.
+    */
+    Time sMin;
+
+    /** The lower bound on the sent time of events yet to be received.
+
+        This value is computed by the initiator (rank 0) when a round
+        of GVT computation completes and is broadcast along with GVT
+        (see getSendTimeBound).
+    */
+    Time sendTimeBound;
+
     /** Instance variable to hold any pending GVT control message.
 
         This instance variable is used to hold a pending GVT control
@@ -153,6 +153,25 @@ public:
     */
     virtual inline Time getGVT() { METHOD_NOT_DEFINED; }
 
+    /** Obtain a lower bound on the sent time of events that are yet
+        to be received by this process.
+
+        GVT is a lower bound on the receive time of events that are
+        yet to be received.  However, some of these events (namely,
+        events that were in transit when GVT was computed) may have
+        been sent at a time below GVT.  This bound is used by the
+        Scheduler to determine when events of a conservative agent
+        (see Agent::setConservative) are safe to process, that is:
+        their receive time is below this bound + lookahead of the
+        agent.
+
+        \return A lower bound on the sent time of events that are yet
+        to be received.  By default this method returns GVT, which is
+        suitable for GVT managers that do not use optimistic
+        synchronization.
+    */
+    virtual Time getSendTimeBound() { return getGVT(); }
+
     virtual void forceUpdateGVT() { METHOD_NOT_DEFINED; }
 
     /** Handle incoming GVT-related messages.
@@ -214,6 +233,43 @@ public:
     */
     virtual void checkWaitingCtrlMsg() { METHOD_NOT_DEFINED; }
 
+    /** Account for pending events migrated to another thread/process.
+
+        This method is used when agents (along with their pending
+        events) are moved from this GVT manager's thread to another
+        thread.  The move is treated as a single message sent to the
+        destination, that is: the vector counter for the destination
+        is incremented and, if the active color is red, tMin is
+        updated.
+
+        \param[in] destRank The thread-based rank of the destination.
+
+        \param[in] minTime The lowest receive time of the events being
+        moved.
+
+        \return The color associated with the logical message.  This
+        value must be passed to recvMigration on the destination.
+    */
+    virtual int sendMigration(const unsigned int destRank,
+                              const Time& minTime) {
+        UNUSED_PARAM(destRank);
+        UNUSED_PARAM(minTime);
+        METHOD_NOT_DEFINED;
+    }
+
+    /** Account for pending events migrated to this thread/process.
+
+        This method is the counterpart of sendMigration and is invoked
+        on the destination GVT manager to decrement the vector counter
+        associated with this process.
+
+        \param[in] color The color returned by sendMigration.
+    */
+    virtual void recvMigration(const int color) {
+        UNUSED_PARAM(color);
+        METHOD_NOT_DEFINED;
+    }
+
     /** Convenience method to override MPI rank with a thread-based
         rank.
 
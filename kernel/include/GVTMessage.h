@@ -80,6 +80,11 @@ BEGIN_NAMESPACE(muse);
     <li> \c count is the list of vector counters that track the number
     of \i white messages that have been dispatched by various
     processes through which this message has already circulated.</li>
+
+    <li> \c sMin (not part of Mattern's algorithm) indicates the
+    cumulative minimum sent time of all red events that have been
+    dispatched by the various processes through which this message
+    has already circulated.</li>
     
     </ul></a>
     
@@ -89,8 +94,10 @@ BEGIN_NAMESPACE(muse);
     <li> \c GVT_EST_MSG: This type of message (indicated by the \c
     kind member in this class) is used to circulate the estimated GVT
     value from the ROOT_KERNEL (process with rank 0) to all other
-    processes. In this message only the m_clock value is used to
-    indicate the current estimate of GVT.</li></a>
+    processes. In this message the m_clock value is used to indicate
+    the current estimate of GVT and sMin is used to indicate the lower
+    bound on sent times of events that are yet to be received (see
+    GVTManagerBase::getSendTimeBound).</li></a>
 
     <a id="gvt_ack_msg"> <li> \c GVT_ACK_MSG: This type of message
     (indicated by the \c kind member in this class) is used to report
@@ -100,6 +107,19 @@ BEGIN_NAMESPACE(muse);
     GVT. This acknowledgement is necessary to ensure that the next
     cycle of GVT does not commence until the previous cycle is
     completed. </li></a>
+
+    <a id="cmb_null_msg"> <li> \c CMB_NULL_MSG: This type of message
+    is used by NullMessageManager to send a null message on a channel
+    between two processes.  The gvtEstimate value is the promise (a
+    lower bound on timestamps of future events on the channel).  The
+    first counter is the rank of the sender and the second counter is
+    the number of events sent on the channel prior to this
+    message.</li></a>
+
+    <a id="cmb_null_req"> <li> \c CMB_NULL_REQ: This type of message
+    is used by NullMessageManager to request a null message from
+    another process.  The first counter is the rank of the
+    sender.</li></a>
     
     </ul>
 
@@ -135,10 +155,16 @@ public:
         from ROOT_KERNEL (rank 0) to other processes.  See <a
         href="#gvt_est_msg">earlier description</a> regarging this
         message for additional details.</li>
+
+        <li> \c CMB_NULL_MSG and \c CMB_NULL_REQ : These kinds
+        identify null messages (and requests for them) exchanged by
+        NullMessageManager.  See <a href="#cmb_null_msg">earlier
+        description</a> regarding these messages.</li>
         
         </ul>
     */
-    enum GVTMsgKind{INVALID_GVT_MSG, GVT_CTRL_MSG, GVT_EST_MSG, GVT_ACK_MSG};
+    enum GVTMsgKind{INVALID_GVT_MSG, GVT_CTRL_MSG, GVT_EST_MSG, GVT_ACK_MSG,
+                    CMB_NULL_MSG, CMB_NULL_REQ};
 
     /** \brief Method to create a GVT message.
 
@@ -214,8 +240,9 @@ public:
         in vector counters stored in this message (if any).
 
         \note The returned pointer is valid only if the kind of this
-        gvt message is \c GVT_CTRL_MSG.  The caller must not delete
-        the returned pointer.
+        gvt message is \c GVT_CTRL_MSG, \c CMB_NULL_MSG, or \c
+        CMB_NULL_REQ.  The caller must not delete the returned
+        pointer.
     */
     inline int* getCounters() { return count; }
 
@@ -278,6 +305,26 @@ public:
         code description of the algorithm in Mattern's paper.
     */
     void setTmin(const Time& tMin);
+
+    /** \brief Obtain the sMin value associated with this message.
+
+        This method must be used to obtain the cumulative minimum sent
+        time of all the red events dispatched by the processes through
+        which this message has circulated.
+
+        \note This value is meaningful only in messages of kind \c
+        GVT_CTRL_MSG and \c GVT_EST_MSG.  In other messages, its
+        value is undefined.
+
+        \return The sMin value associated with this message.
+    */
+    inline Time getSmin() const { return sMin; }
+
+    /** \brief Set the sMin value associated with this message.
+
+        \param[in] sMin The sMin value to be set for this message.
+    */
+    void setSmin(const Time& sMin);
     
     /** \brief Obtain the current estimate of GVT.
 
@@ -414,6 +461,16 @@ private:
     */
     Time tMin;
 
+    /** \brief The minimum sent time of all outgoing red events.
+
+        Mattern's tMin bounds only the receive times of red events
+        that may still be in transit.  This instance variable tracks
+        the cumulative minimum sent time of these events, which can be
+        below GVT.  This value is set via the setSmin() method and
+        accessed via the getSmin() method.
+    */
+    Time sMin;
+
     /** \brief A unique sequence number set by Rank 0 process for this
         GVTMessage.
 
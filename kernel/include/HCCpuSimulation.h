@@ -0,0 +1,229 @@
+#ifndef HC_CPU_SIMULATION_H
+#define HC_CPU_SIMULATION_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <vector>
+#include "Simulation.h"
+
+// Forward declaration for random number generation. MuseOclLibrary.h
+// is not included here because its macros clash with <random>.
+struct MTrand_Info;
+
+BEGIN_NAMESPACE(muse);
+
+// Forward declaration to keep compile times down
+class HCAgent;
+
+/** A single-threaded simulation that runs heterogeneous compute (HC)
+    kernels on the CPU in batches.
+
+    <p>This simulation is selected via \c --simulator \c hc-cpu.  It
+    operates just like DefaultSimulation except for the handling of
+    HCAgent::runHCkernel.  Rather than running the kernel of each
+    agent right away (as done when HC is not supported), agents that
+    request a kernel are collected -- similar to OclSimulation -- as
+    long as they are scheduled at the same LVT.  When the LVT
+    advances, the HC parameters and states of the collected agents are
+    copied into contiguous arrays (the same layout used for OpenCL
+    devices) and the kernel is run over the whole batch.  Kernels
+    generated via the HC_KERNEL macro run the batch as an OpenMP
+    parallel SIMD loop (see HC_PARALLEL_LOOP) when OpenMP is
+    available.  Agents with a custom HCAgent::executeHCkernel are run
+    one at a time.  The number of threads used to run kernels can be
+    set via \c --hc-threads.</p>
+
+    <p>The updated HC states are copied back into the agent's current
+    state and into the state saved at the LVT, so that the kernel's
+    updates are restored correctly on rollbacks.  Agents that are
+    rolled back before the batch is run are dropped from the
+    batch.</p>
+
+    \note Do not instantiate this class; instead use the
+    Simulation::getSimulator() interface method to obtain a pointer to
+    the relevant simulation object.
+*/
+class HCCpuSimulation : public muse::Simulation {
+    // Define friend so that initializeSimulation() static method can
+    // create an instance of this class.
+    friend class muse::Simulation;
+public:
+    /** Utility method to determine if this simulation kernel has
+        Heterogeneous Computing (HC) capabilty.
+
+        \return This method returns true so that HC agents defer
+        their kernels to this class.
+    */
+    virtual bool hasHCsupport() const override { return true; }
+
+protected:
+    /** \brief Complete initialization of the Simulation
+
+        This method creates the communicator, parses command-line
+        arguments, and then lets the base class complete
+        initialization (similar to DefaultSimulation::initialize).
+
+	\param argc[in,out] The number of command line arguments.
+
+	\param argv[in,out] The actual command line arguments.
+
+        \param initMPI[in] Flag to indicate if MPI needs to be
+        reinitialized.
+    */
+    void initialize(int& argc, char* argv[], bool initMPI = true) override;
+
+    /** Parse the command-line arguments specific to this class.
+
+        This method first lets the base class consume its arguments
+        and then processes the \c --hc-threads argument.
+
+        \param[in,out] argc The number of command line arguments.
+
+        \param[in,out] argv The actual command line arguments.
+    */
+    void parseCommandLineArgs(int &argc, char* argv[]) override;
+
+    /** Finalize the Simulation after running any pending kernels.
+
+        \param[in] stopMPI If this flag is true, then MPI is
+        finalized.
+
+        \param[in] delCommMgr If this flag is true, then the
+        communication manager is deleted.
+    */
+    void finalize(bool stopMPI = true, bool delCommMgr = true) override;
+
+    /** Finalizes the AgentMap by calling
+        Communicator::registerAgents(allAgents) after the base class
+        performs common setup.
+    */
+    virtual void preStartInit() override;
+
+    /** Initialize all the agents.
+
+        This method lets the base class initialize all the agents.
+        Kernels requested by agents during initialization are not run
+        (consistent with HCAgent::runHCkernel when HC is not
+        supported).
+    */
+    virtual void initAgents() override;
+
+    /** Runs any pending kernels prior to garbage collection so that
+        the states saved at the LVT of the batch are up to date.
+    */
+    virtual void garbageCollect() override;
+
+    /** Process the next set of events and collect agents that request
+        their HC kernel to be run.
+
+        The batch of agents collected thus far is run (via
+        runHCkernels) when the LVT of the next event differs from the
+        LVT of the batch.
+
+        \return If event(s) were processed this method returns true.
+    */
+    virtual bool processNextEvent() override;
+
+    /** Convenience method to detect if this simulation represents the
+        main thread on a given MPI process.
+
+        \return This method returns true to indicate it is indeed the
+        main thread.
+    */
+    virtual bool isMainThread() const override { return true; }
+
+    /** Run the HC kernels of all the agents collected in the current
+        batch.
+
+        Agents that have been rolled back (or rescheduled) since they
+        were added to the batch are skipped.  The remaining agents
+        are grouped by type and each group is run via
+        runHCkernels(const size_t, const size_t).
+    */
+    void runHCkernels();
+
+    /** Run the HC kernel for a group of agents of the same type.
+
+        \param[in] start The index of the first entry in batch.
+
+        \param[in] end The index just past the last entry in batch.
+    */
+    void runHCkernels(const size_t start, const size_t end);
+
+private:
+    /** An agent collected in the current batch. */
+    struct HCEntry {
+        /// The agent whose kernel is to be run.
+        HCAgent* agent;
+        /// The value of Agent::numSchedules when the agent was added.
+        /// A different value indicates that the agent was rolled
+        /// back or rescheduled since then.
+        int schedules;
+    };
+
+    /** The only constructor for this class.
+
+        The constructor merely initializes the instance variables to
+        their default initial value.
+    */
+    HCCpuSimulation();
+
+    /** The destructor.
+
+        The destructor does not have any special operations.
+    */
+    virtual ~HCCpuSimulation();
+
+    /** The agents whose kernel is to be run at batchLVT. */
+    std::vector<HCEntry> batch;
+
+    /** The LVT of the agents in the batch. */
+    Time batchLVT;
+
+    /** The IDs of the agents in a group being run. */
+    std::vector<muse::AgentID> agentIDs;
+
+    /** The HC parameters of the agents in a group, packed one after
+        another.
+    */
+    std::vector<char> params;
+
+    /** The HC states of the agents in a group, packed one after
+        another.
+    */
+    std::vector<char> states;
+
+    /** The random number generators for the kernels.  Each entry in
+        a group uses the generator at its position in the group.
+    */
+    std::vector<struct MTrand_Info> rndInfo;
+
+    /** The number of threads used to run kernels.  This value is set
+        via the \c --hc-threads command-line argument.  Zero uses the
+        OpenMP default.
+    */
+    int hcThreads;
+};
+
+END_NAMESPACE(muse);
+
+#endif
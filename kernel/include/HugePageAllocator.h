@@ -0,0 +1,157 @@
+#ifndef HUGE_PAGE_ALLOCATOR_H
+#define HUGE_PAGE_ALLOCATOR_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <atomic>
+#include <string>
+#include "config.h"
+#include "DataTypes.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** Allocator for large arenas of memory backed by 2 MiB huge pages.
+
+    Simulations with tens of GB of events and states incur significant
+    TLB misses with regular 4 KiB pages.  This class is used by
+    SlabAllocator (for events) and NumaMemoryManager (for states) to
+    obtain their arenas of memory.  The mode of operation is set via
+    the \c --huge-pages command-line argument and is one of:
+
+    <ul>
+
+    <li><b>none</b> (default): Arenas are not allocated by this
+    class.</li>
+
+    <li><b>thp</b>: Arenas are mapped with mmap and the kernel is
+    advised (via madvise(MADV_HUGEPAGE)) to back them with
+    transparent huge pages.</li>
+
+    <li><b>explicit</b>: Arenas are mapped from the pool of reserved
+    huge pages (via MAP_HUGETLB).  If the pool is exhausted (or not
+    configured), then this class falls back to transparent huge pages
+    and then to regular pages.</li>
+
+    </ul>
+
+    If a NUMA node is specified, then the arena is bound to the node
+    (via mbind) prior to first use.  The sizes of arenas are rounded
+    up to a multiple of the huge page size.
+
+    \note All methods in this class are static and are thread-safe.
+    The mode must be set prior to creating threads.
+*/
+class HugePageAllocator {
+public:
+    /** The different modes of operation supported by this class. */
+    enum Mode { NONE, TRANSPARENT, EXPLICIT };
+
+    /** The size (in bytes) of huge pages used by this class. */
+    static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+    /** Set the mode of operation based on a command-line argument.
+
+        \param[in] mode The mode of operation.  It must be one of:
+        none, thp, or explicit.
+
+        \return This method returns true if the mode was valid.
+        Otherwise it returns false.
+    */
+    static bool setMode(const std::string& mode);
+
+    /** Obtain the current mode of operation.
+
+        \return The current mode of operation.
+    */
+    static Mode getMode() { return mode; }
+
+    /** Determine if arenas are to be allocated by this class.
+
+        \return This method returns true if the mode is not NONE.
+    */
+    static bool isEnabled() { return (mode != NONE); }
+
+    /** Round up the size of an arena to be allocated by this class.
+
+        \param[in] size The desired size of the arena (in bytes).
+
+        \return The size rounded up to a multiple of HugePageSize if
+        huge pages are enabled.  Otherwise size is returned as is.
+    */
+    static size_t roundUp(const size_t size) {
+        return (mode == NONE) ? size :
+            ((size + HugePageSize - 1) / HugePageSize) * HugePageSize;
+    }
+
+    /** Allocate an arena of memory.
+
+        \param[in] size The size of the arena.  This value must be a
+        value returned by the roundUp method.
+
+        \param[in] numaID The NUMA node to which the arena must be
+        bound.  If this value is -1 then the memory is not bound to
+        any NUMA node.
+
+        \param[out] huge This flag is set to true if the arena is
+        backed (or advised to be backed) by huge pages.
+
+        \return The starting address of the arena.  This method
+        aborts if memory cannot be allocated.
+    */
+    static char* allocate(const size_t size, const int numaID, bool& huge);
+
+    /** Free an arena allocated by the allocate method.
+
+        \param[in] mem The address returned by the allocate method.
+
+        \param[in] size The size of the arena.  This must be the same
+        value passed to the allocate method.
+    */
+    static void release(char* mem, const size_t size);
+
+    /** Obtain a line of statistics about huge page coverage.
+
+        \param[in] hugeBytes The number of bytes backed by huge pages.
+
+        \param[in] totalBytes The total number of bytes allocated.
+
+        \return A string with the coverage to be included in
+        statistics reported by memory managers.
+    */
+    static std::string getCoverage(const size_t hugeBytes,
+                                   const size_t totalBytes);
+
+private:
+    /** The current mode of operation. */
+    static Mode mode;
+
+    /** Flag to report fallback from explicit huge pages only once. */
+    static std::atomic<bool> reportedFallback;
+
+    /** The constructor.  This class is not meant to be
+        instantiated. */
+    HugePageAllocator() {}
+};
+
+END_NAMESPACE(muse);
+
+#endif
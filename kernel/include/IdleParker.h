@@ -0,0 +1,160 @@
+#ifndef MUSE_IDLE_PARKER_H
+#define MUSE_IDLE_PARKER_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors:  Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include "DataTypes.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** Spin-then-park policy for threads that have no events to process.
+
+    Without this class, the core simulation loop of an idle thread
+    repeatedly polls for events, wasting a core on shared nodes and
+    adding memory-bus traffic for the busy threads.  This class is
+    used by Simulation (and MultiThreadedSimulation) to park a thread
+    that has been idle for a number of consecutive iterations of the
+    simulation loop.  Parking is enabled via the \c --idle-park-usec
+    command-line argument and proceeds as follows:
+
+    <ol>
+
+    <li>The simulation loop calls idle() each time it has no events
+    to process and busy() each time it processes events.  Once
+    idle() has been called spinLimit consecutive times, the thread
+    calls park().</li>
+
+    <li>The park() method announces that the thread is parked and then
+    rechecks (via a callback) for work that may have raced with the
+    announcement.  If there is no work, the thread sleeps on a
+    condition variable for at most \c --idle-park-usec
+    microseconds.</li>
+
+    <li>Other threads call wakeup() after adding events to the
+    incoming queue of the thread.  The bounded sleep ensures that the
+    parked thread still periodically checks for MPI messages and
+    participates in GVT computations, even if no other thread wakes
+    it up.</li>
+
+    <li>The spin limit adapts to the workload: it is doubled (up to 16x
+    the \c --idle-spin value) when a parked thread is woken up by
+    another thread, as a longer spin would have avoided the cost of
+    parking.  It is halved (down to 1/16th) when the park times out,
+    so that threads that are idle for long periods park sooner.</li>
+
+    </ol>
+
+    \note The idle(), busy(), and park() methods must be called only
+    from the thread that owns this object.  The wakeup() method can
+    be called from any thread.
+*/
+class IdleParker {
+public:
+    /** The constructor.
+
+        \param[in] spinLimit The initial number of consecutive idle
+        iterations after which the thread is parked.  This value must
+        be positive.
+
+        \param[in] parkUsec The maximum time (in microseconds) for
+        which the thread is parked.  This value must be positive.
+    */
+    IdleParker(const int spinLimit, const int parkUsec);
+
+    /** Track an iteration of the simulation loop without events.
+
+        \return This method returns true if the thread has been idle
+        for spinLimit consecutive iterations and must be parked.
+    */
+    inline bool idle() { return (++idleSpins >= spinLimit); }
+
+    /** Track an iteration of the simulation loop with events. */
+    inline void busy() { idleSpins = 0; }
+
+    /** Park the calling thread until it is woken up or times out.
+
+        \param[in] hasWork Callback used to recheck for work after the
+        thread has been announced as parked.  This callback must
+        return true if there is work to do, in which case the thread
+        is not parked.
+
+        \return This method returns true if the thread was woken up
+        (or work was found by the recheck).  It returns false if the
+        park timed out.
+    */
+    bool park(const std::function<bool()>& hasWork);
+
+    /** Wake up the thread if it is parked.
+
+        This method must be called after an event has been added to
+        the incoming queue of the thread that owns this object.  This
+        method is cheap if the thread is not parked.
+    */
+    void wakeup();
+
+    /** Report statistics about parking.
+
+        \param[out] os The output stream to which statistics are to be
+        written.
+    */
+    void reportStats(std::ostream& os) const;
+
+private:
+    /** The current number of consecutive idle iterations after which
+        the thread is parked.
+    */
+    int spinLimit;
+
+    /** The lower and upper bounds for spinLimit. */
+    const int minSpin, maxSpin;
+
+    /** The number of consecutive idle iterations so far. */
+    int idleSpins;
+
+    /** The maximum time for which the thread is parked. */
+    const std::chrono::microseconds parkTime;
+
+    /** Flag set while the thread is (about to be) parked.  This flag
+        is cleared by wakeup().
+    */
+    std::atomic<bool> parked;
+
+    /** Mutex and condition variable on which the thread sleeps. */
+    std::mutex parkMutex;
+    std::condition_variable parkCond;
+
+    /** Statistics: number of times the thread parked, was woken up by
+        another thread, and timed out.
+    */
+    size_t parkCount, wakeCount, timeoutCount;
+};
+
+END_NAMESPACE(muse);
+
+#endif
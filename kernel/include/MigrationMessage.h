@@ -0,0 +1,214 @@
+#ifndef MIGRATION_MESSAGE_H
+#define MIGRATION_MESSAGE_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors:  Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <string>
+#include "DataTypes.h"
+#include "Event.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** This is a sentinel value that is used to distinguish migration
+    messages from other incoming events in Simulation::processMpiMsgs
+    method.  This value is set in the message's sender field in the
+    constructor of MigrationMessage.
+*/
+constexpr int MIGRATION_MSG_SENDER = -3;
+
+/** Message exchanged between processes to migrate agents.
+
+    Migration messages are exchanged by the AgentMigrator on each
+    process to coordinate moving agents between MPI processes.  The
+    messages are sent via the same path as regular events (so that
+    the GVT manager accounts for them) but are routed to the process
+    indicated by getDestRank rather than to the owner of the receiver
+    agent.  The information in the message is a flat array of bytes
+    whose contents depend on the kind of message.
+
+    \see AgentMigrator
+*/
+class MigrationMessage : public muse::Event {
+public:
+    /** The different kinds of messages used by the AgentMigrator.
+        See AgentMigrator for details on how these messages are used.
+    */
+    enum Kind { LOAD_REPORT, FREEZE, PROBE, COUNTS, GO, AGENT_STATE,
+                ADOPTED, RESUME };
+
+    /** Primary method to create this message.
+
+        This method allocates memory for the message as a flat array
+        of bytes, consistent with the MUSE kernel requirements, and
+        copies the payload into the message.
+
+        \param[in] kind The kind of message being created.
+
+        \param[in] srcRank The rank of the process creating the
+        message.
+
+        \param[in] destRank The rank of the process to which this
+        message is to be delivered.
+
+        \param[in] round The migration round (or wave of messages)
+        with which this message is associated.
+
+        \param[in] payload The information to be copied into this
+        message.
+
+        \param[in] recvTime The receive time for this message.  This
+        value bounds GVT while the message is in flight.
+
+        \return The newly created message.  The message must be freed
+        via call to EventRecycler::decreaseReference.
+    */
+    static MigrationMessage* create(const Kind kind, const int srcRank,
+                                    const int destRank, const int round,
+                                    const std::string& payload = "",
+                                    const Time recvTime = TIME_INFINITY);
+
+    /** Convenience method to determine if an event is a migration
+        message.
+
+        \param[in] event The event to be checked.  This pointer cannot
+        be NULL.
+
+        \return True if the event is a migration message.
+    */
+    static bool isMigrationMessage(const muse::Event* const event) {
+        return (event->getSenderAgentID() == MIGRATION_MSG_SENDER);
+    }
+
+    /** Obtain the kind of this message.
+
+        \return The kind of this message set when it was created.
+    */
+    inline Kind getKind() const { return kind; }
+
+    /** Obtain the rank of the process that sent this message.
+
+        \return The rank of the process that created this message.
+    */
+    inline int getSrcRank() const { return srcRank; }
+
+    /** Obtain the rank of the process to which this message is to be
+        delivered.
+
+        \return The rank of the destination process.
+    */
+    inline int getDestRank() const { return destRank; }
+
+    /** Obtain the migration round associated with this message.
+
+        \return The round number set when this message was created.
+    */
+    inline int getRound() const { return round; }
+
+    /** Obtain a copy of the payload in this message.
+
+        \return The information copied into this message when it was
+        created.
+    */
+    inline std::string getPayload() const {
+        return std::string(payload, payloadSize);
+    }
+
+    /** \brief Get the total size (in bytes) of this message.
+
+        This method is used to determine the total size of each
+        message so that it can be properly sent across the wire by
+        MPI.
+
+        \return The total size of the message in bytes as required by
+        MUSE kernel's API.
+    */
+    int getEventSize() const override { return msgSize; }
+
+protected:
+    /** The constructor.
+
+        The constructor is intentionally protected to minimize the
+        chances it is called directly.  Instead use the create method
+        in this class to create messages.
+
+        \param[in] kind The kind of message being created.
+
+        \param[in] srcRank The rank of the process creating the
+        message.
+
+        \param[in] destRank The rank of the process to which this
+        message is to be delivered.
+
+        \param[in] round The migration round for this message.
+
+        \param[in] payloadSize The number of bytes of payload.
+
+        \param[in] msgSize The total size of this message in bytes.
+
+        \param[in] recvTime The receive time for this message.
+    */
+    MigrationMessage(const Kind kind, const int srcRank, const int destRank,
+                     const int round, const int payloadSize,
+                     const int msgSize, const Time recvTime);
+
+    /** \brief The destructor.
+
+        The destructor has been made protected to ensure that this
+        message is never directly deleted.
+    */
+    ~MigrationMessage() {}
+
+private:
+    /** The total size of this message in bytes.  This value is set
+        by the constructor and is never changed.
+    */
+    const int msgSize;
+
+    /** The kind of this message. */
+    const Kind kind;
+
+    /** The rank of the process that created this message. */
+    const int srcRank;
+
+    /** The rank of the process to which this message is delivered. */
+    const int destRank;
+
+    /** The migration round (or wave) associated with this message. */
+    const int round;
+
+    /** The number of bytes in the payload array. */
+    const int payloadSize;
+
+    /** \brief The variable length payload in this message.
+
+        \note This instance variable must be at the end of this class
+        definition.  Do not move it.
+
+        Sufficient memory for the payload is allocated when the
+        message is created.
+    */
+    char payload[];
+};
+
+END_NAMESPACE(muse);
+
+#endif
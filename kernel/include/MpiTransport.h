@@ -0,0 +1,418 @@
+#ifndef MUSE_MPI_TRANSPORT_H
+#define MUSE_MPI_TRANSPORT_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Meseret R. Gebre       meseret.gebre@gmail.com
+//          Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include "Transport.h"
+#include "MPIHelper.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** Transport that uses two-sided MPI operations.
+
+    This is the default transport (<tt>--transport mpi</tt>).  Events
+    and GVT messages are dispatched using non-blocking sends from a
+    bounded pool of requests (see setMaxPendingSends). Incoming
+    events are received via an optional ring of pre-posted receives
+    (see setRecvRing) and via probe-and-receive.
+*/
+class MpiTransport : public muse::Transport {
+public:
+    /** \brief Default Constructor.
+
+        The constructor merely initializes instance variables.
+    */
+    MpiTransport();
+
+    /** \brief Destructor
+
+        Do nothing, since resources are released in finalize.
+    */
+    virtual ~MpiTransport() override;
+
+    /** \brief Initialize MPI (if requested) and obtain the rank.
+
+        \param[in] argc The number of command-line arguments.
+
+        \param[in] argv The command-line arguments passed to MPI.
+
+        \param[in] initMPI If true, MPI is initialized.
+
+        \return The MPI rank of this process.
+    */
+    virtual int initialize(int argc, char* argv[], bool initMPI) override;
+
+    /** Obtain the MPI rank of this process.
+
+        \return The MPI rank of this process.
+    */
+    virtual int getRank() const override { return myRank; }
+
+    /** Obtain the number of MPI processes.
+
+        \return The size of MPI_COMM_WORLD.
+    */
+    virtual int getNumProcesses() const override { return numProcs; }
+
+    /** \brief Exchange ranges of agents via MPI_Allgatherv.
+
+        The number of values contributed by each process is first
+        exchanged via MPI_Allgather followed by a single
+        MPI_Allgatherv of the ranges.
+
+        \param[in] localRanges The ranges of agents on this process.
+
+        \param[out] ownerMap The map to be populated.
+    */
+    virtual void allGatherAgentRanges(const std::vector<AgentID>& localRanges,
+                                      AgentRangeMap& ownerMap) override;
+
+    /** \brief Send an event via MPI.
+
+        Events that don't fit in pre-posted receive buffers are sent
+        with LARGE_EVENT tag.  If the pool of non-blocking sends is
+        used, a copy of the event is sent so that the event itself
+        is not tied to the in-flight send.
+
+        \param[in] e The event to be sent.
+
+        \param[in] eventSize The size (in bytes) of the event.
+
+        \param[in] destRank The rank of the destination process.
+    */
+    virtual void sendEvent(Event* e, const int eventSize,
+                           const int destRank) override;
+
+    /** \brief Send a GVT message via MPI.
+
+        \param[in] msg The GVT message to be sent.
+
+        \param[in] destRank The rank of the destination process.
+    */
+    virtual void sendGVTMessage(const GVTMessage* msg,
+                                const int destRank) override;
+
+    /** \brief Send a string via a blocking MPI send.
+
+        \param[in] str The string to be sent.
+
+        \param[in] destRank The rank of the destination process.
+
+        \param[in] tag The tag associated with the string.
+    */
+    virtual void sendString(const std::string& str, const int destRank,
+                            const int tag) override;
+
+    /** \brief Receive the next event or GVT message.
+
+        This method first reclaims completed sends.  Next it checks
+        the ring of pre-posted receives (if any) followed by
+        probe-and-receive.  If the probe finds an event while all the
+        pre-posted receives are matched, this method waits for the
+        oldest receive in the ring and returns its event.  So a
+        backlog of events never makes this method report that no
+        message is pending, and GVT messages (which are always
+        probed) behind the backlog are received in the same round of
+        Simulation::processMpiMsgs.
+
+        \param[out] data The flat buffer containing the message.
+
+        \param[out] size The size (in bytes) of the message.
+
+        \param[out] tag The MPI tag associated with the message.
+
+        \param[out] srcRank The rank of the sender.
+
+        \return True if a message was received.
+    */
+    virtual bool receive(char*& data, int& size, int& tag,
+                         int& srcRank) override;
+
+    /** \brief Receive a string via MPI probe and receive.
+
+        \param[out] recvRank The actual rank from where the message
+        was received.
+
+        \param[in] srcRank The rank from where the string is to be
+        read.
+
+        \param[in] tag The tag associated with the string.
+
+        \param[in] blocking If true, blocking MPI probe is used.
+
+        \return The string received (if any).
+    */
+    virtual std::string receiveString(int& recvRank, const int srcRank,
+                                      const int tag,
+                                      const bool blocking) override;
+
+    /** \brief Wait on MPI_Barrier. */
+    virtual void barrier() override;
+
+    /** \brief Compute global minimum via MPI_Allreduce.
+
+        \param[in] value The local value to be used.
+
+        \return The global minimum of the values from all processes.
+    */
+    virtual Time allReduceMin(const Time value) override;
+
+    /** \brief Compute global sum via MPI_Allreduce.
+
+        \param[in] value The local value to be used.
+
+        \return The global sum of the values from all processes.
+    */
+    virtual long allReduceSum(const long value) override;
+
+    /** \brief Compute element-wise global sums via MPI_Allreduce.
+
+        \param[in,out] values The local values to be used.  On return,
+        each entry is the global sum of the corresponding entries.
+    */
+    virtual void allReduceSum(std::vector<Time>& values) override;
+
+    /** \brief Set the maximum number of in-flight non-blocking sends.
+
+        Events and GVT messages are dispatched using non-blocking
+        MPI_Isend calls.  The buffers associated with in-flight sends
+        are tracked in a bounded pool of requests.  Completed requests
+        are reclaimed (via MPI_Testsome) and the buffers are released
+        back to the EventRecycler.  If the pool is full, then the
+        sender waits (via MPI_Waitsome) until some requests complete.
+        This method is typically called from
+        Simulation::parseCommandLineArgs based on the
+        --mpi-send-pool command-line argument.
+
+        \note This method must be called before any events are sent.
+
+        \param[in] count The maximum number of in-flight sends.  If
+        this value is zero, then blocking sends (MPI_Send) are used.
+    */
+    virtual void setMaxPendingSends(const int count) override;
+
+    /** \brief Setup a ring of pre-posted receives for events.
+
+        In this mode, a ring of non-blocking receives (MPI_Irecv) is
+        pre-posted for incoming events.  Each receive uses a buffer
+        (of the maximum event size) obtained from the EventRecycler.
+        Completed buffers are directly handed to the scheduler as
+        events (without copying) and a fresh buffer is posted in its
+        place.  Events larger than maxEventSize are sent with
+        LARGE_EVENT tag and are received using the regular
+        probe-and-receive approach.  This method is typically called
+        from Simulation::parseCommandLineArgs based on the
+        --mpi-recv-ring and --mpi-recv-size command-line arguments.
+
+        \note All the processes must use the same settings as the
+        sender uses maxEventSize to choose the tag for events.
+
+        \param[in] count The number of pre-posted receives.  If this
+        value is zero, then only probe-and-receive is used.
+
+        \param[in] maxEventSize The size of each buffer in the ring.
+        This value should be the size of the events used by the
+        model to enable zero-copy handoff of events.
+    */
+    virtual void setRecvRing(const int count, const int maxEventSize)
+        override;
+
+    /** \brief Report statistics about non-blocking sends and receives.
+
+        \param[out] os The output stream to which the statistics are
+        to be written.
+    */
+    virtual void reportStats(std::ostream& os) override;
+
+    /** \brief Drain pending operations and finalize MPI.
+
+        \param[in] stopMPI If this flag is true, then MPI is finalized.
+    */
+    virtual void finalize(bool stopMPI) override;
+
+protected:
+    /** \brief Reclaim buffers of non-blocking sends that have completed.
+
+        This method uses MPI_Testsome (or MPI_Waitsome if wait is
+        true) to check the status of in-flight sends. The buffers
+        associated with completed sends are released -- that is,
+        copies of events and GVT messages made for sending are
+        recycled.  The corresponding slots in the pool are made
+        available for subsequent sends.
+
+        \param[in] wait If this flag is true, then this method blocks
+        until at least one pending send has completed.
+
+        \return The number of sends that completed.
+    */
+    int reclaimCompletedSends(const bool wait = false);
+
+    /** \brief Dispatch a buffer using a non-blocking send.
+
+        This is an internal helper method that is used to send events
+        and GVT messages.  It obtains a free slot in the pool of
+        pending requests (waiting for sends to complete, if
+        necessary) and uses MPI_Isend to dispatch the data.
+
+        \param[in] buffer The event (or GVT message) to be sent.  The
+        buffer is released when the send completes.  The caller must
+        have already ensured that the buffer stays valid until then.
+
+        \param[in] size The size of the buffer in bytes.
+
+        \param[in] destRank The rank of the destination process.
+
+        \param[in] tag The tag (EVENT or GVT_MESSAGE) for the
+        message.  The tag is also used to decide how the buffer is
+        released when the send completes.
+    */
+    void isend(Event* buffer, const int size, const int destRank,
+               const int tag);
+
+    /** \brief Obtain the next event from the ring of pre-posted
+        receives.
+
+        This method checks if the pre-posted receive at the head of
+        the ring has completed.  Entries are consumed in the order in
+        which they were posted to preserve the order of events (that
+        is, anti-messages cannot overtake events) from a given sender.
+        If so, the buffer is handed off and a fresh receive is posted
+        in its place.
+
+        \param[out] data The buffer containing the event.
+
+        \param[out] size The size (in bytes) of the event.
+
+        \param[out] srcRank The rank of the sender.
+
+        \param[in] wait If this flag is true, then this method blocks
+        until the receive at the head of the ring completes.  This
+        flag must be used only if the receive is known to be matched.
+
+        \return True if an event was received.
+    */
+    bool receiveRingEvent(char*& data, int& size, int& srcRank,
+                          const bool wait = false);
+
+    /** \brief Cancel all the pre-posted receives in the ring.
+
+        This method is used at the end of simulation to cancel
+        pending receives and release their buffers.
+    */
+    void cancelRecvRing();
+
+    /** \brief Wait for all pending non-blocking sends to complete.
+
+        This method is used to drain the pool of in-flight sends
+        (releasing all the buffers) when the simulation finishes.
+    */
+    void drainPendingSends();
+
+    /** The MPI rank of this process. This value is setup in the
+        initialize method to minimize calls to MPI_GET_RANK (which is
+        shown to be expensive).
+    */
+    int myRank;
+
+    /** The number of MPI processes. This value is setup in the
+        initialize method.
+    */
+    int numProcs;
+
+private:
+    /** The MPI requests for the pool of in-flight non-blocking sends.
+        Unused slots are set to MPI_REQUEST_NULL.  The size of this
+        vector is set via setMaxPendingSends() method.  If this vector
+        is empty, then blocking MPI sends are used.
+    */
+    std::vector<MPI_REQUEST> sendRequests;
+
+    /** The buffer (copy of an event or GVT message) associated with
+        each entry in the sendRequests vector.  The buffer is released
+        when the corresponding send completes.
+    */
+    std::vector<Event*> sendBuffers;
+
+    /** The MPI tag associated with each entry in the sendRequests
+        vector.  The tag is used to determine how the corresponding
+        buffer is to be released.
+    */
+    std::vector<int> sendTags;
+
+    /** The size (in bytes) of the buffer associated with each entry
+        in the sendRequests vector.
+    */
+    std::vector<int> sendSizes;
+
+    /** The list of indexes of unused entries in sendRequests. */
+    std::vector<int> freeSendSlots;
+
+    /** Temporary list used with MPI_Testsome/MPI_Waitsome to obtain
+        index of completed requests.  This list is created once and
+        reused to minimize allocation/deallocation overheads.
+    */
+    std::vector<int> doneSendIndexs;
+
+    /** Statistics counter to track the total number of non-blocking
+        sends initiated by this transport.
+    */
+    size_t numIsends;
+
+    /** Statistics counter to track the number of times a send had to
+        wait because the pool of in-flight sends was exhausted.
+    */
+    size_t sendPoolStalls;
+
+    /** The requests for the ring of pre-posted receives.  If this
+        vector is empty then pre-posted receives are not used.
+    */
+    std::vector<MPI_REQUEST> recvRequests;
+
+    /** The buffers associated with each pre-posted receive.  The
+        buffers are obtained from the EventRecycler.
+    */
+    std::vector<char*> recvBuffers;
+
+    /** The index of the oldest pre-posted receive in the ring. */
+    size_t recvHead;
+
+    /** The size of each buffer in the ring of pre-posted receives.
+        Events larger than this size are sent using LARGE_EVENT tag.
+        This value is zero if pre-posted receives are not used.
+    */
+    int recvBufferSize;
+
+    /** Statistics counter to track the number of events received via
+        the ring of pre-posted receives.
+    */
+    size_t numRingRecvs;
+
+    /** Statistics counter to track the number of messages received
+        via probe-and-receive.
+    */
+    size_t numProbeRecvs;
+};
+
+END_NAMESPACE(muse);
+
+#endif
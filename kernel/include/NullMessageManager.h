@@ -0,0 +1,230 @@
+#ifndef NULL_MESSAGE_MANAGER_H
+#define NULL_MESSAGE_MANAGER_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+#include "DataTypes.h"
+#include "GVTManagerBase.h"
+
+BEGIN_NAMESPACE(muse)
+
+/** Manager for asynchronous conservative (Chandy-Misra-Bryant)
+    synchronization using null messages.
+
+    This class is used by ConservativeSimulation with the \c
+    --cmb-async command-line argument.  Rather than computing GVT via
+    collective operations, each process communicates with the other
+    processes over a set of logical channels.  A channel from process
+    \c src to process \c dest exists if an agent on \c src may send
+    events to an agent on \c dest.  The lookahead of a channel is the
+    minimum lookahead (see Simulation::declareLookahead) of all the
+    links between agents on the two processes.
+
+    Each process periodically sends a null message on its output
+    channels.  The null message carries a promise, that is, a lower
+    bound on the timestamps of all future events on the channel.  The
+    clock of an input channel is the latest promise received on it and
+    events with timestamps below the minimum of the input clocks can
+    be safely processed (see getSafeTime).  A null message also
+    carries the number of events sent on the channel prior to it.  The
+    promise is applied only after all of these events have been
+    received.  This makes the protocol independent of the ordering of
+    messages in the underlying transport.
+
+    Null messages are suppressed using one of the following policies
+    (set via the \c --cmb-nulls command-line argument):
+
+    <ul>
+
+    <li><b>lazy</b> (default): A null message is sent only if the
+    promise has increased and the process is blocked or the promise
+    has advanced by at least the lookahead of the channel.</li>
+
+    <li><b>demand</b>: A blocked process requests null messages from
+    the input channels that limit its safe time.  A null message is
+    sent only in response to a request.</li>
+
+    </ul>
+
+    \note The GVT value maintained by this class is a local lower
+    bound on the timestamps of events to be processed by this process
+    and is used only to detect the end of the simulation.
+*/
+class NullMessageManager: public GVTManagerBase {
+    // Allow ConservativeSimulation to call protected members
+    friend class ConservativeSimulation;
+public:
+    void initialize(const Time &startTime, Communicator *comm) override;
+
+    /** Send an event on its output channel.
+
+        This method aborts if the model sends an event to a process
+        with which it does not have a channel or if the timestamp of
+        the event is below a promise already sent on the channel (that
+        is, the model did not honor its declared lookahead).
+    */
+    bool sendRemoteEvent(Event *event) override;
+
+    /** Track events received on each input channel so that pending
+        promises can be applied. */
+    void inspectRemoteEvent(Event *event) override;
+
+    /** Process a null message or a request for a null message. */
+    void recvGVTMessage(GVTMessage *message) override;
+
+    inline Time getGVT() override { return gvt; }
+
+    /** Report statistics about null messages exchanged by this
+        process.
+
+        \param[out] os The output stream to which statistics are to
+        be written.
+    */
+    void reportStatistics(std::ostream& os) const;
+
+protected:
+    /** The constructor.
+
+        \param[in] sim The simulation that owns this manager.
+
+        \param[in] demandDriven If true, null messages are sent only
+        on demand.  Otherwise lazy null messages are used.
+    */
+    NullMessageManager(Simulation *sim, const bool demandDriven);
+
+    /** Set the lookahead of the channels to and from each process.
+
+        This method must be called after initialize.
+
+        \param[in] outLookahead The lookahead on the channel to each
+        process.  A zero value indicates that there is no channel.
+
+        \param[in] inLookahead The lookahead on the channel from each
+        process.  A zero value indicates that there is no channel.
+    */
+    void setChannels(const std::vector<Time>& outLookahead,
+                     const std::vector<Time>& inLookahead);
+
+    /** Obtain the time below which events can be safely processed.
+
+        \return The minimum of the clocks of all the input channels.
+        TIME_INFINITY if this process does not have any input
+        channels.
+    */
+    Time getSafeTime() const;
+
+    /** Update the local lower bound used to detect the end of the
+        simulation.
+
+        \param[in] lowerBound The lower bound on the timestamp of
+        events to be processed by this process.
+    */
+    void updateGVT(const Time& lowerBound) {
+        gvt = std::max(gvt, lowerBound);
+    }
+
+    /** Send null messages (or requests for null messages) as
+        permitted by the suppression policy.
+
+        \param[in] lowerBound The lower bound on the timestamp of
+        events to be processed by this process, that is, the minimum
+        of LGVT and the safe time.
+
+        \param[in] blocked True if this process could not process any
+        event because it is waiting on its input channels.
+    */
+    void sendNullMessages(const Time& lowerBound, const bool blocked);
+
+    /** Send a null message with an infinite promise on all output
+        channels.  This method is called when this process has
+        finished simulation so that other processes are not blocked
+        waiting for it.
+    */
+    void sendFinalNullMessages();
+
+private:
+    /** Send a null message with a given promise on a channel.
+
+        \param[in] dest The destination process of the channel.
+
+        \param[in] promise The lower bound on timestamps of future
+        events on the channel.
+    */
+    void sendNullMessage(const unsigned int dest, const Time& promise);
+
+    /** Advance the clock of an input channel.
+
+        \param[in] src The source process of the channel.
+
+        \param[in] promise The promise received on the channel.
+    */
+    void advanceClock(const unsigned int src, const Time& promise);
+
+    /** Flag to indicate if null messages are sent only on demand. */
+    const bool demandDriven;
+
+    /** The lookahead of the channels to and from each process.  Zero
+        values indicate that the channel does not exist.
+    */
+    std::vector<Time> outLookahead, inLookahead;
+
+    /** The last promise sent on each output channel. */
+    std::vector<Time> lastPromise;
+
+    /** The number of events sent on each output channel. */
+    std::vector<int> sentCount;
+
+    /** Flags to indicate processes that have requested a null message
+        (used only in demand-driven mode).
+    */
+    std::vector<bool> wanted;
+
+    /** The clock (latest applied promise) of each input channel. */
+    std::vector<Time> inClock;
+
+    /** The number of events received on each input channel. */
+    std::vector<int> recvCount;
+
+    /** The latest promise received on each input channel that is yet
+        to be applied along with the number of events that must be
+        received before it is applied (-1 if there is no pending
+        promise).
+    */
+    std::vector<Time> pendingPromise;
+    std::vector<int>  pendingCount;
+
+    /** Flags to indicate input channels from which null messages have
+        been requested (used only in demand-driven mode).
+    */
+    std::vector<bool> requested;
+
+    /** Statistics about the messages exchanged by this class. */
+    size_t nullsSent = 0, nullsRecvd = 0, requestsSent = 0;
+};
+
+END_NAMESPACE(muse)
+
+#endif
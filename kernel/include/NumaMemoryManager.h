@@ -36,10 +36,6 @@
 
 BEGIN_NAMESPACE(muse);
 
-// Forward declarations
-class MultiThreadedSimulationManager;
-class RedistributionMessage;
-
 /** An unordered map to store free events of different sizes.
 
     The key into this unordered map is the size of the event being
@@ -83,7 +79,7 @@ public:
         intialization is done by the setup method in this class.
     */
     NumaMemoryManager() : blockSize(65536), allocCalls(0), deallocCalls(0),
-                          recycleHits(0), numRedist(0) {}
+                          recycleHits(0), blockBytes(0), hugeBytes(0) {}
 
     /** The destructor.
 
@@ -103,7 +99,9 @@ public:
         different threads have been allocated.
 
         \param[in] blkSize The size (in bytes) in which NUMA blocks
-        are to be allocated.  The default value is 64 KiB.
+        are to be allocated.  The default value is 64 KiB.  If huge
+        pages are enabled (via \c --huge-pages) the size is rounded
+        up to a multiple of the huge page size.
     */
     void start(const std::vector<int>& numaIDofThread,
                const int blkSize = 65536);
@@ -178,48 +176,6 @@ public:
     */
     std::string getStats() const;
 
-    /** Method to check and redistribute event memory blocks to
-        various threads.
-
-        Depending on communication patterns in the model/simulation,
-        memory usage across numa-nodes can be skewed causing
-        degradation in overall memory usage and recycling performance.
-        This method is periodically called from
-        MultiThreadedSimulation::garbageCollect method to check and
-        redistribute memory blocks.
-
-        \param[in] threadsPerNode The total number of threads to which
-        memory can be redistributed.
-
-        \param[in] threadID The ID of the local thread (0 <= threadID
-        < threadsPerNode) associated with this memory manager.
-
-        \param[in] numaID The preferred NUMA node for the given
-        thread.
-        
-        \param[in] mgr The simulation manager to be used to send the
-        free memory blocks to other threads.
-    */
-    void redistribute(const int threadsPerNode, const int threadID,
-                      const int numaID,
-                      MultiThreadedSimulationManager* const mtc);
-
-    /** Method to add redistributed memory blocks from another thread
-        to this thread.
-
-        This method is used to process the messages generated by the
-        overloaded redistribute method.  This method is invoked from
-        MultiThreadedSimulation's processIncomingEvents method.  The
-        message with redistributed memory pointers is passed in as the
-        parameter.  This method uses the information in the event to
-        add the redistributed memory locations to the appropriate
-        entries in the recycler.
-
-        \param[in] rdm The redistribution message to be processed by
-        this method.  This parameter cannot be NULL.
-    */
-    void redistribute(RedistributionMessage* rdm);
-    
     /** Convenience method to determine the memory allocated by this
         manager on a given numa node.
 
@@ -386,13 +342,17 @@ private:
     */
     size_t recycleHits;
 
-    /** The number of times this memory manager redistributed events.
+    /** The total number of bytes in blocks allocated by this
+        manager.
+    */
+    size_t blockBytes;
+
+    /** The number of bytes in blocks backed by huge pages.
 
-        This counter tracks the number of times redistribution of
-        events was performed by this memory manager.  This value is
-        reported in the statistics.
-     */
-    int numRedist;
+        This value is reported (along with blockBytes) as the huge
+        page coverage in the statistics.
+    */
+    size_t hugeBytes;
 };
 
 END_NAMESPACE(muse);
@@ -0,0 +1,339 @@
+#ifndef MUSE_RMA_TRANSPORT_H
+#define MUSE_RMA_TRANSPORT_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <cstdint>
+#include "MpiTransport.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** Transport that uses MPI one-sided (RMA) operations to exchange
+    events and GVT messages.
+
+    <p>Each process exposes an MPI window that is logically organized
+    as one ring buffer (or mailbox) for each of the other processes.
+    Each ring has a header with two 64-bit counters -- tail (the
+    number of bytes written by the sender) and head (the number of
+    bytes consumed by the receiver).  Only one process writes to a
+    given ring, so the rings are single-producer, single-consumer.</p>
+
+    <p>Outgoing events and GVT messages are appended as records (a
+    small header followed by the flat event) to a local batch for each
+    destination.  Batches are shipped with MPI_Put and the remote tail
+    counter is advanced via MPI_Fetch_and_op.  Receivers simply drain
+    their local rings without any message matching overheads.  If a
+    remote ring does not have sufficient space, the records stay in the
+    local batch and are retried on subsequent calls (so senders never
+    block).</p>
+
+    <p>This transport is selected via the <tt>--transport rma</tt>
+    command-line argument.  Agent registration, string messages, and
+    collective operations continue to use the two-sided operations in
+    the base class.</p>
+*/
+class RmaTransport : public muse::MpiTransport {
+public:
+    /** \brief Default Constructor.
+
+        The constructor merely initializes instance variables.  The
+        MPI window is created in the agentsRegistered method.
+    */
+    RmaTransport();
+
+    /** \brief Destructor
+
+        Do nothing, as the window is freed in the finalize method.
+    */
+    virtual ~RmaTransport() override;
+
+    /** \brief Consume RMA-specific command-line arguments.
+
+        This method processes the --rma-ring-size, --rma-batch-size,
+        and --rma-batch-events command-line arguments.
+
+        \param argc[in,out] The number of command line arguments.
+
+        \param argv[in,out] The actual command line arguments.
+    */
+    virtual void parseCommandLineArgs(int& argc, char* argv[]) override;
+
+    /** \brief Create the MPI window.
+
+        This method creates the MPI window with the rings for incoming
+        messages and opens a passive-target access epoch to all
+        processes.
+    */
+    virtual void agentsRegistered() override;
+
+    /** \brief Append the event to the batch for the destination
+        process.
+
+        The event is copied into the batch and consequently the
+        caller retains ownership of the event.  The batch is shipped
+        if it exceeds the batch size.  All pending batches are shipped
+        once batchEvents events have been added since the last flush,
+        so that events are not delayed for long.
+
+        \param[in] e The event to be sent.
+
+        \param[in] eventSize The size (in bytes) of the event.
+
+        \param[in] destRank The rank of the destination process.
+    */
+    virtual void sendEvent(Event* e, const int eventSize,
+                           const int destRank) override;
+
+    /** \brief Append the GVT message to the batch for the
+        destination process and ship the batch.
+
+        \param[in] msg The message to be dispatched to a remote
+        process.
+
+        \param[in] destRank The rank of the destination process.
+    */
+    virtual void sendGVTMessage(const GVTMessage *msg, const int destRank)
+        override;
+
+    /** \brief Ship the pending batches to all destinations.
+
+        This method is invoked after events are processed and on each
+        call to receive.  Records that do not fit in a remote ring
+        remain pending and are retried on subsequent calls.
+    */
+    virtual void flush() override;
+
+    /** \brief Obtain the next record from the local rings.
+
+        This method first ships any pending batches.  Next it checks
+        the rings (in a round-robin manner) for the next incoming
+        record.  If no records are pending, this method yields the
+        CPU to other processes sharing the core.
+
+        \param[out] data The flat buffer containing the message.
+
+        \param[out] size The size (in bytes) of the message.
+
+        \param[out] tag The tag (EVENT or GVT_MESSAGE) of the record.
+
+        \param[out] srcRank The rank of the sender.
+
+        \return True if a record was read from the rings.
+    */
+    virtual bool receive(char*& data, int& size, int& tag,
+                         int& srcRank) override;
+
+    /** Pre-posted receives are not used by this transport.
+
+        \param[in] count The number of pre-posted receives.  This
+        value is not used.
+
+        \param[in] maxEventSize The size of each buffer.  This value
+        is not used.
+    */
+    virtual void setRecvRing(const int count, const int maxEventSize)
+        override {
+        UNUSED_PARAM(count);
+        UNUSED_PARAM(maxEventSize);
+    }
+
+    /** \brief Report statistics about RMA operations.
+
+        \param[out] os The output stream to which the statistics are
+        to be written.
+    */
+    virtual void reportStats(std::ostream& os) override;
+
+    /** \brief Free the MPI window and finalize.
+
+        \param[in] stopMPI If this flag is true, then MPI is
+        finalized.
+    */
+    virtual void finalize(bool stopMPI) override;
+
+protected:
+    /** The header at the beginning of each ring in the window.  The
+        tail is updated by the sender and the head by the receiver.
+    */
+    struct RingHeader {
+        int64_t tail;
+        int64_t head;
+    };
+
+    /** The header for each record (event or GVT message) in a ring.
+        Records are padded to be 8-byte aligned.
+    */
+    struct RecordHeader {
+        int size;
+        int tag;
+    };
+
+    /** \brief Append a record to the batch for a given destination.
+
+        \param[in] data The flat event or GVT message to be added.
+
+        \param[in] size The size of the data in bytes.
+
+        \param[in] tag The type of record (EVENT or GVT_MESSAGE).
+
+        \param[in] destRank The destination process.
+    */
+    void addRecord(const char* data, const int size, const int tag,
+                   const int destRank);
+
+    /** \brief Ship (as much as possible) the batch for a given
+        destination process.
+
+        This method determines the space available in the remote
+        ring (refreshing the remote head if needed) and ships all the
+        complete records that fit via MPI_Put.  Next it advances the
+        remote tail via MPI_Fetch_and_op.
+
+        \param[in] destRank The destination process.
+    */
+    void flushBatch(const int destRank);
+
+    /** \brief Read the next record from a local ring.
+
+        \param[in] srcRank The process whose ring is to be checked.
+
+        \param[out] data The buffer (allocated via Event::allocate)
+        with the contents of the record.
+
+        \param[out] size The size (in bytes) of the record.
+
+        \param[out] tag The tag associated with the record.
+
+        \return True if a record was read. False if the ring was
+        empty.
+    */
+    bool readRecord(const int srcRank, char*& data, int& size, int& tag);
+
+    /** Helper to copy data out of a local ring, handling wrap-around
+        of the ring.
+
+        \param[out] dest The destination buffer.
+
+        \param[in] ring Pointer to the start of the ring data.
+
+        \param[in] offset The logical offset (modulo ring size) from
+        where data is to be copied.
+
+        \param[in] size The number of bytes to be copied.
+    */
+    void copyFromRing(char* dest, const char* ring, const int64_t offset,
+                      const int size) const;
+
+    /** Convenience method to obtain the displacement (in bytes) of a
+        ring for a given source process in the window.
+
+        \param[in] srcRank The source process.
+
+        \return The displacement of the ring header in the window.
+    */
+    inline int64_t ringDisp(const int srcRank) const {
+        return srcRank * (int64_t) (sizeof(RingHeader) + ringSize);
+    }
+
+    /** Convenience method to obtain the ring header for a given
+        source process in the local window.
+
+        \param[in] srcRank The source process.
+
+        \return Pointer to the ring header in the local window.
+    */
+    inline RingHeader* localRing(const int srcRank) const {
+        return reinterpret_cast<RingHeader*>(windowBase + ringDisp(srcRank));
+    }
+
+private:
+    /** The size (in bytes) of each ring.  This value is set via the
+        --rma-ring-size command-line argument.
+    */
+    int64_t ringSize;
+
+    /** The size (in bytes) of the batch that triggers shipping the
+        batch.  This value is set via the --rma-batch-size
+        command-line argument.
+    */
+    int batchSize;
+
+    /** The maximum number of events added to batches before all the
+        pending batches are shipped. This value bounds the delay of
+        events in batches and is set via the --rma-batch-events
+        command-line argument.  The default value of 1 disables
+        batching of events.  Batching is beneficial only if the MPI
+        implementation performs one-sided operations without
+        involving the target process.  Otherwise (e.g., Open MPI's
+        osc/rdma over shared memory) each batch shipped waits for
+        the target process to enter MPI and batching causes
+        rollback storms.
+    */
+    int batchEvents;
+
+    /** The number of events added to batches since the last time all
+        pending batches were shipped.
+    */
+    int unflushedEvents;
+
+    /** The local memory associated with the MPI window. */
+    char* windowBase;
+
+#ifdef HAVE_LIBMPI
+    /** The MPI window exposing the rings for incoming messages. */
+    MPI_Win window;
+#endif
+
+    /** The outgoing batches of records for each destination. */
+    std::vector<std::vector<char>> batches;
+
+    /** The number of bytes shipped to each destination so far. This
+        value is the same as the tail of the remote ring.
+    */
+    std::vector<int64_t> remoteTail;
+
+    /** The last known head of the remote ring at each destination.
+        This value is refreshed only if the remote ring appears full.
+    */
+    std::vector<int64_t> remoteHead;
+
+    /** The number of destinations with pending batches. */
+    int pendingBatches;
+
+    /** The next local ring to be checked for incoming messages. */
+    int nextSrc;
+
+    /** Statistics counter for the number of batches shipped. */
+    size_t numPuts;
+
+    /** Statistics counter for the number of records shipped. */
+    size_t numRecords;
+
+    /** Statistics counter for the number of times a batch could not
+        be shipped (fully) because the remote ring was full.
+    */
+    size_t numRingFull;
+};
+
+END_NAMESPACE(muse);
+
+#endif
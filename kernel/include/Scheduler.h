@@ -34,6 +34,7 @@
 #include "TwoTierHeapEventQueue.h"
 #include "ThreeTierHeapEventQueue.h"
 #include "TwoTierHeapOfVectorsEventQueue.h"
+#include "AgentDirectory.h"
 
 BEGIN_NAMESPACE(muse);
 
@@ -41,7 +42,9 @@ class Scheduler {
     friend class Simulation;
     friend class OclScheduler;
     friend class OclSimulation;
+    friend class HCCpuSimulation;
     friend class ConservativeSimulation;
+    friend class AgentMigrator;
 public:
     /** \brief Default Constructor
 
@@ -112,6 +115,73 @@ public:
         \return True if the agent was added to the scheduler.
     */
     virtual bool addAgentToScheduler(Agent *agent);
+
+    /** \brief Detach an agent and its pending events from this
+        scheduler.
+
+        This method is used to move an agent to a different scheduler
+        (see attachAgent).  Unlike removeAgentFromScheduler, the
+        agent's entry in the agent directory is retained and pending
+        events are not discarded.
+
+        \param[in] agent The agent to be detached.  The agent must
+        have been added to this scheduler.
+
+        \param[out] events The container to which the pending events
+        of the agent are added (without changing reference counts).
+
+        \return True if the agent was detached.  False if the event
+        queue used by this scheduler does not support detaching
+        agents.
+    */
+    bool detachAgent(Agent* agent, EventContainer& events) {
+        releaseHeldEvents(agent);
+        return agentPQ->detachAgent(agent, events);
+    }
+
+    /** \brief Attach an agent (detached from another scheduler) and
+        its pending events to this scheduler.
+
+        \param[in] agent The agent to be attached.  The agent must
+        have been detached via detachAgent.
+
+        \param[in,out] events The pending events of the agent.  The
+        events are moved into the event queue and the container is
+        cleared.
+    */
+    void attachAgent(Agent* agent, EventContainer& events);
+
+    /** \brief Obtain the number of events pending for an agent.
+
+        \param[in] agent The agent whose pending event count is
+        desired.
+
+        \return The number of events pending for the agent.  Zero if
+        the event queue does not track per-agent events.
+    */
+    size_t getEventCount(Agent* agent) const {
+        return agentPQ->getEventCount(agent);
+    }
+
+    /** \brief Set the directory of agents to be shared with the
+        communicator.
+
+        The directory is used to look-up agents for each event.
+        Sharing the directory with the communicator enables a single
+        look-up to obtain all the information about an agent.  This
+        method is invoked from Simulation::parseCommandLineArgs.
+
+        \note This method must be called before agents are added to
+        the scheduler.
+
+        \param[in] dir The directory to be used.  This pointer cannot
+        be NULL.
+    */
+    void setAgentDirectory(AgentDirectory* dir) {
+        ASSERT(dir != NULL);
+        ASSERT(agentDir->size() == 0);
+        agentDir = dir;
+    }
     
     /** \brief Determine the timestamp of the next top-most event in
         the scheduler.
@@ -229,6 +299,50 @@ protected:
     */
     virtual void handleFutureAntiMessage(const Event* e, Agent* agent);
 
+    /** \brief Hold back events of a conservative agent that are not
+        yet safe to process.
+
+        This method is invoked from processNextAgentEvents when the
+        next batch of events for a conservative agent (see
+        Agent::setConservative) is at or beyond getSafeTimeBound() +
+        lookahead of the agent.  The events are held in heldEvents
+        (without changing reference counts) so that other agents can
+        continue to process events optimistically.
+
+        \param[in] agent The conservative agent to which the events
+        are destined.
+
+        \param[in,out] events The events to be held back.  The
+        container is cleared by this method.
+    */
+    void holdEvents(Agent* agent, EventContainer& events);
+
+    /** \brief Return held events of conservative agents to the
+        scheduler queue.
+
+        \param[in] agent If this pointer is not NULL, then only the
+        events held for the given agent are returned.  Otherwise, the
+        events that have become safe to process (based on the current
+        value of getSafeTimeBound()) are returned.
+    */
+    void releaseHeldEvents(Agent* agent = NULL);
+
+    /** \brief Obtain the time below which events of conservative
+        agents are safe, ignoring the lookahead of the agent.
+
+        GVT alone is not sufficient, because events that were in
+        transit when GVT was computed may have been sent at a time
+        below GVT.  Consequently, this method uses the lower bound on
+        sent times of pending events reported by the GVT manager (see
+        GVTManagerBase::getSendTimeBound).  An event destined to a
+        conservative agent is safe if its receive time is below this
+        bound + the lookahead of the agent.
+
+        \return The lower bound on the sent time of events that are
+        yet to be received.
+    */
+    Time getSafeTimeBound() const;
+
     /** \brief Complete initialization of the Scheduler.
 
         Once the scheduler instance is created by
@@ -297,11 +411,18 @@ protected:
     */
     inline Time getTimeWindow() const { return timeWindow; }
     
-private:
-    /** The agentMap is used to quickly match AgentID to agent
-        pointers in the scheduler.
+protected:
+    /** The directory used to quickly match AgentID to agent pointers
+        in the scheduler.  This pointer refers to the directory shared
+        with the communicator (see setAgentDirectory) or to
+        defaultAgentDir.
+    */
+    AgentDirectory* agentDir;
+
+    /** The directory used if a shared directory has not been set via
+        setAgentDirectory.
     */
-    AgentIDAgentPointerMap agentMap;
+    AgentDirectory defaultAgentDir;
   
     /** The agentPQ is a fibonacci heap data structure, and used for
         scheduling the agents.
@@ -350,6 +471,30 @@ private:
 
     void printTrainingData(muse::Agent* agent, const muse::Event* const event);
 
+    /** The events of a conservative agent held back by the scheduler
+        until they are safe to process (see holdEvents).
+    */
+    struct HeldEvents {
+        /// The conservative agent to which the events are destined.
+        Agent* agent;
+        /// The lowest receive time of the held events.
+        Time minTime;
+        /// The held events in no specific order.
+        EventContainer events;
+    };
+
+    /** The events held back for conservative agents.  There is at
+        most one entry per agent.  This list is typically short as
+        only a few agents are conservative.
+    */
+    std::vector<HeldEvents> heldEvents;
+
+    /** The value of getSafeTimeBound() at which held events were
+        last checked by releaseHeldEvents.  Held events can become
+        safe only when this bound advances.
+    */
+    Time heldBound;
+
 };
 
 END_NAMESPACE(muse);
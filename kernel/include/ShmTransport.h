@@ -0,0 +1,453 @@
+#ifndef MUSE_SHM_TRANSPORT_H
+#define MUSE_SHM_TRANSPORT_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <sys/types.h>
+#include "Transport.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** Transport that uses POSIX shared memory between processes on a
+    single machine, without using MPI.
+
+    <p>This transport is selected via the <tt>--transport shm</tt>
+    command-line argument.  The number of processes is specified via
+    the <tt>--shm-procs</tt> command-line argument.  The first process
+    (rank 0) creates a shared memory segment (via shm_open) and then
+    forks the remaining processes.  Consequently, a parallel
+    simulation is run by simply starting one process -- that is,
+    without mpirun.</p>
+
+    <p>The shared memory segment contains a small control block (used
+    for barriers and reductions) followed by one ring buffer for each
+    ordered pair of processes.  Only one process writes to a given
+    ring and only one process reads from it. Hence, the rings are
+    lock-free, single-producer, single-consumer (SPSC) queues that
+    use just two atomic counters -- tail (bytes written) and head
+    (bytes consumed).  Each message is stored as a record, that is, a
+    small header followed by the flat event or GVT message.</p>
+
+    <p>Senders never block on events or GVT messages: if a ring does
+    not have sufficient space, the records are held in a local
+    backlog and shipped on subsequent calls.  Records that are read
+    while searching for a specific message (for example, a string
+    with a given tag) are stashed and delivered later in order.</p>
+*/
+class ShmTransport : public muse::Transport {
+public:
+    /** \brief Default Constructor.
+
+        The constructor merely initializes instance variables.  The
+        shared memory segment is created in the initialize method.
+    */
+    ShmTransport();
+
+    /** \brief Destructor
+
+        Do nothing, as the shared memory is released in finalize.
+    */
+    virtual ~ShmTransport() override;
+
+    /** \brief Create the shared memory segment and fork processes.
+
+        This method processes the --shm-procs and --shm-ring-size
+        command-line arguments (without consuming them), creates the
+        shared memory segment, and forks the remaining processes.
+
+        \param[in] argc The number of command-line arguments.
+
+        \param[in] argv The command-line arguments.
+
+        \param[in] initialize If false and the shared memory segment
+        has already been setup, then it is reused.
+
+        \return The rank of this process.
+    */
+    virtual int initialize(int argc, char* argv[], bool initialize) override;
+
+    /** \brief Consume the --shm-procs and --shm-ring-size
+        command-line arguments.
+
+        \param argc[in,out] The number of command line arguments.
+
+        \param argv[in,out] The actual command line arguments.
+    */
+    virtual void parseCommandLineArgs(int& argc, char* argv[]) override;
+
+    /** Obtain the rank of this process.
+
+        \return The rank of this process.
+    */
+    virtual int getRank() const override { return myRank; }
+
+    /** Obtain the number of processes.
+
+        \return The number of processes sharing the segment.
+    */
+    virtual int getNumProcesses() const override { return numProcs; }
+
+    /** \brief Send the ranges of local agents to all the processes
+        and build the full map of agents to owners.
+
+        \param[in] localRanges The ranges of agents on this process.
+
+        \param[out] ownerMap The map to be populated.
+    */
+    virtual void allGatherAgentRanges(const std::vector<AgentID>& localRanges,
+                                      AgentRangeMap& ownerMap) override;
+
+    /** \brief Copy an event into the ring to the destination process.
+
+        \param[in] e The event to be sent.  The event is copied and
+        the caller retains ownership.
+
+        \param[in] eventSize The size (in bytes) of the event.
+
+        \param[in] destRank The rank of the destination process.
+    */
+    virtual void sendEvent(Event* e, const int eventSize,
+                           const int destRank) override;
+
+    /** \brief Copy a GVT message into the ring to the destination
+        process.
+
+        \param[in] msg The GVT message to be sent.
+
+        \param[in] destRank The rank of the destination process.
+    */
+    virtual void sendGVTMessage(const GVTMessage* msg,
+                                const int destRank) override;
+
+    /** \brief Copy a string into the ring to the destination process.
+
+        Unlike events, this method waits until the string has been
+        copied into the ring so that strings are not lost if this
+        process finishes right after this call.
+
+        \param[in] str The string to be sent.
+
+        \param[in] destRank The rank of the destination process.
+
+        \param[in] tag The tag associated with the string.
+    */
+    virtual void sendString(const std::string& str, const int destRank,
+                            const int tag) override;
+
+    /** \brief Receive the next event or GVT message.
+
+        \param[out] data The flat buffer containing the message.
+
+        \param[out] size The size (in bytes) of the message.
+
+        \param[out] tag The tag associated with the message.
+
+        \param[out] srcRank The rank of the sender.
+
+        \return True if a message was received.
+    */
+    virtual bool receive(char*& data, int& size, int& tag,
+                         int& srcRank) override;
+
+    /** \brief Receive a string sent via sendString.
+
+        \param[out] recvRank The actual rank from where the message
+        was received.
+
+        \param[in] srcRank The rank from where the string is to be
+        read (negative value for any process).
+
+        \param[in] tag The tag associated with the string.
+
+        \param[in] blocking If true, this method waits for a string.
+
+        \return The string received (if any).
+    */
+    virtual std::string receiveString(int& recvRank, const int srcRank,
+                                      const int tag,
+                                      const bool blocking) override;
+
+    /** \brief Wait (spinning) until all processes reach the barrier.
+     */
+    virtual void barrier() override;
+
+    /** \brief Compute global minimum via the shared control block.
+
+        \param[in] value The local value to be used.
+
+        \return The global minimum of the values from all processes.
+    */
+    virtual Time allReduceMin(const Time value) override;
+
+    /** \brief Compute global sum via the shared control block.
+
+        \param[in] value The local value to be used.  The values are
+        exchanged as Time (double) values and are exact up to 2^53.
+
+        \return The global sum of the values from all processes.
+    */
+    virtual long allReduceSum(const long value) override;
+
+    /** \brief Compute element-wise global sums via the shared control
+        block.
+
+        Each process publishes its whole vector into its row of the
+        reduction area in the control block.  After one barrier every
+        process sums the columns, and a second barrier releases the
+        area for reuse (similar to a single MPI_Allreduce).  Vectors
+        longer than reduceSize are reduced in chunks of reduceSize
+        entries.
+
+        \param[in,out] values The local values to be used.  On return,
+        each entry is the global sum of the corresponding entries.
+    */
+    virtual void allReduceSum(std::vector<Time>& values) override;
+
+    /** \brief Report statistics about the shared memory rings.
+
+        \param[out] os The output stream to which the statistics are
+        to be written.
+    */
+    virtual void reportStats(std::ostream& os) override;
+
+    /** \brief Release the shared memory and wait for forked processes.
+
+        \param[in] stop If this flag is true, the shared memory is
+        unmapped and rank 0 waits for the other processes to finish.
+    */
+    virtual void finalize(bool stop) override;
+
+protected:
+    /** The control block at the beginning of the shared memory
+        segment.  The reduction area, numProcs rows of reduceSize
+        values, immediately follows this structure.
+    */
+    struct ShmControl {
+        alignas(64) std::atomic<int> barrierCount;
+        std::atomic<int> barrierGeneration;
+    };
+
+    /** The header at the beginning of each ring.  The tail is updated
+        by the sender and the head by the receiver.  They are placed
+        on different cache lines to avoid false sharing.
+    */
+    struct RingHeader {
+        alignas(64) std::atomic<int64_t> tail;
+        alignas(64) std::atomic<int64_t> head;
+    };
+
+    /** The header for each record in a ring.  Records are padded to
+        be 8-byte aligned.
+    */
+    struct RecordHeader {
+        int size;
+        int tag;
+    };
+
+    /** A record that was read from a ring but not yet delivered. */
+    struct Message {
+        int srcRank;
+        int tag;
+        int size;
+        char* data;
+    };
+
+    /** \brief Process the command-line arguments for this transport.
+
+        \param argc[in,out] The number of command line arguments.
+
+        \param argv[in,out] The actual command line arguments.
+    */
+    void parseArgs(int& argc, char* argv[]);
+
+    /** \brief Send a record to a given process.
+
+        The record is directly copied into the ring if there is no
+        backlog and the ring has sufficient space. Otherwise it is
+        appended to the backlog for the destination.
+
+        \param[in] data The data to be sent.
+
+        \param[in] size The size (in bytes) of the data.
+
+        \param[in] tag The tag associated with the record.
+
+        \param[in] destRank The destination process.
+    */
+    void sendRecord(const char* data, const int size, const int tag,
+                    const int destRank);
+
+    /** \brief Copy a record directly into the ring to a given process.
+
+        \return True if the record was written. False if the ring did
+        not have sufficient space.
+    */
+    bool writeRecord(const char* data, const int size, const int tag,
+                     const int destRank);
+
+    /** \brief Ship as many records from the backlog (for a given
+        destination) as would fit in the ring.
+
+        \param[in] destRank The destination process.
+    */
+    void flushBacklog(const int destRank);
+
+    /** \brief Try to ship backlogs to all the processes. */
+    void flushBacklogs();
+
+    /** \brief Read the next record from the ring from a given process.
+
+        \param[in] srcRank The process whose ring is to be checked.
+
+        \param[out] msg The record read from the ring.  Events and GVT
+        messages are allocated via Event::allocate while other
+        records are allocated via new[].
+
+        \return True if a record was read.
+    */
+    bool readRecord(const int srcRank, Message& msg);
+
+    /** \brief Find (and optionally wait for) the next record with a
+        given tag.
+
+        Records with other tags that are read in the process are
+        stashed for later delivery.
+
+        \param[in] srcRank The process from where the record is to be
+        read.  A negative value indicates any process.
+
+        \param[in] tag The tag of the record to be read.
+
+        \param[in] blocking If true, this method waits for a record.
+
+        \param[out] msg The record that was read.
+
+        \return True if a record was read.
+    */
+    bool receiveTagged(const int srcRank, const int tag,
+                       const bool blocking, Message& msg);
+
+    /** \brief Release the buffer associated with a record.
+
+        \param[in] msg The record whose buffer is to be released.
+    */
+    void releaseMessage(Message& msg);
+
+    /** Obtain the ring to which srcRank writes and destRank reads.
+
+        \param[in] srcRank The process that writes to the ring.
+
+        \param[in] destRank The process that reads from the ring.
+
+        \return Pointer to the header of the ring.
+    */
+    inline RingHeader* getRing(const int srcRank, const int destRank) const {
+        return reinterpret_cast<RingHeader*>(ringBase + (destRank * numProcs +
+                                                         srcRank) * ringStride);
+    }
+
+    /** Helper to copy data into a ring, handling wrap-around. */
+    void copyToRing(RingHeader* ring, int64_t offset, const char* src,
+                    const int size) const;
+
+    /** Helper to copy data out of a ring, handling wrap-around. */
+    void copyFromRing(char* dest, const RingHeader* ring, int64_t offset,
+                      const int size) const;
+
+    /** Determine if a tag corresponds to events or GVT messages. */
+    static inline bool isEventTag(const int tag) {
+        return (tag == EVENT) || (tag == LARGE_EVENT) ||
+            (tag == GVT_MESSAGE);
+    }
+
+private:
+    /** The rank of this process. */
+    int myRank;
+
+    /** The number of processes (set via --shm-procs). */
+    int numProcs;
+
+    /** The size (in bytes) of each ring (set via --shm-ring-size). */
+    int64_t ringSize;
+
+    /** The size (in bytes) of each ring including its header. */
+    int64_t ringStride;
+
+    /** The total size of the shared memory segment. */
+    size_t segmentSize;
+
+    /** The starting address of the shared memory segment. */
+    char* segment;
+
+    /** Convenience pointer to the control block in the segment. */
+    ShmControl* control;
+
+    /** Convenience pointer to the values used for reductions. */
+    Time* reduceValues;
+
+    /** The number of values each process can publish in the
+        reduction area.  This is numProcs * numProcs, the largest
+        vector reduced by the kernel (the lookahead matrix used by
+        conservative simulations).
+    */
+    size_t reduceSize;
+
+    /** The starting address of the first ring in the segment. */
+    char* ringBase;
+
+    /** The process IDs of the processes forked by rank 0. */
+    std::vector<pid_t> childPids;
+
+    /** The records (for each destination) that did not fit in the
+        ring and are yet to be shipped.
+    */
+    std::vector<std::vector<char>> backlogs;
+
+    /** The number of destinations with pending backlogs. */
+    int pendingBacklogs;
+
+    /** The last known head of the ring to each destination.  This
+        value is refreshed only when the ring appears full.
+    */
+    std::vector<int64_t> cachedHead;
+
+    /** Records read from rings but not yet delivered. */
+    std::deque<Message> stash;
+
+    /** The next ring to be checked for incoming messages. */
+    int nextSrc;
+
+    /** Statistics counter for the number of records sent. */
+    size_t numRecords;
+
+    /** Statistics counter for the number of records that had to be
+        held in backlog because a ring was full.
+    */
+    size_t numRingFull;
+};
+
+END_NAMESPACE(muse);
+
+#endif
@@ -22,6 +22,7 @@
 //
 //---------------------------------------------------------------------------
 
+#include <vector>
 #include "DataTypes.h"
 #include "GVTManagerBase.h"
 #include "ConservativeSimulation.h"
@@ -31,16 +32,104 @@ BEGIN_NAMESPACE(muse)
 class SimpleGVTManager: public GVTManagerBase {
     // Allow ConservativeSimulation to call protected members
     friend class ConservativeSimulation;
+    // The multi-threaded conservative kernel (cmb-mt) combines the
+    // windows of all the threads on a process.
+    friend class MultiThreadedSimulation;
+    friend class MultiThreadedSimulationManager;
 public:
     void initialize(const Time &startTime, Communicator *comm) override;
     bool sendRemoteEvent(Event *event) override;
     inline Time getGVT() override;
     void forceUpdateGVT() override;
     void inspectRemoteEvent(Event *event) override;
+
+    /** Override base class method as the rank is always the MPI rank
+        for this manager.  The events sent to each process (rather
+        than each thread) are tracked for computing windows.
+
+        \param[in] thrRank The thread-based rank (unused).
+    */
+    void setThreadedRank(const int thrRank) override {
+        UNUSED_PARAM(thrRank);
+    }
+
+    /** Override base class method as this manager does not use any
+        control messages.  This method is called by
+        MultiThreadedSimulation::processIncomingEvents.
+    */
+    void checkWaitingCtrlMsg() override {}
 protected:
     SimpleGVTManager(Simulation *sim);
+
+    /** Compute GVT for the next window of safe events (YAWNS).
+
+        This method performs a single collective operation that
+        computes GVT as the minimum of the LGVT values and the
+        timestamps of events sent since the previous window (which
+        may still be in transit).  The same collective also informs
+        each process of the number of events sent to it, so that it
+        can receive all of them before processing the window (see
+        hasEventsInTransit).  Events in the window [GVT, GVT +
+        lookahead) can then be processed without further
+        synchronization.
+    */
+    void updateWindow();
+
+    /** Add the information from this manager needed to compute the
+        next window.
+
+        This is a refactored helper method used by updateWindow.  It
+        is also used by MultiThreadedSimulationManager to combine the
+        information from all the threads on a process prior to a
+        single collective operation.
+
+        \param[in,out] values The list of 2 * numProcesses values (see
+        updateWindow).  The number of events sent by this manager to
+        each process are added to the first numProcesses entries.  The
+        entry at numProcesses + rank is set to the minimum of its
+        current value and the lower bound for this manager.  The
+        caller must initialize this entry to TIME_INFINITY.
+    */
+    void addWindowInfo(std::vector<Time>& values);
+
+    /** Set GVT for the next window from the reduced values.
+
+        \param[in] values The list of 2 * numProcesses values after
+        the sum-reduction across all processes.
+    */
+    void setWindow(const std::vector<Time>& values);
+
+    /** Determine if events sent to this process prior to the last
+        call to updateWindow are yet to be received.
+
+        \return True if more events are yet to be received.
+    */
+    bool hasEventsInTransit() const { return eventsRecvd < expectedRecvd; }
+
 private:
     void allReduceLGVTAndUpdateGVT();
+
+    /** The number of events sent to each process.  This list is used
+        only by updateWindow.
+    */
+    std::vector<long> sentTo;
+
+    /** The minimum timestamp of events sent since the last call to
+        updateWindow.
+    */
+    Time minSentTime = TIME_INFINITY;
+
+    /** The total number of events sent to this process by all other
+        processes as of the last call to updateWindow.
+    */
+    long expectedRecvd = 0;
+
+    /** The number of events sent to and received from other
+        processes.  These counters are used to detect events in
+        transit when all processes have run out of events (see
+        allReduceLGVTAndUpdateGVT).
+    */
+    long eventsSent = 0, eventsRecvd = 0;
 };
 
 END_NAMESPACE(muse)
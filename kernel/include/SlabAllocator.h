@@ -0,0 +1,484 @@
+#ifndef MUSE_SLAB_ALLOCATOR_H
+#define MUSE_SLAB_ALLOCATOR_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "DataTypes.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** A per-thread, size-class based slab allocator for events.
+
+    <p>This class is used as a thread-local object in EventRecycler
+    to allocate and recycle the flat buffers used for events, with or
+    without NUMA-awareness.  It replaces the unordered maps of stacks
+    (keyed by exact size in bytes) previously used by EventRecycler
+    and NumaMemoryManager for events.  Key aspects of this allocator
+    are:</p>
+
+    <ul>
+
+    <li>Requested sizes are rounded up to one of a fixed set of size
+    classes -- multiples of 16 bytes up to 64 bytes, and then 4
+    classes for each power of two up to MaxChunkSize.  Hence, the
+    size class of a request is computed with a few bit operations
+    instead of a hash lookup, and at most 25% of a chunk is
+    unused.</li>
+
+    <li>Chunks are carved (with a bump pointer) out of large slabs of
+    memory.  Each thread has one heap for non-NUMA memory and one
+    heap for each NUMA node.  Slabs for NUMA heaps are allocated on
+    the corresponding NUMA node (similar to the blocks previously
+    used by NumaMemoryManager).</li>
+
+    <li>Each chunk is preceded by a small header that records the
+    thread that owns the chunk, its heap, and its size class.  Hence
+    chunks can be deallocated without knowing their size.</li>
+
+    <li>Free chunks are recycled via intrusive singly-linked free
+    lists (the link is stored in the free chunk itself) -- one for
+    each heap and size class.  These lists serve as the thread's
+    magazines from which allocations are satisfied without any
+    locks or atomic operations.</li>
+
+    <li>Chunks deallocated by a thread other than the owner (which is
+    common when events are shared between threads) are accumulated
+    into a batch for the owner.  Full batches are pushed onto the
+    owner's lock-free inbox with a single compare-and-swap.  The
+    owner drains its inbox (with a single exchange) when a free list
+    runs empty.  Hence memory returns to the thread (and the NUMA
+    node) from which it was allocated.</li>
+
+    </ul>
+
+    \note Requests larger than MaxChunkSize are rare and are directly
+    allocated and freed.
+*/
+class SlabAllocator {
+public:
+    /** The default constructor.
+
+        The constructor does not allocate any memory.  Slabs are
+        allocated on demand.
+    */
+    SlabAllocator();
+
+    /** The destructor.
+
+        The destructor releases all the slabs owned by this allocator,
+        including slabs adopted from other threads via moveSlabsTo.
+    */
+    ~SlabAllocator();
+
+    /** Set the size of slabs allocated by this allocator.
+
+        \param[in] size The size (in bytes) of each slab.  The size is
+        rounded up to be at least twice the largest chunk.  Existing
+        slabs are not affected.
+    */
+    void setSlabSize(const size_t size);
+
+    /** Set the default size of slabs for allocators created
+        subsequently.
+
+        This method is used to set the size of the arena for events
+        via the \c --event-arena-size command-line argument.  It must
+        be called before threads are created.
+
+        \param[in] size The default size (in bytes) of each slab.
+    */
+    static void setDefaultSlabSize(const size_t size) {
+        defaultSlabSize = size;
+    }
+
+    /** Obtain the default size of slabs.
+
+        \return The default size (in bytes) of each slab.
+    */
+    static size_t getDefaultSlabSize() { return defaultSlabSize; }
+
+    /** Obtain a chunk of memory of at least the given size.
+
+        \param[in] size The size (in bytes) of the memory to be
+        allocated.
+
+        \param[in] numaID The NUMA node from which the memory is to be
+        allocated.  If this value is -1, then memory is not bound to
+        any specific NUMA node.
+
+        \return A pointer to memory of at least the given size.  The
+        pointer is suitably aligned for events.  This method never
+        returns NULL.
+    */
+    char* allocate(const int size, const int numaID = -1);
+
+    /** Recycle a chunk previously obtained from allocate.
+
+        This method can be called from any thread.  If the calling
+        thread owns the chunk, then the chunk is added to its free
+        list.  Otherwise, the chunk is added to the batch of chunks to
+        be returned to the owner.
+
+        \param[in] mem The memory previously returned by a call to
+        allocate (on any thread).  This pointer cannot be NULL.
+    */
+    void deallocate(char* mem);
+
+    /** Return all batches of chunks deallocated by this thread to
+        their owners, even if the batches are not full.
+
+        This method is called at the end of simulation so that chunks
+        are not held up in partial batches.
+    */
+    void flushRemoteFrees();
+
+    /** Release all the slabs if none of their chunks are in use.
+
+        This method is called at the end of simulation (after all
+        events have been deallocated) to free up memory.  Chunks
+        returned by other threads are first reclaimed.  If any chunk
+        is still in use (for example, by events that are yet to be
+        deallocated), then no slabs are released.
+
+        \return True if all the slabs were released.
+    */
+    bool releaseSlabs();
+
+    /** Move all the slabs owned by this allocator to another
+        allocator.
+
+        This method is called from MultiThreadedSimulation::simulate()
+        at the end of simulation (just before threads finish) to move
+        slabs to the main thread's allocator.  This is done because
+        the memory cannot be released until all agents have been
+        finalized and their events have been reclaimed.  Chunks owned
+        by this allocator that are deallocated later are returned to
+        the main allocator.
+
+        \param[in,out] mainAlloc The allocator on the main thread that
+        adopts the slabs.
+    */
+    void moveSlabsTo(SlabAllocator& mainAlloc);
+
+    /** Method to print internal statistics.
+
+        \return A string containing statistics informaton that can be
+        readily printed.
+    */
+    std::string getStats() const;
+
+    /** The largest chunk (in bytes) served from slabs.  Larger
+        requests are directly allocated.
+    */
+    static constexpr int MaxChunkSize = 16384;
+
+    /** The number of chunks accumulated for a remote owner before
+        they are returned to the owner as a batch.
+    */
+    static constexpr int BatchSize = 64;
+
+    /** The maximum number of threads that can own chunks over the
+        lifetime of a process.
+    */
+    static constexpr int MaxOwners = 1024;
+
+protected:
+    /** The number of size classes for chunks up to MaxChunkSize. */
+    static constexpr int NumClasses = 36;
+
+    /** The size class recorded in the header of big chunks. */
+    static constexpr int LargeClass = 255;
+
+    /** The header stored just before each chunk.  The header is
+        aligned as muse::Time so that chunks are suitably aligned for
+        events.
+    */
+    struct alignas(alignof(muse::Time)) ChunkHeader {
+        /// The ID of the allocator that carved out this chunk.
+        uint16_t owner;
+        /// The heap (0 for non-NUMA, or NUMA node + 1) of the chunk.
+        uint8_t heap;
+        /// The size class of the chunk.  LargeClass for big chunks.
+        uint8_t sizeClass;
+        /// The size (in bytes) of the allocation for big chunks.
+        uint32_t largeSize;
+    };
+
+    /** The link stored in free chunks (just after the header) to
+        form intrusive free lists and batches.
+    */
+    struct FreeChunk {
+        /// The next free chunk in the list.
+        FreeChunk* next;
+    };
+
+    /** The free lists and slab being carved for a NUMA node (or
+        non-NUMA memory).
+    */
+    struct Heap {
+        /// The NUMA node for the heap, or -1 for non-NUMA memory.
+        int numaID;
+        /// The free list for each size class.
+        std::vector<FreeChunk*> freeList;
+        /// The current position in the slab being carved.
+        char* current;
+        /// The number of bytes available in the current slab.
+        size_t avail;
+    };
+
+    /** Information about a slab used to release it. */
+    struct Slab {
+        /// The starting address of the slab.
+        char* start;
+        /// The size of the slab in bytes.
+        size_t size;
+        /// The NUMA node of the slab, or -1 for non-NUMA memory.
+        int numaID;
+        /// Flag to indicate the slab was mapped by HugePageAllocator.
+        bool mapped;
+    };
+
+    /** A batch of chunks being accumulated for a remote owner. */
+    struct Batch {
+        /// The first chunk in the batch.
+        FreeChunk* head;
+        /// The last chunk in the batch.
+        FreeChunk* tail;
+        /// The number of chunks in the batch.
+        int count;
+    };
+
+    /** The lock-free inbox to which batches of chunks are returned to
+        an owner.  Each inbox is on its own cache-line.
+    */
+    struct alignas(64) Inbox {
+        /// The first chunk of the list of returned chunks.
+        std::atomic<FreeChunk*> head;
+        /// The ID of the allocator to which this owner's chunks are
+        /// now returned (changed by moveSlabsTo).
+        std::atomic<int> forward;
+    };
+
+    /** Compute the size class for a given size.
+
+        \param[in] size The size in bytes.  This value must be in the
+        range 1 to MaxChunkSize.
+
+        \return The zero-based size class.
+    */
+    static inline int getSizeClass(const int size) {
+        if (size <= 64) {
+            return (size - 1) >> 4;
+        }
+        // Four classes for each power of two above 64.
+        const int log2   = 31 - __builtin_clz(size - 1);
+        const int offset = (size - 1 - (1 << log2)) >> (log2 - 2);
+        return 4 + ((log2 - 6) << 2) + offset;
+    }
+
+    /** Compute the size (in bytes) of chunks in a size class.
+
+        \param[in] sizeClass The zero-based size class.
+
+        \return The size of chunks in the size class.
+    */
+    static inline int getClassSize(const int sizeClass) {
+        if (sizeClass < 4) {
+            return (sizeClass + 1) << 4;
+        }
+        const int log2 = ((sizeClass - 4) >> 2) + 6;
+        return (1 << log2) + ((((sizeClass - 4) & 3) + 1) << (log2 - 2));
+    }
+
+    /** Obtain the header for a chunk. */
+    static inline ChunkHeader* getHeader(char* mem) {
+        return reinterpret_cast<ChunkHeader*>(mem - sizeof(ChunkHeader));
+    }
+
+    /** Obtain a heap, creating heaps if needed.
+
+        \param[in] heapIdx The index of the heap, that is, the NUMA
+        node + 1 (or 0 for non-NUMA memory).
+
+        \return The heap at the given index.
+    */
+    inline Heap& getHeap(const int heapIdx) {
+        if (heapIdx >= (int) heaps.size()) {
+            addHeaps(heapIdx);
+        }
+        return heaps[heapIdx];
+    }
+
+    /** Add heaps up to (and including) a given index.
+
+        \param[in] heapIdx The index of the last heap to be added.
+    */
+    void addHeaps(const int heapIdx);
+
+    /** Assign an ID (and an inbox) to this allocator. */
+    void registerOwner();
+
+    /** Carve out a new chunk from the current slab of a heap,
+        allocating a new slab if needed.
+
+        \param[in] heapIdx The index of the heap.
+
+        \param[in] sizeClass The size class of the chunk.
+
+        \return The new chunk (just after its header).
+    */
+    char* carve(const int heapIdx, const int sizeClass);
+
+    /** Move chunks returned by other threads to the free lists.
+
+        \return The number of chunks reclaimed.
+    */
+    size_t drainInbox();
+
+    /** Push a list of chunks onto the inbox of an owner.
+
+        \param[in] owner The ID of the owner (after forwarding).
+
+        \param[in] head The first chunk in the list.
+
+        \param[in] tail The last chunk in the list.
+    */
+    static void pushToInbox(int owner, FreeChunk* head, FreeChunk* tail);
+
+    /** Determine the current owner of chunks carved by an allocator.
+
+        \param[in] owner The ID in the chunk's header.
+
+        \return The ID of the allocator to which the chunk must be
+        returned.
+    */
+    static int resolveOwner(int owner);
+
+    /** Allocate a large chunk directly.
+
+        \param[in] size The size requested.
+
+        \param[in] numaID The NUMA node or -1 for non-NUMA memory.
+    */
+    char* allocateLarge(const int size, const int numaID);
+
+    /** Allocate memory, on a NUMA node if specified. */
+    static char* allocateMemory(const size_t size, const int numaID);
+
+    /** Free memory allocated via allocateMemory. */
+    static void freeMemory(char* mem, const size_t size, const int numaID);
+
+    /** Allocate a new slab for a given heap and make it the current
+        slab of the heap.  Slabs are backed by huge pages if enabled
+        via HugePageAllocator.
+
+        \param[in,out] heap The heap for which a slab is needed.
+    */
+    void addSlab(Heap& heap);
+
+    /** Free a slab allocated by the addSlab method.
+
+        \param[in] slab The slab to be freed.
+    */
+    static void freeSlab(const Slab& slab);
+
+private:
+    /** The ID of this allocator (the index of its inbox).  It is -1
+        until the first slab is allocated.
+    */
+    int ownerID;
+
+    /** The size (in bytes) of the slabs allocated by this allocator. */
+    size_t slabSize;
+
+    /** The heaps for non-NUMA memory (at index 0) and each NUMA node
+        (NUMA node i at index i + 1).
+    */
+    std::vector<Heap> heaps;
+
+    /** The slabs owned by this allocator.  Access to this list is
+        serialized via slabMutex as other threads may add slabs to it
+        in moveSlabsTo.
+    */
+    std::vector<Slab> slabs;
+
+    /** Batches of chunks to be returned to each remote owner,
+        indexed by the owner's ID.
+    */
+    std::vector<Batch> batches;
+
+    /** The number of chunks owned by this allocator that are
+        currently in use.  This value can be negative when adopted
+        chunks are deallocated.
+    */
+    long liveChunks;
+
+    /** The number of chunks in use adopted from other allocators via
+        moveSlabsTo.
+    */
+    std::atomic<long> adoptedChunks;
+
+    /** The number of calls to the allocate method. */
+    size_t allocCalls;
+
+    /** The number of calls to the deallocate method. */
+    size_t deallocCalls;
+
+    /** The number of allocations satisfied by recycling a chunk. */
+    size_t recycleHits;
+
+    /** The number of chunks returned to other threads. */
+    size_t remoteFrees;
+
+    /** The number of chunks returned to this thread by others. */
+    size_t remoteReclaims;
+
+    /** The total number of bytes in slabs allocated by this
+        allocator.
+    */
+    size_t slabBytes;
+
+    /** The number of bytes in slabs backed by huge pages. */
+    size_t hugeBytes;
+
+    /** The default size of slabs for new allocators. */
+    static size_t defaultSlabSize;
+
+    /** The inboxes (and forwarding information) for each owner. */
+    static Inbox inboxes[MaxOwners];
+
+    /** The number of owner IDs assigned so far. */
+    static std::atomic<int> ownerCount;
+
+    /** Mutex to serialize changes to the list of slabs. */
+    static std::mutex slabMutex;
+};
+
+END_NAMESPACE(muse);
+
+#endif
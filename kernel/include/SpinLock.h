@@ -81,6 +81,81 @@ public:
     }
 };
 
+/** A writer-preferring reader-writer spin lock.
+
+    This lock is used to let many threads operate concurrently (each
+    holding a shared lock) while occasionally one thread needs
+    exclusive access (for example, to compute GVT while no events are
+    being processed).  C++11 does not provide std::shared_mutex and
+    hence this class provides the minimal API needed.  Once a thread
+    requests an exclusive lock, new shared lock requests wait so that
+    the exclusive lock is not starved.
+
+    \note Similar to SpinLock, threads spin-wait and are not
+    suspended.  Shared locks are not recursive.
+*/
+class SharedSpinLock {
+private:
+    /** The number of threads currently holding a shared lock.
+        Note that operations on readers and writer use the default
+        (sequentially consistent) ordering as each thread stores to
+        one and then loads the other. */
+    mutable std::atomic<int> readers;
+
+    /** Flag set by a thread that holds (or is waiting to hold) an
+        exclusive lock. */
+    mutable std::atomic<bool> writer;
+
+public:
+    /** The only constructor for the lock.  The lock is initialized
+        to the 'unlocked' state.
+    */
+    SharedSpinLock() : readers(0), writer(false) {}
+
+    /** Obtain an exclusive lock.
+
+        This method first blocks out new shared locks and then waits
+        for all existing shared locks to be released.
+    */
+    inline void lock() const {
+        while (writer.exchange(true)) {
+            /* busy-wait for other writer */
+        }
+        while (readers.load() > 0) {
+            /* busy-wait for readers to drain */
+        }
+    }
+
+    /** Release an exclusive lock obtained via lock(). */
+    inline void unlock() const {
+        writer.store(false, std::memory_order_release);
+    }
+
+    /** Obtain a shared lock.
+
+        This method waits while an exclusive lock is held or has been
+        requested.
+    */
+    inline void lock_shared() const {
+        while (true) {
+            while (writer.load(std::memory_order_acquire)) {
+                /* busy-wait for writer to finish */
+            }
+            readers.fetch_add(1);
+            if (!writer.load()) {
+                return;  // Got shared lock.
+            }
+            // A writer snuck in. Back-off and retry.
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    /** Release a shared lock obtained via lock_shared(). */
+    inline void unlock_shared() const {
+        readers.fetch_sub(1, std::memory_order_release);
+    }
+};
+
 END_NAMESPACE(muse);
 
 #endif
@@ -59,6 +59,7 @@ using StateRecycleMap = std::unordered_map<int, std::stack<char*>>;
 */
 class StateRecycler {
     friend class MultiThreadedSimulation;
+    friend class MultiThreadedShmSimulation;
 public:
     /** Setup NUMA-aware memory management.
 
@@ -78,6 +79,16 @@ public:
     */
     static void setup(bool enableNuma, int numaNodeID);
 
+    /** Set the size of NUMA memory blocks (arenas) used for states.
+
+        This method is used to set the size via the \c
+        --state-arena-size command-line argument.  It must be called
+        before the setup method.
+
+        \param[in] size The size (in bytes) of each arena.
+    */
+    static void setArenaSize(const int size) { arenaSize = size; }
+
     /** Allocate a block of memory for creating/storing state.
 
         This method is called from operator new in muse::State.  This
@@ -168,6 +179,11 @@ protected:
         is updated in the setup() method in this class.
      */
     thread_local static int numaID;
+
+    /** The size (in bytes) of NUMA memory blocks for states.  The
+        default is 32 KiB.
+    */
+    static int arenaSize;
     
 #if USE_NUMA == 1
     /** A thread-local NUMA memory manager for managing memory in a
@@ -203,6 +203,31 @@ public:
         to be removed from the vector managed by this class.
     */
     void removeAgent(muse::Agent* agent) override;
+
+    /** Detach an agent along with its pending events.
+
+        This method implements the corresponding API method in the
+        base class.  The agent is removed from the heap of agents and
+        the events in its tier-2 buckets are added to the supplied
+        container without changing reference counts.
+
+        \param[in,out] agent The agent to be detached.
+
+        \param[out] events The container to which pending events are
+        added.
+
+        \return This method always returns true.
+    */
+    bool detachAgent(muse::Agent* agent, muse::EventContainer& events) override;
+
+    /** Obtain the number of pending events for a given agent.
+
+        \param[in] agent The agent whose pending event count is
+        desired.
+
+        \return The number of events in the agent's tier-2 buckets.
+    */
+    size_t getEventCount(muse::Agent* agent) const override;
     
     /** Determine if the event queue is empty.
         
@@ -26,6 +26,8 @@
 
 
 #include <vector>
+#include <deque>
+#include <mutex>
 #include <stack>
 #include <algorithm>
 #include "Avg.h"
@@ -119,11 +121,11 @@ public:
         return recvTime;
     }
     
-    inline const std::vector<muse::Event*> getEventList() const {
+    inline const std::vector<muse::Event*>& getEventList() const {
         return eventList;
     }
 
-    inline std::vector<muse::Event*> getEventList() {
+    inline std::vector<muse::Event*>& getEventList() {
         return eventList;
     }
     
@@ -268,7 +270,9 @@ public:
      * This agent must be returned back into the queue when processing of it is
      * done via EventQueue::returnAgent(). 
      * 
-     * @return the next agent to be processed by the sim
+     * @return the next agent to be processed by the sim.  This value
+     * is NULL if all agents are currently being processed by other
+     * threads.
      */
     muse::Agent* popNextAgent();
 
@@ -372,6 +376,54 @@ public:
     */
     virtual int eraseAfter(muse::Agent* dest, const muse::AgentID sender,
                            const muse::Time sentTime);
+
+    /** Dequeue all events canceled by a given anti-message.
+
+        This method is similar to the sender/sentTime version of
+        eraseAfter.  However, events are matched using the rollback
+        epoch in the anti-message (see EventAdapter::isCanceledBy) so
+        that events that were resent after the rollback (and may
+        already be in this queue when the anti-message is processed)
+        are not canceled.
+
+        This method must be called only by the thread that has popped
+        dest from the queue (see popNextAgent).  Other threads may
+        concurrently enqueue events for dest.
+
+        \param[in] dest The agent whose currently scheduled events
+        are to be checked and cleaned-up.  The pointer cannot be NULL.
+
+        \param[in] antiMsg The anti-message whose corresponding events
+        are to be removed.  This pointer cannot be NULL.
+
+        \return This method returns the number of events actually
+        removed.
+    */
+    virtual int eraseAfter(muse::Agent* dest, const muse::Event* antiMsg);
+
+    /** Obtain the lowest timestamp of events in this queue.
+
+        ===== This Method is NOT Thread Safe =====
+        The value is meaningful only when no agent has been popped and
+        no events are being concurrently added.
+
+        \return The lowest receive time of events in this queue or
+        TIME_INFINITY if the queue is empty.
+    */
+    virtual muse::Time getNextEventTime();
+
+    /** Recycle tier2 entries that were removed from this queue.
+
+        ===== This Method is NOT Thread Safe =====
+        Entries removed from tier2 lists may still be referenced by
+        other threads (that obtained them via getEntry just before
+        their removal).  Hence, such entries are retired rather than
+        being reused right away.  This method must be called only when
+        no other thread is operating on this queue (for example, at
+        the end of GVT computation) to make retired entries available
+        for reuse.
+    */
+    virtual void recycleRetiredEntries();
     
     /** Print full contents of scheduler queue to given output stream.
 
@@ -439,6 +491,22 @@ protected:
      */
     void restructureTopQueue(muse::Agent* agent, muse::Time newTime);
 
+    /** Helper method used by the eraseAfter methods to remove events.
+
+        \param[in] dest The agent whose events are to be removed.
+
+        \param[in] sentTime The earliest sent time of the events to be
+        removed.  Only tier2 entries at or after this time are checked.
+
+        \param[in] isCanceled The predicate that returns true if a
+        given event is to be removed.
+
+        \return The number of events removed.
+    */
+    template<typename Predicate>
+    int eraseEvents(muse::Agent* dest, const muse::Time sentTime,
+                    Predicate isCanceled);
+
     /** Convenience method to determine if an event is a future event.
 
         This method is a helper method used in the eraseAfter() method
@@ -500,6 +568,20 @@ protected:
         tier2Recycler.emplace_back(e);
         tier2RecyclerLock.unlock();
     }
+
+    /**
+     * Adds a tier2Entry removed from a tier2 list to the list of
+     * retired entries in a thread safe way.
+     * 
+     * Retired entries are recycled only via recycleRetiredEntries.
+     * 
+     * @param e - the tier2entry that was removed
+     */
+    inline void retireTier2Entry(HOETier2EntryMT* e) {
+        tier2RecyclerLock.lock();
+        retiredEntries.emplace_back(e);
+        tier2RecyclerLock.unlock();
+    }
     
     /**
      * Attempts to insert an event into a tier2Entry.
@@ -564,6 +646,12 @@ private:
     */
     std::deque<HOETier2EntryMT*> tier2Recycler;
     
+    /** Tier2 entries that have been removed from tier2 lists but may
+        still be referenced by other threads.  These are moved to the
+        tier2Recycler by recycleRetiredEntries.
+    */
+    std::vector<HOETier2EntryMT*> retiredEntries;
+
     /** Simple lock to allow threadsafe access to recycler stack
      */
     std::mutex tier2RecyclerLock;
@@ -583,4 +671,15 @@ private:
 
 END_NAMESPACE(muse);
 
+// Sentinel keys for the lock-free queues (defined in the .cpp file)
+template<> muse::ThreeTierSkipMTQueue::AgentKey
+muse::ThreeTierSkipMTQueue::AgentList::keyMax;
+template<> muse::ThreeTierSkipMTQueue::AgentKey
+muse::ThreeTierSkipMTQueue::AgentList::keyMaxMinusOne;
+template<> muse::ThreeTierSkipMTQueue::AgentKey
+muse::ThreeTierSkipMTQueue::AgentList::keyMin;
+template<> muse::Time muse::ThreeTierSkipMTQueue::Tier2ListMT::keyMax;
+template<> muse::Time muse::ThreeTierSkipMTQueue::Tier2ListMT::keyMaxMinusOne;
+template<> muse::Time muse::ThreeTierSkipMTQueue::Tier2ListMT::keyMin;
+
 #endif
@@ -0,0 +1,317 @@
+#ifndef MUSE_TRANSPORT_H
+#define MUSE_TRANSPORT_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "DataTypes.h"
+#include "HashMap.h"
+#include "AgentRangeMap.h"
+
+//these are the tag types
+#define AGENT_LIST        0
+#define EVENT             1
+#define GVT_MESSAGE       2
+#define GVT_ESTIMATE_TIME 3
+#define STRING_MESSAGE    4
+#define LARGE_EVENT       5
+
+//these are the source types
+#define ROOT_KERNEL       0
+
+BEGIN_NAMESPACE(muse);
+
+class GVTMessage;
+
+/** The interface for moving messages between processes.
+
+    <p>A transport is the low-level mechanism used by the Communicator
+    to exchange flat (binary) events, GVT messages, and strings
+    between the processes constituting a parallel simulation.  The
+    Communicator retains the simulation-specific logic -- that is,
+    mapping agents to processes and handing incoming events and GVT
+    messages to the GVT manager -- and delegates the actual data
+    transfer to a transport.</p>
+
+    <p>The following transports are currently available (selected
+    via the <tt>--transport</tt> command-line argument):
+
+    <ul>
+
+    <li><b>mpi</b>: Two-sided MPI operations (see MpiTransport).</li>
+
+    <li><b>rma</b>: MPI one-sided operations (see RmaTransport).</li>
+
+    <li><b>shm</b>: POSIX shared memory between processes on a single
+    machine, without using MPI (see ShmTransport).</li>
+
+    </ul></p>
+
+    \note Messages from a given process to another process must be
+    delivered in the order in which they were sent. Otherwise
+    anti-messages can overtake the events they cancel.
+*/
+class Transport {
+public:
+    /** \brief Destructor
+
+        The destructor does not have any specific task to perform.
+        Resources are released in the finalize method.
+    */
+    virtual ~Transport() {}
+
+    /** \brief Initialize the transport and determine the rank of
+        this process.
+
+        \param[in] argc The number of command-line arguments.
+
+        \param[in] argv The command-line arguments.  Transports must
+        not consume arguments in this method (see
+        parseCommandLineArgs).
+
+        \param[in] initialize Flag to indicate if the underlying
+        infrastructure (say MPI) needs to be initialized. This flag is
+        false if a simulation is simply being repeated.
+
+        \return The rank of this process.
+    */
+    virtual int initialize(int argc, char* argv[], bool initialize) = 0;
+
+    /** \brief Consume any transport-specific command-line arguments.
+
+        The base class method does not consume any arguments.
+
+        \param argc[in,out] The number of command line arguments.
+
+        \param argv[in,out] The actual command line arguments.
+    */
+    virtual void parseCommandLineArgs(int& argc, char* argv[]) {
+        UNUSED_PARAM(argc);
+        UNUSED_PARAM(argv);
+    }
+
+    /** Obtain the rank of this process.
+
+        \return The rank of this process. This value is valid only
+        after the transport has been initialized.
+    */
+    virtual int getRank() const = 0;
+
+    /** Obtain the number of processes in the simulation.
+
+        \return The number of processes.  This value is valid only
+        after the transport has been initialized.
+    */
+    virtual int getNumProcesses() const = 0;
+
+    /** \brief Exchange the ranges of agents on each process to build
+        the full map of agents to owners.
+
+        This is a collective operation that must be invoked by all
+        the processes.  Each process contributes a list of ranges
+        (generated via AgentRangeMap::encode) and receives the ranges
+        from all the processes.
+
+        \param[in] localRanges The flat list of <i>startID, count,
+        owner</i> triples for agents on this process.
+
+        \param[out] ownerMap The map to which ranges from all the
+        processes are to be added.  The map is finalized by this
+        method.
+    */
+    virtual void allGatherAgentRanges(const std::vector<AgentID>& localRanges,
+                                      AgentRangeMap& ownerMap) = 0;
+
+    /** \brief Setup resources once agents have been registered.
+
+        This method is invoked (on all the processes) after agents
+        have been registered and just before the simulation starts.
+        The base class method does not do anything.
+    */
+    virtual void agentsRegistered() {}
+
+    /** \brief Send an event to a given process.
+
+        \param[in] e The event to be sent.  The transport may hold a
+        reference to the event (via EventRecycler) until the data
+        has been dispatched.
+
+        \param[in] eventSize The size (in bytes) of the event.
+
+        \param[in] destRank The rank of the destination process.
+    */
+    virtual void sendEvent(Event* e, const int eventSize,
+                           const int destRank) = 0;
+
+    /** \brief Send a GVT message to a given process.
+
+        \param[in] msg The GVT message to be sent. The message is
+        destroyed (or reused) by the caller right after this call.
+
+        \param[in] destRank The rank of the destination process.
+    */
+    virtual void sendGVTMessage(const GVTMessage* msg,
+                                const int destRank) = 0;
+
+    /** \brief Ship any events buffered by the transport.
+
+        Transports that batch outgoing events (such as RmaTransport)
+        override this method to dispatch pending batches, bounding the
+        time events are delayed.  The default implementation does
+        nothing as events are dispatched right away.
+    */
+    virtual void flush() {}
+
+    /** \brief Send a string (with a given tag) to a given process.
+
+        \param[in] str The string to be sent. The string can be empty.
+
+        \param[in] destRank The rank of the destination process.
+
+        \param[in] tag The tag associated with the string.
+    */
+    virtual void sendString(const std::string& str, const int destRank,
+                            const int tag) = 0;
+
+    /** \brief Receive the next pending event or GVT message, if any.
+
+        This method does not block.
+
+        \param[out] data The flat buffer containing the message. The
+        buffer is allocated via Event::allocate and its ownership is
+        transferred to the caller.
+
+        \param[out] size The size (in bytes) of the message.
+
+        \param[out] tag The tag (EVENT, LARGE_EVENT, or GVT_MESSAGE)
+        associated with the message.
+
+        \param[out] srcRank The rank of the sender.
+
+        \return This method returns true if a message was received.
+        Otherwise it returns false.
+    */
+    virtual bool receive(char*& data, int& size, int& tag, int& srcRank) = 0;
+
+    /** \brief Receive a string sent via sendString.
+
+        \param[out] recvRank The actual rank from where the message
+        was received.  This value is set to -1 if a string was not
+        received.
+
+        \param[in] srcRank The rank of the process from where the
+        string is to be read (MPI_ANY_SOURCE for any process).
+
+        \param[in] tag The tag associated with the string.
+
+        \param[in] blocking If true, this method waits until a string
+        is received.
+
+        \return The string received (if any).
+    */
+    virtual std::string receiveString(int& recvRank, const int srcRank,
+                                      const int tag, const bool blocking) = 0;
+
+    /** \brief Wait until all processes have reached this call. */
+    virtual void barrier() = 0;
+
+    /** \brief Compute the minimum of a value across all processes.
+
+        This is a collective operation that must be invoked by all
+        the processes.
+
+        \param[in] value The local value to be used.
+
+        \return The global minimum of the values from all processes.
+    */
+    virtual Time allReduceMin(const Time value) = 0;
+
+    /** \brief Compute the sum of a value across all processes.
+
+        This is a collective operation that must be invoked by all
+        the processes.
+
+        \param[in] value The local value to be used.
+
+        \return The global sum of the values from all processes.
+    */
+    virtual long allReduceSum(const long value) = 0;
+
+    /** \brief Compute the element-wise sum of a list of values across
+        all processes.
+
+        This is a collective operation that must be invoked by all
+        the processes with lists of the same size.
+
+        \param[in,out] values The local values to be used.  On return,
+        each entry is the global sum of the corresponding entries.
+    */
+    virtual void allReduceSum(std::vector<Time>& values) = 0;
+
+    /** \brief Set the maximum number of in-flight non-blocking sends.
+
+        This is an optional tuning hook.  The base class ignores it.
+
+        \param[in] count The maximum number of in-flight sends.
+    */
+    virtual void setMaxPendingSends(const int count) {
+        UNUSED_PARAM(count);
+    }
+
+    /** \brief Setup a ring of pre-posted receives for events.
+
+        This is an optional tuning hook.  The base class ignores it.
+
+        \param[in] count The number of pre-posted receives.
+
+        \param[in] maxEventSize The size of each buffer in the ring.
+    */
+    virtual void setRecvRing(const int count, const int maxEventSize) {
+        UNUSED_PARAM(count);
+        UNUSED_PARAM(maxEventSize);
+    }
+
+    /** \brief Report statistics about the transport.
+
+        The base class does not report any statistics.
+
+        \param[out] os The output stream to which the statistics are
+        to be written.
+    */
+    virtual void reportStats(std::ostream& os) {
+        UNUSED_PARAM(os);
+    }
+
+    /** \brief Release resources and (optionally) stop the transport.
+
+        \param[in] stop If this flag is true the underlying
+        infrastructure (say MPI) is shutdown.  Otherwise it is
+        retained so that another simulation can be run.
+    */
+    virtual void finalize(bool stop) = 0;
+};
+
+END_NAMESPACE(muse);
+
+#endif
@@ -32,21 +32,27 @@
 #include <cstdint>    // additional int types, specifically uintptr_t
 #include <climits>    // numeric type limits
 #include <functional> // std::less comparator
-#include <vector>     // next pointers and preds/succs arrays
-#include <mutex>      // locks
-#include <deque>      // holds ptrs for garbage collection
-#include <atomic>     // atomic int for state
+#include <vector>     // retired nodes and node pools
+#include <atomic>     // atomic epochs and thread states
 #include <random>     // random node level generator (geometric dist)
+#include <thread>     // std::this_thread::yield
 #include <iostream>
 #include <assert.h>    // (deperomm) use utilities.h
-#include <math.h>      // pow()
 
 
 #define NUM_LEVELS 32
 // todo(deperomm): make this dynamic, should be >= number of threads
 #define MAX_OFFSET 8
-// Used to initially set thread_id to an invalid value
-#define THREAD_ID_NULL (UINT_MAX)
+// The maximum number of threads that can concurrently use queues of a
+// given type
+#define MAX_PQ_THREADS 256
+// The maximum number of free nodes cached by each thread
+#define NODE_POOL_SIZE 1024
+// The number of operations/retires after which a thread with retired
+// nodes tries to advance the epoch
+#define EPOCH_CHECK_RATE 64
+// Nodes retired in epoch e are reused in epoch e + 2. So 3 lists suffice
+#define EPOCH_BUCKETS 3
 
 
 
@@ -72,6 +78,14 @@
  * logical and physical deletes, combining the "next" pointer with the logical 
  * delete flag for a node, and also utilizing compare and swap (CAS) 
  * instructions on the CPU. The details of which can be read in the above paper
+ * 
+ * Nodes removed from the queue are reclaimed using a lock-free, epoch-based
+ * scheme shared by all queues with the same template parameters. Each
+ * thread announces the global epoch when it enters a critical section (that
+ * is, any queue operation), retires removed nodes to a thread-local list for
+ * the epoch, and reuses them from a thread-local pool of nodes once the
+ * global epoch has advanced twice. Consequently, no queue operation blocks
+ * on a lock.
  */
 template <class K, class V, class Compare = std::less<K> >
 class LockFreePQ {
@@ -204,6 +218,17 @@ public:
      */
     Node_t* getNode(K key);
     
+    /**
+     * For traversal, pointer to head of queue
+     * 
+     * The head is a sentinel node whose value is always NULL.
+     * 
+     * @return pointer to head of queue
+     */
+    Node_t* getHead() {
+        return head;
+    }
+    
     /**
      * For traversal, pointer to tail of queue
      * 
@@ -309,122 +334,125 @@ private:
      * node still needs to be linked into the queue before it can be useful.
      * 
      * Node starts with inserting flag set to true, must be set to false
-     * when done inserting the returned node.
+     * when done inserting the returned node. Nodes are reused from the
+     * thread's pool of free nodes when possible.
      * 
      * @return Node_t - the newly allocated queue node
      */
     Node_t* allocNode();
     
     /**
-     * Marks a node as ready for deletion and deletes nodes when safe to do so
+     * Retires a node that has been unlinked from the queue
      * 
      * Because threads could still be operating on memory that is ready for
-     * deletion, must wait until all threads have left critical sections before
-     * physically deleting the memory.
+     * deletion, the node is added to this thread's list of nodes retired
+     * in the current epoch. It is reused (or deleted) only after all
+     * threads that could have accessed it have left their critical sections,
+     * that is, once the global epoch has advanced twice.
      * 
-     * Nodes that are freed should be totally disconnected from the queue,
+     * Nodes that are retired should be totally disconnected from the queue,
      * meaning any threads that newly enters a critical section will not ever
-     * reach the to-be-freed node. 
+     * reach the retired node. 
      * 
      * @param n - Node_t, the node being marked as no longer needed by the queue
      */
     void freeNode(Node_t *n);
     
+    /**
+     * Returns a node that was never visible to other threads (or when no
+     * other thread is using the queue) to this thread's pool of free nodes
+     * 
+     * @param n - Node_t, the node to be reused
+     */
+    static void recycleNode(Node_t *n);
+    
     /**
      * Alerts the garbage collector that a thread has entered a critical section
      * 
-     * When called for first time on a thread, also initializes garabage
-     * collection for that thread
+     * The thread announces the global epoch it observed.  When called
+     * for first time on a thread, also assigns a slot for the thread. If the
+     * epoch has advanced since this thread's last critical section, nodes
+     * retired by this thread two or more epochs ago are moved to its pool.
      */
     void enterCritical();
     
     /**
      * Alerts garbage collection that this thread has left a critical section
      * 
-     * Once all threads have left their critical sections, we move forward
-     * one epoch. Nodes that have waited at least a full epoch since being
-     * released are guarenteed to no longer be accessed by any thread
+     * Periodically, threads that have retired nodes try to advance the epoch.
      */
     void exitCritical();
     
     /**
-     * Goes through the process of changing epoch and garbage collecting
+     * Advances the global epoch if all threads in critical sections have
+     * announced the current epoch
      * 
-     * This thread should only be called by a single thread exclusively
-     * and therefore must be surrounded by a lock
+     * This method is lock free. If several threads try to advance the epoch
+     * concurrently, only one of them succeeds.
      */
-    void garbageCollectAndChangeEpoch();
+    static void tryAdvanceEpoch();
     
     /**
-     * When a new thread accesses the queue, it is assigned an id for garbage
-     * collection purposes
+     * The state of a thread that uses queues of this type
      * 
-     * thread_id is always a unique power of two, as it is used for bitwise ops
-     * to toggle overall thread state
-     * 
-     * For example, the 3rd thread in the system gets thread_id = 0b100 = 4
+     * Each thread has its own slot. The slot holds the epoch announced by
+     * the thread (shifted left by 1) with the lowest bit set while the thread
+     * is in a critical section. Slots are on separate cache lines to avoid
+     * false sharing between threads.
      */
-    thread_local static size_t thread_id;
-    static size_t *lastId;  // used to distribute IDs to threads
+    struct alignas(64) ThreadSlot {
+        std::atomic<size_t> state;    // announced epoch and active bit
+        std::atomic<bool>   claimed;  // true if a thread uses this slot
+    };
     
     /**
-     * bitmap which represents which threads are acitvely in critical sections
-     * 
-     * Each bit represents a thread actively in a critical section, when a 
-     * thread leaves its critical section it flips its bit back to 0
+     * Thread-local information used for reclaiming nodes
      * 
-     * For example, if state = 0b0110 then two threads are actively in crit secs
+     * The retired lists and pool are shared by all queues of this type used
+     * by a thread. When the thread exits, the destructor waits for nodes 
+     * retired by the thread to become safe, deletes all nodes, and releases
+     * the thread's slot.
      */
-    std::atomic_uint *thread_curr_state = new std::atomic_uint;
+    struct ThreadState {
+        ThreadState() : slot(-1), epoch(0), pending(0), ops(0) {}
+        ~ThreadState();
+        // Moves retired nodes to the pool (deleting excess nodes)
+        void reclaim(std::vector<Node_t*>& nodes);
+        int    slot;      // index into slots, -1 if not yet assigned
+        size_t epoch;     // epoch announced in last critical section
+        size_t pending;   // number of nodes in the retired lists
+        size_t ops;       // critical sections since last epoch check
+        std::vector<Node_t*> retired[EPOCH_BUCKETS];  // by epoch
+        std::vector<Node_t*> pool;    // free nodes for allocNode
+    };
     
     /**
-     * bitmap which represents threads that were active when epoch last switched
+     * Assigns a free slot to the calling thread
      * 
-     * This is specifically set after the moment the epoch switched to ensure
-     * that even if new threads entered and previously active threads exited
-     * since the moment we switched, we guarantee that when this is zero, all
-     * threads that were active at the moment we switched have since exited.
-     */
-    std::atomic_uint *thread_epoch_state = new std::atomic_uint;
-    
-    /**
-     * For garbage collection, any new node that is being marked for deletion is
-     * added to this vector. These nodes are very likely not safe to delete
-     * as other threads could still use them.
+     * @param ts - the thread-local state of the calling thread
      */
-    std::vector<Node_t*> *pendingDeallocs = new std::vector<Node_t*>;
+    static void registerThread(ThreadState& ts);
     
     /**
-     * For garbage collection, when we switch epochs (all threads since last
-     * epoch change have left their critical sections), this vector is safe
-     * to free (since it has been at least a full epoch since this vector was
-     * populated, meaning every node was released during the previous epoch). 
-     * 
-     * Every epoch, this queue is processed to free memory and then populated
-     * with the contents of pendingDeallocs.
+     * The slots for threads using queues of this type
      */
-    std::vector<Node_t*> *waitingDeallocs = new std::vector<Node_t*>;
+    static ThreadSlot slots[MAX_PQ_THREADS];
     
     /**
-     * Finalizes the entire garbage collection system for queue tear down
-     * 
-     * Clears all pending and waiting deallocations that were removed from the 
-     * queue but not physically deleted yet
-     * 
-     * This should only be called when tearing down the queue and is NOT
-     * thread sa<K,V><K,V>fe.
+     * One more than the highest slot assigned so far. Only these many slots
+     * are checked when advancing the epoch.
      */
-    void finalizeDeallocs();
+    static std::atomic<int> slotCount;
     
     /**
-     * a mutex to ensure safe insertion into pendingDeallocs queue
+     * The global epoch shared by all queues of this type
      */
-    std::mutex freeMutex;
+    static std::atomic<size_t> globalEpoch;
     
     /**
-     * a mutex to ensure only one thread changes epoch at a time
+     * The reclamation state of the calling thread
      */
-    std::mutex epochMutex;
+    thread_local static ThreadState threadState;
     
     // variables and pointers
     int          maxOffset;
@@ -41,8 +41,8 @@ class MultiThreadedScheduler : public Scheduler {
 public:
     /** \brief Default Constructor
 
-        Does not have a specific task to perform and is merely present
-        as a place holder for future extensions.
+        Does not have a specific task to perform.  The queue is
+        created in the initialize method.
     */
     MultiThreadedScheduler();
 
@@ -71,11 +71,14 @@ public:
         This method operates very similar to Scheduler::scheduleEvent()
         
         Only used by the Simulation kernel. Users of MUSE API should
-        not touch this function.  Rollback checks are done at this
-        level.
-
-        After the appropriate processing has occured, the Event will
-        be placed into the appropraite Agent's Event Priority Queue.
+        not touch this function.  Unlike the base class, rollback
+        checks and anti-messages are not handled here (as the
+        receiving agent may be processing events on another thread).
+        Instead, they are handled when events are dequeued in
+        processNextAgentEvents.
+
+        The Event (including anti-messages) is placed into the
+        appropraite Agent's Event Priority Queue.
         
         \param[in] e Event to be scheduled
 
@@ -83,7 +86,44 @@ public:
     */
     virtual bool scheduleEvent(Event *e);
 
+    /** Obtain the lowest timestamp of events in the shared queue.
+
+        This method is not thread safe and must be called only when
+        no other thread is processing or scheduling events.  It is
+        used to determine the LGVT of the process.
+
+        \return The lowest receive time of events in the scheduler or
+        TIME_INFINITY if there are no events.
+    */
+    Time getNextEventTime() const;
+
+    /** Method invoked when GVT has been updated.
+
+        This method overrides the base class method to reclaim
+        internal entries in the shared queue.  This method must be
+        called only when no other thread is operating on the
+        scheduler.
+
+        \param[in] gvt The current GVT value (unused).
+    */
+    virtual void garbageCollect(const Time& gvt) override;
+
 protected:
+    /** Process anti-messages in the current batch of events.
+
+        This is a refactored helper method that is used by
+        processNextAgentEvents.  It removes anti-messages from the
+        batch of events (in agentEvents), rolls back the agent if
+        needed, and removes events canceled by the anti-messages from
+        both the batch and the agent's pending events.
+
+        \param[in,out] agent The agent that has been popped by this
+        thread and is receiving the batch of events.
+
+        \return True if the agent was rolled back.
+    */
+    bool handleAntiMessages(muse::Agent* agent);
+
     
     /** \brief Complete initialization of the MT Scheduler.
       
@@ -125,7 +165,7 @@ private:
      * as this reference.
      */
     EventQueueMT *mtAgentPQ;
-    
+
 };
 
 END_NAMESPACE(muse);
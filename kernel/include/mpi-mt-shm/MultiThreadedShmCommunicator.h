@@ -121,15 +121,11 @@ public:
     /** \brief Obtain the thread-based rank of the process on which a
         given agent resides.
 
-        This method can be used to determine the thread-based rank,
-        that is: <i>getOwnerRank(id) * getThreadID(id)</i> of the
-        thread on which a given agent resides.  This information is
-        directly obtained from the agentMap which already contains
-        agent--thread mapping.
-
-        \note The values returned by this method make sense only after
-        the communicator has been initialized and information
-        regarding all the agents has been exchanged.
+        In this simulator, agents are not partitioned to threads --
+        that is, any thread on a process may schedule any agent on the
+        process.  Consequently, this method returns the same value as
+        getOwnerRank and all agents on a process are treated as being
+        local to each other (see isAgentLocal).
 
         \param id The ID of the agent for which the corresponding
         thread-based rank is desired.
@@ -139,10 +135,7 @@ public:
         resides.  Otherwise this method returns a negative value.
     */
     virtual int getOwnerThreadRank(const AgentID& id) const override {
-        // Find iterator for given agent id
-        AgentIDSimulatorIDMap::const_iterator entry = agentMap.find(id);
-        // If id is valid then iterator is valid.
-        return (entry != agentMap.end()) ? (int) entry->second : -1;
+        return getOwnerRank(id);
     }
     
     /** \brief Obtain process configuration information.
@@ -322,47 +315,6 @@ public:
     int receiveManyEvents(EventContainer& eventList, const int maxEvents,
                           int retryCount = 10);
     
-protected:
-
-    /** Registers local agents with all processes.
-
-        This method creates a list of local agents and uses
-        Communicator::registerAgents(const std::vector<AgentID>&)
-        method to register agents with all the parallel processes.
-    */
-    void registerAllAgents();
-
-private:
-    /** Method run on MPI-rank zero to aggregate and broadcast
-        agent--thread mapping.
-
-        This method is invoked from the registerAgents() method in
-        this class only on rank zero.  This method first gathers the
-        agent--thread mapping from all other processes into the
-        supplied idThrList.  It then broadcasts the aggregate list to
-        all other processes.
-
-        \param[in,out] idThrList The list of local mappings.  This
-        list is modified by this method to contain the full list of
-        mappings.
-    */
-    void gatherBroadcastAgentInfo(VecUint& idThrList);
-
-    /** Method run on MPI-rank not-zero to send and receive
-        agent--thread mapping.
-
-        This method is invoked on all processes that are not rank zero
-        to coordinate activites in the gatherBroadcastAgentInfo
-        method.  This first sends the local agent--thread mapping to
-        rank zero.  It then receives the broadcasted aggregate list
-        information.
-
-        \param[in,out] idThrList The list of local mappings.  This
-        list is modified by this method to contain the full list of
-        mappings.        
-    */
-    void sendGatherAgentInfo(VecUint& idThrList);
-                          
 private:
 
     /** The simulation manager associated with this
@@ -22,10 +22,14 @@
 //
 //---------------------------------------------------------------------------
 
+#include <atomic>
 #include <mutex>
 #include "Event.h"
 #include "GVTManager.h"
+#include "NumaMemoryManager.h"
 #include "Simulation.h"
+#include "SlabAllocator.h"
+#include "SpinLock.h"
 #include "SpinLockThreadBarrier.h"
 #include "mpi-mt-shm/MultiThreadedScheduler.h"
 
@@ -271,7 +275,7 @@ protected:
     pointer to the gvtManager to be used.  The manager is
     shared between multiple threads.
     */
-    void setGVTManager(GVTManager* gvtMan);
+    void setGVTManager(GVTManagerBase* gvtMan);
 
     /** Performs the core simulation operation for each thread.
 
@@ -345,15 +349,13 @@ protected:
 
         This method overrides the default implementation in the base
         class.  First it passess control to the base class to perform
-        the standard garbage collection process.  Next, this method
-        calls EventRecycler::processPendingDeallocs() to try to
-        reclaim pending events after a garbage collection cycle has
-        completed.  This is done here because EventRecycler::
-        processPendingDeallocs method is a time consuming one
-        (particularly when there are many events pending) and each
-        iteration through it has to be successful.
-
-        \see EventRecycler::processPendingDeallocs()
+        the standard garbage collection process.  Next, when events
+        are shared between threads, this method calls
+        EventRecycler::tryAdvanceEpoch() so that events retired by
+        threads can be reclaimed once every thread has completed a
+        garbage collection cycle.
+
+        \see EventRecycler::announceEpoch()
      */
     virtual void garbageCollect() override;
     
@@ -445,30 +447,47 @@ protected:
     */
     const int threadID;
 
-    /** Refactored utility method to make copy of an event honoring
-        NUMA and other runtime flags/settings.
+    /** Obtain the time of the next event to be processed on this
+        process.
 
-        This is a refactored utility method used to make copy of
-        events going across thread boundaries.  This method is
-        currently called only from MultiThreadedSimulation's
-        scheduleEvent method.  This method is used only when
-        usingSharedEvents is set to \c false.  This method make an
-        identical clone of the given event.
+        This method overrides the base class implementation because
+        the scheduler (and its event queue) is shared by all the
+        threads on this process.  The GVT manager uses this value as
+        the local GVT estimate for the whole process.
 
-        \param[in] src The source event to be cloned. This parameter
-        cannot be NULL.
+        \note This method must be invoked only when all other threads
+        have been quiesced via simLock (see runGVTtasks).
 
-        \param[in] receiver The receiving agent ID used for cloning
-        event (if NUMA is not being used or when sharing events).
-        
-        \param[in] destThrID The global rank of the destination thread
-        to which the event is to be sent.  This value modulo
-        threadsPerNode gives the local thread ID.
+        \return The time of the next event in the shared scheduler.
+    */
+    virtual Time getLGVT() const override;
+
+    /** Perform GVT-related operations while all threads are quiesced.
+
+        The GVT manager is shared by all the threads on this process
+        and it uses the shared scheduler's queue to estimate local
+        GVT.  Therefore, this method is called only from thread #0.
+        It exclusively locks simLock (blocking other threads once
+        they finish processing their current batch of events) and
+        then processes any deferred GVT messages, optionally
+        initiates a GVT estimation, and forwards pending control
+        messages.  Garbage collection (triggered by the GVT manager
+        when GVT advances) also occurs while the lock is held.
+
+        \param[in] startEstimation If true, a new GVT estimation is
+        initiated (if one is not already in progress).
+    */
+    void runGVTtasks(const bool startEstimation);
+
+    /** Enable reclamation of events retired on the calling thread.
 
-        \return A clone of the event with memory suitably allocated.
+        This is a refactored helper method that is called after each
+        garbage collection cycle.  It calls
+        EventRecycler::tryAdvanceEpoch() so that the reclamation epoch
+        advances once all threads have reached it.  Retired events are
+        reclaimed by each thread when it announces the new epoch.
     */
-    muse::Event* cloneEvent(const muse::Event* src,
-                            const muse::AgentID receiver) const;
+    void reclaimPendingDeallocs();
     
 private:
     /** The undefined copy constructor.
@@ -497,6 +516,40 @@ private:
     */
     static std::mutex mpiMutex;
 
+    /** Lock used to quiesce all the threads for GVT operations.
+
+        Threads hold this lock in shared mode while they read MPI
+        messages and process events.  Thread #0 periodically acquires
+        it in exclusive mode (see runGVTtasks) so that the GVT manager
+        can consistently inspect the shared scheduler and perform
+        garbage collection.
+    */
+    static SharedSpinLock simLock;
+
+    /** Mutex to serialize sending of events to remote processes.
+
+        Sending an event to a remote process updates the shared
+        counters in the GVT manager and must be serialized between
+        threads.
+    */
+    static std::mutex gvtMutex;
+
+    /** GVT messages received via MPI but not yet processed.
+
+        GVT messages may be read from MPI by any thread.  However,
+        they can be processed only when the threads have been
+        quiesced.  Hence, they are added to this list (while holding
+        mpiMutex) and processed by thread #0 in runGVTtasks.
+    */
+    static std::vector<GVTMessage*> gvtMsgs;
+
+    /** Flag to indicate that gvtMsgs has entries to be processed.
+
+        This flag enables thread #0 to check for GVT messages without
+        acquiring locks.
+    */
+    static std::atomic<bool> haveGVTMsgs;
+
     /** The multi-threading aware communicator.
 
         This communicator is shared between multiple threaded.  It is
@@ -562,50 +615,13 @@ private:
     */
     EventContainer mpiEvents;
 
-    /** Track the fraction of events reclaimed from EventRecycler's
-        pendingDeallocs list at end of each GC cycle.  This counter is
-        updated in garbageCollect method in this class.  This value
-        essentially indicates the number of times EventRecycler::
-        processPendingDeallocs() method was called and the fraction of
-        events that were successfully reclaimed.  If this value is low
-        then we need fewer calles to the method.
+    /** Track the fraction of retired events reclaimed by
+        EventRecycler::announceEpoch() each time the reclamation epoch
+        advances.  This value is updated in the main simulation loop
+        in this class and is reported as a statistic at the end of
+        simulation.
     */
     Avg deallocsPerCall;
-    
-    /** Command-line argument to set the desired fraction of events
-        cleared from pendingDeallocs list for each GC cycle.  This
-        value is a fraction in the range 0.01 to 1.0.  It cannot be
-        set to zero. This value is used to double the deallocRate
-        until the desired deallocFrac is achieved.  If the fraction of
-        deallocated events is more than 1.5 times this value then the
-        deallocRate is halved (but not below 1).
-    */
-    double deallocThresh;
-
-    /** The current rate at which processPendingDeallocs() should be
-        called.  This value is updated after each call to
-        processPendingDeallocs() method to reach the specified
-        deallocFrac threshold value, the following manner:
-
-        \code
-
-        const double fracRecovered = EventRecycler::processPendingDallocs();
-        if (fracRecovered < deallocThresh) {
-            deallocRate *= 2;
-        } else if (fracRecovered > (deallocThresh * 1.5)) {
-            deallocRate = std::max(1, deallocRate / 2);
-        }
-    */
-    int deallocRate;
-
-    /** This is the counter used to determine if
-        processPendingDeallocs() method should be called.  This
-        counter is initialized to deallocRate.  It is decremented in
-        each call to garbageCollect() method.  If this counter reaches
-        zero, then processPendingDeallocs() is called and it is reset
-        back to deallocRate.
-    */
-    int deallocTicker;
 
     /** The CPU ID setup for this thread.
 
@@ -641,22 +657,21 @@ private:
     */
     static std::vector<int> numaIDofThread;
 
-#if USE_NUMA == 1
-    /** Reference to main Numa memory manager to add list of allocated
-        pages to finally free at end of simulation.
+    /** Reference to main thread's slab allocator to add slabs of
+        events to finally free at end of simulation.
 
-        This reference always referes to the NumaMemoryManager on the
-        main thread.  This object is used for the following reason --
-        Event deallocations on various threads cannot be fully
+        This reference always referes to the EventRecycler::slabs on
+        the main thread.  This object is used for the following reason
+        -- Events allocated by various threads cannot be fully
         reclaimed until all agents are finalized (and they relinquish
         references to events in their internal queues).  Consequently,
-        at the end of the MultiThreadedSimulation::simulate() method,
-        each thread (other than the main thread) adds its NUMA blocks
-        to the main numa manager. This list is finally cleaned-up in
-        the main thread.
+        at the end of the simulate() method, each thread (other than
+        the main thread) adds its slabs to the main thread's slab
+        allocator. The slabs are finally freed in the main thread.
     */
-    NumaMemoryManager& mainNumaManager;
+    SlabAllocator& mainSlabs;
 
+#if USE_NUMA == 1
     /** Reference to main-thread's Numa memory manager to add list of
         allocated pages to finally free at end of simulation.
 
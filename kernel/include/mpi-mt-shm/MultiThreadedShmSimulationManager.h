@@ -224,24 +224,6 @@ private:
     */
     std::vector<MultiThreadedShmSimulation*> threads;
 
-    /** Mutex to ensure only one thread at a time performs reading
-        events from MPI.
-
-        This mutex is used in the processMpiMsgs method to ensure that
-        only one thread at a time reads and enqueues incoming events
-        from MPI.
-    */
-    std::mutex mpiMutex;
-
-    /** A temporary vector to hold incoming MPI events.
-
-        This container is repeatedly reused in processMpiMsgs to
-        obtain events from MPI via call to MultiThreadedCommunicator's
-        receiveManyEvents method.  This container is reused so that we
-        don't waste CPU cycles on recreating/resizing the container.
-    */
-    EventContainer mpiEvents;
-    
     /** The only constructor for this class.
 
         The constructor merely initializes all the pointers and
@@ -0,0 +1,169 @@
+#ifndef MUSE_CPU_TOPOLOGY_H
+#define MUSE_CPU_TOPOLOGY_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "DataTypes.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** The topology of a set of CPUs used to place threads.
+
+    This class discovers the physical core, SMT (hyper-thread)
+    siblings, L3 cache domain, and NUMA node of each CPU from
+    /sys/devices/system/cpu.  If this information is not available,
+    each CPU is treated as a separate core in a single L3 domain and
+    NUMA node.  This information is used by
+    MultiThreadedSimulationManager to order CPUs for pinning threads
+    based on a placement policy (set via \c --thread-placement) that
+    is one of:
+
+    <ul>
+
+    <li><b>linear</b> (default): CPUs are used in the order in which
+    they appear in the affinity mask of the process.</li>
+
+    <li><b>core</b>: One thread per physical core.  SMT siblings are
+    used only after one CPU on each core has been used.</li>
+
+    <li><b>compact</b>: Threads are packed into an L3 domain (one per
+    physical core first and then on SMT siblings) before the next L3
+    domain is used.  This minimizes cache-coherence traffic between
+    threads.</li>
+
+    <li><b>scatter</b>: Consecutive threads are spread across NUMA
+    nodes and L3 domains (one per physical core first) to maximize
+    the aggregate cache and memory bandwidth.</li>
+
+    </ul>
+
+    The topology also provides the memory domain of each CPU, which is
+    used to partition agents so that heavily communicating agents are
+    placed on threads in the same domain (see AgentGraph::partition).
+*/
+class CpuTopology {
+public:
+    /** Information about a single CPU. */
+    struct CpuInfo {
+        /// The logical ID of the CPU.
+        int cpu;
+        /// The zero-based index of the physical core of the CPU.
+        int core;
+        /// The index of this CPU among the SMT siblings on its core.
+        int smt;
+        /// The ID of the L3 domain (lowest CPU sharing the L3 cache).
+        int l3;
+        /// The NUMA node of the CPU.
+        int numa;
+    };
+
+    /** Discover the topology of a given set of CPUs.
+
+        \param[in] cpuList The CPUs available to this process.
+    */
+    explicit CpuTopology(const std::vector<int>& cpuList);
+
+    /** Determine if a placement policy is supported by this class.
+
+        \param[in] policy The name of the policy.
+
+        \return True if the policy is one of: linear, core, compact,
+        or scatter.
+    */
+    static bool isValidPolicy(const std::string& policy);
+
+    /** Order the CPUs for pinning threads based on a policy.
+
+        \param[in] policy The name of a valid placement policy.
+
+        \return All the CPUs in this topology in the order in which
+        threads are to be pinned to them.  Thread i is to be pinned
+        to entry (i % size) in the returned list.
+    */
+    std::vector<int> getPlacement(const std::string& policy) const;
+
+    /** Obtain the memory domain of a CPU.
+
+        The domain is the NUMA node if the CPUs span multiple NUMA
+        nodes.  Otherwise it is the L3 domain.
+
+        \param[in] cpu The logical ID of a CPU in this topology.
+
+        \return The domain of the CPU or 0 if the CPU is unknown.
+    */
+    int getDomain(const int cpu) const;
+
+    /** Obtain the SMT siblings of a CPU.
+
+        \param[in] cpu The logical ID of the CPU.
+
+        \return The logical IDs of the other CPUs on the same physical
+        core.  The siblings may not be in this topology.
+    */
+    static std::vector<int> getSiblings(const int cpu);
+
+    /** Print a brief summary of the topology.
+
+        \param[out] os The output stream to which the summary is to be
+        written.
+    */
+    void printSummary(std::ostream& os) const;
+
+protected:
+    /** Parse a list of CPUs in the format used by sysfs.
+
+        \param[in] list A list of the form "0-3,8,10-11".
+
+        \return The CPUs in the list.
+    */
+    static std::vector<int> parseCpuList(const std::string& list);
+
+    /** Read the first line of a file in sysfs.
+
+        \param[in] path The path to the file.
+
+        \return The first line of the file or an empty string if the
+        file could not be read.
+    */
+    static std::string readLine(const std::string& path);
+
+    /** Determine the number of distinct values of a field.
+
+        \param[in] field Pointer to the field in CpuInfo.
+
+        \return The number of distinct values of the field.
+    */
+    int countDistinct(int CpuInfo::*field) const;
+
+private:
+    /** The information about each CPU in the order of the affinity
+        mask of the process.
+    */
+    std::vector<CpuInfo> cpus;
+};
+
+END_NAMESPACE(muse);
+
+#endif
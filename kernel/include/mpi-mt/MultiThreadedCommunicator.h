@@ -29,6 +29,7 @@ BEGIN_NAMESPACE(muse);
 
 // Forward declarations to keep compile fast
 class GVTMessage;
+class MTQueue;
 class MultiThreadedSimulationManager;
 
 // A short cut to a vector of unsigned integers
@@ -64,7 +65,7 @@ public:
 
     /** \brief Destructor
 
-        Do nothing, since no memory is allocated.
+        Deletes the outbound queue (if any).
     */
     virtual ~MultiThreadedCommunicator() override;
 
@@ -95,6 +96,40 @@ public:
     */
     virtual void finalize(bool stopMPI = true) override;
 
+    /** \brief Override base class method to retain blocking sends.
+
+        The base class releases buffers of completed non-blocking
+        sends back to the EventRecycler.  However, the EventRecycler
+        maintains thread-local pools and sends are initiated by
+        different threads in this multi-threaded communicator.
+        Consequently, this method intentionally ignores the pool size
+        and blocking sends are used.
+
+        \param[in] count The maximum number of in-flight sends.  This
+        value is not used.
+    */
+    virtual void setMaxPendingSends(const int count) override {
+        UNUSED_PARAM(count);
+    }
+
+    /** \brief Override base class method to retain probe-and-receive.
+
+        Incoming messages are received by different threads using the
+        receiveManyEvents method in this class.  Consequently, this
+        method intentionally ignores the ring of pre-posted receives.
+
+        \param[in] count The number of pre-posted receives.  This
+        value is not used.
+
+        \param[in] maxEventSize The size of each buffer.  This value
+        is not used.
+    */
+    virtual void setRecvRing(const int count, const int maxEventSize)
+        override {
+        UNUSED_PARAM(count);
+        UNUSED_PARAM(maxEventSize);
+    }
+
     /** Determine the thread ID for the specified agent.
 
         This method can be used to determine the thread ID associated
@@ -108,8 +143,30 @@ public:
         local or invalid).
     */
     int getThreadID(const AgentID id) const {
-        AgentIDSimulatorIDMap::const_iterator entry = agentThreadMap.find(id);
-        return (entry != agentThreadMap.end() ? (int) entry->second : -1);
+        const AgentDirectory::Entry* const entry = agentDir.find(id);
+        return (entry != NULL) ? entry->thread : getHomeThreadID(id);
+    }
+
+    /** Determine the thread with which a local agent was originally
+        registered.
+
+        Other processes route events to the thread with which an agent
+        was registered (and account for them in GVT computations
+        accordingly).  If agents are stolen by other threads, events
+        received via MPI must still be delivered to this thread, which
+        forwards them to the agent's current thread.
+
+        \param[in] id The ID of the local agent whose original thread
+        is desired.
+
+        \return The zero-based index of the thread with which the
+        agent was registered.  -1 if the agent is not local.
+    */
+    int getHomeThreadID(const AgentID id) const {
+        const int owner = ownerMap.find(id);
+        return ((owner != -1) && ((owner / threadsPerNode) ==
+                                  (int) myMPIrank)) ?
+            (owner % threadsPerNode) : -1;
     }
 
     /** Determine the thread ID for the specified agent.
@@ -127,10 +184,10 @@ public:
         is not local or invalid.
     */
     int getThreadID(const AgentID id, const int defaultThrID) const {
-        AgentIDSimulatorIDMap::const_iterator entry = agentThreadMap.find(id);
+        const AgentDirectory::Entry* const entry = agentDir.find(id);
         ASSERT((defaultThrID >= 0) && (defaultThrID < threadsPerNode));
-        return (entry != agentThreadMap.end() ? (int) entry->second :
-                defaultThrID);
+        return ((entry != NULL) && (entry->thread != -1)) ? entry->thread :
+            defaultThrID;
     }
     
     /** \brief Obtain the thread-based rank of the process on which a
@@ -162,8 +219,8 @@ public:
         This method can be used to determine the thread-based rank,
         that is: <i>getOwnerRank(id) * getThreadID(id)</i> of the
         thread on which a given agent resides.  This information is
-        directly obtained from the agentMap which already contains
-        agent--thread mapping.
+        directly obtained from the agent directory which already
+        contains agent--thread mapping.
 
         \note The values returned by this method make sense only after
         the communicator has been initialized and information
@@ -177,10 +234,24 @@ public:
         resides.  Otherwise this method returns a negative value.
     */
     virtual int getOwnerThreadRank(const AgentID& id) const override {
-        // Find iterator for given agent id
-        AgentIDSimulatorIDMap::const_iterator entry = agentMap.find(id);
-        // If id is valid then iterator is valid.
-        return (entry != agentMap.end()) ? (int) entry->second : -1;
+        return Communicator::getOwnerRank(id);
+    }
+
+    /** \brief Ignore partitions declared by the model.
+
+        In this communicator the owner of an agent is the global
+        thread ID (rather than the MPI rank) and agents are assigned
+        to threads independent of the declared partition.
+        Consequently, ranges of agents are always exchanged.
+
+        \param[in] kind The type of partition (unused).
+
+        \param[in] numAgents The total number of agents (unused).
+    */
+    virtual void setAgentPartition(const AgentPartition kind,
+                                   const AgentID numAgents) override {
+        UNUSED_PARAM(kind);
+        UNUSED_PARAM(numAgents);
     }
     
     /** \brief Obtain process configuration information.
@@ -359,14 +430,46 @@ public:
     */
     int receiveManyEvents(EventContainer& eventList, const int maxEvents,
                           int retryCount = 10);
-    
+
+    /** Send all the events and GVT messages queued for dispatch over
+        MPI by the worker threads.
+
+        This method is used only by the MPI progress thread (see
+        MultiThreadedSimulationManager::progressLoop) when the outbound
+        queue is enabled.  It drains the outbound queue and sends each
+        copy via the base class, after which the copy is recycled.
+
+        \return The number of events and messages sent.
+    */
+    int sendOutbound();
+
 protected:
+    /** Route events and GVT messages to other processes via an
+        outbound queue.
+
+        Once this method is called, sendEvent and sendMessage do not
+        make MPI calls for remote destinations.  Instead, each thread
+        adds a copy of the event or message to its own lock-free ring
+        in the outbound queue.  The MPI progress thread sends them via
+        the sendOutbound method.  This method must be called before
+        worker threads are started.
+    */
+    void enableOutboundQueue();
+
+    /** Stop using the outbound queue and revert to direct MPI calls.
+
+        This method must be called only after the worker threads have
+        stopped and the outbound queue has been drained via a final
+        call to sendOutbound.
+    */
+    void disableOutboundQueue();
+
     /** Set/update the logical thread ID for an agent on this physical
         process.
 
         This method is invoked as agents are registered and added to
         the differen threads on this physical process.  This method
-        updates entries in the agentThreadMap to enable looking-up
+        updates entries in the agent directory to enable looking-up
         thread ID's associated with a given agent.
 
         \param[in] id The ID of the agent
@@ -375,60 +478,40 @@ protected:
         actually managing the agent.
     */
     void setAgentThread(const AgentID id, const int thrIdx) {
-        agentThreadMap[id] = thrIdx;
+        agentDir.add(id).thread = thrIdx;
     }
 
-    /** Registers local agents (already in agentThreadMap) with all
-        processes.
-
-        This method creates a list of local agents and uses
-        Communicator::registerAgents(const std::vector<AgentID>&)
-        method to register agents with all the parallel processes.
-    */
-    void registerAllAgents();
+    /** Move a registered local agent to a different thread on this
+        process.
 
-private:
-    /** Method run on MPI-rank zero to aggregate and broadcast
-        agent--thread mapping.
+        This method updates both the thread and the global thread ID
+        (i.e., owner) of the agent so that subsequent events are
+        routed to the new thread.  Since the directory is read without
+        locks, this method must be called only when all the threads on
+        this process are quiescent (e.g., waiting on a barrier).
 
-        This method is invoked from the registerAgents() method in
-        this class only on rank zero.  This method first gathers the
-        agent--thread mapping from all other processes into the
-        supplied idThrList.  It then broadcasts the aggregate list to
-        all other processes.
+        \param[in] id The ID of the agent being moved.
 
-        \param[in,out] idThrList The list of local mappings.  This
-        list is modified by this method to contain the full list of
-        mappings.
+        \param[in] thrIdx The zero-based index of the thread that
+        manages the agent from now on.
     */
-    void gatherBroadcastAgentInfo(VecUint& idThrList);
-
-    /** Method run on MPI-rank not-zero to send and receive
-        agent--thread mapping.
-
-        This method is invoked on all processes that are not rank zero
-        to coordinate activites in the gatherBroadcastAgentInfo
-        method.  This first sends the local agent--thread mapping to
-        rank zero.  It then receives the broadcasted aggregate list
-        information.
+    void moveAgent(const AgentID id, const int thrIdx) {
+        AgentDirectory::Entry* const entry = agentDir.find(id);
+        ASSERT((entry != NULL) && (entry->thread != -1));
+        entry->thread = thrIdx;
+        entry->owner  = (myMPIrank * threadsPerNode) + thrIdx;
+    }
 
-        \param[in,out] idThrList The list of local mappings.  This
-        list is modified by this method to contain the full list of
-        mappings.        
-    */
-    void sendGatherAgentInfo(VecUint& idThrList);
-                          
-private:
-    /** \brief The zero-based thread IDs on this local process that
-        logically manages a given agent.
+    /** Registers local agents (already in agent directory) with all
+        processes.
 
-        As local agents are registered, the logical threads that
-	manages the agent are added to this map.  This information is
-	used to route local and incoming MPI events to appropriate
-	threads.
+        This method compresses the list of local agents on each thread
+        into ranges (see AgentRangeMap::encode) and uses the transport
+        to exchange the ranges with all the parallel processes.
     */
-    AgentIDSimulatorIDMap agentThreadMap;
+    void registerAllAgents();
 
+private:
     /** The simulation manager associated with this
         communicator.
 
@@ -470,6 +553,21 @@ private:
         process or same process).
     */
     unsigned int numMpiProcesses;
+
+    /** The queue of copies of events and GVT messages to be sent via
+        MPI by the progress thread.
+
+        This queue has a lock-free ring for each worker thread (see
+        SpscRingMTQueue) with the progress thread as the only
+        consumer.  This pointer is NULL when the progress thread is
+        not used.
+    */
+    MTQueue* outbound;
+
+    /** A temporary vector to hold the entries removed from the
+        outbound queue.  It is reused to avoid reallocations.
+    */
+    EventContainer outEvents;
 };
 
 END_NAMESPACE(muse)
@@ -23,11 +23,13 @@
 //---------------------------------------------------------------------------
 
 #include <mutex>
+#include <atomic>
 #include "Simulation.h"
 #include "SpinLockThreadBarrier.h"
 #include "mpi-mt/MTQueue.h"
 #include "Avg.h"
 #include "NumaMemoryManager.h"
+#include "SlabAllocator.h"
 
 BEGIN_NAMESPACE(muse);
 
@@ -121,6 +123,13 @@ public:
         simulation).
     */    
     virtual unsigned int getNumberOfThreads() const { return threadsPerNode; }
+
+    /** Determine if the threads use the conservative strategy.
+
+        \return This method returns true if the conservative
+        multi-threaded simulator (\c --simulator cmb-mt) is used.
+    */
+    bool isConservative() const override { return conservative; }
     
 protected:
     /** The default constructor for this class.
@@ -228,7 +237,11 @@ protected:
         <ul>
 
         <li>The type of MT-queue to be used (\c --mt-queue).</li>
-        
+
+        <li>Flag to enable stealing of agents by idle threads (\c
+        --work-stealing) and the idle threshold (\c
+        --steal-idle-thresh).</li>
+
         </ul>
 
 	\param argc[in,out] The number of command line arguments.
@@ -292,6 +305,23 @@ protected:
     */
     virtual void simulate();
 
+    /** Core simulation loop used by the conservative multi-threaded
+        simulator (\c --simulator cmb-mt).
+
+        Each iteration of this loop processes one window of safe
+        events (YAWNS).  All the threads on a process first drain the
+        events exchanged (via the MTQueue) in the previous window.
+        Next, thread #0 computes GVT for all the threads with a single
+        collective operation across processes (see
+        MultiThreadedSimulationManager::updateWindow).  Then all the
+        threads process events in the window [GVT, GVT + lookahead)
+        in parallel without any further synchronization.  Events
+        sent in a window are at or beyond the end of the window (due
+        to lookahead) and are processed in subsequent windows.  This
+        method returns once GVT has reached the end time.
+    */
+    void simulateWindows();
+
     /** \brief Schedule the specified event.
         
 	Agents actually use this method to schedule all events.
@@ -318,15 +348,13 @@ protected:
 
         This method overrides the default implementation in the base
         class.  First it passess control to the base class to perform
-        the standard garbage collection process.  Next, this method
-        calls EventRecycler::processPendingDeallocs() to try to
-        reclaim pending events after a garbage collection cycle has
-        completed.  This is done here because EventRecycler::
-        processPendingDeallocs method is a time consuming one
-        (particularly when there are many events pending) and each
-        iteration through it has to be successful.
-
-        \see EventRecycler::processPendingDeallocs()
+        the standard garbage collection process.  Next, when events
+        are shared between threads, this method calls
+        EventRecycler::tryAdvanceEpoch() so that events retired by
+        threads can be reclaimed once every thread has completed a
+        garbage collection cycle.
+
+        \see EventRecycler::announceEpoch()
      */
     virtual void garbageCollect() override;
     
@@ -335,8 +363,14 @@ protected:
         This method is periodically invoked from the core simulation
         loop to process all events currently present in incomingEvents
         queue.  The events are from other threads or remote processes.
+        Events for agents that have been stolen by another thread are
+        forwarded to the agent's current thread.
+
+        \return The number of regular events (that is, events other
+        than GVT and control messages) that were scheduled or
+        forwarded by this method.
     */
-    virtual void processIncomingEvents();
+    virtual int processIncomingEvents();
 
     /** Read messages (if any) from MPI and add them to incomingEvent
         queues of various threads.
@@ -357,6 +391,21 @@ protected:
     */
     virtual int processMpiMsgs() override;
 
+    /** Park this thread after it has been idle for a while.
+
+        This method overrides the base class method to recheck the
+        incoming event queue (events from other threads and those
+        received over MPI) and pending steal requests before parking.
+        A parked thread is woken up when another thread adds an event
+        to its incoming queue (see
+        MultiThreadedSimulationManager::addIncomingEvent) or posts a
+        steal request.
+
+        \return This method returns true if the thread was woken up
+        (or found work) before the park timed out.
+    */
+    virtual bool parkIdleThread() override;
+
     /** Overridable method to report additional local statistics (from
         derived classes) at the end of simulation.
 
@@ -393,6 +442,31 @@ protected:
         this method always returns -1.
     */
     int getNumaNodeOfCpu(const int cpu) const;
+
+    /** Request to steal agents from other threads on this process.
+
+        This method is called from the core simulation loop (after
+        garbage collection has determined that this thread has been
+        mostly idle) if work-stealing has been enabled via the \c
+        --work-stealing command-line argument.  If no other thread has
+        a pending request, this method posts a request (with this
+        thread as the thief) and calls serviceStealRequest.
+    */
+    void requestSteal();
+
+    /** Participate in stealing agents between threads.
+
+        This method is invoked by all the threads on this process once
+        a steal request has been posted (see requestSteal).  All the
+        threads repeatedly wait on threadBarrier and process their
+        incoming events until no events are in transit between
+        threads, so that agents and their events are quiescent.  The
+        thief then calls
+        MultiThreadedSimulationManager::stealAgents to move agents
+        from the thread with the largest backlog.  Finally, all the
+        threads wait on the barrier again before resuming simulation.
+    */
+    void serviceStealRequest();
     
 protected:
     /** The number of threads to be spun-up for each MPI process.
@@ -520,50 +594,13 @@ private:
     */
     EventContainer& mainPendingDeallocs;
 
-    /** Track the fraction of events reclaimed from EventRecycler's
-        pendingDeallocs list at end of each GC cycle.  This counter is
-        updated in garbageCollect method in this class.  This value
-        essentially indicates the number of times EventRecycler::
-        processPendingDeallocs() method was called and the fraction of
-        events that were successfully reclaimed.  If this value is low
-        then we need fewer calles to the method.
+    /** Track the fraction of retired events reclaimed by
+        EventRecycler::announceEpoch() each time the reclamation epoch
+        advances.  This value is updated in the main simulation loop
+        in this class and is reported as a statistic at the end of
+        simulation.
     */
     Avg deallocsPerCall;
-    
-    /** Command-line argument to set the desired fraction of events
-        cleared from pendingDeallocs list for each GC cycle.  This
-        value is a fraction in the range 0.01 to 1.0.  It cannot be
-        set to zero. This value is used to double the deallocRate
-        until the desired deallocFrac is achieved.  If the fraction of
-        deallocated events is more than 1.5 times this value then the
-        deallocRate is halved (but not below 1).
-    */
-    double deallocThresh;
-
-    /** The current rate at which processPendingDeallocs() should be
-        called.  This value is updated after each call to
-        processPendingDeallocs() method to reach the specified
-        deallocFrac threshold value, the following manner:
-
-        \code
-
-        const double fracRecovered = EventRecycler::processPendingDallocs();
-        if (fracRecovered < deallocThresh) {
-            deallocRate *= 2;
-        } else if (fracRecovered > (deallocThresh * 1.5)) {
-            deallocRate = std::max(1, deallocRate / 2);
-        }
-    */
-    int deallocRate;
-
-    /** This is the counter used to determine if
-        processPendingDeallocs() method should be called.  This
-        counter is initialized to deallocRate.  It is decremented in
-        each call to garbageCollect() method.  If this counter reaches
-        zero, then processPendingDeallocs() is called and it is reset
-        back to deallocRate.
-    */
-    int deallocTicker;
 
     /** Average number of events processed as a single batch from the
         incomingEvents queue.
@@ -626,22 +663,21 @@ private:
     */
     static std::vector<int> numaIDofThread;
 
-#if USE_NUMA == 1
-    /** Reference to main Numa memory manager to add list of allocated
-        pages to finally free at end of simulation.
+    /** Reference to main thread's slab allocator to add slabs of
+        events to finally free at end of simulation.
 
-        This reference always referes to the NumaMemoryManager on the
-        main thread.  This object is used for the following reason --
-        Event deallocations on various threads cannot be fully
+        This reference always referes to the EventRecycler::slabs on
+        the main thread.  This object is used for the following reason
+        -- Events allocated by various threads cannot be fully
         reclaimed until all agents are finalized (and they relinquish
         references to events in their internal queues).  Consequently,
-        at the end of the MultiThreadedSimulation::simulate() method,
-        each thread (other than the main thread) adds its NUMA blocks
-        to the main numa manager. This list is finally cleaned-up in
-        the main thread.
+        at the end of the simulate() method, each thread (other than
+        the main thread) adds its slabs to the main thread's slab
+        allocator. The slabs are finally freed in the main thread.
     */
-    NumaMemoryManager& mainNumaManager;
+    SlabAllocator& mainSlabs;
 
+#if USE_NUMA == 1
     /** Reference to main-thread's Numa memory manager to add list of
         allocated pages to finally free at end of simulation.
 
@@ -671,18 +707,6 @@ private:
 
 #endif   // USE_NUMA == 1
 
-    /** Runtime flag to enable/disable redistribution of unused memory
-        chunks when using NUMA-aware memory management.
-
-        This flag is used to determine if redistribution of unused
-        memory chunks should be disabled.  This is primarily used for
-        experimental purposes only and typically redistribution should
-        be enabled.  Redistribution can be disabled on the \c
-        --dont-redist command-line argument to multi-threaded
-        simulation.
-    */
-    bool doRedist;
-
     /** Rate at which incoming messages are to be processed.
 
         This instance variable tracks a command-line argument to
@@ -694,6 +718,100 @@ private:
         default value is 1 (check every time).
     */
     int msgCheckRate;
+
+    /** Flag to indicate if idle threads can steal agents from other
+        threads on this process.
+
+        This flag is set via the \c --work-stealing command-line
+        argument.  Work-stealing requires events to be shared between
+        threads (\c --use-shared-events) as agents on different
+        threads use separate reference counters on shared events.
+    */
+    bool doWorkStealing;
+
+    /** The minimum number of idle iterations of the simulation loop,
+        between garbage collections, for this thread to steal agents.
+
+        This value is set via the \c --steal-idle-thresh command-line
+        argument.
+    */
+    int stealIdleThresh;
+
+    /** The number of iterations of the simulation loop in which this
+        thread had no events to process.  This value is reset each
+        time garbage collection is performed.
+    */
+    int idleCount;
+
+    /** Flag set after garbage collection if idleCount exceeded
+        stealIdleThresh.  This flag is used to steal agents at a safe
+        point in the core simulation loop (rather than from within
+        garbage collection).
+    */
+    bool stealPending;
+
+    /** Flag set once GVT has swept past the end time on this thread.
+        Agents are not stolen from threads that are done.
+    */
+    bool doneSimulating;
+
+    /** The number of times this thread successfully stole agents. */
+    size_t stealCount;
+
+    /** The number of agents stolen by this thread. */
+    size_t agentsStolen;
+
+    /** The number of agents stolen from this thread by other
+        threads.
+    */
+    size_t agentsLost;
+
+    /** The number of pending events that moved to this thread along
+        with agents stolen by this thread.
+    */
+    size_t eventsStolen;
+
+    /** The thread ID (i.e., index) of the thread that has requested
+        to steal agents.  This value is -1 if there is no pending
+        request.  This variable is shared by all threads.
+    */
+    static std::atomic<int> stealRequest;
+
+    /** The number of threads that have completed the core simulation
+        loop.  When work-stealing is enabled, threads that are done
+        continue to participate in steal requests until all the
+        threads are done.
+    */
+    static std::atomic<int> doneThreads;
+
+    /** The number of threads that processed incoming events in the
+        current round of draining events in serviceStealRequest.  This
+        variable is shared by all threads.
+    */
+    static std::atomic<int> drainActivity;
+
+    /** Flag to indicate if the scheduler queue in use supports
+        detaching agents.  This flag is cleared (by the thief) on the
+        first steal attempt if the queue does not support detaching
+        agents.
+    */
+    static bool stealingSupported;
+
+    /** Flag to indicate if the conservative strategy is to be used.
+        This flag is set by MultiThreadedSimulationManager if the \c
+        --simulator cmb-mt command-line argument is specified.
+    */
+    static bool conservative;
+
+    /** The lookahead used with the conservative strategy.  This value
+        is set via the \c --cmbLookahead command-line argument.
+    */
+    double lookAhead;
+
+    /** The number of windows processed (used only with the
+        conservative strategy).
+    */
+    size_t numWindows;
 };
 
 END_NAMESPACE(muse);
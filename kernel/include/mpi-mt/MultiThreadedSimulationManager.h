@@ -22,9 +22,11 @@
 //
 //---------------------------------------------------------------------------
 
+#include <atomic>
 #include <mutex>
 #include "mpi-mt/MultiThreadedSimulation.h"
 #include "EventRecycler.h"
+#include "IdleParker.h"
 
 BEGIN_NAMESPACE(muse);
 
@@ -132,6 +134,20 @@ public:
     */
     bool registerAgent(Agent* agent, const int threadRank = -1) override;
 
+    /** Get the memory domain of each thread on this process.
+
+        This method overrides the base class method to return the
+        memory domain (NUMA node, or L3 cache domain on single-node
+        machines) of the CPU to which each thread is pinned.  The
+        domains are used by partitionAgents to place heavily
+        communicating agents on threads in the same domain.
+
+        \return The domain of each thread on this process.
+    */
+    std::vector<int> getThreadDomains() const override {
+        return threadDomains;
+    }
+
     /** \brief Start the Simulation
 
         This method should be called after all of the appropriate
@@ -172,16 +188,81 @@ public:
 
         \param[in] event The event to be added.  This pointer cannot
         be NULL.
+
+        \param[in] srcThrIdx The index of the thread adding the event.
+        By default, the EventRecycler's index for the calling thread
+        is used.  Events received over MPI are added with -1 (while
+        holding mpiMutex) so that their order is preserved regardless
+        of the thread pumping MPI messages.
     */
-    inline void addIncomingEvent(const size_t destThrIdx, muse::Event* event) {
+    inline void addIncomingEvent(const size_t destThrIdx, muse::Event* event,
+                                 const int srcThrIdx =
+                                 EventRecycler::threadID) {
         ASSERT(destThrIdx < threads.size());
         ASSERT(event != NULL);
-        // The EventRecyler has the current thread's index. Use that
-        // directly to determine the index of the calling thread.
-        threads[destThrIdx]->incomingEvents->add(EventRecycler::threadID,
-                                                 destThrIdx, event);
+        MultiThreadedSimulation* const dest = threads[destThrIdx];
+        dest->incomingEvents->add(srcThrIdx, destThrIdx, event);
+        // Wake-up the destination thread if it is parked.
+        if (dest->idleParker != NULL) {
+            dest->idleParker->wakeup();
+        }
+    }
+
+    /** Wake-up all the threads on this process that are parked.
+
+        This method is used when all the threads must participate in
+        an operation (such as stealing agents) to wake-up threads that
+        have been parked because they were idle (see IdleParker).
+    */
+    void wakeupThreads();
+
+    /** Wake-up the MPI progress thread if it is parked.
+
+        This method is called by MultiThreadedCommunicator after it
+        adds an event or GVT message to the outbound queue, so that
+        the progress thread (see progressLoop) sends it promptly.
+        This method is cheap if the progress thread is not parked.
+    */
+    inline void wakeupProgressThread() {
+        if (progressParker != NULL) {
+            progressParker->wakeup();
+        }
     }
 
+    /** \brief Move agents from the most loaded thread to an idle thread.
+
+        This method is invoked (via
+        MultiThreadedSimulation::serviceStealRequest) by an idle thread
+        while all the other threads on this process are waiting on the
+        thread barrier.  This method identifies the thread with the
+        largest backlog of pending events and moves a subset of its
+        agents -- along with their pending events in the scheduler
+        queue and their input/output/state history -- to the thief.
+        The agent-to-thread routing information in the communicator is
+        updated accordingly.
+
+        \note Moving an agent is accounted by the GVT managers as a
+        message from the victim to the thief to ensure GVT estimates
+        remain correct.
+
+        \param[in,out] thief The idle thread requesting agents.  This
+        pointer cannot be NULL.
+    */
+    void stealAgents(MultiThreadedSimulation* thief);
+
+    /** \brief Compute GVT for the next window of safe events on all
+        the threads (used only by \c --simulator cmb-mt).
+
+        This method is invoked by thread #0 (see
+        MultiThreadedSimulation::simulateWindows) while all the other
+        threads are waiting on the thread barrier.  It combines the
+        information from the SimpleGVTManager of each thread and
+        performs a single collective operation across processes.  It
+        then receives all the events sent to this process over MPI
+        prior to this window and sets GVT on all the threads.
+    */
+    void updateWindow();
+
 protected:
     /** \brief Convenience method to perform initialization/setup just
         before agents are initialized.
@@ -203,7 +284,9 @@ protected:
         to serialize reading events to ensure MT-safe operations.
 
         \note This method is called from multiple sub-threads
-        logically managed by this class.
+        logically managed by this class.  If a dedicated MPI progress
+        thread is used (see progressLoop), this method only yields the
+        CPU to the progress thread (see yieldToProgress).
         
         \note Events read by this method could be destined to any of
         the threads on this nodes.  This method appropriately
@@ -216,6 +299,54 @@ protected:
     */
     virtual int processMpiMsgs() override;
 
+    /** Add events received over MPI to the incomingEvent queues of
+        the threads to which they are destined.
+
+        This is a refactored helper method used by processMpiMsgs and
+        progressLoop.  The events are read from the mpiEvents list,
+        which is cleared by this method.  The caller must ensure that
+        only one thread at a time calls this method.
+
+        \return The number of events dispatched.
+    */
+    int dispatchMpiEvents();
+
+    /** The main method of the dedicated MPI progress thread.
+
+        This method is used only if the \c --mpi-progress-thread
+        command-line argument is specified.  In this case, this thread
+        performs all the MPI operations during simulation.  It
+        repeatedly sends the events and GVT messages queued by the
+        worker threads (see MultiThreadedCommunicator::sendOutbound)
+        and dispatches events received over MPI to the threads.  The
+        worker threads do not read MPI messages and no longer contend
+        for MPI.  When there is no work, this thread is parked via
+        progressParker (and woken up by wakeupProgressThread).  This
+        method returns after stopProgress is set (and queued events
+        have been sent).
+
+        \param[in] cpu The CPU to which this thread is to be pinned.
+        If this value is -1, then the thread is not pinned.
+    */
+    void progressLoop(const int cpu);
+
+    /** Determine the CPU to which the MPI progress thread is to be
+        pinned.
+
+        If \c --mpi-progress-cpu was not specified, then this method
+        looks for an SMT (hyper-thread) sibling of a CPU used by a
+        worker thread that is not itself used by a worker thread.
+        This enables the progress thread to share a core without
+        interfering with worker threads.
+
+        \param[in] cpuList The list of CPUs available to this process
+        in the order in which worker threads are pinned to them.
+
+        \return The CPU to be used.  -1 if a suitable CPU was not
+        found.
+    */
+    int getProgressThreadCpu(const std::vector<int>& cpuList) const;
+
     /** Refactored utility method to create threads.
 
         This method is called only once from the initialize() method
@@ -281,7 +412,78 @@ private:
         don't waste CPU cycles on recreating/resizing the container.
     */
     EventContainer mpiEvents;
-    
+
+    /** The number of events received over MPI and dispatched to the
+        threads.  This value is used by updateWindow to receive all
+        the events sent to this process before processing a window.
+    */
+    long mpiEventsRecvd;
+
+    /** Flag to indicate if a dedicated thread performs all MPI calls.
+
+        This flag is set via the \c --mpi-progress-thread command-line
+        argument.  It is used only if there are multiple processes.
+    */
+    bool useProgressThread;
+
+    /** The CPU to which the MPI progress thread is to be pinned.
+
+        This value is set via the \c --mpi-progress-cpu command-line
+        argument.  The default value of -1 causes a suitable CPU to be
+        chosen (see getProgressThreadCpu).
+    */
+    int progressCpu;
+
+    /** Flag set by the main thread to stop the MPI progress thread. */
+    std::atomic<bool> stopProgress;
+
+    /** The maximum time (in microseconds) for which the MPI progress
+        thread is parked when it has no work.
+
+        This value is set via the \c --mpi-progress-park-usec
+        command-line argument.  The progress thread is woken up when
+        events are added to the outbound queue.  However, it must
+        still periodically poll MPI for incoming messages.  So this
+        value bounds the latency for receiving remote events.
+    */
+    int progressParkUsec;
+
+    /** The parker used by the MPI progress thread when it has no
+        work.  This object is created only while the progress thread
+        is running.  Otherwise this pointer is NULL.
+    */
+    IdleParker* progressParker;
+
+    /** Flag to indicate if the MPI progress thread shares a CPU with
+        a worker thread.
+
+        In this case, worker threads yield their CPU each time they
+        would have read MPI messages themselves (see processMpiMsgs).
+        Otherwise, the progress thread is starved by busy (or idle but
+        spinning) worker threads and remote events are delayed,
+        causing excessive rollbacks (or no progress at all).
+    */
+    bool yieldToProgress;
+
+    /** The policy used to order CPUs for pinning threads.
+
+        This value is set via the \c --thread-placement command-line
+        argument.  It is one of: linear (default), core, compact, or
+        scatter (see CpuTopology).
+    */
+    std::string threadPlacement;
+
+    /** The CPUs in the order in which threads are pinned to them.
+        Thread i is pinned to entry (i % size) in this list.  This
+        list is setup in createThreads.
+    */
+    std::vector<int> threadCpus;
+
+    /** The memory domain of each thread on this process.  This list
+        is setup in createThreads (see getThreadDomains).
+    */
+    std::vector<int> threadDomains;
+
     /** The only constructor for this class.
 
         The constructor merely initializes all the pointers and
@@ -0,0 +1,273 @@
+#ifndef MUSE_SPSC_RING_MT_QUEUE_H
+#define MUSE_SPSC_RING_MT_QUEUE_H
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <atomic>
+#include <mutex>
+#include "MTQueue.h"
+
+BEGIN_NAMESPACE(muse);
+
+/** A shared queue that uses one lock-free single-producer,
+    single-consumer (SPSC) ring for each source thread.
+
+    This class implements the features of the abstract MTQueue base
+    class.  Each thread on a process has its own instance of this
+    queue and is the only consumer of events from it.  Since every
+    source thread has its own ring, the set of queues on a process
+    forms a matrix of rings -- one for each (source thread,
+    destination thread) pair.  Consequently, producers never contend
+    with each other, which is important with 32 or more threads per
+    process.  Key implementation aspects include:
+
+    <ul>
+
+    <li>Each ring is a fixed-size array (with a power-of-2 capacity)
+    with a head index (updated only by the consumer) and a tail index
+    (updated only by the producer) on separate cache lines to avoid
+    false sharing.</li>
+
+    <li>The producer caches the head of the ring and rereads it only
+    when its cached copy shows the ring as full.  A batch of events (added via the overloaded add
+    method) is published with a single store to the tail.</li>
+
+    <li>The consumer drains a ring with one load of the tail and one
+    store to the head -- no read-modify-write atomic operations or
+    locks are used on this fast path.</li>
+
+    <li>When a ring is full, events are spilled to a mutex-protected
+    list for the ring.  Once a ring has spilled, the producer
+    continues to spill until the consumer has drained the spill list
+    to preserve the order of events from each source thread.</li>
+
+    <li>Events received over MPI (that is, with a source thread index
+    of -1) are added to a separate ring.  Such events are added by
+    any thread that is pumping MPI messages.  The callers must
+    serialize such additions (which MultiThreadedSimulationManager
+    does via its MPI mutex) so that the ring has only one producer at
+    a time.  This also preserves the order of events received over
+    MPI, so that an anti-message never overtakes its event.  Events
+    with any other index are always added to a shared,
+    mutex-protected list.</li>
+
+    </ul>
+*/
+class SpscRingMTQueue : public muse::MTQueue {
+public:
+    /** The constructor.
+
+        \param[in] numThreads The number of threads on this process
+        that may add events to this queue.  A ring is created for each
+        thread.
+
+        \param[in] ringSize The number of entries in each ring.  This
+        value is rounded up to the nearest power of 2.
+    */
+    SpscRingMTQueue(int numThreads, int ringSize = 1024);
+
+    /** Add an event into the queue.
+
+        This method adds the event to the ring for the source thread
+        and publishes it immediately.  If the ring is full, the event
+        is added to the spill list for the ring.
+
+        \param[in] srcThrIdx The zero-based index of the thread
+        calling this method, or -1 for events received over MPI.
+        Each ring must be used only by one thread at a time.
+
+        \param[in] destThrIdx The index of the destination thread on
+        the local process which will process the event. This value is
+        not used by this method.
+
+        \param[in] event Pointer to a MUSE event.  This pointer cannot
+        be NULL.
+    */
+    virtual void add(int srcThrIdx, int destThrIdx,
+                     muse::Event* event) override;
+
+    /** Add a big batch of events into the queue.
+
+        This method copies as many events as possible into the ring
+        for the source thread and publishes all of them with a single
+        update to the tail of the ring.  The remaining events (if any)
+        are spilled.
+
+        \param[in] srcThrIdx The zero-based index of the thread
+        calling this method.
+
+        \param[in] destThrIdx The index of the destination thread on
+        the local process which will process the event. This value is
+        not used by this method.
+
+        \param[in] eventList The list of events to be added to this
+        queue.
+    */
+    virtual void add(int srcThrIdx, int destThrIdx,
+                     EventContainer& eventList) override;
+
+    /** Remove all the events in this queue into a given local list.
+
+        This method must be called only by the thread that owns this
+        queue.  It drains each ring in turn, followed by spilled
+        events (if any).
+
+        \param[out] eventList The container to which events are to be
+        added.  Eisting entries in this list are left unmodified.
+
+        \param[in] destThrIdx The index of the destination thread on
+        the local process which will process the event.  This value is
+        not used by this method.
+
+        \param[in] maxEvents The maximum number of events to be
+        returned by this method.  If this parameter is -1, then all
+        the pending events are returned.
+    */
+    virtual void removeAll(EventContainer& eventList, int destThrIdx,
+                           int maxEvents = -1) override;
+
+    /** The polymorphic destructor.
+
+        The destructor releases the memory used by the rings.  Events
+        still in the queue are not released -- the user of this queue
+        (see MultiThreadedSimulation::finalize) removes and releases
+        them prior to deleting the queue.
+    */
+    virtual ~SpscRingMTQueue() override;
+
+protected:
+    /** A single-producer, single-consumer ring of events.  The
+        members used by the producer and the consumer are placed on
+        separate cache lines to avoid false sharing.
+    */
+    struct Ring {
+        /// The constructor to initialize the indexes.
+        Ring() : tail(0), cachedHead(0), head(0), spilled(false),
+                 slots(NULL) {}
+        /// Index of the next entry to be written.  Set by producer.
+        alignas(64) std::atomic<size_t> tail;
+        /// Producer's copy of the head.  Used only by producer.
+        size_t cachedHead;
+        /// Index of the next entry to be read.  Set by consumer.
+        alignas(64) std::atomic<size_t> head;
+        /// Flag set by the producer when events have been spilled.
+        /// It is cleared by the consumer when the spill is drained.
+        alignas(64) std::atomic<bool> spilled;
+        /// The entries in the ring.  NULL for the shared list.
+        muse::Event** slots;
+        /// The mutex used to protect the spill list.
+        std::mutex spillMutex;
+        /// Events that did not fit into the ring.
+        EventContainer spill;
+    };
+
+    /** Copy events into a ring without publishing them.  This method
+        must be called only by the producer for the ring.
+
+        \param[in,out] ring The ring to which events are to be added.
+
+        \param[in] events The array of events to be copied.
+
+        \param[in] count The number of events in the array.
+
+        \param[in,out] tail The producer's tail for the ring.  This
+        value is advanced by the number of events copied.
+
+        \return The number of events copied into the ring.  This
+        value is less than count if the ring became full.
+    */
+    size_t copyToRing(Ring& ring, muse::Event* const* events,
+                      const size_t count, size_t& tail);
+
+    /** Add events that did not fit into the ring to its spill list.
+
+        If the consumer has drained the spill list since the caller
+        checked, then the events are added to the ring instead.
+
+        \param[in,out] ring The ring to whose spill list events are to
+        be added.
+
+        \param[in] events The array of events to be added.
+
+        \param[in] count The number of events in the array.
+    */
+    void spill(Ring& ring, muse::Event* const* events, const size_t count);
+
+    /** Move events from a ring into a given list.  This method must be
+        called only by the consumer.
+
+        \param[in,out] ring The ring from which events are to be
+        removed.
+
+        \param[out] eventList The list to which events are added.
+
+        \param[in] maxEvents The maximum number of events to remove.
+
+        \return The number of events removed.
+    */
+    size_t drainRing(Ring& ring, EventContainer& eventList,
+                     const size_t maxEvents);
+
+    /** Obtain the ring to be used for events from a given thread.
+
+        \param[in] srcThrIdx The index of the source thread or -1 for
+        events received over MPI.
+
+        \return The ring for the source thread.  The shared list is
+        returned for invalid thread indexes.
+    */
+    inline Ring& getRing(const int srcThrIdx) {
+        if ((srcThrIdx >= 0) && (srcThrIdx < numRings)) {
+            return rings[srcThrIdx];
+        }
+        return rings[(srcThrIdx == -1) ? numRings : (numRings + 1)];
+    }
+
+private:
+    /** The number of threads (each with its own ring). */
+    const int numRings;
+
+    /** The capacity (a power of 2) of each ring. */
+    size_t capacity;
+
+    /** Mask used to convert ring indexes to slot positions.  This
+        value is capacity - 1.
+    */
+    size_t mask;
+
+    /** The array of rings.  The memory for the rings is allocated
+        with cache-line alignment in the constructor.  The array has
+        numRings + 2 entries.  The entry at numRings is used for events
+        received over MPI.  The last entry (which has no slots) is
+        used for events from threads that do not have a ring.
+    */
+    Ring* rings;
+
+    /** The slots for all the rings.  The slots for ring i start at
+        position i * capacity (for 0 <= i <= numRings).
+    */
+    muse::Event** slots;
+};
+
+END_NAMESPACE(muse);
+
+#endif
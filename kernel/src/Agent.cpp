@@ -29,14 +29,15 @@
 #include "BinaryHeapWrapper.h"
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 #include "EventQueue.h"
 #include "EventAdapter.h"
 
 using namespace muse;
 
 Agent::Agent(AgentID id, State* agentState)
-    : myID(id), lvt(0), myState(agentState), mustSaveState(true),
-      numRollbacks(0), numScheduledEvents(0), numProcessedEvents(0),
+    : myID(id), lvt(0), myState(agentState), tier2MT(NULL),
+      mustSaveState(true), lookahead(0), epoch(0), numRollbacks(0), numScheduledEvents(0), numProcessedEvents(0),
       numMPIMessages(0), numCommittedEvents(0), numSchedules(0) {
     // Initialize kernel to an invalid value.
     kernel = NULL;
@@ -101,7 +102,7 @@ Agent::processNextEvents(muse::EventContainer& events) {
     const bool usingSharedEvents = kernel->usingSharedEvents();
     // Add the events to our input queue only when state saving is
     // enabled -- that is we have more than 1 process and rollbacks
-    // are possible.
+    // are possible (that is, not a conservative simulation).
     if (mustSaveState) {
         for (EventContainer::iterator curr = events.begin();
              (curr != events.end()); curr++) {
@@ -114,8 +115,8 @@ Agent::processNextEvents(muse::EventContainer& events) {
     } else {
         // keep track number of processed events -- this would be
         // normally done during garbage collection.  However, in 1 LP
-        // mode we do not add events to input queue and consequently
-        // we need to track it here.
+        // (or conservative) mode we do not add events to input queue
+        // and consequently we need to track it here.
         numCommittedEvents += events.size();
     }
     DEBUG(std::cout << "Agent " << getAgentID() << " is scheduled to process "
@@ -143,10 +144,11 @@ Agent::processNextEvents(muse::EventContainer& events) {
     saveState();
 
     if (!mustSaveState) {
-        // This applicable only in sequential mode. So the ASSERT
-        // establishes the necessary conditions.
-        ASSERT((kernel->getNumberOfProcesses() == 1) &&
-               (kernel->getNumberOfThreads()   == 1));
+        // This applicable only in sequential or conservative mode. So
+        // the ASSERT establishes the necessary conditions.
+        ASSERT(kernel->isConservative() || isConservative() ||
+               ((kernel->getNumberOfProcesses() == 1) &&
+                (kernel->getNumberOfThreads()   == 1)));
         // Decrease reference and free-up events as we are not adding to 
         // input queue for handling rollbacks that cannot occur in this case.
         for (muse::Event* curr : events) {
@@ -157,13 +159,28 @@ Agent::processNextEvents(muse::EventContainer& events) {
                 // The order of decreasing reference counters is important
                 EventRecycler::decreaseInputRefCount(curr);
             }
-            ASSERT( EventRecycler::getReferenceCount(curr) == 1 );
+            // Optimistic senders retain a reference to events sent
+            // to a conservative agent in their output queues.
+            ASSERT( isConservative() ||
+                    (EventRecycler::getReferenceCount(curr) == 1) );
             ASSERT( EventRecycler::getInputRefCount(curr)  == 0 );
             EventRecycler::decreaseOutputRefCount(curr);
         }
     }
 }
 
+void
+Agent::setConservative(const Time lookahead) {
+    if (lookahead <= 0) {
+        std::cerr << "Error: Lookahead of conservative agent " << myID
+                  << " must be positive (got " << lookahead << ").\n";
+        abort();
+    }
+    ASSERT(kernel == NULL);
+    this->lookahead = lookahead;
+    mustSaveState   = false;
+}
+
 State*
 Agent::cloneState(State* state) {
     return state->getClone();
@@ -193,6 +210,7 @@ Agent::scheduleEvent(Event* e) {
     // Fill in the sent time and sender agent id info.
     EventAdapter::setSentTime(e, getLVT());
     EventAdapter::setSenderAgentID(e, getAgentID());
+    EventAdapter::setEpoch(e, epoch);
     ASSERT(e->getSentTime() >= getTime(GVT));
     
     // Check to make sure we don't schedule past the simulation end time.
@@ -266,6 +284,9 @@ Agent::doRollbackRecovery(const Event* stragglerEvent,
     // Next clean-up output queue. This will cause future clean-up of
     // input queue if there are cyclic dependencies.
     doCancellationPhaseOutputQueue(restoredTime);
+    // Events sent from here onwards are not canceled by the
+    // anti-messages sent above.
+    epoch++;
     
     // We need to rollback all SimStreams here.
     oss.rollback(restoredTime);
@@ -431,22 +452,40 @@ Agent::sendAntiMessage(const muse::Time minSendTime,
     DEBUG(std::cout << "- Sending anti-message: " << *currEvt
                     << ", minSendTime: " << minSendTime << std::endl);
     const AgentID receiver = currEvt->getReceiverAgentID();
-    if (!kernel->isAgentLocal(myID, receiver) && !useSharedEvents) {
+    const bool remoteEvent = (!kernel->isAgentLocal(myID, receiver) &&
+                              !useSharedEvents);
+    if (remoteEvent && (currEvt->getReferenceCount() == 1)) {
         // Directly use the event instead of making copy for remote
         // agent as copy is sent on the wire right away.
         EventAdapter::setSenderInfo(currEvt, currEvt->getSenderAgentID(),
                                     minSendTime);
+        EventAdapter::setEpoch(currEvt, epoch);
         EventAdapter::makeAntiMessage(currEvt);
         kernel->scheduleEvent(currEvt);
         return;   // All done in this case. Early return to streamline code
     }
-    // Send an anti-message to the agent on the same process (could be
-    // different thread) so that it rolls back. Since pointers are
-    // shared, a duplicate needs to be made.
-    Event* const antiEvent = Event::create(receiver, currEvt->getReceiveTime());
+    Event* antiEvent = NULL;
+    if (remoteEvent) {
+        // The event is still being sent via a non-blocking send (it
+        // has an extra reference) and its buffer cannot be modified.
+        // So send a verbatim copy (of the same size to ensure the
+        // copy is sent with the same MPI tag and does not overtake
+        // the original event).
+        const int eventSize = EventAdapter::getEventSize(currEvt);
+        char* buffer = Event::allocate(eventSize, receiver);
+        std::memcpy(buffer, reinterpret_cast<char*>(currEvt), eventSize);
+        antiEvent = reinterpret_cast<Event*>(buffer);
+        EventAdapter::setReferenceCount(antiEvent, 1);
+    } else {
+        // Send an anti-message to the agent on the same process
+        // (could be different thread) so that it rolls back. Since
+        // pointers are shared, a duplicate needs to be made.
+        antiEvent = Event::create(receiver, currEvt->getReceiveTime());
+    }
     // Setup sender and send-time information.
     EventAdapter::setSenderInfo(antiEvent, currEvt->getSenderAgentID(),
                                 minSendTime);
+    EventAdapter::setEpoch(antiEvent, epoch);
     EventAdapter::makeAntiMessage(antiEvent);
     if (!kernel->scheduleEvent(antiEvent)) {
         // The scheduler rejected our anti-message.  This is normal
@@ -456,9 +495,13 @@ Agent::sendAntiMessage(const muse::Time minSendTime,
         // When event sharing is enabled, anti-messages sent to
         // another thread (on same process) cannot be immediately
         // reclaimed (until the receiving thread has processed
-        // it.). But we don't have an output reference so decrease
-        // output reference count on the anti-message.
-        ASSERT(!kernel->isAgentLocal(myID, receiver) && useSharedEvents);
+        // it.). Similarly, anti-messages sent to a remote process via
+        // non-blocking sends are reclaimed when the send completes.
+        // Kernels with a shared scheduler (mpi-mt-shm) also enqueue
+        // anti-messages to local agents.  But we don't have an output
+        // reference so decrease output reference count on the
+        // anti-message.
+        ASSERT(useSharedEvents || !kernel->isAgentLocal(myID, receiver));
         EventRecycler::decreaseOutputRefCount(useSharedEvents, antiEvent);
     }    
 }
@@ -502,10 +545,11 @@ Agent::doCancellationPhaseInputQueue(const Time& restoredTime,
         // addressing a missing/unhandled-case.  The code is a
         // simplification of a series of if-else statements that were
         // here prior to this revision.
-        if (!((straggler->getSenderAgentID() == currentEvent->getSenderAgentID()) &&
-              (currentEvent->getSentTime() >= straggler->getSentTime()) &&
-              (straggler->isAntiMessage()))) {
-            ASSERT((straggler->getSenderAgentID() != currentEvent->getSenderAgentID()) || !straggler->isAntiMessage() || (currentEvent->getSentTime() < straggler->getSentTime()));
+        // The rollback epoch check (see EventAdapter::isCanceledBy)
+        // retains events resent after the anti-message when events
+        // are not delivered in FIFO order.
+        if (!(straggler->isAntiMessage() &&
+              EventAdapter::isCanceledBy(currentEvent, straggler))) {
             reschedule.push_back(currentEvent);
             DEBUG(std::cout << "*Rescheduling: " << *currentEvent << std::endl);
         } else {
@@ -0,0 +1,128 @@
+#ifndef MUSE_AGENT_DIRECTORY_CPP
+#define MUSE_AGENT_DIRECTORY_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include "AgentDirectory.h"
+
+using namespace muse;
+
+// An unused entry in the directory
+static const AgentDirectory::Entry EmptyEntry = {NULL, InvalidAgentID, -1, -1};
+
+AgentDirectory::AgentDirectory() : dense(true), baseID(0), mask(0),
+                                   shift(32), count(0) {
+    // Nothing else to be done.
+}
+
+AgentDirectory::Entry&
+AgentDirectory::add(const AgentID id) {
+    ASSERT(id != InvalidAgentID);
+    Entry* entry = find(id);
+    if (entry != NULL) {
+        return *entry;  // Agent already has an entry.
+    }
+    if (dense) {
+        const size_t idx = (size_t) ((int64_t) id - baseID);
+        if (idx < entries.size()) {
+            count++;
+            entries[idx].id = id;
+            return entries[idx];
+        }
+    } else if ((count + 1) * 2 <= entries.size()) {
+        // Hash table is at most half full. Add entry to it.
+        count++;
+        Entry newEntry = EmptyEntry;
+        newEntry.id    = id;
+        return insertHashed(newEntry);
+    }
+    // The entries need to be reorganized to accommodate the new ID.
+    rebuild(id);
+    return add(id);
+}
+
+void
+AgentDirectory::rebuild(const AgentID id) {
+    // Save the existing entries and determine the range of IDs.
+    std::vector<Entry> oldEntries;
+    oldEntries.reserve(count);
+    int64_t minID = id, maxID = id;
+    for (const Entry& entry : entries) {
+        if (entry.id != InvalidAgentID) {
+            oldEntries.push_back(entry);
+            minID = std::min<int64_t>(minID, entry.id);
+            maxID = std::max<int64_t>(maxID, entry.id);
+        }
+    }
+    const int64_t span   = maxID - minID + 1;
+    const size_t  numIDs = oldEntries.size() + 1;
+    if (span <= (int64_t) (4 * numIDs + 1024)) {
+        // IDs are compact. Use a directly indexed array that grows
+        // geometrically (in the direction of the new ID) to amortize
+        // the cost of adding IDs in sorted order.
+        const int64_t size = std::max<int64_t>(span, dense ?
+                                               2 * entries.size() : 0);
+        baseID = ((id == minID) && !oldEntries.empty()) ?
+            (maxID - size + 1) : minID;
+        entries.assign(size, EmptyEntry);
+        dense = true;
+        for (const Entry& entry : oldEntries) {
+            entries[entry.id - baseID] = entry;
+        }
+    } else {
+        // IDs are sparse. Use a hash table that is at most 1/4 full.
+        size_t capacity = 2;
+        for (shift = 31; (capacity < 4 * numIDs); shift--) {
+            capacity *= 2;
+        }
+        entries.assign(capacity, EmptyEntry);
+        mask  = capacity - 1;
+        dense = false;
+        for (const Entry& entry : oldEntries) {
+            insertHashed(entry);
+        }
+    }
+}
+
+AgentDirectory::Entry&
+AgentDirectory::insertHashed(const Entry& entry) {
+    ASSERT(!dense);
+    size_t idx = hash(entry.id);
+    while (entries[idx].id != InvalidAgentID) {
+        idx = (idx + 1) & mask;
+    }
+    entries[idx] = entry;
+    return entries[idx];
+}
+
+void
+AgentDirectory::clear() {
+    entries.clear();
+    dense  = true;
+    baseID = 0;
+    mask   = 0;
+    shift  = 32;
+    count  = 0;
+}
+
+#endif
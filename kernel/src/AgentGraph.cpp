@@ -0,0 +1,409 @@
+#ifndef MUSE_AGENT_GRAPH_CPP
+#define MUSE_AGENT_GRAPH_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include "AgentGraph.h"
+
+using namespace muse;
+
+// The maximum number of refinement passes for each level
+static const int MaxRefinePasses = 8;
+
+AgentGraph::AgentGraph() {
+    // Nothing else to be done.
+}
+
+void
+AgentGraph::addAgent(const AgentID id, const double agentCost) {
+    if (agentCost <= 0) {
+        std::cerr << "Error: The cost of agent " << id
+                  << " declared for partitioning must be positive.\n";
+        abort();
+    }
+    if (!index.emplace(id, (int) ids.size()).second) {
+        std::cerr << "Error: Agent " << id << " was declared more than "
+                  << "once for partitioning.\n";
+        abort();
+    }
+    ids.push_back(id);
+    cost.push_back(agentCost);
+    // Any previous partition is no longer valid.
+    rank.clear();
+    thread.clear();
+}
+
+void
+AgentGraph::addEdge(const AgentID src, const AgentID dest,
+                    const double weight) {
+    if (weight <= 0) {
+        std::cerr << "Error: The weight of edge between agents " << src
+                  << " and " << dest << " must be positive.\n";
+        abort();
+    }
+    edges.push_back({{src, dest}, weight});
+    rank.clear();
+    thread.clear();
+}
+
+void
+AgentGraph::buildAdjacency() {
+    adjacency.resize(ids.size());
+    for (const auto& edge : edges) {
+        const auto src  = index.find(edge.first.first);
+        const auto dest = index.find(edge.first.second);
+        if ((src == index.end()) || (dest == index.end())) {
+            std::cerr << "Error: Edge between agents " << edge.first.first
+                      << " and " << edge.first.second << " refers to an "
+                      << "agent that was not declared for partitioning.\n";
+            abort();
+        }
+        if (src->second != dest->second) {
+            adjacency[src->second].push_back({dest->second, edge.second});
+            adjacency[dest->second].push_back({src->second, edge.second});
+        }
+    }
+    // Edges are no longer needed.  Release memory used by them.
+    std::vector<std::pair<std::pair<AgentID, AgentID>, double>>().swap(edges);
+    // Merge duplicate edges so that each neighbor is listed only once.
+    for (auto& nbrs : adjacency) {
+        std::sort(nbrs.begin(), nbrs.end());
+        size_t last = 0;
+        for (size_t i = 1; (i < nbrs.size()); i++) {
+            if (nbrs[i].first == nbrs[last].first) {
+                nbrs[last].second += nbrs[i].second;
+            } else {
+                nbrs[++last] = nbrs[i];
+            }
+        }
+        nbrs.resize(std::min(nbrs.size(), last + 1));
+    }
+}
+
+void
+AgentGraph::partition(const int numProcs, const int numThreads,
+                      const double imbalance,
+                      const std::vector<int>& threadDomains) {
+    ASSERT(numProcs > 0);
+    ASSERT(numThreads > 0);
+    ASSERT(imbalance >= 0);
+    buildAdjacency();
+    local.assign(ids.size(), -1);
+    // First partition all the agents across processes.
+    std::vector<int> verts(ids.size());
+    for (size_t i = 0; (i < verts.size()); i++) {
+        verts[i] = i;
+    }
+    rank = kwayPartition(verts, numProcs, imbalance);
+    // Next partition the agents on each process across threads.
+    thread.assign(ids.size(), 0);
+    if (numThreads > 1) {
+        // Group threads by their memory domain.  Domains are used
+        // only if all of them have the same number of threads.
+        std::map<int, std::vector<int>> domains;
+        for (size_t thr = 0; (thr < threadDomains.size()); thr++) {
+            domains[threadDomains[thr]].push_back(thr);
+        }
+        std::vector<std::vector<int>> domainThreads;
+        for (const auto& entry : domains) {
+            domainThreads.push_back(entry.second);
+        }
+        if (((int) threadDomains.size() != numThreads) ||
+            (numThreads % domainThreads.size() != 0) ||
+            (std::any_of(domainThreads.begin(), domainThreads.end(),
+                         [&](const std::vector<int>& dt) {
+                             return (dt.size() != domainThreads[0].size());
+                         }))) {
+            // Treat all threads as one domain.
+            domainThreads.assign(1, std::vector<int>(numThreads));
+            std::iota(domainThreads[0].begin(), domainThreads[0].end(), 0);
+        }
+        std::vector<std::vector<int>> procVerts(numProcs);
+        for (size_t i = 0; (i < ids.size()); i++) {
+            procVerts[rank[i]].push_back(i);
+        }
+        for (const std::vector<int>& pv : procVerts) {
+            partitionThreads(pv, domainThreads, imbalance);
+        }
+    }
+    // The vector of positions is no longer needed.
+    std::vector<int>().swap(local);
+}
+
+void
+AgentGraph::partitionThreads(const std::vector<int>& verts,
+                             const std::vector<std::vector<int>>& domainThreads,
+                             const double imbalance) {
+    // First partition the agents across the domains.
+    const std::vector<int> domPart =
+        kwayPartition(verts, domainThreads.size(), imbalance);
+    std::vector<std::vector<int>> domVerts(domainThreads.size());
+    for (size_t i = 0; (i < verts.size()); i++) {
+        domVerts[domPart[i]].push_back(verts[i]);
+    }
+    // Next partition agents in each domain across its threads.
+    for (size_t dom = 0; (dom < domainThreads.size()); dom++) {
+        const std::vector<int>& threads = domainThreads[dom];
+        const std::vector<int> part =
+            kwayPartition(domVerts[dom], threads.size(), imbalance);
+        for (size_t i = 0; (i < domVerts[dom].size()); i++) {
+            thread[domVerts[dom][i]] = threads[part[i]];
+        }
+    }
+}
+
+std::vector<int>
+AgentGraph::kwayPartition(const std::vector<int>& verts, const int numParts,
+                          const double imbalance) {
+    std::vector<int> part(verts.size(), 0);
+    if (numParts == 1) {
+        return part;  // Trivial case
+    }
+    if ((int) verts.size() <= numParts) {
+        // Too few agents. Just assign one agent to each part.
+        for (size_t i = 0; (i < verts.size()); i++) {
+            part[i] = i;
+        }
+        return part;
+    }
+    // Setup positions of agents in the subset being partitioned.
+    double totalCost = 0;
+    for (size_t i = 0; (i < verts.size()); i++) {
+        local[verts[i]] = i;
+        totalCost      += cost[verts[i]];
+    }
+    // Grow the parts and refine them to reduce the cut.
+    growParts(verts, numParts, part);
+    const double maxCost = totalCost / numParts * (1 + imbalance);
+    refineParts(verts, numParts, maxCost, part);
+    // Reset positions for use with the next subset.
+    for (const int v : verts) {
+        local[v] = -1;
+    }
+    return part;
+}
+
+void
+AgentGraph::growParts(const std::vector<int>& verts, const int numParts,
+                      std::vector<int>& part) const {
+    double totalCost = 0;
+    for (const int v : verts) {
+        totalCost += cost[v];
+    }
+    const double target = totalCost / numParts;
+    // The weight of edges from each unassigned agent into the part
+    // being grown.  Agents are prioritized by this value.  Ties are
+    // broken in favor of agents that were reached earlier so that
+    // parts grow outwards (as in a breadth-first search) into compact
+    // regions rather than in long strips.
+    std::vector<double> gain(verts.size(), 0);
+    typedef std::tuple<double, long, int> Candidate;
+    long seq = 0;  // Order in which candidates are added
+    std::fill(part.begin(), part.end(), -1);
+    size_t nextSeed = 0;  // Agents before this position are assigned
+    for (int p = 0; (p < numParts - 1); p++) {
+        std::priority_queue<Candidate> candidates;
+        std::vector<int> touched;
+        double partCost = 0;
+        while (partCost < target) {
+            if (candidates.empty()) {
+                // Start (or restart, for disconnected graphs) from the
+                // first unassigned agent.
+                while ((nextSeed < verts.size()) && (part[nextSeed] != -1)) {
+                    nextSeed++;
+                }
+                if (nextSeed == verts.size()) {
+                    break;  // All agents have been assigned.
+                }
+                candidates.push(Candidate(0, seq--, nextSeed));
+            }
+            const Candidate top = candidates.top();
+            candidates.pop();
+            const int pos = std::get<2>(top);
+            if ((part[pos] != -1) || (std::get<0>(top) != gain[pos])) {
+                continue;  // Stale entry in priority queue.
+            }
+            const double agentCost = cost[verts[pos]];
+            if ((partCost > 0) && (partCost + agentCost / 2 > target)) {
+                break;  // Adding this agent would overshoot the target.
+            }
+            part[pos]  = p;
+            partCost  += agentCost;
+            for (const auto& nbr : adjacency[verts[pos]]) {
+                const int nbrPos = local[nbr.first];
+                if ((nbrPos != -1) && (part[nbrPos] == -1)) {
+                    gain[nbrPos] += nbr.second;
+                    touched.push_back(nbrPos);
+                    candidates.push(Candidate(gain[nbrPos], seq--, nbrPos));
+                }
+            }
+        }
+        for (const int pos : touched) {
+            gain[pos] = 0;
+        }
+    }
+    // The remaining agents are assigned to the last part.
+    std::vector<int> count(numParts, 0);
+    for (size_t i = 0; (i < part.size()); i++) {
+        if (part[i] == -1) {
+            part[i] = numParts - 1;
+        }
+        count[part[i]]++;
+    }
+    // Ensure that no part is empty by taking an agent from the
+    // largest part.
+    for (int p = 0; (p < numParts); p++) {
+        if (count[p] == 0) {
+            const int from = std::max_element(count.begin(), count.end()) -
+                count.begin();
+            const int pos  = std::find(part.rbegin(), part.rend(), from) -
+                part.rbegin();
+            part[part.size() - 1 - pos] = p;
+            count[from]--;
+            count[p]++;
+        }
+    }
+}
+
+void
+AgentGraph::refineParts(const std::vector<int>& verts, const int numParts,
+                        const double maxCost, std::vector<int>& part) const {
+    std::vector<double> partCost(numParts, 0);
+    std::vector<int> count(numParts, 0);
+    for (size_t i = 0; (i < verts.size()); i++) {
+        partCost[part[i]] += cost[verts[i]];
+        count[part[i]]++;
+    }
+    // The weight of edges from the current agent to each part.
+    std::vector<double> conn(numParts, 0);
+    std::vector<int> nbrParts;
+    for (int pass = 0; (pass < MaxRefinePasses); pass++) {
+        int moves = 0;
+        for (size_t i = 0; (i < verts.size()); i++) {
+            const int from = part[i];
+            if (count[from] == 1) {
+                continue;  // Do not empty a part.
+            }
+            // Compute weight of edges to the neighboring parts.
+            for (const auto& nbr : adjacency[verts[i]]) {
+                const int nbrPos = local[nbr.first];
+                if (nbrPos != -1) {
+                    const int q = part[nbrPos];
+                    if (conn[q] == 0) {
+                        nbrParts.push_back(q);
+                    }
+                    conn[q] += nbr.second;
+                }
+            }
+            // Find the part to which moving this agent reduces the
+            // cut the most without violating balance.  Agents on
+            // overloaded parts are moved even if the cut increases.
+            const double agentCost = cost[verts[i]];
+            const bool overloaded  = (partCost[from] > maxCost);
+            double bestGain = overloaded ?
+                -std::numeric_limits<double>::max() : 0;
+            int best = from;
+            for (const int q : nbrParts) {
+                const double gain = conn[q] - conn[from];
+                if ((q != from) && (partCost[q] + agentCost <= maxCost) &&
+                    (gain > bestGain)) {
+                    best     = q;
+                    bestGain = gain;
+                }
+            }
+            for (const int q : nbrParts) {
+                conn[q] = 0;
+            }
+            conn[from] = 0;
+            nbrParts.clear();
+            if (best != from) {
+                part[i]         = best;
+                partCost[from] -= agentCost;
+                partCost[best] += agentCost;
+                count[from]--;
+                count[best]++;
+                moves++;
+            }
+        }
+        if (moves == 0) {
+            break;  // No further improvement possible.
+        }
+    }
+}
+
+int
+AgentGraph::getRank(const AgentID id) const {
+    const auto entry = index.find(id);
+    return ((entry == index.end()) || !isPartitioned()) ? -1 :
+        rank[entry->second];
+}
+
+int
+AgentGraph::getThread(const AgentID id) const {
+    const auto entry = index.find(id);
+    return ((entry == index.end()) || !isPartitioned()) ? -1 :
+        thread[entry->second];
+}
+
+void
+AgentGraph::printSummary(std::ostream& os) const {
+    if (!isPartitioned()) {
+        return;  // Nothing to report.
+    }
+    double totalWeight = 0, procCut = 0, threadCut = 0;
+    int numProcs = 0;
+    for (size_t i = 0; (i < adjacency.size()); i++) {
+        numProcs = std::max(numProcs, rank[i] + 1);
+        for (const auto& nbr : adjacency[i]) {
+            if ((int) i < nbr.first) {
+                continue;  // Count each edge only once.
+            }
+            totalWeight += nbr.second;
+            if (rank[i] != rank[nbr.first]) {
+                procCut += nbr.second;
+            } else if (thread[i] != thread[nbr.first]) {
+                threadCut += nbr.second;
+            }
+        }
+    }
+    std::vector<double> procCost(numProcs, 0);
+    for (size_t i = 0; (i < cost.size()); i++) {
+        procCost[rank[i]] += cost[i];
+    }
+    const double totalCost = std::accumulate(procCost.begin(),
+                                             procCost.end(), 0.0);
+    const double maxCost   = *std::max_element(procCost.begin(),
+                                               procCost.end());
+    os << "Partitioned " << ids.size() << " agents: edge weight cut "
+       << "across processes = " << procCut << ", across threads = "
+       << threadCut << " (of " << totalWeight << "), max/avg process "
+       << "cost = " << (maxCost * numProcs / totalCost) << std::endl;
+}
+
+#endif
@@ -0,0 +1,536 @@
+#ifndef MUSE_AGENT_MIGRATOR_CPP
+#define MUSE_AGENT_MIGRATOR_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors:  Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <sstream>
+#include "AgentMigrator.h"
+#include "Simulation.h"
+#include "Scheduler.h"
+#include "Communicator.h"
+#include "GVTManagerBase.h"
+#include "EventAdapter.h"
+#include "EventRecycler.h"
+
+// Switch default namespace to streamline code
+using namespace muse;
+
+// Helpers to write/read binary values to/from the payload of messages
+namespace {
+    template<typename T>
+    void write(std::ostream& os, const T& value) {
+        os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    T read(std::istream& is) {
+        T value;
+        is.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+}
+
+AgentMigrator::AgentMigrator(Simulation* sim, const int interval,
+                             const double threshold, const int maxAgents) :
+    sim(sim), myRank(sim->getSimulatorID()),
+    numProcs(sim->getNumberOfProcesses()), interval(interval),
+    threshold(threshold), maxAgents(maxAgents) {
+    ASSERT(interval > 0);
+    gvtUpdates     = 0;
+    reportDue      = false;
+    reportNum      = 0;
+    frozen         = false;
+    numEventsSent  = 0;
+    numEventsRecv  = 0;
+    migrating      = false;
+    wave           = 0;
+    countsRecv     = 0;
+    numAdopted     = 0;
+    numRounds      = 0;
+    agentsSent     = 0;
+    agentsRecv     = 0;
+    eventsSent     = 0;
+}
+
+bool
+AgentMigrator::start() {
+    if (!sim->agentFactory) {
+        std::cerr << "Warning: Agent migration requires a factory to be "
+                  << "registered via Simulation::setAgentFactory. "
+                  << "Disabling agent migration.\n";
+        return false;
+    }
+    // Check if the scheduler's queue supports detaching agents.  No
+    // events have been scheduled yet.  So an agent is just detached
+    // and attached back.
+    ASSERT(!sim->allAgents.empty());
+    Agent* const agent = sim->allAgents.front();
+    EventContainer events;
+    if (!sim->scheduler->detachAgent(agent, events)) {
+        std::cerr << "Warning: The scheduler queue does not support "
+                  << "detaching agents. Disabling agent migration.\n";
+        return false;
+    }
+    sim->scheduler->attachAgent(agent, events);
+    return true;
+}
+
+void
+AgentMigrator::gvtUpdated(const Time& gvt) {
+    UNUSED_PARAM(gvt);
+    if (++gvtUpdates >= interval) {
+        // Load reports are not sent from here as this method is
+        // called while GVT messages are being processed.
+        gvtUpdates = 0;
+        reportDue  = true;
+    }
+}
+
+void
+AgentMigrator::doPending() {
+    if (reportDue) {
+        reportDue = false;
+        sendLoadReport();
+    }
+    // Handle messages sent to this process.  Handling a message may
+    // add further messages to the queue.
+    while (!localMsgs.empty()) {
+        MigrationMessage* const msg = localMsgs.front();
+        localMsgs.pop_front();
+        handleMessage(msg);
+        EventRecycler::decreaseReference(msg);
+    }
+}
+
+void
+AgentMigrator::send(const MigrationMessage::Kind kind, const int destRank,
+                    const int round, const std::string& payload,
+                    const Time recvTime) {
+    MigrationMessage* const msg =
+        MigrationMessage::create(kind, myRank, destRank, round, payload,
+                                 recvTime);
+    if (destRank == myRank) {
+        localMsgs.push_back(msg);  // handled from processPending
+        return;
+    }
+    // Send via the GVT manager so that GVT accounts for the message.
+    sim->gvtManager->sendRemoteEvent(msg);
+    EventRecycler::decreaseReference(msg);
+}
+
+void
+AgentMigrator::broadcast(const MigrationMessage::Kind kind, const int round,
+                         const std::string& payload) {
+    for (int rank = 0; (rank < numProcs); rank++) {
+        send(kind, rank, round, payload);
+    }
+}
+
+void
+AgentMigrator::handleMessage(const MigrationMessage* msg) {
+    ASSERT(msg != NULL);
+    switch (msg->getKind()) {
+    case MigrationMessage::LOAD_REPORT:
+        recordLoadReport(msg);
+        break;
+    case MigrationMessage::FREEZE:
+        freeze(msg);
+        break;
+    case MigrationMessage::PROBE: {
+        // Report number of events sent and received to the root.
+        std::ostringstream os;
+        write(os, numEventsSent);
+        write(os, numEventsRecv);
+        send(MigrationMessage::COUNTS, ROOT_KERNEL, msg->getRound(),
+             os.str());
+        break;
+    }
+    case MigrationMessage::COUNTS:
+        recordCounts(msg);
+        break;
+    case MigrationMessage::GO:
+        migrateAgents();
+        break;
+    case MigrationMessage::AGENT_STATE:
+        adoptAgent(msg);
+        break;
+    case MigrationMessage::ADOPTED:
+        ASSERT(myRank == ROOT_KERNEL);
+        if (++numAdopted == plan.size()) {
+            // All agents have been migrated.  Let processes resume.
+            migrating = false;
+            broadcast(MigrationMessage::RESUME, msg->getRound());
+        }
+        break;
+    case MigrationMessage::RESUME:
+        frozen = false;
+        plan.clear();
+        break;
+    default:
+        std::cerr << "Error: Unhandled migration message (kind="
+                  << msg->getKind() << ") at rank " << myRank << std::endl;
+        abort();
+    }
+}
+
+void
+AgentMigrator::sendLoadReport() {
+    // Compute the events committed and rollbacks (since previous
+    // report) for all local agents.
+    long committed = 0, rollbacks = 0;
+    std::vector<std::pair<long, Agent*>> candidates;
+    for (Agent* agent : sim->allAgents) {
+        std::pair<int, int>& last = lastCounts[agent->getAgentID()];
+        const long commits = agent->numCommittedEvents - last.first;
+        committed += commits;
+        rollbacks += agent->numRollbacks - last.second;
+        last = {agent->numCommittedEvents, agent->numRollbacks};
+        // Conservative agents cannot be rolled back to GVT for
+        // migration.
+        if ((commits > 0) && !agent->isConservative()) {
+            candidates.push_back({commits, agent});
+        }
+    }
+    // Report the busiest agents that can be migrated.
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<long, Agent*>& a1,
+                 const std::pair<long, Agent*>& a2) {
+                  return a1.first > a2.first; });
+    std::vector<std::pair<AgentID, long>> hotAgents;
+    for (const auto& cand : candidates) {
+        if ((int) hotAgents.size() >= maxAgents) {
+            break;
+        }
+        std::ostringstream dummy;
+        if (cand.second->serialize(dummy)) {
+            hotAgents.push_back({cand.second->getAgentID(), cand.first});
+        }
+    }
+    // Send the report to the root.
+    std::ostringstream os;
+    write(os, committed);
+    write(os, rollbacks);
+    write(os, (int) sim->allAgents.size());
+    write(os, (int) hotAgents.size());
+    for (const auto& hot : hotAgents) {
+        write(os, hot.first);
+        write(os, hot.second);
+    }
+    send(MigrationMessage::LOAD_REPORT, ROOT_KERNEL, reportNum++, os.str());
+}
+
+void
+AgentMigrator::recordLoadReport(const MigrationMessage* msg) {
+    ASSERT(myRank == ROOT_KERNEL);
+    const int round = msg->getRound();
+    std::vector<LoadReport>& loads = reports[round];
+    loads.resize(numProcs);
+    // Extract the report from the message.
+    std::istringstream is(msg->getPayload());
+    LoadReport& report = loads.at(msg->getSrcRank());
+    report.committed   = read<long>(is);
+    report.rollbacks   = read<long>(is);
+    report.numAgents   = read<int>(is);
+    const int numHot   = read<int>(is);
+    for (int i = 0; (i < numHot); i++) {
+        const AgentID id = read<AgentID>(is);
+        report.hotAgents.push_back({id, read<long>(is)});
+    }
+    if (++reportCount[round] < numProcs) {
+        return;  // Wait for reports from other processes.
+    }
+    // Reports from all processes have been received.
+    std::vector<LoadReport> allLoads;
+    allLoads.swap(loads);
+    reports.erase(round);
+    reportCount.erase(round);
+    if (migrating) {
+        return;  // Agents from a previous round are still being moved
+    }
+    // Find the busiest process (source) and the least busy process
+    // (destination).  Among equally busy processes, the one with more
+    // rollbacks is running ahead and is preferred as destination.
+    int src = 0, dest = 0;
+    for (int rank = 1; (rank < numProcs); rank++) {
+        const LoadReport& load = allLoads[rank];
+        if (load.committed > allLoads[src].committed) {
+            src = rank;
+        }
+        if ((load.committed < allLoads[dest].committed) ||
+            ((load.committed == allLoads[dest].committed) &&
+             (load.rollbacks > allLoads[dest].rollbacks))) {
+            dest = rank;
+        }
+    }
+    const LoadReport& srcLoad = allLoads[src];
+    if ((src == dest) || (srcLoad.committed <=
+                          (1 + threshold) * allLoads[dest].committed)) {
+        return;  // Load is sufficiently balanced.
+    }
+    // Choose agents until about half the difference in load has been
+    // moved.  The source always retains at least one agent.
+    const long target = (srcLoad.committed - allLoads[dest].committed) / 2;
+    long moved = 0;
+    std::vector<AgentID> agents;
+    for (const auto& hot : srcLoad.hotAgents) {
+        if (((int) agents.size() >= maxAgents) || (moved >= target) ||
+            (srcLoad.numAgents - (int) agents.size() <= 1)) {
+            break;
+        }
+        if (moved + hot.second > target) {
+            continue;  // Agent is too busy to be moved.
+        }
+        agents.push_back(hot.first);
+        moved += hot.second;
+    }
+    if (agents.empty()) {
+        return;  // No suitable agents to move.
+    }
+    // Broadcast the plan and start detecting when no events are in
+    // flight.
+    std::ostringstream os;
+    write(os, (int) agents.size());
+    for (const AgentID id : agents) {
+        write(os, id);
+        write(os, src);
+        write(os, dest);
+    }
+    migrating      = true;
+    numAdopted     = 0;
+    countsRecv     = 0;
+    waveCounts     = {0, 0};
+    prevWaveCounts = {-1, -1};
+    broadcast(MigrationMessage::FREEZE, round, os.str());
+    broadcast(MigrationMessage::PROBE, ++wave);
+}
+
+void
+AgentMigrator::freeze(const MigrationMessage* msg) {
+    // Stop processing events until the agents have been migrated.
+    frozen = true;
+    numRounds++;
+    // Extract the plan from the message.
+    std::istringstream is(msg->getPayload());
+    const int numMoves = read<int>(is);
+    plan.clear();
+    for (int i = 0; (i < numMoves); i++) {
+        Move move;
+        move.agentID  = read<AgentID>(is);
+        move.srcRank  = read<int>(is);
+        move.destRank = read<int>(is);
+        plan.push_back(move);
+    }
+    // Roll back outgoing agents to GVT so that only their committed
+    // state and pending events need to be moved.  Rollbacks must
+    // occur now so that the anti-messages are delivered before the
+    // agents are moved.
+    const Time gvt = sim->getGVT();
+    for (const Move& move : plan) {
+        Agent* const agent = findAgent(move.agentID);
+        if ((move.srcRank != myRank) || (agent->getLVT() < gvt)) {
+            continue;
+        }
+        Event* const marker = Event::create<Event>(move.agentID, gvt);
+        agent->doRollbackRecovery(marker, *sim->scheduler->agentPQ);
+        EventRecycler::decreaseReference(marker);
+        ASSERT(agent->getLVT() < gvt);
+    }
+    sim->LGVT = sim->scheduler->getNextEventTime();
+}
+
+void
+AgentMigrator::recordCounts(const MigrationMessage* msg) {
+    ASSERT(myRank == ROOT_KERNEL);
+    ASSERT(msg->getRound() == wave);
+    std::istringstream is(msg->getPayload());
+    waveCounts.first  += read<long>(is);
+    waveCounts.second += read<long>(is);
+    if (++countsRecv < numProcs) {
+        return;  // Wait for counts from other processes.
+    }
+    // No events are in flight if the total events sent and received
+    // are equal and unchanged in two consecutive waves.
+    if ((waveCounts.first == waveCounts.second) &&
+        (waveCounts == prevWaveCounts)) {
+        broadcast(MigrationMessage::GO, wave);
+        return;
+    }
+    prevWaveCounts = waveCounts;
+    waveCounts     = {0, 0};
+    countsRecv     = 0;
+    broadcast(MigrationMessage::PROBE, ++wave);
+}
+
+void
+AgentMigrator::migrateAgents() {
+    // Update owners of all the agents being moved.
+    for (const Move& move : plan) {
+        sim->commManager->setAgentOwner(move.agentID, move.destRank);
+    }
+    // Ship the agents from this process.
+    for (const Move& move : plan) {
+        if (move.srcRank == myRank) {
+            sendAgent(findAgent(move.agentID), move.destRank);
+        }
+    }
+    sim->LGVT = sim->scheduler->getNextEventTime();
+}
+
+void
+AgentMigrator::sendAgent(Agent* agent, const int destRank) {
+    ASSERT(agent != NULL);
+    const Time gvt = sim->getGVT();
+    ASSERT(agent->getLVT() < gvt);
+    // All events processed by the agent are below GVT. So commit them.
+    agent->garbageCollect(gvt);
+    agent->cleanInputQueue();
+    agent->cleanOutputQueue();
+    // Detach pending events and remove agent from this process.
+    EventContainer events;
+    const bool detached = sim->scheduler->detachAgent(agent, events);
+    ASSERT(detached);
+    UNUSED_PARAM(detached);
+    AgentDirectory& agentDir = sim->commManager->getAgentDirectory();
+    agentDir.find(agent->getAgentID())->agent = NULL;
+    // Serialize the kernel's bookkeeping for the agent.
+    std::ostringstream os;
+    write(os, agent->getAgentID());
+    write(os, agent->getLVT());
+    write(os, agent->epoch);
+    write(os, agent->numRollbacks);
+    write(os, agent->numScheduledEvents);
+    write(os, agent->numProcessedEvents);
+    write(os, agent->numMPIMessages);
+    write(os, agent->numCommittedEvents);
+    write(os, agent->numSchedules);
+    // Serialize the model's data for the agent.
+    std::ostringstream modelData;
+    if (!agent->serialize(modelData)) {
+        std::cerr << "Error: Agent " << agent->getAgentID()
+                  << " could not be serialized for migration.\n";
+        abort();
+    }
+    const std::string data = modelData.str();
+    write(os, (int) data.size());
+    os.write(data.data(), data.size());
+    // Serialize the pending events.  The message is time-stamped with
+    // the earliest pending event so that GVT does not advance past
+    // these events while they are in flight.
+    Time minTime = TIME_INFINITY;
+    write(os, (int) events.size());
+    for (Event* event : events) {
+        const int size = EventAdapter::getEventSize(event);
+        write(os, size);
+        os.write(reinterpret_cast<const char*>(event), size);
+        minTime = std::min(minTime, event->getReceiveTime());
+        EventRecycler::decreaseReference(event);
+    }
+    send(MigrationMessage::AGENT_STATE, destRank, numRounds, os.str(),
+         events.empty() ? gvt : minTime);
+    // Track statistics and get rid of the local agent.
+    agentsSent++;
+    eventsSent += events.size();
+    AgentContainer& allAgents = sim->allAgents;
+    allAgents.erase(std::find(allAgents.begin(), allAgents.end(), agent));
+    lastCounts.erase(agent->getAgentID());
+    agent->cleanStateQueue();
+    delete agent;
+}
+
+void
+AgentMigrator::adoptAgent(const MigrationMessage* msg) {
+    std::istringstream is(msg->getPayload());
+    const AgentID id       = read<AgentID>(is);
+    const Time lvt         = read<Time>(is);
+    const unsigned epoch   = read<unsigned int>(is);
+    const int rollbacks    = read<int>(is);
+    const int scheduled    = read<int>(is);
+    const int processed    = read<int>(is);
+    const int mpiMessages  = read<int>(is);
+    const int committed    = read<int>(is);
+    const int schedules    = read<int>(is);
+    std::string data(read<int>(is), '\0');
+    is.read(&data[0], data.size());
+    // Have the model recreate the agent.
+    std::istringstream modelData(data);
+    Agent* const agent = sim->agentFactory(id, modelData);
+    if ((agent == NULL) || (agent->getAgentID() != id)) {
+        std::cerr << "Error: Agent factory did not recreate agent " << id
+                  << " migrated to rank " << myRank << std::endl;
+        abort();
+    }
+    // Restore the kernel's bookkeeping for the agent.
+    agent->setKernel(sim);
+    agent->mustSaveState      = sim->mustSaveState;
+    agent->epoch              = epoch;
+    agent->numRollbacks       = rollbacks;
+    agent->numScheduledEvents = scheduled;
+    agent->numProcessedEvents = processed;
+    agent->numMPIMessages     = mpiMessages;
+    agent->numCommittedEvents = committed;
+    agent->numSchedules       = schedules;
+    agent->setLVT(lvt);
+    agent->getState()->timestamp = lvt;
+    agent->saveState();
+    // Recreate the pending events.
+    const int numEvents = read<int>(is);
+    EventContainer events;
+    for (int i = 0; (i < numEvents); i++) {
+        const int size = read<int>(is);
+        char* const buffer = Event::allocate(size, id);
+        is.read(buffer, size);
+        Event* const event = reinterpret_cast<Event*>(buffer);
+        EventAdapter::setReferenceCount(event, 1);
+        events.push_back(event);
+    }
+    // Add the agent to this process.  The message may arrive before
+    // GO.  So the owner of the agent is updated here as well.
+    sim->commManager->setAgentOwner(id, myRank);
+    AgentDirectory& agentDir = sim->commManager->getAgentDirectory();
+    ASSERT(agentDir.find(id) != NULL);
+    agentDir.find(id)->agent = agent;
+    sim->scheduler->attachAgent(agent, events);
+    sim->allAgents.push_back(agent);
+    lastCounts[id] = {committed, rollbacks};
+    sim->LGVT = sim->scheduler->getNextEventTime();
+    agentsRecv++;
+    send(MigrationMessage::ADOPTED, ROOT_KERNEL, msg->getRound());
+}
+
+Agent*
+AgentMigrator::findAgent(const AgentID id) const {
+    const AgentDirectory::Entry* const entry =
+        sim->commManager->getAgentDirectory().find(id);
+    return (entry != NULL) ? entry->agent : NULL;
+}
+
+void
+AgentMigrator::reportStats(std::ostream& os) const {
+    os << "Migration rounds       : " << numRounds
+       << "\nAgents migrated out    : " << agentsSent
+       << "\nAgents migrated in     : " << agentsRecv
+       << "\nEvents migrated        : " << eventsSent
+       << std::endl;
+}
+
+#endif
@@ -191,23 +191,23 @@ AgentPQ::decrease(pointer n, Agent* data) {
     m_min = 0;
 }
 
-//void
-//FibonacciHeap::remove(pointer n)           {
-//  if (n->is_root())
-//    m_roots[n->rank()] = 0;
-//  else
-//    cut(n);
-//
-//  std::vector<node*>::const_iterator it = n->begin();
-//  std::vector<node*>::const_iterator end = n->end();
-//  for (it = n->begin(); it != end; ++it){
-//    add_root(*it);
-//  }
-//
-//  m_min = 0;
-//  --m_size;
-//  delete n;
-//}
+void
+AgentPQ::remove(pointer n) {
+    if (n->is_root()) {
+        m_roots[n->rank()] = 0;
+    } else {
+        cut(n);
+    }
+    // The children of the removed node become roots.
+    std::vector<node*>::const_iterator it = n->begin();
+    std::vector<node*>::const_iterator end = n->end();
+    for (; it != end; ++it) {
+        add_root(*it);
+    }
+    m_min = 0;
+    --m_size;
+    delete n;
+}
 
 //fibonacci heap basic interface
 
@@ -266,6 +266,23 @@ AgentPQ::removeAgent(Agent* agent) {
     agent->oldTopTime = getTopTime(agent);
 }
 
+bool
+AgentPQ::detachAgent(Agent* agent, EventContainer& events) {
+    ASSERT(agent != NULL);
+    ASSERT(agent->schedRef.eventPQ != &EmptyBHW);
+    pointer ptr = reinterpret_cast<pointer>(agent->fibHeapPtr);
+    ASSERT(ptr != NULL);
+    ASSERT(ptr->data() == agent);
+    remove(ptr);
+    // Hand-off events (with their references) to the caller.
+    agent->schedRef.eventPQ->moveTo(events);
+    delete agent->schedRef.eventPQ;
+    agent->schedRef.eventPQ = NULL;
+    agent->fibHeapPtr       = NULL;
+    agent->oldTopTime       = TIME_INFINITY;
+    return true;
+}
+
 muse::Event*
 AgentPQ::front() {
     muse::Event* retVal = NULL;
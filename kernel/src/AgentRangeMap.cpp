@@ -0,0 +1,128 @@
+#ifndef MUSE_AGENT_RANGE_MAP_CPP
+#define MUSE_AGENT_RANGE_MAP_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <iostream>
+#include "AgentRangeMap.h"
+
+using namespace muse;
+
+AgentRangeMap::AgentRangeMap() : partition(ANY_PARTITION), numAgents(0),
+                                 numOwners(1), blockSize(1) {
+    // Nothing else to be done.
+}
+
+void
+AgentRangeMap::encode(std::vector<AgentID> ids, const int owner,
+                      std::vector<AgentID>& ranges) {
+    std::sort(ids.begin(), ids.end());
+    size_t i = 0;
+    while (i < ids.size()) {
+        // Extend the range as long as IDs are consecutive.
+        size_t j = i + 1;
+        while ((j < ids.size()) && (ids[j] == ids[j - 1] + 1)) {
+            j++;
+        }
+        ranges.push_back(ids[i]);
+        ranges.push_back(j - i);
+        ranges.push_back(owner);
+        // Duplicate IDs end up in a range of their own and are
+        // reported as overlaps in finalize.
+        i = j;
+    }
+}
+
+void
+AgentRangeMap::add(const AgentID* triples, const size_t count) {
+    ASSERT(count % 3 == 0);
+    for (size_t i = 0; (i < count); i += 3) {
+        ranges.push_back(Range{triples[i], triples[i] + triples[i + 1],
+                               triples[i + 2]});
+    }
+}
+
+void
+AgentRangeMap::finalize() {
+    std::sort(ranges.begin(), ranges.end(),
+              [](const Range& r1, const Range& r2) {
+                  return r1.start < r2.start; });
+    // Check for overlaps and merge adjacent ranges in-place.
+    size_t last = 0;
+    for (size_t i = 1; (i < ranges.size()); i++) {
+        if (ranges[i].start < ranges[last].end) {
+            std::cerr << "Duplicate agent with ID: " << ranges[i].start
+                      << " encountered. Aborting!\n";
+            abort();
+        }
+        if ((ranges[i].start == ranges[last].end) &&
+            (ranges[i].owner == ranges[last].owner)) {
+            ranges[last].end = ranges[i].end;  // merge
+        } else {
+            ranges[++last] = ranges[i];
+        }
+    }
+    if (!ranges.empty()) {
+        ranges.resize(last + 1);
+    }
+}
+
+void
+AgentRangeMap::setPartition(const AgentPartition kind, const AgentID numAgents,
+                            const int numOwners) {
+    ASSERT(numOwners > 0);
+    this->partition = kind;
+    this->numAgents = numAgents;
+    this->numOwners = numOwners;
+    this->blockSize = std::max(1, numAgents / numOwners);
+}
+
+AgentID
+AgentRangeMap::getExpectedCount(const int owner) const {
+    if (partition == BLOCK_PARTITION) {
+        const AgentID start = std::min(numAgents, owner * blockSize);
+        const AgentID end   = (owner == numOwners - 1) ? numAgents :
+            std::min(numAgents, (owner + 1) * blockSize);
+        return end - start;
+    }
+    // Cyclic partition
+    return (owner < numAgents) ?
+        ((numAgents - owner + numOwners - 1) / numOwners) : 0;
+}
+
+bool
+AgentRangeMap::checkPartition(std::vector<AgentID> ids,
+                              const int owner) const {
+    ASSERT(partition != ANY_PARTITION);
+    if ((AgentID) ids.size() != getExpectedCount(owner)) {
+        return false;
+    }
+    std::sort(ids.begin(), ids.end());
+    for (size_t i = 0; (i < ids.size()); i++) {
+        if ((find(ids[i]) != owner) || ((i > 0) && (ids[i] == ids[i - 1]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
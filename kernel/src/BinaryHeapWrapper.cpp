@@ -180,4 +180,11 @@ BinaryHeapWrapper::clear() {
     heapContainer->clear();
 }
 
+void
+BinaryHeapWrapper::moveTo(EventContainer& events) {
+    ASSERT( heapContainer != NULL );
+    events.insert(events.end(), heapContainer->begin(), heapContainer->end());
+    heapContainer->clear();
+}
+
 #endif
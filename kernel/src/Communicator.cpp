@@ -26,26 +26,28 @@
 #include "Communicator.h"
 #include "GVTManagerBase.h"
 #include "GVTMessage.h"
+#include "MigrationMessage.h"
 #include "DataTypes.h"
 #include "Event.h"
 #include "Agent.h"
-#include <algorithm>
+#include "EventAdapter.h"
+#include "MpiTransport.h"
 
 using namespace muse;
 
-Communicator::Communicator() {
+Communicator::Communicator(Transport* transport) : transport(transport) {
     gvtManager = NULL;
     myMPIrank  = SimulatorID(-1);
+    if (this->transport == NULL) {
+        // Use MPI as the default transport
+        this->transport = new MpiTransport();
+    }
 }
 
 SimulatorID
 Communicator::initialize(int argc, char* argv[], bool initMPI) {
-    if (initMPI) {
-        // Initialize MPI.
-        MPI_INIT(argc, argv);
-    }
     // Setup the rank for this process
-    myMPIrank = MPI_GET_RANK();
+    myMPIrank = transport->initialize(argc, argv, initMPI);
     return myMPIrank;
 }
 
@@ -62,199 +64,131 @@ Communicator::registerAgents(AgentContainer& allAgents) {
 
 void
 Communicator::registerAgents(const std::vector<AgentID>& allAgents) {
-    const int procCount = MPI_GET_SIZE();
-    const int rank      = MPI_GET_RANK();
-    
-    // Add all of the local agents to the map
-    AgentContainer::iterator ac_it;
+    ownerMap.clear();
+    if ((ownerMap.getPartition() != ANY_PARTITION) &&
+        !checkAgentPartition(allAgents)) {
+        // Fall back to exchanging agent lists.
+        ownerMap.setPartition(ANY_PARTITION, 0, 1);
+    }
+    if (ownerMap.getPartition() == ANY_PARTITION) {
+        // Have the transport exchange ranges of agents and populate
+        // ownerMap
+        std::vector<AgentID> localRanges;
+        AgentRangeMap::encode(allAgents, myMPIrank, localRanges);
+        transport->allGatherAgentRanges(localRanges, ownerMap);
+    }
+    // Only local agents have entries in the directory.  Owners of
+    // remote agents are looked up in ownerMap.
     for (const AgentID id : allAgents) {
-        agentMap[id] = rank;
+        AgentDirectory::Entry& entry = agentDir.add(id);
+        entry.owner  = myMPIrank;
+        entry.thread = 0;
     }
+    // Let the transport setup any resources it needs for simulation.
+    transport->agentsRegistered();
+}
 
-    // If the number of Processes in the system is 1, we don't have any
-    // registrations coming in from the network
-    if (procCount == 1) {
-        return;
+bool
+Communicator::checkAgentPartition(const std::vector<AgentID>& allAgents) {
+    // Check if agents on all processes are consistent with the
+    // declared partition. If so, no agent lists need to be exchanged.
+    const bool valid = ownerMap.checkPartition(allAgents, myMPIrank);
+    const bool allValid = (transport->allReduceMin(valid ? 1 : 0) > 0);
+    if (myMPIrank == ROOT_KERNEL) {
+        if (allValid) {
+            std::cout << "Agent Registration: using declared "
+                      << ((ownerMap.getPartition() == BLOCK_PARTITION) ?
+                          "block" : "cyclic") << " partition.\n";
+        } else {
+            std::cerr << "Warning: Agents are inconsistent with declared "
+                      << "partition. Exchanging agent lists instead.\n";
+        }
     }
+    return allValid;
+}
 
-    if (rank == ROOT_KERNEL) {
-        // The Root Kernel (rank 0) needs to accept registrations from
-        // other processes.
-        MPI_STATUS status;
-        // We start at 1 because we have already self-registered
-        for (int p = 1; (p < procCount); p++) {
-            // Probe for a message from another simulation kernel.
-            MPI_PROBE(MPI_ANY_SOURCE, AGENT_LIST, status);
-            // Figure out the agent list size
-            int agentListSize = MPI_GET_COUNT(status, MPI_TYPE_UNSIGNED);
-            // Make a large enough array
-            std::vector<unsigned int> agentList(agentListSize);
-            // Perform the actual receive operation
-            MPI_RECV(&agentList[0], agentListSize, MPI_TYPE_UNSIGNED,
-                     status.MPI_SOURCE, AGENT_LIST, status);
-            // Add the contents of this list to master AgentMap
-            for(int i = 0; (i < agentListSize); i++) {
-                if (agentMap.find(agentList[i]) != agentMap.end()) {
-                    std::cerr << "Duplicate agent with ID: "
-                              << agentList[i] << " encountered. Aborting!\n";
-                    ASSERT( false );
-                }
-                agentMap[agentList[i]] = status.MPI_SOURCE;
-            }
-        }
+void
+Communicator::setAgentPartition(const AgentPartition kind,
+                                const AgentID numAgents) {
+    ownerMap.setPartition(kind, numAgents, transport->getNumProcesses());
+}
 
-        // Calculate the size of a flattened agent map. We need to
-        // double the size because we are sending both the agent-id
-        // and the rank
-        int flatAgentMapSize  = agentMap.size() * 2;
-        AgentID* flatAgentMap = new AgentID[flatAgentMapSize];
-        
-        int counter = 0;
-        AgentIDSimulatorIDMap::iterator it = agentMap.begin();
-        for (; (it != agentMap.end()); it++){
-            flatAgentMap[counter]     = it->first;
-            flatAgentMap[counter + 1] = it->second;
-            counter += 2;
-        }
-        // Broadcast the size of the flat agent map
-        MPI_BCAST(&flatAgentMapSize, 1, MPI_TYPE_INT, ROOT_KERNEL);
-        // Broadcast the actual flat agent map
-        MPI_BCAST(flatAgentMap, flatAgentMapSize, MPI_TYPE_UNSIGNED,
-                  ROOT_KERNEL);
-        std::cout << "Agent Registration: complete!" << std::endl;
-        delete[] flatAgentMap;
-    } else {
-        // Send the flat list across with MPI
-        MPI_SEND(allAgents.data(), allAgents.size(), MPI_TYPE_UNSIGNED,
-                 ROOT_KERNEL, AGENT_LIST);
-        //get the size of incoming agentMap list
-        int agentMapLength = 0;
-        MPI_BCAST(&agentMapLength, 1, MPI_TYPE_INT, ROOT_KERNEL);        
-        // Receive a completed agentMap from the Root Kernel (rank 0)
-        AgentID* flatAgentMap = new AgentID[agentMapLength];
-        MPI_BCAST(flatAgentMap, agentMapLength, MPI_TYPE_UNSIGNED, ROOT_KERNEL);
-        // Populate the real agentMap using the flatAgentMap
-        ASSERT(agentMapLength % 2 == 0);
-        for (int i = 0; (i < agentMapLength); i += 2){
-            agentMap[flatAgentMap[i]] = flatAgentMap[i + 1];
-        }
-        delete[] flatAgentMap;
-    }
+void
+Communicator::parseCommandLineArgs(int& argc, char* argv[]) {
+    transport->parseCommandLineArgs(argc, argv);
+}
+
+void
+Communicator::setMaxPendingSends(const int count) {
+    transport->setMaxPendingSends(count);
+}
+
+void
+Communicator::setRecvRing(const int count, const int maxEventSize) {
+    transport->setRecvRing(count, maxEventSize);
 }
 
 void
 Communicator::sendEvent(Event* e, const int eventSize){
-    try {
-        // Send event as raw (char) data
-        const char* serialEvent = reinterpret_cast<const char*>(e);
-        const int destRank      = getOwnerRank(e->getReceiverAgentID());
-        MPI_SEND(serialEvent, eventSize, MPI_TYPE_CHAR, destRank, EVENT);
-        //cout << "SENT an Event of size: " << eventSize << endl;
-        //cout << "[COMMUNICATOR] - made it in sendEvent" << endl;
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (sendEvent): "
-                  << e.Get_error_string() << std::endl;
-    }
+    // Migration messages are routed to a specific process rather
+    // than to the owner of the receiver agent.
+    const int destRank = MigrationMessage::isMigrationMessage(e) ?
+        static_cast<MigrationMessage*>(e)->getDestRank() :
+        getOwnerRank(e->getReceiverAgentID());
+    transport->sendEvent(e, eventSize, destRank);
 }
 
 void
 Communicator::sendMessage(const GVTMessage *msg, const int destRank) {
-    try {
-        // GVT messages are already serialized.
-        const char *data = reinterpret_cast<const char*>(msg);
-        MPI_SEND(data, msg->getSize(), MPI_TYPE_CHAR, destRank, GVT_MESSAGE);
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (sendMessage): ";
-        std::cerr << e.Get_error_string() << std::endl;
-    }
+    transport->sendGVTMessage(msg, destRank);
+}
+
+void
+Communicator::flush() {
+    transport->flush();
 }
 
 void
 Communicator::sendMessage(const std::string& str, const int destRank, int tag) {
-    try {
-        MPI_SEND(str.c_str(), str.size() + 1, MPI_TYPE_CHAR, destRank, tag);
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (sendMessage): ";
-        std::cerr << e.Get_error_string() << std::endl;
-    }
+    transport->sendString(str, destRank, tag);
 }
 
 std::string
 Communicator::receiveMessage(int& recvRank, const int srcRank, int tag,
                              bool blocking) {
-    recvRank = -1;  // Initialize to invalid value
-    MPI_STATUS status;
-    try {
-        if (!blocking && !MPI_IPROBE(srcRank, tag, status)) {
-            // No pending message.
-            return "";
-        } else if (blocking) {
-            // Wait until we get a valid message to read.
-            MPI_PROBE(srcRank, tag, status);
-        }
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (receiveEvent): ";
-        std::cerr << e.Get_error_string() << std::endl;
-        return NULL;
-    }
-    // Figure out the size of the string we need.
-    const int strSize = MPI_GET_COUNT(status, MPI_TYPE_CHAR);
-    std::string msg(strSize - 1, 0);
-    // Read the actual string data.
-    try {
-        MPI_RECV(&msg[0], strSize, MPI_CHAR, status.MPI_SOURCE,
-                 status.MPI_TAG, status);
-        recvRank = status.MPI_SOURCE;
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (receiveEvent): ";
-        std::cerr << e.Get_error_string() << std::endl;
-        return "";
-    }
-    return msg;
+    return transport->receiveString(recvRank, srcRank, tag, blocking);
 }
 
 Event*
 Communicator::receiveEvent(){
-    MPI_STATUS status;
-    try {
-        if (!MPI_IPROBE(MPI_ANY_SOURCE, MPI_ANY_TAG, status)) {
-            // No pending event.
-            return NULL;
-        }
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (receiveEvent): ";
-        std::cerr << e.Get_error_string() << std::endl;
-        return NULL;
-    }
-    // Figure out the agent list size
-    const int eventSize = MPI_GET_COUNT(status, MPI_TYPE_CHAR);
-    char *incoming_event = Event::allocate(eventSize, -1);
-    ASSERT( incoming_event != NULL );
-    // Read the actual data.
-    try {
-        MPI_RECV(incoming_event, eventSize, MPI_TYPE_CHAR,
-                 status.MPI_SOURCE, status.MPI_TAG, status);
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (receiveEvent): ";
-        std::cerr << e.Get_error_string() << std::endl;
-        delete[] incoming_event;
-        return NULL;
+    char* incoming_event = NULL;
+    int eventSize = 0, tag = -1, srcRank = -1;
+    if (!transport->receive(incoming_event, eventSize, tag, srcRank)) {
+        return NULL;  // No pending event.
     }
+    // Now handle the incoming data based on the tag value.
+    return dispatchMessage(incoming_event, eventSize, tag, srcRank);
+}
 
+Event*
+Communicator::dispatchMessage(char* incoming_event, const int eventSize,
+                              const int tag, const int srcRank) {
     // Ensure some of the core data is valid.        
     ASSERT( gvtManager != NULL );
     
     // Now handle the incoming data based on the tag value.
-    if (status.MPI_TAG == EVENT) {
+    if ((tag == EVENT) || (tag == LARGE_EVENT)) {
         // Type cast does the trick as events are binary blobs
         Event* the_event = reinterpret_cast<Event*>(incoming_event);
-        // Since the event is from the network, the reference count must be 1
-        ASSERT(the_event->getReferenceCount() == 1);
+        // Since the event is from the network, the reference count
+        // must be 1. However, the sender may hold extra references on
+        // in-flight events. So reset reference count on our copy.
+        EventAdapter::setReferenceCount(the_event, 1);
         // Let GVT manager inspect incoming events.
         gvtManager->inspectRemoteEvent(the_event);
         // Dispatch event for further processing.
         return the_event;
-    } else if (status.MPI_TAG == GVT_MESSAGE ) {
+    } else if (tag == GVT_MESSAGE ) {
         // Type cast does the trick as GVT messages are binary blobs
         GVTMessage *msg = reinterpret_cast<GVTMessage*>(incoming_event);
         // Let the GVT manager handle it.
@@ -262,8 +196,8 @@ Communicator::receiveEvent(){
     } else {
         // An unhandled message.  This is a serious problem!
         std::cout << "Error: Received an unhandled message at rank="
-                  << myMPIrank << ", from=" << status.MPI_SOURCE
-                  << ", Tag=" << status.MPI_TAG << ", size="
+                  << myMPIrank << ", from=" << srcRank
+                  << ", Tag=" << tag << ", size="
                   << eventSize << std::endl;
         std::cout << "Aborting due to unhandled message.\n";
         abort();
@@ -272,16 +206,29 @@ Communicator::receiveEvent(){
     return NULL;
 }
 
+void
+Communicator::barrier() {
+    transport->barrier();
+}
+
+Time
+Communicator::allReduceMin(const Time value) {
+    return transport->allReduceMin(value);
+}
+
+long
+Communicator::allReduceSum(const long value) {
+    return transport->allReduceSum(value);
+}
+
+void
+Communicator::allReduceSum(std::vector<Time>& values) {
+    transport->allReduceSum(values);
+}
+
 void
 Communicator::finalize(bool stopMPI) {
-    try {
-        if (stopMPI) {
-            MPI_FINALIZE();
-        }
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (finalize): "
-                  << e.Get_error_string() << std::endl;
-    }
+    transport->finalize(stopMPI);
 }
 
 void
@@ -292,11 +239,18 @@ Communicator::setGVTManager(GVTManagerBase* gvtMgr) {
 void
 Communicator::getProcessInfo(unsigned int& rank, unsigned int& numProcesses,
                              unsigned int& totNumThreads) {
-    rank          = MPI_GET_RANK();
-    numProcesses  = MPI_GET_SIZE();
+    rank          = transport->getRank();
+    numProcesses  = transport->getNumProcesses();
     totNumThreads = numProcesses;
 }
 
-Communicator::~Communicator() {}
+void
+Communicator::reportStats(std::ostream& os) {
+    transport->reportStats(os);
+}
+
+Communicator::~Communicator() {
+    delete transport;
+}
 
 #endif
@@ -24,11 +24,13 @@
 #include "ArgParser.h"
 #include "Communicator.h"
 #include "SimpleGVTManager.h"
+#include "NullMessageManager.h"
 #include "Scheduler.h"
 #include <iostream>
 #include <cstdio>
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
 
 muse::ConservativeSimulation::ConservativeSimulation() {
     mustSaveState = false;
@@ -39,7 +41,7 @@ muse::ConservativeSimulation::~ConservativeSimulation() {
 }
 
 void muse::ConservativeSimulation::initialize(int& argc, char* argv[], bool initMPI) {
-    commManager = new Communicator();
+    commManager = createCommunicator();
     myID = commManager->initialize(argc, argv, initMPI);
     unsigned int numThreads;
     commManager->getProcessInfo(myID, numberOfProcesses, numThreads);
@@ -64,6 +66,12 @@ void muse::ConservativeSimulation::parseCommandLineArgs(int& argc, char* argv[])
     ArgParser::ArgRecord arg_list[] = {
         {"--cmbLookahead", "The constant lookahead value for Conservative Simulation",
             &cmdLookahead, ArgParser::DOUBLE},
+        {"--cmb-yawns", "Synchronize once per lookahead window (YAWNS)",
+            &useWindows, ArgParser::BOOLEAN},
+        {"--cmb-async", "Synchronize asynchronously using null messages",
+            &useAsync, ArgParser::BOOLEAN},
+        {"--cmb-nulls", "Null message policy with --cmb-async: lazy|demand",
+            &nullPolicy, ArgParser::STRING},
         {"", "", NULL, ArgParser::INVALID}
     };
 
@@ -78,16 +86,37 @@ void muse::ConservativeSimulation::parseCommandLineArgs(int& argc, char* argv[])
     }
 
     lookAhead = cmdLookahead;
+
+    if ((nullPolicy != "lazy") && (nullPolicy != "demand")) {
+        throw std::runtime_error("Invalid value for --cmb-nulls argument" \
+                                 " (must be lazy or demand)");
+    }
+    if (useAsync && useWindows) {
+        throw std::runtime_error("The --cmb-async and --cmb-yawns " \
+                                 "arguments cannot be used together");
+    }
 }
 
 void muse::ConservativeSimulation::preStartInit() {
     ASSERT(commManager != nullptr);
-    gvtManager = new SimpleGVTManager(this);
+    if (useAsync) {
+        gvtManager = new NullMessageManager(this, nullPolicy == "demand");
+    } else {
+        gvtManager = new SimpleGVTManager(this);
+    }
     gvtManager->initialize(startTime, commManager);
 
     commManager->setGVTManager(gvtManager);
     commManager->registerAgents(allAgents);
 
+    if (useAsync) {
+        // Channels are determined once all agents are registered.
+        std::vector<Time> outLA, inLA;
+        computeChannels(outLA, inLA);
+        static_cast<NullMessageManager*>(gvtManager)->setChannels(outLA,
+                                                                  inLA);
+    }
+
     scheduler->start(startTime);
 }
 
@@ -150,10 +179,17 @@ void muse::ConservativeSimulation::start() {
 
     LGVT = startTime;
 
+    if (useWindows || useAsync) {
+        useWindows ? runWindows() : runAsync();
+        commManager->barrier();
+        return;
+    }
+
     while (true) {
         processMpiMsgs();
 
         gvtManager->forceUpdateGVT();
+        safeTime = getGVT() + lookAhead;
 
         if (getGVT() >= getStopTime()) break;
 
@@ -166,7 +202,113 @@ void muse::ConservativeSimulation::start() {
         processNextEvent();
     }
     
-    MPI_BARRIER();
+    commManager->barrier();
+}
+
+void muse::ConservativeSimulation::runWindows() {
+    SimpleGVTManager* const gvtMgr = static_cast<SimpleGVTManager*>(gvtManager);
+
+    while (true) {
+        // Compute the next window with a single collective.
+        LGVT = scheduler->getNextEventTime();
+        gvtMgr->updateWindow();
+        safeTime = getGVT() + lookAhead;
+
+        if (getGVT() >= getStopTime()) break;
+
+        if (doDumpStats) {
+            dumpStats();
+            doDumpStats = false;
+        }
+
+        // Receive all events sent to us in the previous window. Events
+        // sent in this window are beyond the window (due to lookahead)
+        // and are received before the next window is processed.
+        while (gvtMgr->hasEventsInTransit()) {
+            processMpiMsgs();
+        }
+
+        // Process all the events in the window [GVT, GVT + lookAhead)
+        while (processNextEvent()) {}
+        numWindows++;
+    }
+}
+
+void muse::ConservativeSimulation::runAsync() {
+    NullMessageManager* const nullMgr =
+        static_cast<NullMessageManager*>(gvtManager);
+
+    while (true) {
+        processMpiMsgs();
+
+        // Events below the input channel clocks are safe to process.
+        LGVT     = scheduler->getNextEventTime();
+        safeTime = nullMgr->getSafeTime();
+        nullMgr->updateGVT(std::min(LGVT, safeTime));
+
+        if (getGVT() >= getStopTime()) break;
+
+        if (doDumpStats) {
+            dumpStats();
+            doDumpStats = false;
+        }
+
+        const bool processed = processNextEvent();
+
+        // Promise a lower bound on future events to other processes.
+        LGVT = scheduler->getNextEventTime();
+        nullMgr->sendNullMessages(std::min(LGVT, safeTime), !processed);
+    }
+
+    // We will not send any more events. So let other processes run
+    // to completion without waiting on us.
+    nullMgr->sendFinalNullMessages();
+}
+
+void muse::ConservativeSimulation::computeChannels(std::vector<Time>& outLA,
+                                                   std::vector<Time>& inLA) {
+    // Each process fills in its row (channels from it to other
+    // processes) in a matrix that is then shared via sum-reduction.
+    // Zero entries indicate that there is no channel.
+    const unsigned int numProcs = numberOfProcesses;
+    std::vector<Time> matrix(numProcs * numProcs, 0);
+    for (const auto& link : linkLookahead) {
+        const AgentID src = link.first.first, dest = link.first.second;
+        const int srcRank  = commManager->getOwnerRank(src);
+        const int destRank = commManager->getOwnerRank(dest);
+        if ((srcRank != (int) myID) || (destRank == (int) myID) ||
+            (destRank < 0)) {
+            continue;  // Not an output channel of this process.
+        }
+        Time& entry = matrix[myID * numProcs + destRank];
+        entry = ((entry == 0) ? link.second : std::min(entry, link.second));
+    }
+    if (numProcs > 1) {
+        commManager->allReduceSum(matrix);
+    }
+    if (std::all_of(matrix.begin(), matrix.end(),
+                    [](const Time& la) { return la == 0; })) {
+        // No links declared. Connect all processes.
+        for (unsigned int pid = 0; (pid < numProcs * numProcs); pid++) {
+            matrix[pid] = ((pid / numProcs) == (pid % numProcs)) ? 0 :
+                lookAhead;
+        }
+    }
+    outLA.assign(matrix.begin() + myID * numProcs,
+                 matrix.begin() + (myID + 1) * numProcs);
+    inLA.resize(numProcs);
+    for (unsigned int pid = 0; (pid < numProcs); pid++) {
+        inLA[pid] = matrix[pid * numProcs + myID];
+    }
+}
+
+void muse::ConservativeSimulation::reportLocalStatistics(std::ostream& os) {
+    if (useWindows) {
+        os << "Synchronization windows: " << numWindows << std::endl;
+    }
+    if (useAsync) {
+        static_cast<NullMessageManager*>(gvtManager)->reportStatistics(os);
+    }
 }
 
 bool muse::ConservativeSimulation::processNextEvent() {
@@ -197,7 +339,7 @@ bool muse::ConservativeSimulation::processNextEvent() {
     // }
 
 
-    if (nextEventTime >= getGVT() + lookAhead) {
+    if (nextEventTime >= safeTime) {
         return false;
     }
 
@@ -36,7 +36,7 @@ muse::DefaultSimulation::~DefaultSimulation() {
 
 void
 muse::DefaultSimulation::initialize(int& argc, char* argv[], bool initMPI) {
-    commManager = new Communicator();
+    commManager = createCommunicator();
     myID = commManager->initialize(argc, argv, initMPI);
     unsigned int numThreads;  // dummy. not really used.
     commManager->getProcessInfo(myID, numberOfProcesses, numThreads);
@@ -43,31 +43,29 @@ std::vector<int> EventRecycler::numaIDofThread;
 // The shared communicator to provide agent-to-thread mapping.
 const MultiThreadedCommunicator* EventRecycler::mtc = NULL;
 
+// The global epoch used to reclaim events shared between threads.
+std::atomic<size_t> EventRecycler::globalEpoch(0);
+
+// The epoch announced by each thread.
+std::vector<EventRecycler::ThreadEpoch> EventRecycler::threadEpochs;
+
 //-------------[ The following are thread-local statics ]----------------
 
-// The static map used for recycling events
-thread_local RecycleMap EventRecycler::Recycler;
+// The slab allocator used for recycling events
+thread_local SlabAllocator EventRecycler::slabs;
 
 // The list of pending output events to be deallocated/recycled
 thread_local EventContainer EventRecycler::pendingDeallocs;
 
-// The thread-local index (zero-based) of the thread.
-thread_local char EventRecycler::threadID = 0;
-
-#if USE_NUMA == 1
-// The NUMA-aware memory manager for each thread
-thread_local NumaMemoryManager EventRecycler::numaMemMgr;
-#endif
+// The epoch last announced by this thread
+thread_local size_t EventRecycler::localEpoch = 0;
 
-// The number of method calls to the allocateDefault method in
-thread_local size_t EventRecycler::allocCalls = 0;
+// The lists of events retired by this thread in recent epochs
+thread_local EventContainer
+EventRecycler::retiredEvents[EventRecycler::EpochBuckets];
 
-// The number of deallocationDefault method calls.
-thread_local size_t EventRecycler::deallocCalls = 0;
-
-// The number of times memory requests were satisfied from the default
-// event recycler
-thread_local size_t EventRecycler::recycleHits = 0;
+// The thread-local index (zero-based) of the thread.
+thread_local char EventRecycler::threadID = 0;
 
 int
 EventRecycler::getReferenceCount(const muse::Event* const event) {
@@ -106,17 +104,94 @@ EventRecycler::decreaseOutputRefCount(muse::Event* const event) {
             deallocate(event);
         } else {
             // This event is still being used by the receiving
-            // thread. Queue it to be reclaimed later.
+            // thread. Retire it to be reclaimed in a later epoch.
             ASSERT(event->referenceCount == 0);
-            pendingDeallocs.push_back(event);
+            retiredEvents[localEpoch % EpochBuckets].push_back(event);
         }
     }  // event->refCount == 0
 }
 
 // -------[ Methods for managing shared events between threads ]---------
 
+void
+EventRecycler::setupEpochs(const int numThreads) {
+    ASSERT(numThreads > 0);
+    globalEpoch  = 0;
+    localEpoch   = 0;
+    threadEpochs = std::vector<ThreadEpoch>(numThreads);
+}
+
+double
+EventRecycler::announceEpoch() {
+    const size_t epoch = globalEpoch.load(std::memory_order_acquire);
+    if (epoch == localEpoch) {
+        return -1;  // Epoch has not advanced.  Nothing to be done.
+    }
+    // The global epoch cannot advance past an epoch that this thread
+    // has not announced.  So it must have advanced by exactly one.
+    ASSERT(epoch == localEpoch + 1);
+    ASSERT(threadID < (int) threadEpochs.size());
+    localEpoch = epoch;
+    threadEpochs[threadID].epoch.store(epoch, std::memory_order_release);
+    // Events retired in epoch - 2 (i.e., in the bucket to be reused
+    // for epoch + 1) can now be checked.
+    return reclaimRetired(retiredEvents[(epoch + 1) % EpochBuckets]);
+}
+
+void
+EventRecycler::tryAdvanceEpoch() {
+    size_t epoch = globalEpoch.load(std::memory_order_acquire);
+    for (const ThreadEpoch& te : threadEpochs) {
+        if (te.epoch.load(std::memory_order_acquire) != epoch) {
+            return;  // This thread has not yet reached current epoch
+        }
+    }
+    // All threads have announced the current epoch.  If another
+    // thread advances the epoch first, the CAS below fails harmlessly.
+    globalEpoch.compare_exchange_strong(epoch, epoch + 1,
+                                        std::memory_order_acq_rel);
+}
+
+double
+EventRecycler::reclaimRetired(EventContainer& retired) {
+    if (retired.empty()) {
+        return -1;  // No events retired in this epoch
+    }
+    EventContainer& current = retiredEvents[localEpoch % EpochBuckets];
+    ASSERT(&current != &retired);
+    const size_t fullSize = retired.size();
+    size_t delCount       = 0;
+    for (muse::Event* const event : retired) {
+        ASSERT(event != NULL);
+        ASSERT(event->referenceCount == 0);
+        if (event->inputRefCount == 0) {
+            // Both threads are done with the event.  Recycle it.
+            deallocate(event);
+            delCount++;
+        } else {
+            // Still in use by the receiving thread.  Retire again.
+            current.push_back(event);
+        }
+    }
+    retired.clear();
+    DEBUG(std::cout << "Retired events reclaimed: " << delCount << " of "
+                    << fullSize << std::endl);
+    return (delCount / (double) fullSize);
+}
+
+void
+EventRecycler::moveRetiredToPending() {
+    for (EventContainer& retired : retiredEvents) {
+        pendingDeallocs.insert(pendingDeallocs.end(), retired.begin(),
+                               retired.end());
+        retired.clear();
+    }
+}
+
 double
 EventRecycler::processPendingDeallocs() {
+    // Move retired events to the pending list for final clean-up
+    moveRetiredToPending();
     if (pendingDeallocs.empty()) {
         return -1;  // No events pending to be deallocated
     }
@@ -152,6 +227,8 @@ void
 EventRecycler::movePendingDeallocsTo(EventContainer& mainList) {
     // Ensure the lists are not the same by checking their addresses
     ASSERT(&pendingDeallocs != &mainList);
+    // Include events retired (but not yet reclaimed) on this thread
+    moveRetiredToPending();
     // Copy the pending events from this list to the end of the main
     // list in a thread safe manner. This method is not frequently
     // called and consequently having a static mutex here is not a
@@ -177,33 +254,22 @@ EventRecycler::allocateDefault(const int size, const muse::AgentID receiver) {
     // of the desirable ~5% it should.
     // processPendingDeallocs();  // <-- A *big* no, no!
 
-    // Track the number of times this method was called
-    allocCalls++;
-    
 #ifdef RECYCLE_EVENTS
-    RecycleMap::iterator curr = Recycler.find(size);
-    if (curr != Recycler.end() && !curr->second.empty()) {
-        // Recycle existing buffer.
-        char *buf = curr->second.top();
-        curr->second.pop();
-        // Track success here.
-        recycleHits++;
-        return buf;
-    }
+    // Recycle (or carve out) a chunk of memory not bound to any
+    // specific NUMA node.
+    return slabs.allocate(size);
+#else
+    // Recycling is disabled. So, create a new buffer.
+    return new char[size];
 #endif
-    // No existing buffer of given size to recycle (or recycling is
-    // disabled). So, create a new one.
-    char *buffer = new char[size];
-    return buffer;
 }
 
 void
 EventRecycler::deallocateDefault(char* buffer, const int size) {
-    deallocCalls++;
+    UNUSED_PARAM(size);
 #ifdef RECYCLE_EVENTS
-    Recycler[size].push(buffer);
+    slabs.deallocate(buffer);
 #else
-    UNUSED_PARAM(size);
     delete [] buffer;
 #endif
 }
@@ -215,16 +281,10 @@ EventRecycler::deleteRecycledEventsDefault() {
     // clean-up. So performance is not an issue but aggressive
     // clean-up is important.
     processPendingDeallocs();
-    // Now finally delete recycled events.
-    for (RecycleMap::iterator curr = Recycler.begin();
-         (curr != Recycler.end()); curr++) {
-        std::stack<char*>& stack = curr->second;
-        while (!stack.empty()) {
-            delete [] stack.top();
-            stack.pop();
-        }
-    }
-    Recycler.clear();
+    // Now return events deallocated by this thread to their owners
+    // and release slabs if all of their events have been recycled.
+    // Otherwise, the slabs are released when the thread finishes.
+    slabs.releaseSlabs();
 }
 
 // -------[ Methods associated with event recycling with NUMA ]---------
@@ -259,15 +319,9 @@ EventRecycler::setupNUMA(const MultiThreadedCommunicator* comm,
 
 void
 EventRecycler::startNUMA(const int blockSize) {
-#if USE_NUMA == 1
-    if (numaSetting != NUMA_NONE) {
-        // Start the per-thread NUMA operations.
-        numaMemMgr.start(numaIDofThread, blockSize);
-    }
-#else
-    // Not using NUMA
-    UNUSED_PARAM(blockSize);
-#endif // USE_NUMA == 1
+    // The same slab size is used with or without NUMA.
+    slabs.setSlabSize(blockSize > 0 ? blockSize :
+                      SlabAllocator::getDefaultSlabSize());
 }
 
 #if USE_NUMA == 1
@@ -282,12 +336,15 @@ EventRecycler::allocateNuma(const NumaSetting numaMode, const int size,
     }
     // Use NUMA-aware memory allocator.
     ASSERT(mtc != NULL);
-    const int thrID  = ((numaMode == NUMA_SENDER) ? threadID :
-                        mtc->getThreadID(receiver, threadID));
+    // The MPI progress thread has a slot after the worker threads.
+    // So it is used only as a fallback if the receiver is not local.
+    const int recvThrID = ((numaMode == NUMA_SENDER) ? -1 :
+                           mtc->getThreadID(receiver));
+    const int thrID     = ((recvThrID != -1) ? recvThrID : threadID);
     ASSERT((thrID >= 0) && (thrID < (int) numaIDofThread.size()));
     const int numaID = numaIDofThread[thrID];
-    // Let NUMA memory manager give us the desried block of memory
-    return numaMemMgr.allocate(numaID, size);
+    // Let slab allocator give us the desried block of memory
+    return slabs.allocate(size, numaID);
 }
 
 char*
@@ -302,17 +359,19 @@ EventRecycler::allocateNuma(const int size, const int destThreadID) {
     const int thrID = (destThreadID != -1 ? destThreadID : threadID);
     ASSERT((thrID >= 0) && (thrID < (int) numaIDofThread.size()));
     const int numaID = numaIDofThread[thrID];
-    // Let NUMA memory manager give us the desried block of memory
-    return numaMemMgr.allocate(numaID, size);                       
+    // Let slab allocator give us the desried block of memory
+    return slabs.allocate(size, numaID);
 }
     
 void
 EventRecycler::deallocateNuma(char* buffer, const int size) {
     if (numaSetting == NUMA_NONE) {
         deallocateDefault(buffer, size);
+        return;
     }
-    // Return memory to NUMA-aware memory manager
-    numaMemMgr.deallocate(buffer, size);
+    // Return memory to the slab allocator.  It is returned to the
+    // thread (and hence the NUMA node) from which it was allocated.
+    slabs.deallocate(buffer);
 }
 
 void
@@ -324,19 +383,8 @@ EventRecycler::deleteRecycledEventsNuma() {
 
 std::string
 EventRecycler::getStats() {
-    std::ostringstream os;
-    os << "  Default Allocate calls  : " << allocCalls
-       << "\n  Default Deallocate calls: " << deallocCalls
-       << "\n  Default Recycler hits   : " << recycleHits
-       << "\n  Default Recycler %hits  : "
-       << ((float) recycleHits / allocCalls)
-       << "\n  Defult Recycler         : ";
-    for (auto curr : Recycler) {
-        os << " " << curr.first << " bytes [" << curr.second.size() << "]";
-    }
-    os << std::endl;
     // Return stats information back to the caller
-    return os.str();
+    return slabs.getStats();
 }
 
 #endif
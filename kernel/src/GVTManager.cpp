@@ -25,6 +25,7 @@
 
 #include "GVTManager.h"
 #include "GVTMessage.h"
+#include "MigrationMessage.h"
 #include "Communicator.h"
 #include "Simulation.h"
 #include "EventAdapter.h"
@@ -42,7 +43,9 @@ GVTManager::GVTManager(muse::Simulation* sim) : GVTManagerBase(sim) {
     vecCounters[1] = NULL;
     // Set time to some invalid values.
     tMin           = TIME_INFINITY;
+    sMin           = TIME_INFINITY;
     gvt            = TIME_INFINITY;
+    sendTimeBound  = TIME_INFINITY;
     numProcesses   = 0;
     pendingAcks    = 0;
     cycle          = 0;
@@ -69,6 +72,7 @@ GVTManager::initialize(const Time& startTime, Communicator* comm) {
     
     // Re-initialize the instance variables using new info.
     gvt          = startTime;
+    sendTimeBound = startTime;
     commManager  = comm;
     // Determine configuration information from the comm manager.
     unsigned int numProcs;  // Dummy, as we want total number of threads.
@@ -91,8 +95,9 @@ GVTManager::sendRemoteEvent(Event *event) {
     ASSERT(commManager != NULL);
     
     // Compute remote process id.
-    const unsigned int destRank =
-    commManager->getOwnerThreadRank(event->getReceiverAgentID());
+    const unsigned int destRank = MigrationMessage::isMigrationMessage(event) ?
+        static_cast<MigrationMessage*>(event)->getDestRank() :
+        commManager->getOwnerThreadRank(event->getReceiverAgentID());
     ASSERT(destRank < numProcesses);
 
     // Perform the operations related to sending of a message as
@@ -105,9 +110,10 @@ GVTManager::sendRemoteEvent(Event *event) {
     // of white and red will be swapped.
     vecCounters[(int) activeColor][destRank]++;
     // For non-white messages track minimum outgoing event time stamp
-    // as well
+    // (and sent time) as well
     if (activeColor != white) {
         tMin = std::min<Time>(tMin, event->getReceiveTime());
+        sMin = std::min<Time>(sMin, event->getSentTime());
         DEBUG(std::cout << "GVTManager tMin = " << tMin << std::endl);
     }
     // Finally actually ship out the event to the destination
@@ -134,6 +140,24 @@ GVTManager::inspectRemoteEvent(Event *event) {
     // incoming event has been scheduled.
 }
 
+int
+GVTManager::sendMigration(const unsigned int destRank, const Time& minTime) {
+    ASSERT(destRank < numProcesses);
+    ASSERT((activeColor == 0) || (activeColor == 1));
+    // Track the move just as sendRemoteEvent tracks an event.
+    vecCounters[(int) activeColor][destRank]++;
+    if (activeColor != white) {
+        tMin = std::min<Time>(tMin, minTime);
+    }
+    return activeColor;
+}
+
+void
+GVTManager::recvMigration(const int color) {
+    ASSERT((color == 0) || (color == 1));
+    vecCounters[color][rank]--;
+}
+
 void
 GVTManager::checkWaitingCtrlMsg() {
     if (ctrlMsg == NULL) {
@@ -157,7 +181,11 @@ GVTManager::checkWaitingCtrlMsg() {
                     << ", tMin = " << tMin << std::endl);
     if ((rank == ROOT_KERNEL) && (ctrlMsg->areCountersZero(numProcesses))) {
         ASSERT (tMin >= ctrlMsg->getMin());
-        // A phase of GVT computation is done.
+        // A phase of GVT computation is done. Red events sent by this
+        // process are not yet included in the sMin of the message.
+        sendTimeBound = std::min<Time>(ctrlMsg->getMin(),
+                                       std::min<Time>(ctrlMsg->getSmin(),
+                                                      sMin));
         setGVT(ctrlMsg->getMin());
         // Get rid of the control message as we no longer need it.
         GVTMessage::destroy(ctrlMsg);
@@ -182,6 +210,7 @@ GVTManager::forwardCtrlMsg() {
     }
     // Update tmin.
     ctrlMsg->setTmin(std::min<Time>(ctrlMsg->getTmin(), tMin));
+    ctrlMsg->setSmin(std::min<Time>(ctrlMsg->getSmin(), sMin));
     // Set GVT estimate based on rank of process. But first determine
     // our LGVT value.
     const Time lgvt = sim->getLGVT();
@@ -219,6 +248,7 @@ GVTManager::recvGVTMessage(GVTMessage *message) {
         ASSERT(ctrlMsg == NULL);
         ASSERT(activeColor != white);
         // We have a new gvt estimate. update and garbage collect.
+        sendTimeBound = message->getSmin();
         setGVT(message->getGVTEstimate());
         DEBUG(std::cout << "Rank " << rank << " set GVT via: "
                         << *message << std::endl);
@@ -250,6 +280,7 @@ GVTManager::recvGVTMessage(GVTMessage *message) {
     if ((rank != ROOT_KERNEL) && (activeColor == white)) {
         activeColor = !white;
         tMin        = TIME_INFINITY;
+        sMin        = TIME_INFINITY;
     }
     // Let the helper method do rest of the processing.
     checkWaitingCtrlMsg();
@@ -267,7 +298,9 @@ GVTManager::startGVTestimation() {
         // If there is only one process in the simulation, then simply
         // use LGVT as the GVT value!
         activeColor = !white; // Change our active color.
-        setGVT(sim->getLGVT());
+        const Time lgvt = sim->getLGVT();
+        sendTimeBound   = lgvt;  // No events can be in transit.
+        setGVT(lgvt);
         return;
     }
     
@@ -295,6 +328,7 @@ GVTManager::startGVTestimation() {
     // Now toggle our state and update tmin.
     activeColor = !white;
     tMin        = TIME_INFINITY;
+    sMin        = TIME_INFINITY;
     // Track GVT cycle in process.
     cycle       = 1;
     // Dispatch the message to the next process.
@@ -324,6 +358,7 @@ GVTManager::setGVT(const Time& gvtEst) {
         GVTMessage *gvtMsg = GVTMessage::create(GVTMessage::GVT_EST_MSG);
         ASSERT(gvtMsg != NULL);
         gvtMsg->setGVTEstimate(gvtEst);
+        gvtMsg->setSmin(sendTimeBound);
         // Update the pending acks variable first.
         ASSERT(pendingAcks == 0);
         pendingAcks = numProcesses - 1;
@@ -37,8 +37,12 @@ GVTMessage::create(const GVTMsgKind msgKind, const int numProcesses,
     static unsigned int GlobalSequenceCounter = 0;
     
     // First compute the message size.
-    const int vecSize = (msgKind != GVT_CTRL_MSG) ? 0 :
-        (sizeof(unsigned int) * numProcesses);
+    int vecSize = 0;
+    if (msgKind == GVT_CTRL_MSG) {
+        vecSize = sizeof(unsigned int) * numProcesses;
+    } else if ((msgKind == CMB_NULL_MSG) || (msgKind == CMB_NULL_REQ)) {
+        vecSize = sizeof(int) * 2;  // sender rank and event count
+    }
     const int msgSize = sizeof(GVTMessage) + vecSize;
     // Allocate flat memory for the message.
     char* memory = Event::allocate(msgSize, -1);
@@ -83,6 +87,11 @@ GVTMessage::setTmin(const Time& min) {
     tMin = min;
 }
 
+void
+GVTMessage::setSmin(const Time& min) {
+    sMin = min;
+}
+
 void
 GVTMessage::setGVTEstimate(const Time& estimate) {
     gvtEstimate = estimate;
@@ -104,7 +113,7 @@ GVTMessage::areCountersZero(const int numProcesses) const {
 GVTMessage::GVTMessage(const GVTMsgKind msgKind, const int msgSize)
     : Event(-1, -1), kind(msgKind), size(msgSize) {
     // Initialize other members to invalid values.
-    gvtEstimate = tMin = TIME_INFINITY;
+    gvtEstimate = tMin = sMin = TIME_INFINITY;
     // Set variables in muse::Event base class to invalid values
     // senderAgentID = -1;
     // sentTime      = -1;
@@ -115,7 +124,8 @@ operator<<(std::ostream& os, const muse::GVTMessage& gvtMsg) {
     os << "GVTMessage(kind=" << gvtMsg.kind << ", " << "size="
        << gvtMsg.size << ", seq#=" << gvtMsg.sequenceNumber
        << "): gvtEstimate=" << gvtMsg.gvtEstimate
-       << ", tMin = "<< gvtMsg.tMin << ". Vector counters = { ";
+       << ", tMin = "<< gvtMsg.tMin << ", sMin = " << gvtMsg.sMin
+       << ". Vector counters = { ";
 
     const int MaxCounters = (gvtMsg.size - sizeof(muse::GVTMessage)) /
         sizeof(int);
@@ -0,0 +1,252 @@
+#ifndef HC_CPU_SIMULATION_CPP
+#define HC_CPU_SIMULATION_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <typeindex>
+#include "HCCpuSimulation.h"
+#include "HCAgent.h"
+#include "ArgParser.h"
+#include "Communicator.h"
+#include "Scheduler.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+muse::HCCpuSimulation::HCCpuSimulation() : batchLVT(TIME_INFINITY),
+                                           hcThreads(0) {
+    // Nothing else to be done for now.
+}
+
+muse::HCCpuSimulation::~HCCpuSimulation() {
+    // Necessary clean-up is done in the finalize() method to enable
+    // running multiple simulations.
+}
+
+void
+muse::HCCpuSimulation::initialize(int& argc, char* argv[], bool initMPI) {
+    commManager = createCommunicator();
+    myID = commManager->initialize(argc, argv, initMPI);
+    unsigned int numThreads;  // dummy. not really used.
+    commManager->getProcessInfo(myID, numberOfProcesses, numThreads);
+    // Consume any specific command-line arguments used to setup and
+    // configure other components like the scheduler and GVT manager.
+    parseCommandLineArgs(argc, argv);
+    // Finally, let the base-class perform generic initialization
+    muse::Simulation::initialize(argc, argv, initMPI);
+}
+
+void
+muse::HCCpuSimulation::parseCommandLineArgs(int &argc, char* argv[]) {
+    // First let the base class do the core processing.
+    muse::Simulation::parseCommandLineArgs(argc, argv);
+    // Now parse arguments specific to this class.
+    ArgParser::ArgRecord arg_list[] = {
+        {"--hc-threads", "Number of threads used to run HC kernels " \
+         "(0: OpenMP default)", &hcThreads, ArgParser::INTEGER},
+        {"", "", NULL, ArgParser::INVALID}
+    };
+    ArgParser ap(arg_list);
+    ap.parseArguments(argc, argv, false);
+    if (hcThreads < 0) {
+        throw std::runtime_error("The --hc-threads argument must be >= 0");
+    }
+#ifdef _OPENMP
+    if (hcThreads > 0) {
+        omp_set_num_threads(hcThreads);
+    }
+#else
+    if (hcThreads > 1) {
+        std::cerr << "Warning: OpenMP support not compiled-in. "
+                  << "HC kernels will be run using 1 thread.\n";
+    }
+#endif
+}
+
+void
+muse::HCCpuSimulation::finalize(bool stopMPI, bool delCommMgr) {
+    // Run kernels of agents at the last LVT before agents are finalized
+    runHCkernels();
+    Simulation::finalize(stopMPI, delCommMgr);
+}
+
+void
+muse::HCCpuSimulation::preStartInit() {
+    // First let the base class do the necessary setup.
+    muse::Simulation::preStartInit();
+    // Next, we setup/finalize the AgentMap for all kernels
+    commManager->registerAgents(allAgents);
+}
+
+void
+muse::HCCpuSimulation::initAgents() {
+    // First let the base class do standard initialization of all
+    // agents.
+    Simulation::initAgents();
+    // Kernels are not run for requests made during initialization.
+    for (muse::Agent* agent : allAgents) {
+        agent->hcKernel = -1;
+    }
+}
+
+void
+muse::HCCpuSimulation::garbageCollect() {
+    // Ensure saved states at the LVT of the batch are up to date
+    // before they are garbage collected.
+    runHCkernels();
+    Simulation::garbageCollect();
+}
+
+bool
+muse::HCCpuSimulation::processNextEvent() {
+    // Update lgvt to the time of the next event to be processed.
+    LGVT = scheduler->getNextEventTime();
+    // Run the batch once all agents at its LVT have been scheduled.
+    if (LGVT != batchLVT) {
+        runHCkernels();
+    }
+    // Do sanity checks.
+    if (LGVT < getGVT()) {
+        std::cout << "Offending event: "
+                  << *scheduler->agentPQ->front() << std::endl;
+        std::cout << "LGVT = " << LGVT << " is below GVT: " << getGVT()
+                  << " which is serious error. Scheduled agents: \n";
+        scheduler->agentPQ->prettyPrint(std::cout);
+        std::cout << "Rank " << myID << " Aborting.\n";
+        std::cout << std::flush;
+        DEBUG(logFile->close());
+        abort();
+    }
+    // Let the scheduler have the next agent process its events and
+    // collect the agent if it requested its HC kernel to be run.
+    const AgentID ret = scheduler->processNextAgentEvents();
+    if (ret != InvalidAgentID) {
+        Agent* const agent = scheduler->agentDir->find(ret)->agent;
+        if (agent->hcKernel != -1) {
+            ASSERT(dynamic_cast<HCAgent*>(agent) != NULL);
+            ASSERT(batch.empty() || (agent->getLVT() == batchLVT));
+            batch.push_back(HCEntry{static_cast<HCAgent*>(agent),
+                                    agent->numSchedules});
+            batchLVT        = agent->getLVT();
+            agent->hcKernel = -1;  // reset
+        }
+    }
+    return (ret != InvalidAgentID);
+}
+
+void
+muse::HCCpuSimulation::runHCkernels() {
+    if (batch.empty()) {
+        return;  // No pending agents that require HC operations.
+    }
+    // Drop agents that were rolled back or rescheduled since they
+    // were added to the batch.
+    batch.erase(std::remove_if(batch.begin(), batch.end(),
+                               [this](const HCEntry& entry) {
+                                   return (entry.agent->getLVT() != batchLVT) ||
+                                       (entry.agent->numSchedules !=
+                                        entry.schedules); }),
+                batch.end());
+    // Group agents by type as each type has its own kernel.
+    auto typeOf = [](const HCEntry& entry) {
+        return std::type_index(typeid(*entry.agent)); };
+    std::stable_sort(batch.begin(), batch.end(),
+                     [&typeOf](const HCEntry& e1, const HCEntry& e2) {
+                         return typeOf(e1) < typeOf(e2); });
+    for (size_t start = 0, end = 0; (start < batch.size()); start = end) {
+        for (end = start + 1; (end < batch.size()) &&
+                 (typeOf(batch[end]) == typeOf(batch[start])); end++) {}
+        runHCkernels(start, end);
+    }
+    batch.clear();
+    batchLVT = TIME_INFINITY;
+}
+
+void
+muse::HCCpuSimulation::runHCkernels(const size_t start, const size_t end) {
+    ASSERT(start < end);
+    ASSERT(end <= batch.size());
+    // NOTE: All agents of the same type have the same state and
+    // parameter sizes.
+    const int count     = end - start;
+    const int stateSize = static_cast<muse::HCState*>(batch[start].agent->
+                                          getState())->getHCStateSize();
+    const int paramSize = batch[start].agent->getHCParamSize();
+    agentIDs.resize(count);
+    params.resize(count * paramSize);
+    states.resize(count * stateSize);
+    // Setup random number generators for new entries.
+    if ((int) rndInfo.size() < count) {
+        const int now = time(NULL);
+        for (int i = rndInfo.size(); (i < count); i++) {
+            struct MTrand_Info info;
+            bzero(&info, sizeof(info));
+            info.seed = now + i;
+            rndInfo.push_back(info);
+        }
+    }
+    // Copy agent IDs, parameters, and states into contiguous buffers.
+    for (int i = 0; (i < count); i++) {
+        HCAgent* const agent = batch[start + i].agent;
+        ASSERT(dynamic_cast<muse::HCState*>(agent->getState()) != NULL);
+        muse::HCState* state = static_cast<muse::HCState*>(agent->getState());
+        ASSERT(agent->getHCParamSize() == paramSize);
+        ASSERT(state->getHCStateSize() == stateSize);
+        agentIDs[i] = agent->getAgentID();
+        agent->copyToDevice(params.data() + i * paramSize, paramSize);
+        state->copyToDevice(states.data() + i * stateSize, stateSize);
+    }
+    // Run the kernel on all the agents in one shot if supported.
+    // Otherwise run the kernel of each agent one at a time.
+    if (!batch[start].agent->executeHCkernels(count, agentIDs.data(),
+                                              params.data(), states.data(),
+                                              rndInfo.data(), batchLVT,
+                                              getGVT())) {
+        for (int i = 0; (i < count); i++) {
+            HCAgent* const agent = batch[start + i].agent;
+            agent->executeHCkernel();
+            static_cast<muse::HCState*>(agent->getState())->
+                copyToDevice(states.data() + i * stateSize, stateSize);
+        }
+    }
+    // Copy the updated states back into the current state and into
+    // the state saved at the LVT (for rollbacks).
+    for (int i = 0; (i < count); i++) {
+        HCAgent* const agent = batch[start + i].agent;
+        const char* const hcState = states.data() + i * stateSize;
+        static_cast<muse::HCState*>(agent->getState())->
+            copyFromDevice(hcState, stateSize);
+        if (agent->mustSaveState &&
+            (agent->stateQueue.back()->getTimeStamp() == batchLVT)) {
+            ASSERT(dynamic_cast<muse::HCState*>(agent->stateQueue.back()));
+            static_cast<muse::HCState*>(agent->stateQueue.back())->
+                copyFromDevice(hcState, stateSize);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef HUGE_PAGE_ALLOCATOR_CPP
+#define HUGE_PAGE_ALLOCATOR_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <sys/mman.h>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include "HugePageAllocator.h"
+
+#if USE_NUMA == 1
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+// Switch to muse namespace to streamline code
+using namespace muse;
+
+// Huge pages are not used by default
+HugePageAllocator::Mode HugePageAllocator::mode = HugePageAllocator::NONE;
+
+// Fallback from explicit huge pages is reported only once
+std::atomic<bool> HugePageAllocator::reportedFallback(false);
+
+bool
+HugePageAllocator::setMode(const std::string& modeName) {
+    if (modeName == "none") {
+        mode = NONE;
+    } else if (modeName == "thp") {
+        mode = TRANSPARENT;
+    } else if (modeName == "explicit") {
+        mode = EXPLICIT;
+    } else {
+        return false;  // Invalid mode
+    }
+    return true;
+}
+
+char*
+HugePageAllocator::allocate(const size_t size, const int numaID, bool& huge) {
+    ASSERT(mode != NONE);
+    ASSERT(size % HugePageSize == 0);
+    void* mem = MAP_FAILED;
+    huge      = false;
+#ifdef MAP_HUGETLB
+    if (mode == EXPLICIT) {
+        // Memory from the reserved huge page pool is always aligned.
+        mem  = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        huge = (mem != MAP_FAILED);
+        if (!huge && !reportedFallback.exchange(true)) {
+            std::cerr << "Warning: Explicit huge pages are unavailable. "
+                      << "Using transparent huge pages instead.\n";
+        }
+    }
+#endif
+    if (mem == MAP_FAILED) {
+        // Map extra memory and trim it so that the arena is aligned
+        // to a huge page boundary. Otherwise the kernel cannot use
+        // huge pages for the partial pages at either end.
+        const size_t mapSize = size + HugePageSize;
+        char* const raw = static_cast<char*>(mmap(NULL, mapSize,
+                                                  PROT_READ | PROT_WRITE,
+                                                  MAP_PRIVATE | MAP_ANONYMOUS,
+                                                  -1, 0));
+        if (raw == MAP_FAILED) {
+            std::cerr << "Error mapping " << size << " bytes of memory\n";
+            abort();
+        }
+        const uintptr_t addr    = reinterpret_cast<uintptr_t>(raw);
+        const uintptr_t aligned = (addr + HugePageSize - 1) &
+            ~(HugePageSize - 1);
+        char* const start = reinterpret_cast<char*>(aligned);
+        if (start > raw) {
+            munmap(raw, start - raw);
+        }
+        if (start + size < raw + mapSize) {
+            munmap(start + size, (raw + mapSize) - (start + size));
+        }
+        mem = start;
+#ifdef MADV_HUGEPAGE
+        // Advise the kernel to back the arena with huge pages.  This
+        // fails if transparent huge pages are not supported.
+        huge = (madvise(mem, size, MADV_HUGEPAGE) == 0);
+#endif
+    }
+#if USE_NUMA == 1
+    if (numaID >= 0) {
+        // Bind the arena to the NUMA node before it is touched.  The
+        // preferred policy is used so that running out of (huge)
+        // pages on the node does not cause SIGBUS on first use.
+        struct bitmask* const nodes = numa_allocate_nodemask();
+        numa_bitmask_setbit(nodes, numaID);
+        if (mbind(mem, size, MPOL_PREFERRED, nodes->maskp,
+                  nodes->size + 1, 0) != 0) {
+            std::cerr << "Warning: Unable to bind memory to NUMA node "
+                      << numaID << std::endl;
+        }
+        numa_free_nodemask(nodes);
+    }
+#else
+    UNUSED_PARAM(numaID);
+#endif
+    return static_cast<char*>(mem);
+}
+
+void
+HugePageAllocator::release(char* mem, const size_t size) {
+    ASSERT(mem != NULL);
+    munmap(mem, size);
+}
+
+std::string
+HugePageAllocator::getCoverage(const size_t hugeBytes,
+                               const size_t totalBytes) {
+    std::ostringstream os;
+    os << hugeBytes << " of " << totalBytes << " bytes ("
+       << (totalBytes > 0 ? (100.0 * hugeBytes / totalBytes) : 0)
+       << "%, mode: "
+       << (mode == NONE ? "none" : (mode == TRANSPARENT ? "thp" : "explicit"))
+       << ")";
+    return os.str();
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef MUSE_IDLE_PARKER_CPP
+#define MUSE_IDLE_PARKER_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors:  Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+
+#include <algorithm>
+#include "IdleParker.h"
+
+// Switch to muse namespace to streamline code
+using namespace muse;
+
+IdleParker::IdleParker(const int spinLimit, const int parkUsec) :
+    spinLimit(spinLimit), minSpin(std::max(1, spinLimit / 16)),
+    maxSpin(spinLimit * 16), idleSpins(0), parkTime(parkUsec),
+    parked(false), parkCount(0), wakeCount(0), timeoutCount(0) {
+    ASSERT(spinLimit > 0);
+    ASSERT(parkUsec > 0);
+}
+
+bool
+IdleParker::park(const std::function<bool()>& hasWork) {
+    idleSpins = 0;
+    // Announce that this thread is parked before rechecking for
+    // work.  Together with the fence in wakeup(), this ensures that
+    // either the recheck sees an event added by another thread or
+    // the other thread sees this flag (and wakes us up).
+    parked.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (hasWork()) {
+        parked.store(false);
+        return true;
+    }
+    parkCount++;
+    std::unique_lock<std::mutex> lock(parkMutex);
+    const bool woken = parkCond.wait_for(lock, parkTime, [this] {
+            return !parked.load(std::memory_order_relaxed); });
+    parked.store(false, std::memory_order_relaxed);
+    // Adapt the spin limit based on why the park ended.
+    if (woken) {
+        wakeCount++;
+        spinLimit = std::min(spinLimit * 2, maxSpin);
+    } else {
+        timeoutCount++;
+        spinLimit = std::max(spinLimit / 2, minSpin);
+    }
+    return woken;
+}
+
+void
+IdleParker::wakeup() {
+    // Order the preceding add to the incoming queue before checking
+    // the flag (see park()).
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            parked.store(false, std::memory_order_relaxed);
+        }
+        parkCond.notify_one();
+    }
+}
+
+void
+IdleParker::reportStats(std::ostream& os) const {
+    os << "#Idle parks            : " << parkCount
+       << "\n#Parks woken / timeout : " << wakeCount << " / "
+       << timeoutCount
+       << "\nFinal idle spin limit  : " << spinLimit << std::endl;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef MIGRATION_MESSAGE_CPP
+#define MIGRATION_MESSAGE_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors:  Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <cstring>
+#include "MigrationMessage.h"
+#include "EventAdapter.h"
+
+// Switch default namespace to streamline code
+using namespace muse;
+
+MigrationMessage*
+MigrationMessage::create(const Kind kind, const int srcRank,
+                         const int destRank, const int round,
+                         const std::string& payload, const Time recvTime) {
+    // First compute the message size.
+    const int payloadSize = payload.size();
+    const int msgSize     = sizeof(MigrationMessage) + payloadSize;
+    // Allocate flat memory for the message via the event allocator so
+    // that the message can be recycled just as any other event.
+    char* memory = Event::allocate(msgSize, -1);
+    // Now use the flat memory to instantiate an object.
+    MigrationMessage* msg = new (memory)
+        MigrationMessage(kind, srcRank, destRank, round, payloadSize,
+                         msgSize, recvTime);
+    std::memcpy(msg->payload, payload.data(), payloadSize);
+    return msg;
+}
+
+MigrationMessage::MigrationMessage(const Kind kind, const int srcRank,
+                                   const int destRank, const int round,
+                                   const int payloadSize, const int msgSize,
+                                   const Time recvTime) :
+    muse::Event(MIGRATION_MSG_SENDER, recvTime), msgSize(msgSize),
+    kind(kind), srcRank(srcRank), destRank(destRank), round(round),
+    payloadSize(payloadSize) {
+    // Setup the sender to sentinel value for identification of
+    // message in Simulation::processMpiMsgs
+    EventAdapter::setSenderAgentID(this, MIGRATION_MSG_SENDER);
+}
+
+#endif
@@ -0,0 +1,425 @@
+#ifndef MUSE_MPI_TRANSPORT_CPP
+#define MUSE_MPI_TRANSPORT_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Meseret R. Gebre       meseret.gebre@gmail.com
+//          Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include "MpiTransport.h"
+#include "GVTMessage.h"
+#include "Event.h"
+#include "EventRecycler.h"
+
+using namespace muse;
+
+MpiTransport::MpiTransport() : myRank(-1), numProcs(0), numIsends(0),
+                               sendPoolStalls(0), recvHead(0),
+                               recvBufferSize(0), numRingRecvs(0),
+                               numProbeRecvs(0) {
+    // Nothing else to be done.
+}
+
+MpiTransport::~MpiTransport() {}
+
+int
+MpiTransport::initialize(int argc, char* argv[], bool initMPI) {
+    if (initMPI) {
+        // Initialize MPI.
+        MPI_INIT(argc, argv);
+    }
+    // Setup the rank for this process
+    myRank   = MPI_GET_RANK();
+    numProcs = MPI_GET_SIZE();
+    return myRank;
+}
+
+void
+MpiTransport::allGatherAgentRanges(const std::vector<AgentID>& localRanges,
+                                   AgentRangeMap& ownerMap) {
+    if (numProcs == 1) {
+        // No registrations coming in from the network.
+        ownerMap.add(localRanges.data(), localRanges.size());
+        ownerMap.finalize();
+        return;
+    }
+    // First exchange the number of values contributed by each process
+    // so that the displacements for MPI_Allgatherv can be computed.
+    int localCount = localRanges.size();
+    std::vector<int> counts(numProcs), displs(numProcs);
+    MPI_ALL_GATHER(&localCount, 1, MPI_TYPE_INT, counts.data(), 1,
+                   MPI_TYPE_INT);
+    int totalCount = 0;
+    for (int p = 0; (p < numProcs); p++) {
+        displs[p]   = totalCount;
+        totalCount += counts[p];
+    }
+    // Now gather the ranges from all the processes in one shot.
+    std::vector<AgentID> allRanges(totalCount);
+    MPI_ALL_GATHERV(const_cast<AgentID*>(localRanges.data()), localCount,
+                    MPI_TYPE_INT, allRanges.data(), counts.data(),
+                    displs.data(), MPI_TYPE_INT);
+    ownerMap.add(allRanges.data(), allRanges.size());
+    ownerMap.finalize();
+    if (myRank == ROOT_KERNEL) {
+        std::cout << "Agent Registration: complete ("
+                  << ownerMap.size() << " ranges)!" << std::endl;
+    }
+}
+
+void
+MpiTransport::setMaxPendingSends(const int count) {
+    ASSERT(count >= 0);
+    ASSERT(numIsends == 0);  // Can't change pool once sends have started
+    sendRequests.assign(count, MPI_REQUEST_NULL);
+    sendBuffers.assign(count, NULL);
+    sendTags.assign(count, EVENT);
+    sendSizes.assign(count, 0);
+    doneSendIndexs.resize(count);
+    // Initially all the slots are free.
+    freeSendSlots.resize(count);
+    for (int i = 0; (i < count); i++) {
+        freeSendSlots[i] = count - i - 1;
+    }
+}
+
+int
+MpiTransport::reclaimCompletedSends(const bool wait) {
+    if (freeSendSlots.size() == sendRequests.size()) {
+        return 0;  // No pending sends to check.
+    }
+    int doneCount = 0;
+    try {
+        if (wait) {
+            MPI_WAITSOME(sendRequests.size(), &sendRequests[0], doneCount,
+                         &doneSendIndexs[0]);
+        } else {
+            MPI_TESTSOME(sendRequests.size(), &sendRequests[0], doneCount,
+                         &doneSendIndexs[0]);
+        }
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (reclaimCompletedSends): "
+                  << e.Get_error_string() << std::endl;
+        return 0;
+    }
+    // Release buffers associated with the completed requests.
+    for (int i = 0; (i < doneCount); i++) {
+        const int slot = doneSendIndexs[i];
+        ASSERT(sendBuffers[slot] != NULL);
+        if (sendTags[slot] != GVT_MESSAGE) {
+            // Recycle the copy of the event made for sending.
+            EventRecycler::deallocateDefault(
+                reinterpret_cast<char*>(sendBuffers[slot]), sendSizes[slot]);
+        } else {
+            // Recycle the copy of the GVT message made for sending.
+            GVTMessage::destroy(static_cast<GVTMessage*>(sendBuffers[slot]));
+        }
+        sendBuffers[slot] = NULL;
+        freeSendSlots.push_back(slot);
+    }
+    // MPI sets doneCount to MPI_UNDEFINED if all requests are NULL.
+    return std::max(0, doneCount);
+}
+
+void
+MpiTransport::isend(Event* buffer, const int size, const int destRank,
+                    const int tag) {
+    // Reclaim any completed sends to free-up slots & buffers
+    reclaimCompletedSends();
+    if (freeSendSlots.empty()) {
+        // All slots are in use. We have no option but to wait.
+        sendPoolStalls++;
+        reclaimCompletedSends(true);
+    }
+    ASSERT(!freeSendSlots.empty());
+    const int slot = freeSendSlots.back();
+    freeSendSlots.pop_back();
+    ASSERT(sendBuffers[slot] == NULL);
+    sendBuffers[slot] = buffer;
+    sendTags[slot]    = tag;
+    sendSizes[slot]   = size;
+    numIsends++;
+    MPI_ISEND(reinterpret_cast<const char*>(buffer), size, MPI_TYPE_CHAR,
+              destRank, tag, sendRequests[slot]);
+}
+
+void
+MpiTransport::drainPendingSends() {
+    while (freeSendSlots.size() < sendRequests.size()) {
+        reclaimCompletedSends(true);
+    }
+}
+
+void
+MpiTransport::sendEvent(Event* e, const int eventSize, const int destRank) {
+    try {
+        // Events that don't fit in pre-posted receive buffers are
+        // sent with a different tag.
+        const int tag = ((recvBufferSize > 0) && (eventSize > recvBufferSize)
+                         ? LARGE_EVENT : EVENT);
+        if (!sendRequests.empty()) {
+            // The buffer of a pending send must not be modified. But
+            // the sender changes the reference count of the event (and
+            // may recycle it) while the send is in flight.  So send a
+            // copy instead, just as it is done for GVT messages.
+            char* copy = Event::allocate(eventSize, -1);
+            std::memcpy(copy, e, eventSize);
+            isend(reinterpret_cast<Event*>(copy), eventSize, destRank, tag);
+            return;
+        }
+        // Send event as raw (char) data
+        const char* serialEvent = reinterpret_cast<const char*>(e);
+        MPI_SEND(serialEvent, eventSize, MPI_TYPE_CHAR, destRank, tag);
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (sendEvent): "
+                  << e.Get_error_string() << std::endl;
+    }
+}
+
+void
+MpiTransport::sendGVTMessage(const GVTMessage *msg, const int destRank) {
+    try {
+        if (!sendRequests.empty()) {
+            // GVT messages are destroyed (or reused) by the caller
+            // right after this call. So send a copy instead.
+            GVTMessage* copy =
+                GVTMessage::create(msg, msg->getReceiverAgentID(), 0);
+            isend(copy, copy->getSize(), destRank, GVT_MESSAGE);
+            return;
+        }
+        // GVT messages are already serialized.
+        const char *data = reinterpret_cast<const char*>(msg);
+        MPI_SEND(data, msg->getSize(), MPI_TYPE_CHAR, destRank, GVT_MESSAGE);
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (sendMessage): ";
+        std::cerr << e.Get_error_string() << std::endl;
+    }
+}
+
+void
+MpiTransport::sendString(const std::string& str, const int destRank,
+                         const int tag) {
+    try {
+        MPI_SEND(str.c_str(), str.size() + 1, MPI_TYPE_CHAR, destRank, tag);
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (sendMessage): ";
+        std::cerr << e.Get_error_string() << std::endl;
+    }
+}
+
+std::string
+MpiTransport::receiveString(int& recvRank, const int srcRank, const int tag,
+                            const bool blocking) {
+    recvRank = -1;  // Initialize to invalid value
+    MPI_STATUS status;
+    try {
+        if (!blocking && !MPI_IPROBE(srcRank, tag, status)) {
+            // No pending message.
+            return "";
+        } else if (blocking) {
+            // Wait until we get a valid message to read.
+            MPI_PROBE(srcRank, tag, status);
+        }
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (receiveEvent): ";
+        std::cerr << e.Get_error_string() << std::endl;
+        return "";
+    }
+    // Figure out the size of the string we need.
+    const int strSize = MPI_GET_COUNT(status, MPI_TYPE_CHAR);
+    std::string msg(strSize - 1, 0);
+    // Read the actual string data.
+    try {
+        MPI_RECV(&msg[0], strSize, MPI_CHAR, status.MPI_SOURCE,
+                 status.MPI_TAG, status);
+        recvRank = status.MPI_SOURCE;
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (receiveEvent): ";
+        std::cerr << e.Get_error_string() << std::endl;
+        return "";
+    }
+    return msg;
+}
+
+void
+MpiTransport::setRecvRing(const int count, const int maxEventSize) {
+    ASSERT(count >= 0);
+    ASSERT(recvRequests.empty());
+    if (count == 0) {
+        return;  // Pre-posted receives are not used.
+    }
+    ASSERT(maxEventSize >= (int) sizeof(Event));
+    recvBufferSize = maxEventSize;
+    recvHead       = 0;
+    recvRequests.resize(count);
+    recvBuffers.resize(count);
+    // Pre-post all the receives in the ring.
+    for (int i = 0; (i < count); i++) {
+        recvBuffers[i] = Event::allocate(recvBufferSize, -1);
+        MPI_IRECV(recvBuffers[i], recvBufferSize, MPI_TYPE_CHAR,
+                  MPI_ANY_SOURCE, EVENT, recvRequests[i]);
+    }
+}
+
+void
+MpiTransport::cancelRecvRing() {
+    for (size_t i = 0; (i < recvRequests.size()); i++) {
+        MPI_CANCEL(recvRequests[i]);
+        EventRecycler::deallocateDefault(recvBuffers[i], recvBufferSize);
+    }
+    recvRequests.clear();
+    recvBuffers.clear();
+    recvBufferSize = 0;
+}
+
+bool
+MpiTransport::receiveRingEvent(char*& data, int& size, int& srcRank,
+                               const bool wait) {
+    MPI_STATUS status;
+    try {
+        if (wait) {
+            MPI_WAIT(recvRequests[recvHead], status);
+        } else if (!MPI_TEST(recvRequests[recvHead], status)) {
+            return false;  // The oldest receive has not completed yet.
+        }
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (receiveRingEvent): ";
+        std::cerr << e.Get_error_string() << std::endl;
+        return false;
+    }
+    // Hand-off the buffer (no copy) and re-post a fresh receive.
+    data    = recvBuffers[recvHead];
+    size    = MPI_GET_COUNT(status, MPI_TYPE_CHAR);
+    srcRank = status.MPI_SOURCE;
+    recvBuffers[recvHead] = Event::allocate(recvBufferSize, -1);
+    MPI_IRECV(recvBuffers[recvHead], recvBufferSize, MPI_TYPE_CHAR,
+              MPI_ANY_SOURCE, EVENT, recvRequests[recvHead]);
+    recvHead = (recvHead + 1) % recvRequests.size();
+    numRingRecvs++;
+    return true;
+}
+
+bool
+MpiTransport::receive(char*& data, int& size, int& tag, int& srcRank) {
+    // Use this opportunity to reclaim buffers from completed sends.
+    reclaimCompletedSends();
+    // Next check for events received via pre-posted receives, if any.
+    if (!recvRequests.empty() && receiveRingEvent(data, size, srcRank)) {
+        tag = EVENT;
+        return true;
+    }
+    MPI_STATUS status;
+    try {
+        if (!MPI_IPROBE(MPI_ANY_SOURCE, MPI_ANY_TAG, status)) {
+            // No pending event.
+            return false;
+        }
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (receiveEvent): ";
+        std::cerr << e.Get_error_string() << std::endl;
+        return false;
+    }
+    if (!recvRequests.empty() && (status.MPI_TAG == EVENT)) {
+        // All pre-posted receives are matched (otherwise this event
+        // would have matched one). Leave this event to be received
+        // via the ring to preserve order of events. But the oldest
+        // receive in the ring is matched and completes shortly. So
+        // wait for it, rather than report no messages, so that
+        // processMpiMsgs continues draining and GVT messages queued
+        // behind a backlog of events are not delayed.
+        if (receiveRingEvent(data, size, srcRank, true)) {
+            tag = EVENT;
+            return true;
+        }
+        return false;
+    }
+    // Figure out the agent list size
+    size = MPI_GET_COUNT(status, MPI_TYPE_CHAR);
+    data = Event::allocate(size, -1);
+    ASSERT( data != NULL );
+    // Read the actual data.
+    try {
+        MPI_RECV(data, size, MPI_TYPE_CHAR, status.MPI_SOURCE,
+                 status.MPI_TAG, status);
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (receiveEvent): ";
+        std::cerr << e.Get_error_string() << std::endl;
+        delete[] data;
+        return false;
+    }
+    numProbeRecvs++;
+    tag     = status.MPI_TAG;
+    srcRank = status.MPI_SOURCE;
+    return true;
+}
+
+void
+MpiTransport::barrier() {
+    MPI_BARRIER();
+}
+
+Time
+MpiTransport::allReduceMin(const Time value) {
+    Time localValue = value, globalMin = value;
+    MPI_ALL_REDUCE(&localValue, &globalMin, 1, MPI_DOUBLE, MPI_MIN);
+    return globalMin;
+}
+
+long
+MpiTransport::allReduceSum(const long value) {
+    long localValue = value, globalSum = value;
+    MPI_ALL_REDUCE(&localValue, &globalSum, 1, MPI_LONG, MPI_SUM);
+    return globalSum;
+}
+
+void
+MpiTransport::allReduceSum(std::vector<Time>& values) {
+    std::vector<Time> localValues(values);
+    MPI_ALL_REDUCE(localValues.data(), values.data(), values.size(),
+                   MPI_DOUBLE, MPI_SUM);
+}
+
+void
+MpiTransport::finalize(bool stopMPI) {
+    // Ensure all in-flight sends are done and buffers released.
+    drainPendingSends();
+    // Release buffers used for pre-posted receives (if any)
+    cancelRecvRing();
+    try {
+        if (stopMPI) {
+            MPI_FINALIZE();
+        }
+    } catch (CONST_EXP MPI_EXCEPTION& e) {
+        std::cerr << "MPI ERROR (finalize): "
+                  << e.Get_error_string() << std::endl;
+    }
+}
+
+void
+MpiTransport::reportStats(std::ostream& os) {
+    os << "Non-blocking MPI sends : " << numIsends
+       << "\nMPI send pool stalls   : " << sendPoolStalls
+       << "\nPre-posted recv events : " << numRingRecvs
+       << "\nProbed MPI recvs       : " << numProbeRecvs << std::endl;
+}
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef NULL_MESSAGE_MANAGER_CPP
+#define NULL_MESSAGE_MANAGER_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+
+#include <iostream>
+#include "Communicator.h"
+#include "Event.h"
+#include "EventAdapter.h"
+#include "GVTMessage.h"
+#include "NullMessageManager.h"
+#include "Simulation.h"
+
+using namespace muse;
+
+NullMessageManager::NullMessageManager(Simulation *sim, const bool demandDriven)
+    : GVTManagerBase(sim), demandDriven(demandDriven) {
+}
+
+void
+NullMessageManager::initialize(const Time &startTime, Communicator *comm) {
+    ASSERT(startTime < TIME_INFINITY);
+    ASSERT(comm != nullptr);
+
+    gvt         = startTime;
+    commManager = comm;
+
+    unsigned int numThreads;
+    commManager->getProcessInfo(rank, numProcesses, numThreads);
+
+    ASSERT(numProcesses > 0);
+    ASSERT(rank < numProcesses);
+}
+
+void
+NullMessageManager::setChannels(const std::vector<Time>& outLA,
+                                const std::vector<Time>& inLA) {
+    ASSERT(outLA.size() == numProcesses);
+    ASSERT(inLA.size()  == numProcesses);
+    outLookahead = outLA;
+    inLookahead  = inLA;
+    // Initially, events can be exchanged only after start time plus
+    // the lookahead of each channel.
+    lastPromise.assign(numProcesses, TIME_INFINITY);
+    inClock.assign(numProcesses, TIME_INFINITY);
+    for (unsigned int pid = 0; (pid < numProcesses); pid++) {
+        if (outLookahead[pid] > 0) {
+            lastPromise[pid] = gvt + outLookahead[pid];
+        }
+        if (inLookahead[pid] > 0) {
+            inClock[pid] = gvt + inLookahead[pid];
+        }
+    }
+    pendingPromise.assign(numProcesses, TIME_INFINITY);
+    sentCount.assign(numProcesses, 0);
+    recvCount.assign(numProcesses, 0);
+    pendingCount.assign(numProcesses, -1);
+    wanted.assign(numProcesses, false);
+    requested.assign(numProcesses, false);
+}
+
+bool
+NullMessageManager::sendRemoteEvent(Event *event) {
+    const unsigned int dest =
+        commManager->getOwnerRank(event->getReceiverAgentID());
+    if (outLookahead[dest] <= 0) {
+        std::cerr << "Error: Agent " << event->getSenderAgentID()
+                  << " sent an event to agent " << event->getReceiverAgentID()
+                  << " on rank " << dest << " without a declared "
+                  << "lookahead (see Simulation::declareLookahead).\n";
+        abort();
+    }
+    if (event->getReceiveTime() < lastPromise[dest]) {
+        std::cerr << "Error: Agent " << event->getSenderAgentID()
+                  << " sent an event at time " << event->getReceiveTime()
+                  << " to agent " << event->getReceiverAgentID()
+                  << " which is below the promise of " << lastPromise[dest]
+                  << " made to rank " << dest << " (lookahead violated).\n";
+        abort();
+    }
+    commManager->sendEvent(event, EventAdapter::getEventSize(event));
+    sentCount[dest]++;
+    return true;
+}
+
+void
+NullMessageManager::inspectRemoteEvent(Event *event) {
+    const unsigned int src =
+        commManager->getOwnerRank(event->getSenderAgentID());
+    ASSERT(src < numProcesses);
+    recvCount[src]++;
+    // Apply a pending promise if all events sent prior to it have
+    // now been received.
+    if ((pendingCount[src] >= 0) && (recvCount[src] >= pendingCount[src])) {
+        advanceClock(src, pendingPromise[src]);
+    }
+}
+
+void
+NullMessageManager::recvGVTMessage(GVTMessage *message) {
+    ASSERT(message != NULL);
+    const int* const counters = message->getCounters();
+    const unsigned int src    = counters[0];
+    ASSERT(src < numProcesses);
+    if (message->getKind() == GVTMessage::CMB_NULL_REQ) {
+        // Send a null message the next time our promise advances.
+        wanted[src] = true;
+    } else {
+        ASSERT(message->getKind() == GVTMessage::CMB_NULL_MSG);
+        nullsRecvd++;
+        requested[src] = false;
+        if (recvCount[src] >= counters[1]) {
+            advanceClock(src, message->getGVTEstimate());
+        } else {
+            // Some events sent before this promise are in transit.
+            pendingPromise[src] = message->getGVTEstimate();
+            pendingCount[src]   = counters[1];
+        }
+    }
+    GVTMessage::destroy(message);
+}
+
+void
+NullMessageManager::advanceClock(const unsigned int src, const Time& promise) {
+    ASSERT(inLookahead[src] > 0);
+    inClock[src]        = std::max(inClock[src], promise);
+    pendingPromise[src] = TIME_INFINITY;
+    pendingCount[src]   = -1;  // No pending promise
+}
+
+Time
+NullMessageManager::getSafeTime() const {
+    return *std::min_element(inClock.begin(), inClock.end());
+}
+
+void
+NullMessageManager::sendNullMessages(const Time& lowerBound,
+                                     const bool blocked) {
+    for (unsigned int dest = 0; (dest < numProcesses); dest++) {
+        if (outLookahead[dest] <= 0) {
+            continue;  // No channel to this process.
+        }
+        const Time promise = lowerBound + outLookahead[dest];
+        if (promise <= lastPromise[dest]) {
+            continue;  // Nothing new to promise.
+        }
+        if (demandDriven ? wanted[dest] :
+            (blocked || (promise >= lastPromise[dest] + outLookahead[dest]))) {
+            sendNullMessage(dest, promise);
+        }
+    }
+    if (demandDriven && blocked) {
+        // Request null messages from the channels limiting our progress.
+        const Time safeTime = getSafeTime();
+        for (unsigned int src = 0; (src < numProcesses); src++) {
+            if ((inClock[src] == safeTime) && (safeTime < TIME_INFINITY) &&
+                !requested[src]) {
+                GVTMessage* req =
+                    GVTMessage::create(GVTMessage::CMB_NULL_REQ, 0, -src);
+                req->getCounters()[0] = rank;
+                commManager->sendMessage(req, src);
+                GVTMessage::destroy(req);
+                requested[src] = true;
+                requestsSent++;
+            }
+        }
+    }
+}
+
+void
+NullMessageManager::sendFinalNullMessages() {
+    for (unsigned int dest = 0; (dest < numProcesses); dest++) {
+        if ((outLookahead[dest] > 0) && (lastPromise[dest] < TIME_INFINITY)) {
+            sendNullMessage(dest, TIME_INFINITY);
+        }
+    }
+}
+
+void
+NullMessageManager::sendNullMessage(const unsigned int dest,
+                                    const Time& promise) {
+    GVTMessage* msg = GVTMessage::create(GVTMessage::CMB_NULL_MSG, 0, -dest);
+    msg->setGVTEstimate(promise);
+    msg->getCounters()[0] = rank;
+    msg->getCounters()[1] = sentCount[dest];
+    commManager->sendMessage(msg, dest);
+    GVTMessage::destroy(msg);
+    lastPromise[dest] = promise;
+    wanted[dest]      = false;
+    nullsSent++;
+}
+
+void
+NullMessageManager::reportStatistics(std::ostream& os) const {
+    os << "Null messages sent: "     << nullsSent
+       << ", received: "             << nullsRecvd
+       << ", requests sent: "        << requestsSent << std::endl;
+}
+
+#endif
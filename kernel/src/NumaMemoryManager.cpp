@@ -34,8 +34,7 @@
 #include <thread>
 #include <sstream>
 #include "EventAdapter.h"
-#include "mpi-mt/RedistributionMessage.h"
-#include "mpi-mt/MultiThreadedSimulationManager.h"
+#include "HugePageAllocator.h"
 
 // Switch to muse namespace to streamline code
 using namespace muse;
@@ -52,6 +51,8 @@ NumaMemoryManager::getStats() const {
        << "\n  NUMA Recycler hits      : " << recycleHits
        << "\n  NUMA Recycler %hits     : "
        << ((float) recycleHits / allocCalls)
+       << "\n  NUMA huge-page coverage : "
+       << HugePageAllocator::getCoverage(hugeBytes, blockBytes)
        << std::endl;
     // Print block information for each NUMA node.
     os << "  NUMA Blocks: ";
@@ -69,7 +70,6 @@ NumaMemoryManager::getStats() const {
         }
         os << "\n";
     }
-    os << "  Redistributions: " << numRedist << std::endl;
     // Return the string containing statistics
     return os.str();
 }
@@ -85,7 +85,11 @@ NumaMemoryManager::~NumaMemoryManager() {
         while (!blockStack.empty()) {
             // Free the numa memory for the top-block.
             NumaBlock& top = blockStack.top();
-            numa_free(top.start, blockSize);
+            if (HugePageAllocator::isEnabled()) {
+                HugePageAllocator::release(top.start, blockSize);
+            } else {
+                numa_free(top.start, blockSize);
+            }
             // Remove block from stack
             blockStack.pop();
         }
@@ -101,8 +105,9 @@ NumaMemoryManager::start(const std::vector<int>& numaIDofThread,
                          const int blkSize) {
     ASSERT(!numaIDofThread.empty());
     ASSERT(blkSize > 1024);
-    // Save block size for future use
-    blockSize = blkSize;
+    // Save block size for future use.  With huge pages, the size is
+    // rounded up to whole huge pages.
+    blockSize = HugePageAllocator::roundUp(blkSize);
     // NUMA node numbers start with zero. So find the largest NUMA
     // node up to which memory is to be allocated.
     const int maxNumaID = *std::max_element(numaIDofThread.begin(),
@@ -123,7 +128,13 @@ NumaMemoryManager::start(const std::vector<int>& numaIDofThread,
 void
 NumaMemoryManager::allocateBlock(const int numaID) {
     ASSERT((numaID >= 0) && (numaID < (int) blockList.size()));
-    char* mem = reinterpret_cast<char*>(numa_alloc_onnode(blockSize, numaID));
+    bool huge = false;
+    char* mem = (HugePageAllocator::isEnabled() ?
+                 HugePageAllocator::allocate(blockSize, numaID, huge) :
+                 reinterpret_cast<char*>(numa_alloc_onnode(blockSize, numaID)));
+    // Track huge page coverage for statistics
+    blockBytes += blockSize;
+    hugeBytes  += (huge ? blockSize : 0);
     DEBUG(std::cout << "Allocated NUMA block (this= " << this
                     << "): " << static_cast<void*>(mem) << " to "
                     << static_cast<void*>(mem + blockSize) << std::endl);
@@ -212,70 +223,6 @@ NumaMemoryManager::moveNumaBlocksTo(NumaMemoryManager& mainMgr) {
     }
 }
 
-void
-NumaMemoryManager::redistribute(const int threadCount, const int threadID,
-                                const int numaID,
-                                MultiThreadedSimulationManager* const mgr) {
-    ASSERT(threadCount > 0);
-    ASSERT((threadID >= 0) && (threadID < threadCount));
-    ASSERT((numaID >= 0) && (numaID < (int) blockList.size()));
-    ASSERT(mgr != NULL);
-    // Find the amount of memory allocated by this manager on the
-    // specified numa node to determine if recycling is needed.
-    const int memAllocd = getAllocatedMemory(numaID);
-    // Find the amount recycled memory we currently have
-    const int recyclMem = getRecycledMemory(numaID);
-    // If recyclMemory is 2x more than allocated memory, it is time to
-    // redistribute.
-    if (recyclMem <= memAllocd * 2) {
-        // We have not hit the threshold. No further operation needed.
-        return;
-    }
-    DEBUG(std::cout << "Recycled memory: " << recyclMem
-                    << " bytes more than 2x the memory allocated: "
-                    << memAllocd << std::endl);
-    // Compute the proportion of entries to redistribute to each thread.
-    const double redistFrac = (recyclMem - memAllocd) / (threadCount - 1.) /
-        recyclMem;
-    // Redistribute computed fraction of each size. First, get the
-    // recycler map for the given numa node.
-    RecycleMemMap& nodeRecycler = recycler[numaID];
-    // Iterate over each entry (each entry has a different size)
-    for (RecycleMemMap::value_type& entry : nodeRecycler) {
-        // Compute actual number of memory chunks to send to each thread.
-        const int entryCount = std::ceil(redistFrac * entry.second.size());
-        // Now ditribute that many entries to each thread.
-        for (int thrID = 0; (thrID < threadCount); thrID++) {
-            if (thrID == threadID) {
-                continue;  // Nothing to do for local thread.
-            }
-            RedistributionMessage* const rde =
-                RedistributionMessage::create(numaID, entryCount, entry.first,
-                                              entry.second);
-            ASSERT(rde != NULL);
-            // Send event to destination thread.
-            mgr->addIncomingEvent(thrID, rde);
-        }
-    }
-    // Track the number of redistributions
-    numRedist++;
-}
-
-void
-NumaMemoryManager::redistribute(RedistributionMessage* rdm) {
-    ASSERT(rdm != NULL);
-    ASSERT(rdm->getNumaID() >= 0);
-    ASSERT(rdm->getNumaID() < (int) recycler.size());
-    ASSERT(rdm->getEntryCount() > 0);
-    ASSERT(rdm->getEntrySize()  > 0);
-    // Get the recycler entry corresponding to the NUMA node.
-    RecycleMemMap& nodeRecycler = recycler[rdm->getNumaID()];
-    // Get the recycler stack for the given size
-    std::stack<char*>& stack = nodeRecycler[rdm->getEntrySize()];
-    // Now let the redistribution message add entries to this object
-    rdm->addEntriesTo(stack);
-}
-
 int
 NumaMemoryManager::getAllocatedMemory(const int numaID) const {
     ASSERT((numaID >= 0) && (numaID < (int) blockList.size()));
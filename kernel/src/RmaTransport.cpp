@@ -0,0 +1,287 @@
+#ifndef MUSE_RMA_TRANSPORT_CPP
+#define MUSE_RMA_TRANSPORT_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include "RmaTransport.h"
+#include "ArgParser.h"
+#include "GVTMessage.h"
+#include "Event.h"
+
+using namespace muse;
+
+// Convenience macro to round sizes up to 8-byte alignment for records
+#define RMA_ALIGN(size) (((size) + 7) & ~7)
+
+RmaTransport::RmaTransport() : ringSize(1 << 20), batchSize(1024),
+                               batchEvents(1), unflushedEvents(0),
+                               windowBase(NULL), pendingBatches(0),
+                               nextSrc(0), numPuts(0), numRecords(0),
+                               numRingFull(0) {
+#ifndef HAVE_LIBMPI
+    throw std::runtime_error("--transport rma requires MPI");
+#endif
+}
+
+RmaTransport::~RmaTransport() {}
+
+void
+RmaTransport::parseCommandLineArgs(int& argc, char* argv[]) {
+    int ringKiB = ringSize / 1024;
+    ArgParser::ArgRecord arg_list[] = {
+        { "--rma-ring-size", "Size (in KiB) of RMA ring from each process",
+          &ringKiB, ArgParser::INTEGER},
+        { "--rma-batch-size", "Size (in bytes) of batches of RMA events",
+          &batchSize, ArgParser::INTEGER},
+        { "--rma-batch-events", "Max events batched before all batches "
+          "are shipped (1: no batching)", &batchEvents, ArgParser::INTEGER},
+        {"", "", NULL, ArgParser::INVALID}
+    };
+    ArgParser ap(arg_list);
+    ap.parseArguments(argc, argv, false);
+    ringSize = ringKiB * 1024LL;
+    if ((batchSize < 1) || (ringSize < 2 * RMA_ALIGN(batchSize))) {
+        std::cerr << "Invalid --rma-batch-size or --rma-ring-size. Ring "
+                  << "size must be at least twice the batch size.\n";
+        abort();
+    }
+    if (batchEvents < 1) {
+        std::cerr << "Invalid --rma-batch-events. Value must be >= 1\n";
+        abort();
+    }
+}
+
+void
+RmaTransport::agentsRegistered() {
+    // Setup local data structures for sending to each process.
+    batches.resize(numProcs);
+    remoteTail.assign(numProcs, 0);
+    remoteHead.assign(numProcs, 0);
+#ifdef HAVE_LIBMPI
+    // Create the window with one ring for each process
+    const MPI_Aint winSize = ringDisp(numProcs);
+    MPI_Win_allocate(winSize, 1, MPI_INFO_NULL, MPI_COMM_WORLD,
+                     &windowBase, &window);
+    std::memset(windowBase, 0, winSize);
+    // Ensure all processes have initialized their window before use.
+    MPI_BARRIER();
+    // Open passive target access epoch to all processes.
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+#endif
+}
+
+void
+RmaTransport::addRecord(const char* data, const int size, const int tag,
+                           const int destRank) {
+    ASSERT((destRank >= 0) && (destRank < numProcs));
+    ASSERT(destRank != myRank);
+    std::vector<char>& batch = batches[destRank];
+    if (batch.empty()) {
+        pendingBatches++;
+    }
+    // Append record header followed by the data, suitably padded.
+    const RecordHeader hdr = {size, tag};
+    const size_t pos = batch.size();
+    batch.resize(pos + sizeof(RecordHeader) + RMA_ALIGN(size));
+    std::memcpy(&batch[pos], &hdr, sizeof(RecordHeader));
+    std::memcpy(&batch[pos + sizeof(RecordHeader)], data, size);
+    numRecords++;
+}
+
+void
+RmaTransport::sendEvent(Event* e, const int eventSize, const int destRank) {
+    addRecord(reinterpret_cast<const char*>(e), eventSize, EVENT, destRank);
+    if ((int) batches[destRank].size() >= batchSize) {
+        flushBatch(destRank);
+    }
+    // Bound the delay of events waiting in batches.
+    if (++unflushedEvents >= batchEvents) {
+        flush();
+    }
+}
+
+void
+RmaTransport::sendGVTMessage(const GVTMessage *msg, const int destRank) {
+    // GVT messages are shipped right away to avoid delaying GVT.
+    addRecord(reinterpret_cast<const char*>(msg), msg->getSize(),
+              GVT_MESSAGE, destRank);
+    flushBatch(destRank);
+}
+
+void
+RmaTransport::flush() {
+    for (int dest = 0; (pendingBatches > 0) && (dest < numProcs); dest++) {
+        flushBatch(dest);
+    }
+    unflushedEvents = 0;
+}
+
+void
+RmaTransport::flushBatch(const int destRank) {
+    std::vector<char>& batch = batches[destRank];
+    if (batch.empty()) {
+        return;  // Nothing to be shipped.
+    }
+    size_t shipSize = 0;  // Bytes of complete records to be shipped
+#ifdef HAVE_LIBMPI
+    // Check for sufficient space in the remote ring.  Refresh the
+    // remote head only if the batch does not fit.
+    const MPI_Aint headDisp = ringDisp(myRank) + offsetof(RingHeader, head);
+    const MPI_Aint tailDisp = ringDisp(myRank) + offsetof(RingHeader, tail);
+    int64_t freeSpace = ringSize - (remoteTail[destRank] - remoteHead[destRank]);
+    if (freeSpace < (int64_t) batch.size()) {
+        const int64_t dummy = 0;
+        MPI_Fetch_and_op(&dummy, &remoteHead[destRank], MPI_INT64_T,
+                         destRank, headDisp, MPI_NO_OP, window);
+        MPI_Win_flush(destRank, window);
+        freeSpace = ringSize - (remoteTail[destRank] - remoteHead[destRank]);
+    }
+    // Determine the complete records that fit in the free space.
+    while (shipSize < batch.size()) {
+        const RecordHeader* rec =
+            reinterpret_cast<const RecordHeader*>(&batch[shipSize]);
+        const size_t recSize = sizeof(RecordHeader) + RMA_ALIGN(rec->size);
+        if ((int64_t) (shipSize + recSize) > freeSpace) {
+            break;  // This record does not fit.
+        }
+        shipSize += recSize;
+    }
+    if (shipSize < batch.size()) {
+        numRingFull++;  // Remote ring is full. Try again later.
+        if (shipSize == 0) {
+            return;
+        }
+    }
+    // Put the data into the remote ring, handling wrap-around.
+    const MPI_Aint ringStart = ringDisp(myRank) + sizeof(RingHeader);
+    const int64_t offset = remoteTail[destRank] % ringSize;
+    const int64_t part1  = std::min<int64_t>(shipSize, ringSize - offset);
+    MPI_Put(&batch[0], part1, MPI_CHAR, destRank, ringStart + offset,
+            part1, MPI_CHAR, window);
+    if (part1 < (int64_t) shipSize) {
+        MPI_Put(&batch[part1], shipSize - part1, MPI_CHAR, destRank,
+                ringStart, shipSize - part1, MPI_CHAR, window);
+    }
+    // Ensure data is in place before the tail is advanced.
+    MPI_Win_flush(destRank, window);
+    int64_t delta = shipSize, oldTail = 0;
+    MPI_Fetch_and_op(&delta, &oldTail, MPI_INT64_T, destRank, tailDisp,
+                     MPI_SUM, window);
+    MPI_Win_flush(destRank, window);
+    ASSERT(oldTail == remoteTail[destRank]);
+    remoteTail[destRank] += shipSize;
+    numPuts++;
+#endif
+    // Remove the records that have been shipped
+    batch.erase(batch.begin(), batch.begin() + shipSize);
+    if (batch.empty()) {
+        pendingBatches--;
+    }
+}
+
+void
+RmaTransport::copyFromRing(char* dest, const char* ring,
+                              const int64_t offset, const int size) const {
+    const int64_t start = offset % ringSize;
+    const int part1     = std::min<int64_t>(size, ringSize - start);
+    std::memcpy(dest, ring + start, part1);
+    if (part1 < size) {
+        std::memcpy(dest + part1, ring, size - part1);
+    }
+}
+
+bool
+RmaTransport::readRecord(const int srcRank, char*& data, int& size, int& tag) {
+    RingHeader* const ring = localRing(srcRank);
+    const volatile int64_t* const tail = &ring->tail;
+    if (*tail == ring->head) {
+        return false;  // No pending records from this process.
+    }
+    // Read the record header followed by the event.
+    const char* const ringData = reinterpret_cast<char*>(ring + 1);
+    RecordHeader hdr;
+    copyFromRing(reinterpret_cast<char*>(&hdr), ringData, ring->head,
+                 sizeof(RecordHeader));
+    data = Event::allocate(hdr.size, -1);
+    copyFromRing(data, ringData, ring->head + sizeof(RecordHeader), hdr.size);
+    size = hdr.size;
+    tag  = hdr.tag;
+    // Release space in the ring. Sender reads it atomically
+    ring->head += sizeof(RecordHeader) + RMA_ALIGN(hdr.size);
+    MPI_CODE(MPI_Win_sync(window));
+    return true;
+}
+
+bool
+RmaTransport::receive(char*& data, int& size, int& tag, int& srcRank) {
+    if (windowBase == NULL) {
+        return false;  // Agents have not been registered yet
+    }
+    // Ship out any pending batches.
+    flush();
+    // Synchronize public and private copies of the window.
+    MPI_CODE(MPI_Win_sync(window));
+    // Check each of the rings in a round-robin manner.
+    for (int i = 0; (i < numProcs); i++) {
+        const int src = nextSrc;
+        nextSrc = (nextSrc + 1) % numProcs;
+        if (src == myRank) {
+            continue;  // No ring for ourselves.
+        }
+        if (readRecord(src, data, size, tag)) {
+            srcRank = src;
+            return true;
+        }
+    }
+    // No pending records. Yield the CPU, similar to MPI's two-sided
+    // receive path when processes share cores.  Otherwise a process
+    // that is ahead keeps its core and speculates far ahead of its
+    // peers, causing rollback storms.
+    std::this_thread::yield();
+    return false;
+}
+
+void
+RmaTransport::reportStats(std::ostream& os) {
+    os << "RMA batches shipped    : " << numPuts
+       << "\nRMA records shipped    : " << numRecords
+       << "\nRMA ring full          : " << numRingFull << std::endl;
+}
+
+void
+RmaTransport::finalize(bool stopMPI) {
+#ifdef HAVE_LIBMPI
+    if (windowBase != NULL) {
+        MPI_Win_unlock_all(window);
+        MPI_Win_free(&window);
+        windowBase = NULL;
+    }
+#endif
+    // Let the base class finalize MPI.
+    MpiTransport::finalize(stopMPI);
+}
+
+#endif
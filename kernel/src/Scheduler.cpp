@@ -28,19 +28,23 @@
 #include "Simulation.h"
 #include "ArgParser.h"
 #include "ConservativeSimulation.h"
+#include "GVTManagerBase.h"
 
 using namespace muse;
 
 // temp queue used to reduce allocate and deallocate overheads
 thread_local muse::EventContainer Scheduler::agentEvents;
 
-Scheduler::Scheduler() : agentPQ(NULL), timeWindow(0), adaptTimeWindow(false) {}
+Scheduler::Scheduler() : agentDir(&defaultAgentDir), agentPQ(NULL),
+                         timeWindow(0), adaptTimeWindow(false),
+                         heldBound(TIME_INFINITY) {}
 
 bool
 Scheduler::addAgentToScheduler(Agent* agent) {
     ASSERT(agent != NULL);
-    if (agentMap[agent->getAgentID()] == NULL) {
-        agentMap[agent->getAgentID()] = agent;
+    AgentDirectory::Entry& entry = agentDir->add(agent->getAgentID());
+    if (entry.agent == NULL) {
+        entry.agent = agent;
         agent->fibHeapPtr = agentPQ->addAgent(agent);
         return true;
     }
@@ -50,15 +54,26 @@ Scheduler::addAgentToScheduler(Agent* agent) {
 bool
 Scheduler::removeAgentFromScheduler(Agent* agent) {
     ASSERT(agent != NULL);
-    if (agentMap[agent->getAgentID()] != NULL) {
+    AgentDirectory::Entry* const entry = agentDir->find(agent->getAgentID());
+    if ((entry != NULL) && (entry->agent != NULL)) {
+        // Held events are cleaned-up along with other pending events
+        releaseHeldEvents(agent);
         agentPQ->removeAgent(agent);  // remove agent from scheduler.
-        // Clear out agent entry in our internal look-up map.
-        agentMap[agent->getAgentID()] = NULL;
+        // Clear out agent entry in our internal look-up directory.
+        entry->agent = NULL;
         return true;
     }
     return false;
 }
 
+void
+Scheduler::attachAgent(Agent* agent, EventContainer& events) {
+    ASSERT(agent != NULL);
+    ASSERT(agentDir->find(agent->getAgentID()) != NULL);
+    agent->fibHeapPtr = agentPQ->addAgent(agent);
+    agentPQ->enqueue(agent, events);
+}
+
 void
 Scheduler::updateKey(void* pointer, Time uTime) {
     UNUSED_PARAM(pointer);
@@ -89,18 +104,39 @@ Scheduler::withinTimeWindow(muse::Agent* agent,
 
 AgentID
 Scheduler::processNextAgentEvents() {
-    // If the event queue is empty, do no further operations.
-    if (agentPQ->empty()) {
-        return InvalidAgentID;
+    // Return held events of conservative agents that may have become
+    // safe to process.
+    if (!heldEvents.empty()) {
+        releaseHeldEvents();
     }
-    // Get the first of next batch of events to be scheduled.
-    const muse::Event* const front = agentPQ->front();
-    ASSERT(front != NULL);
-    DEBUG(std::cout << "Scheduler is processing event: " << *front
-                    << std::endl);
-    // Figure out the agent to receive this event.
-    Agent* const agent = agentMap[front->getReceiverAgentID()];
-    ASSERT(agent != NULL);
+    const muse::Event* front = NULL;
+    Agent* agent             = NULL;
+    do {
+        // If the event queue is empty, do no further operations.
+        if (agentPQ->empty()) {
+            return InvalidAgentID;
+        }
+        // Get the first of next batch of events to be scheduled.
+        front = agentPQ->front();
+        ASSERT(front != NULL);
+        DEBUG(std::cout << "Scheduler is processing event: " << *front
+                        << std::endl);
+        // Figure out the agent to receive this event.
+        ASSERT(agentDir->find(front->getReceiverAgentID()) != NULL);
+        agent = agentDir->find(front->getReceiverAgentID())->agent;
+        ASSERT(agent != NULL);
+        // Events of a conservative agent are processed only if they
+        // are safe.  Otherwise they are held back so that other
+        // (optimistic) agents can continue to process events.  This
+        // is needed only if other agents can rollback.
+        if (agent->isConservative() && agent->kernel->mustSaveState &&
+            (front->getReceiveTime() >= getSafeTimeBound() +
+             agent->lookahead)) {
+            agentPQ->dequeueNextAgentEvents(agentEvents);
+            holdEvents(agent, agentEvents);
+            agent = NULL;
+        }
+    } while (agent == NULL);
     // Check if the next lowest time-stamp event falls within time
     // window with respect to GVT.  If not, do not process events.
     if ((timeWindow > muse::Time(0)) && !withinTimeWindow(agent, front)) {
@@ -119,21 +155,32 @@ bool
 Scheduler::scheduleEvent(Event* e) {
     // Make sure the recevier agent has an entry
     const AgentID agent_id = e->getReceiverAgentID();
-    AgentIDAgentPointerMap::iterator entry = agentMap.find(agent_id);
-    Agent* const agent = (entry != agentMap.end()) ? entry->second : NULL;
-    
+    const AgentDirectory::Entry* const entry = agentDir->find(agent_id);
+    Agent* const agent = (entry != NULL) ? entry->agent : NULL;
+
     if (agent == NULL) {
         std::cerr << "Trying to schedule (" << *e <<") to unknown agent\n";
         std::cerr << "Available agents are: \n";
-        AgentIDAgentPointerMap::iterator it = agentMap.begin();
-        for (; it!=agentMap.end(); it++) {
-            std::cerr << *(it->second) << std::endl;
-        }
+        agentDir->forEach([](const AgentDirectory::Entry& entry) {
+                if (entry.agent != NULL) {
+                    std::cerr << *entry.agent << std::endl;
+                }
+            });
         std::cerr << "Trying to schedule to local agent "
                   << "that doesn't exist" << std::endl;
         abort();
     }
 
+    // Events to conservative agents (except those sent when agents
+    // are initialized) must honor the lookahead of the agent.
+    if (agent->isConservative() &&
+        (e->getSentTime() > agent->kernel->getStartTime()) &&
+        (e->getReceiveTime() - e->getSentTime() < agent->lookahead)) {
+        std::cerr << "Event " << *e << " violates the lookahead ("
+                  << agent->lookahead << ") of conservative agent "
+                  << agent_id << ". Aborting.\n";
+        abort();
+    }
     // Process rollbacks (only if necessary)
     checkAndHandleRollback(e, agent);
     // If the event is an anti-message then all pending future events
@@ -177,6 +224,13 @@ Scheduler::checkAndHandleRollback(const Event* e, Agent* agent) {
     // the optimistic strategy. Rollback if needed
     if (e->getReceiveTime() <= agent->getLVT()) {
         ASSERT(e->getSenderAgentID() != e->getReceiverAgentID());
+        if (agent->isConservative()) {
+            // Conservative agents do not save state to rollback.
+            std::cerr << "Event " << *e << " is below LVT ("
+                      << agent->getLVT() << ") of conservative agent "
+                      << agent->getAgentID() << ". Aborting.\n";
+            abort();
+        }
         DEBUG(std::cout << "Rollingback due to: " << *e
                         << " at LVT: " << agent->getLVT() << std::endl);
         // If adaptive time window is to be used, then update the time
@@ -217,7 +271,11 @@ void
 Scheduler::handleFutureAntiMessage(const Event* e, Agent* agent){
     DEBUG(std::cout << "*Cancelling due to: " << *e << std::endl);
     // This event is an anti-message we must remove it and
-    // future events from this agent.
+    // future events from this agent.  Held events (if any) are
+    // returned to the queue so that they are also removed.
+    if (agent->isConservative()) {
+        releaseHeldEvents(agent);
+    }
     agentPQ->eraseAfter(agent, e->getSenderAgentID(), e->getSentTime());
     // agent->eventPQ->removeFutureEvents(e);
     // There are cases when we may not have a future anti-message as
@@ -234,14 +292,68 @@ Scheduler::~Scheduler() {
     }
 }
 
+void
+Scheduler::holdEvents(Agent* agent, EventContainer& events) {
+    ASSERT(agent->isConservative());
+    ASSERT(!events.empty());
+    // Find the existing entry for the agent or add a new one.
+    size_t idx = 0;
+    while ((idx < heldEvents.size()) && (heldEvents[idx].agent != agent)) {
+        idx++;
+    }
+    if (idx == heldEvents.size()) {
+        heldEvents.push_back(HeldEvents{agent, TIME_INFINITY, {}});
+    }
+    HeldEvents& held = heldEvents[idx];
+    held.minTime = std::min(held.minTime, events.front()->getReceiveTime());
+    held.events.insert(held.events.end(), events.begin(), events.end());
+    events.clear();
+}
+
+Time
+Scheduler::getSafeTimeBound() const {
+    return Simulation::getSimulator()->gvtManager->getSendTimeBound();
+}
+
+void
+Scheduler::releaseHeldEvents(Agent* agent) {
+    if (heldEvents.empty()) {
+        return;  // No events are held. Nothing further to do.
+    }
+    const Time bound = getSafeTimeBound();
+    if ((agent == NULL) && (bound == heldBound)) {
+        return;  // Bound has not changed. So no events have become safe.
+    }
+    if (agent == NULL) {
+        heldBound = bound;
+    }
+    for (size_t idx = 0; (idx < heldEvents.size());) {
+        HeldEvents& held = heldEvents[idx];
+        if ((held.agent == agent) || ((agent == NULL) &&
+            (held.minTime < bound + held.agent->lookahead))) {
+            // Return events to the queue and remove entry.
+            agentPQ->enqueue(held.agent, held.events);
+            heldEvents[idx] = std::move(heldEvents.back());
+            heldEvents.pop_back();
+        } else {
+            idx++;
+        }
+    }
+}
+
 Time
 Scheduler::getNextEventTime() {
-    // If the queue is empty, return infinity
+    // The earliest held event (if any) is also pending.
+    Time heldTime = TIME_INFINITY;
+    for (const HeldEvents& held : heldEvents) {
+        heldTime = std::min(heldTime, held.minTime);
+    }
+    // If the queue is empty, return the time of held events
     if (agentPQ->empty()) {
-        return TIME_INFINITY;
+        return heldTime;
     }
     // Otherwise, return the time of the top agent
-    return agentPQ->front()->getReceiveTime();
+    return std::min(heldTime, agentPQ->front()->getReceiveTime());
 }
 
 void
@@ -0,0 +1,562 @@
+#ifndef MUSE_SHM_TRANSPORT_CPP
+#define MUSE_SHM_TRANSPORT_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ShmTransport.h"
+#include "ArgParser.h"
+#include "GVTMessage.h"
+#include "Event.h"
+
+using namespace muse;
+
+// Convenience macro to round sizes up to 8-byte alignment for records
+#define SHM_ALIGN(size) (((size) + 7) & ~7)
+
+// Convenience macro to round sizes up to cache line boundaries
+#define SHM_CACHE_ALIGN(size) (((size) + 63) & ~63)
+
+ShmTransport::ShmTransport() : myRank(0), numProcs(1), ringSize(1 << 20),
+                               ringStride(0), segmentSize(0),
+                               segment(NULL), control(NULL),
+                               reduceValues(NULL), reduceSize(0),
+                               ringBase(NULL),
+                               pendingBacklogs(0), nextSrc(0),
+                               numRecords(0), numRingFull(0) {
+    // Nothing else to be done.
+}
+
+ShmTransport::~ShmTransport() {}
+
+void
+ShmTransport::parseArgs(int& argc, char* argv[]) {
+    int ringKiB = ringSize / 1024;
+    ArgParser::ArgRecord arg_list[] = {
+        { "--shm-procs", "Number of local processes for shm transport",
+          &numProcs, ArgParser::INTEGER},
+        { "--shm-ring-size", "Size (in KiB) of each shm ring",
+          &ringKiB, ArgParser::INTEGER},
+        {"", "", NULL, ArgParser::INVALID}
+    };
+    ArgParser ap(arg_list);
+    ap.parseArguments(argc, argv, false);
+    ringSize = ringKiB * 1024LL;
+    if ((numProcs < 1) || (ringKiB < 64)) {
+        std::cerr << "Invalid --shm-procs (must be >= 1) or --shm-ring-size "
+                  << "(must be >= 64 KiB)\n";
+        abort();
+    }
+}
+
+void
+ShmTransport::parseCommandLineArgs(int& argc, char* argv[]) {
+    // The values were already used in initialize. Here we just
+    // consume the arguments.
+    parseArgs(argc, argv);
+}
+
+int
+ShmTransport::initialize(int argc, char* argv[], bool initialize) {
+    if (!initialize && (segment != NULL)) {
+        return myRank;  // Reuse the existing setup.
+    }
+    // Process arguments using a copy of argv (as argv can't be
+    // changed in this method).
+    std::vector<char*> args(argv, argv + argc);
+    parseArgs(argc, args.data());
+    // Compute the layout of the shared memory segment.
+    reduceSize = (size_t) numProcs * numProcs;
+    const size_t ctrlSize = SHM_CACHE_ALIGN(sizeof(ShmControl) +
+                                            numProcs * reduceSize *
+                                            sizeof(Time));
+    ringStride  = sizeof(RingHeader) + SHM_CACHE_ALIGN(ringSize);
+    segmentSize = ctrlSize + (size_t) numProcs * numProcs * ringStride;
+    // Create the shared memory segment.
+    const std::string name = "/muse-shm-" + std::to_string(getpid());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        throw std::runtime_error("shm_open failed for " + name + ": " +
+                                 std::strerror(errno));
+    }
+    if (ftruncate(fd, segmentSize) == -1) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Unable to size shared memory segment: " +
+                                 std::string(std::strerror(errno)));
+    }
+    void* addr = mmap(NULL, segmentSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Unable to map shared memory segment: " +
+                                 std::string(std::strerror(errno)));
+    }
+    // Setup the control block and all the rings.
+    segment      = static_cast<char*>(addr);
+    control      = new (segment) ShmControl();
+    control->barrierCount      = 0;
+    control->barrierGeneration = 0;
+    reduceValues = reinterpret_cast<Time*>(segment + sizeof(ShmControl));
+    ringBase     = segment + ctrlSize;
+    for (int dest = 0; (dest < numProcs); dest++) {
+        for (int src = 0; (src < numProcs); src++) {
+            RingHeader* const ring = new (getRing(src, dest)) RingHeader();
+            ring->tail = 0;
+            ring->head = 0;
+        }
+    }
+    backlogs.assign(numProcs, std::vector<char>());
+    cachedHead.assign(numProcs, 0);
+    // Fork the remaining processes.  Flush streams to ensure buffered
+    // output is not duplicated in the child processes.
+    std::cout.flush();
+    std::cerr.flush();
+    myRank = 0;
+    for (int rank = 1; (rank < numProcs); rank++) {
+        const pid_t pid = fork();
+        if (pid == -1) {
+            throw std::runtime_error("Unable to fork process: " +
+                                     std::string(std::strerror(errno)));
+        }
+        if (pid == 0) {
+            // This is the child process.
+            myRank = rank;
+            childPids.clear();
+            break;
+        }
+        childPids.push_back(pid);
+    }
+    // All processes have the segment mapped. The name is no longer
+    // needed.
+    if (myRank == 0) {
+        shm_unlink(name.c_str());
+    }
+    return myRank;
+}
+
+void
+ShmTransport::copyToRing(RingHeader* ring, int64_t offset, const char* src,
+                         const int size) const {
+    char* const data = reinterpret_cast<char*>(ring + 1);
+    const int64_t start = offset % ringSize;
+    const int part1     = std::min<int64_t>(size, ringSize - start);
+    std::memcpy(data + start, src, part1);
+    if (part1 < size) {
+        std::memcpy(data, src + part1, size - part1);
+    }
+}
+
+void
+ShmTransport::copyFromRing(char* dest, const RingHeader* ring,
+                           int64_t offset, const int size) const {
+    const char* const data = reinterpret_cast<const char*>(ring + 1);
+    const int64_t start = offset % ringSize;
+    const int part1     = std::min<int64_t>(size, ringSize - start);
+    std::memcpy(dest, data + start, part1);
+    if (part1 < size) {
+        std::memcpy(dest + part1, data, size - part1);
+    }
+}
+
+bool
+ShmTransport::writeRecord(const char* data, const int size, const int tag,
+                          const int destRank) {
+    RingHeader* const ring = getRing(myRank, destRank);
+    const int64_t recSize  = sizeof(RecordHeader) + SHM_ALIGN(size);
+    const int64_t tail     = ring->tail.load(std::memory_order_relaxed);
+    if (ringSize - (tail - cachedHead[destRank]) < recSize) {
+        // Refresh the head from the receiver and check again.
+        cachedHead[destRank] = ring->head.load(std::memory_order_acquire);
+        if (ringSize - (tail - cachedHead[destRank]) < recSize) {
+            return false;  // Ring is full.
+        }
+    }
+    const RecordHeader hdr = {size, tag};
+    copyToRing(ring, tail, reinterpret_cast<const char*>(&hdr),
+               sizeof(RecordHeader));
+    copyToRing(ring, tail + sizeof(RecordHeader), data, size);
+    // Publish the record to the receiver.
+    ring->tail.store(tail + recSize, std::memory_order_release);
+    return true;
+}
+
+void
+ShmTransport::sendRecord(const char* data, const int size, const int tag,
+                         const int destRank) {
+    ASSERT((destRank >= 0) && (destRank < numProcs));
+    ASSERT(destRank != myRank);
+    if (sizeof(RecordHeader) + SHM_ALIGN(size) > (size_t) ringSize) {
+        std::cerr << "Message of " << size << " bytes does not fit in "
+                  << "shm ring. Increase --shm-ring-size.\n";
+        abort();
+    }
+    numRecords++;
+    std::vector<char>& backlog = backlogs[destRank];
+    if (!backlog.empty()) {
+        // Ship backlog first to preserve order of messages.
+        flushBacklog(destRank);
+    }
+    if (backlog.empty() && writeRecord(data, size, tag, destRank)) {
+        return;  // Record was directly written to the ring.
+    }
+    // Ring is full. Append record to the backlog.
+    if (backlog.empty()) {
+        pendingBacklogs++;
+    }
+    numRingFull++;
+    const RecordHeader hdr = {size, tag};
+    const size_t pos = backlog.size();
+    backlog.resize(pos + sizeof(RecordHeader) + SHM_ALIGN(size));
+    std::memcpy(&backlog[pos], &hdr, sizeof(RecordHeader));
+    std::memcpy(&backlog[pos + sizeof(RecordHeader)], data, size);
+}
+
+void
+ShmTransport::flushBacklog(const int destRank) {
+    std::vector<char>& backlog = backlogs[destRank];
+    if (backlog.empty()) {
+        return;  // Nothing to be shipped.
+    }
+    RingHeader* const ring = getRing(myRank, destRank);
+    const int64_t tail     = ring->tail.load(std::memory_order_relaxed);
+    cachedHead[destRank]   = ring->head.load(std::memory_order_acquire);
+    const int64_t freeSpace = ringSize - (tail - cachedHead[destRank]);
+    // Determine the complete records that fit in the free space.
+    size_t shipSize = 0;
+    while (shipSize < backlog.size()) {
+        const RecordHeader* rec =
+            reinterpret_cast<const RecordHeader*>(&backlog[shipSize]);
+        const size_t recSize = sizeof(RecordHeader) + SHM_ALIGN(rec->size);
+        if ((int64_t) (shipSize + recSize) > freeSpace) {
+            break;  // This record does not fit.
+        }
+        shipSize += recSize;
+    }
+    if (shipSize == 0) {
+        return;  // Ring is still full.
+    }
+    copyToRing(ring, tail, &backlog[0], shipSize);
+    ring->tail.store(tail + shipSize, std::memory_order_release);
+    // Remove the records that have been shipped
+    backlog.erase(backlog.begin(), backlog.begin() + shipSize);
+    if (backlog.empty()) {
+        pendingBacklogs--;
+    }
+}
+
+void
+ShmTransport::flushBacklogs() {
+    for (int dest = 0; (pendingBacklogs > 0) && (dest < numProcs); dest++) {
+        flushBacklog(dest);
+    }
+}
+
+void
+ShmTransport::sendEvent(Event* e, const int eventSize, const int destRank) {
+    sendRecord(reinterpret_cast<const char*>(e), eventSize, EVENT, destRank);
+}
+
+void
+ShmTransport::sendGVTMessage(const GVTMessage* msg, const int destRank) {
+    sendRecord(reinterpret_cast<const char*>(msg), msg->getSize(),
+               GVT_MESSAGE, destRank);
+}
+
+void
+ShmTransport::sendString(const std::string& str, const int destRank,
+                         const int tag) {
+    sendRecord(str.c_str(), str.size() + 1, tag, destRank);
+    // Wait until the string has been shipped.
+    while (!backlogs[destRank].empty()) {
+        sched_yield();
+        flushBacklog(destRank);
+    }
+}
+
+bool
+ShmTransport::readRecord(const int srcRank, Message& msg) {
+    RingHeader* const ring = getRing(srcRank, myRank);
+    const int64_t head = ring->head.load(std::memory_order_relaxed);
+    if (ring->tail.load(std::memory_order_acquire) == head) {
+        return false;  // No pending records from this process.
+    }
+    // Read the record header followed by the data.
+    RecordHeader hdr;
+    copyFromRing(reinterpret_cast<char*>(&hdr), ring, head,
+                 sizeof(RecordHeader));
+    msg.srcRank = srcRank;
+    msg.tag     = hdr.tag;
+    msg.size    = hdr.size;
+    msg.data    = (isEventTag(hdr.tag) ? Event::allocate(hdr.size, -1) :
+                   new char[hdr.size]);
+    copyFromRing(msg.data, ring, head + sizeof(RecordHeader), hdr.size);
+    // Release space in the ring for the sender.
+    ring->head.store(head + sizeof(RecordHeader) + SHM_ALIGN(hdr.size),
+                     std::memory_order_release);
+    return true;
+}
+
+bool
+ShmTransport::receive(char*& data, int& size, int& tag, int& srcRank) {
+    Message msg;
+    // First check if stashed records have an event or GVT message.
+    for (std::deque<Message>::iterator it = stash.begin();
+         (it != stash.end()); it++) {
+        if (isEventTag(it->tag)) {
+            msg = *it;
+            stash.erase(it);
+            data = msg.data, size = msg.size;
+            tag  = msg.tag,  srcRank = msg.srcRank;
+            return true;
+        }
+    }
+    // Ship out any pending backlogs.
+    flushBacklogs();
+    // Check each of the rings in a round-robin manner.
+    for (int i = 0; (i < numProcs); i++) {
+        const int src = nextSrc;
+        nextSrc = (nextSrc + 1) % numProcs;
+        if (src == myRank) {
+            continue;  // No ring for ourselves.
+        }
+        while (readRecord(src, msg)) {
+            if (isEventTag(msg.tag)) {
+                data = msg.data, size = msg.size;
+                tag  = msg.tag,  srcRank = msg.srcRank;
+                return true;
+            }
+            // Some other record. Stash it for later.
+            stash.push_back(msg);
+        }
+    }
+    return false;
+}
+
+bool
+ShmTransport::receiveTagged(const int srcRank, const int tag,
+                            const bool blocking, Message& msg) {
+    do {
+        // First check the stashed records in order.
+        for (std::deque<Message>::iterator it = stash.begin();
+             (it != stash.end()); it++) {
+            if ((it->tag == tag) && ((srcRank < 0) ||
+                                     (it->srcRank == srcRank))) {
+                msg = *it;
+                stash.erase(it);
+                return true;
+            }
+        }
+        // Ensure our messages continue to flow to other processes.
+        flushBacklogs();
+        // Read records from the rings, stashing unmatched records.
+        for (int src = 0; (src < numProcs); src++) {
+            if ((src == myRank) || ((srcRank >= 0) && (src != srcRank))) {
+                continue;
+            }
+            while (readRecord(src, msg)) {
+                if (msg.tag == tag) {
+                    return true;
+                }
+                stash.push_back(msg);
+            }
+        }
+        if (blocking) {
+            sched_yield();  // Let other processes make progress.
+        }
+    } while (blocking);
+    return false;
+}
+
+void
+ShmTransport::releaseMessage(Message& msg) {
+    if (msg.tag == GVT_MESSAGE) {
+        GVTMessage::destroy(reinterpret_cast<GVTMessage*>(msg.data));
+    } else if (isEventTag(msg.tag)) {
+        Event::deallocate(reinterpret_cast<Event*>(msg.data));
+    } else {
+        delete[] msg.data;
+    }
+    msg.data = NULL;
+}
+
+std::string
+ShmTransport::receiveString(int& recvRank, const int srcRank, const int tag,
+                            const bool blocking) {
+    recvRank = -1;  // Initialize to invalid value
+    Message msg;
+    if (!receiveTagged(srcRank, tag, blocking, msg)) {
+        return "";  // No pending string.
+    }
+    ASSERT(msg.size > 0);
+    const std::string str(msg.data, msg.size - 1);
+    recvRank = msg.srcRank;
+    releaseMessage(msg);
+    return str;
+}
+
+void
+ShmTransport::allGatherAgentRanges(const std::vector<AgentID>& localRanges,
+                                   AgentRangeMap& ownerMap) {
+    ownerMap.add(localRanges.data(), localRanges.size());
+    // Send the local ranges to all other processes. The ranges are
+    // sent as a count followed by chunks (of whole triples) that fit
+    // in the rings.
+    const int count    = localRanges.size();
+    const int maxChunk = ((ringSize / 4) / (3 * sizeof(AgentID))) * 3;
+    for (int dest = 0; (dest < numProcs); dest++) {
+        if (dest == myRank) {
+            continue;
+        }
+        sendRecord(reinterpret_cast<const char*>(&count), sizeof(int),
+                   AGENT_LIST, dest);
+        for (int start = 0; (start < count); start += maxChunk) {
+            const int chunk = std::min(maxChunk, count - start);
+            sendRecord(reinterpret_cast<const char*>(&localRanges[start]),
+                       chunk * sizeof(AgentID), AGENT_LIST, dest);
+        }
+    }
+    // Receive the ranges from all other processes.
+    for (int src = 0; (src < numProcs); src++) {
+        if (src == myRank) {
+            continue;
+        }
+        Message msg;
+        receiveTagged(src, AGENT_LIST, true, msg);
+        ASSERT(msg.size == sizeof(int));
+        int remaining = *reinterpret_cast<int*>(msg.data);
+        releaseMessage(msg);
+        while (remaining > 0) {
+            receiveTagged(src, AGENT_LIST, true, msg);
+            const int numValues = msg.size / sizeof(AgentID);
+            ownerMap.add(reinterpret_cast<AgentID*>(msg.data), numValues);
+            remaining -= numValues;
+            releaseMessage(msg);
+        }
+    }
+    ownerMap.finalize();
+    if (myRank == ROOT_KERNEL) {
+        std::cout << "Agent Registration: complete ("
+                  << ownerMap.size() << " ranges)!" << std::endl;
+    }
+}
+
+void
+ShmTransport::barrier() {
+    if (numProcs == 1) {
+        return;  // Nothing to synchronize
+    }
+    const int generation =
+        control->barrierGeneration.load(std::memory_order_acquire);
+    if (control->barrierCount.fetch_add(1, std::memory_order_acq_rel) ==
+        numProcs - 1) {
+        // Last process to arrive. Reset and release other processes
+        control->barrierCount.store(0, std::memory_order_relaxed);
+        control->barrierGeneration.fetch_add(1, std::memory_order_release);
+    } else {
+        while (control->barrierGeneration.load(std::memory_order_acquire) ==
+               generation) {
+            // Ensure our messages continue to flow while waiting
+            flushBacklogs();
+            sched_yield();
+        }
+    }
+}
+
+Time
+ShmTransport::allReduceMin(const Time value) {
+    reduceValues[myRank] = value;
+    barrier();  // Wait for all processes to publish their values
+    const Time globalMin = *std::min_element(reduceValues,
+                                             reduceValues + numProcs);
+    barrier();  // Ensure values are not overwritten until all are done
+    return globalMin;
+}
+
+long
+ShmTransport::allReduceSum(const long value) {
+    reduceValues[myRank] = value;
+    barrier();  // Wait for all processes to publish their values
+    const Time globalSum = std::accumulate(reduceValues,
+                                           reduceValues + numProcs, 0.0);
+    barrier();  // Ensure values are not overwritten until all are done
+    return static_cast<long>(globalSum);
+}
+
+void
+ShmTransport::allReduceSum(std::vector<Time>& values) {
+    for (size_t start = 0; (start < values.size()); start += reduceSize) {
+        const size_t count = std::min(reduceSize, values.size() - start);
+        std::copy_n(values.begin() + start, count,
+                    reduceValues + myRank * reduceSize);
+        barrier();  // Wait for all processes to publish their values
+        for (size_t i = 0; (i < count); i++) {
+            Time sum = 0;
+            for (int rank = 0; (rank < numProcs); rank++) {
+                sum += reduceValues[rank * reduceSize + i];
+            }
+            values[start + i] = sum;
+        }
+        barrier();  // Ensure values are not overwritten until all are done
+    }
+}
+
+void
+ShmTransport::reportStats(std::ostream& os) {
+    os << "Shm records sent       : " << numRecords
+       << "\nShm ring full          : " << numRingFull << std::endl;
+}
+
+void
+ShmTransport::finalize(bool stop) {
+    // Release any records that were not delivered.
+    for (Message& msg : stash) {
+        releaseMessage(msg);
+    }
+    stash.clear();
+    if (!stop) {
+        return;  // Shared memory is retained for another simulation.
+    }
+    munmap(segment, segmentSize);
+    segment = NULL;
+    // Rank 0 waits for the processes it forked to finish.
+    for (const pid_t pid : childPids) {
+        int status = 0;
+        if ((waitpid(pid, &status, 0) == -1) || !WIFEXITED(status) ||
+            (WEXITSTATUS(status) != 0)) {
+            std::cerr << "Process " << pid << " did not finish normally.\n";
+        }
+    }
+    childPids.clear();
+}
+
+#endif
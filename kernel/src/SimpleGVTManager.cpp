@@ -18,6 +18,7 @@
 // Authors: Jingbin Yu       yuj53@miamioh.edu
 //
 //---------------------------------------------------------------------------
+#include <algorithm>
 #include "SimpleGVTManager.h"
 #include "DataTypes.h"
 #include "Communicator.h"
@@ -43,12 +44,17 @@ void muse::SimpleGVTManager::initialize(const Time &startTime, Communicator *com
 
     ASSERT(numProcesses > 0);
     ASSERT(rank < numProcesses);
+    sentTo.assign(numProcesses, 0);
 }
 
 bool muse::SimpleGVTManager::sendRemoteEvent(Event *event) {
     // We don't do anything else but just send the event.
     // This method exists in the base class for GVTManager
     commManager->sendEvent(event, EventAdapter::getEventSize(event));
+    eventsSent++;
+    // Track information needed to compute windows (see updateWindow)
+    sentTo[commManager->getOwnerRank(event->getReceiverAgentID())]++;
+    minSentTime = std::min(minSentTime, event->getReceiveTime());
     return true;
 }
 
@@ -76,9 +82,17 @@ void muse::SimpleGVTManager::forceUpdateGVT() {
 void muse::SimpleGVTManager::allReduceLGVTAndUpdateGVT() {
     ASSERT(sim != nullptr);
 
-    Time LGVT2Send = sim->getLGVT(), GVTUpdated;
+    Time LGVT2Send = sim->getLGVT();
     
-    MPI_ALL_REDUCE(&LGVT2Send, &GVTUpdated, 1, MPI_DOUBLE, MPI_MIN);
+    const Time GVTUpdated = commManager->allReduceMin(LGVT2Send);
+
+    // All processes have run out of events.  The simulation has
+    // terminated only if no events are in transit.  Otherwise, the
+    // receivers will have events to process shortly.
+    if ((GVTUpdated == TIME_INFINITY) &&
+        (commManager->allReduceSum(eventsSent - eventsRecvd) != 0)) {
+        return;
+    }
 
     ASSERT(GVTUpdated >= gvt && "New GVT should not be smaller than the previous GVT");
 
@@ -91,6 +105,45 @@ void muse::SimpleGVTManager::allReduceLGVTAndUpdateGVT() {
     gvt = GVTUpdated;
 }
 
+void muse::SimpleGVTManager::updateWindow() {
+    ASSERT(commManager != nullptr);
+    // If there is only 1 process, we just use its LGVT as GVT
+    if (numProcesses < 2) {
+        gvt = sim->getLGVT();
+        return;
+    }
+    // The first numProcesses entries are the number of events sent
+    // to each process. The rest are the lower bound on timestamps of
+    // unprocessed events from each process.  A sum-reduction gives
+    // each process the total number of events it must receive along
+    // with the lower bounds from all the processes.
+    std::vector<Time> values(numProcesses * 2, 0);
+    values[numProcesses + rank] = TIME_INFINITY;
+    addWindowInfo(values);
+    commManager->allReduceSum(values);
+    setWindow(values);
+}
+
+void muse::SimpleGVTManager::addWindowInfo(std::vector<Time>& values) {
+    ASSERT(values.size() == numProcesses * 2);
+    for (unsigned int pid = 0; (pid < numProcesses); pid++) {
+        values[pid] += sentTo[pid];
+    }
+    Time& lowerBound = values[numProcesses + rank];
+    lowerBound  = std::min(lowerBound, std::min(sim->getLGVT(), minSentTime));
+    minSentTime = TIME_INFINITY;
+}
+
+void muse::SimpleGVTManager::setWindow(const std::vector<Time>& values) {
+    ASSERT(values.size() == numProcesses * 2);
+    expectedRecvd = static_cast<long>(values[rank]);
+    const Time GVTUpdated = *std::min_element(values.begin() + numProcesses,
+                                              values.end());
+    ASSERT(GVTUpdated >= gvt && "New GVT should not be smaller than the previous GVT");
+    gvt = GVTUpdated;
+}
+
 void muse::SimpleGVTManager::inspectRemoteEvent(Event *event) {
     UNUSED_PARAM(event);
+    eventsRecvd++;
 }
\ No newline at end of file
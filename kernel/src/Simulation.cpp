@@ -29,6 +29,9 @@
 #include <unistd.h>
 
 #include "Communicator.h"
+#include "MpiTransport.h"
+#include "RmaTransport.h"
+#include "ShmTransport.h"
 #include "Simulation.h"
 #include "GVTManager.h"
 #include "HRMScheduler.h"
@@ -37,12 +40,20 @@
 #include "ArgParser.h"
 #include "EventAdapter.h"
 #include "StateRecycler.h"
+#include "HugePageAllocator.h"
+#include "SlabAllocator.h"
 #include "SharedOutBuffer.h"
+#include "AgentMigrator.h"
+#include "IdleParker.h"
+#include "AgentGraph.h"
+#include "MigrationMessage.h"
 
 // The different types of simulators currently supported
 #include "DefaultSimulation.h"
+#include "HCCpuSimulation.h"
 #include "ConservativeSimulation.h"
 #include "mpi-mt/MultiThreadedSimulationManager.h"
+#include "mpi-mt-shm/MultiThreadedShmSimulationManager.h"
 
 #ifdef HAVE_OPEN_CL
 #include "ocl/OclSimulation.h"
@@ -64,6 +75,8 @@ using namespace muse;
 muse::Simulation* muse::Simulation::kernel = NULL;
 // Static value for type of sim this is
 std::string muse::Simulation::simName = "";
+// Static value for type of transport used by the simulation
+std::string muse::Simulation::transportName = "mpi";
 
 #ifdef POLLER
 std::string pollPolicyType = "";
@@ -77,6 +90,9 @@ Simulation::Simulation(const bool useSharedEvents)
     scheduler          = NULL;
     myID               = -1u;
     listener           = NULL;
+    migrator           = NULL;
+    agentGraph         = NULL;
+    idleParker         = NULL;
     doDumpStats        = false;
     mustSaveState      = false;
     maxMpiMsgThresh    = 1000;
@@ -90,25 +106,65 @@ Simulation*
 Simulation::initializeSimulation(int& argc, char* argv[], bool initMPI) {
     // First use a temporary argument parser to determine type of
     // simulation kernel to instantiate.
-    simName = "default";
+    simName       = "default";
+    transportName = "mpi";
+    std::string hugePages = "none";
+    int eventArenaSize    = SlabAllocator::getDefaultSlabSize();
+    int stateArenaSize    = 32768;
     ArgParser::ArgRecord arg_list[] = {
         { "--simulator", "The type of simulator/kernel to use; one of: " \
-          "default, mpi-mt, cmb, ocl", 
+          "default, mpi-mt, mpi-mt-shm, cmb, cmb-mt, hc-cpu, ocl", 
           &simName, ArgParser::STRING},
+        { "--transport", "The transport to exchange events between " \
+          "processes; one of: mpi, rma, shm", &transportName,
+          ArgParser::STRING},
+        { "--huge-pages", "Back memory arenas with 2 MiB huge pages; one " \
+          "of: none, thp, explicit", &hugePages, ArgParser::STRING},
+        { "--event-arena-size", "Size (bytes) of memory arenas for events",
+          &eventArenaSize, ArgParser::INTEGER},
+        { "--state-arena-size", "Size (bytes) of NUMA memory arenas for " \
+          "states", &stateArenaSize, ArgParser::INTEGER},
         {"", "", NULL, ArgParser::INVALID}
     };
     // Use the MUSE argument parser to parse command-line arguments
     // and update instance variables
     ArgParser ap(arg_list);
     ap.parseArguments(argc, argv, false);
+    // Check to ensure transport is valid for the simulator
+    if ((transportName != "mpi") && (transportName != "rma") &&
+        (transportName != "shm")) {
+        throw std::runtime_error("Invalid value for --transport argument" \
+                                 "(must be: mpi, rma, or shm)");
+    }
+    if ((transportName != "mpi") && (simName != "default") &&
+        (simName != "cmb")) {
+        throw std::runtime_error("The --transport argument can be used " \
+                                 "only with default or cmb simulators");
+    }
+    // Setup the memory arenas used for events and states.  This must
+    // be done before any events or states are allocated.
+    if (!HugePageAllocator::setMode(hugePages)) {
+        throw std::runtime_error("Invalid value for --huge-pages argument" \
+                                 "(must be: none, thp, or explicit)");
+    }
+    if ((eventArenaSize < 4096) || (stateArenaSize < 4096)) {
+        throw std::runtime_error("The --event-arena-size and " \
+                                 "--state-arena-size must be >= 4096");
+    }
+    SlabAllocator::setDefaultSlabSize(eventArenaSize);
+    StateRecycler::setArenaSize(stateArenaSize);
     // Instantiate the actual simulation object based on simName.
     ASSERT( kernel == NULL );
     if (simName == "default") {
         kernel = new DefaultSimulation();
-    } else if (simName == "mpi-mt") {
+    } else if ((simName == "mpi-mt") || (simName == "cmb-mt")) {
         kernel = new MultiThreadedSimulationManager();
+    } else if (simName == "mpi-mt-shm") {
+        kernel = new MultiThreadedShmSimulationManager();
     } else if (simName == "cmb") {
         kernel = new ConservativeSimulation();
+    } else if (simName == "hc-cpu") {
+        kernel = new HCCpuSimulation();
     } else if (simName == "ocl"){
 #ifdef HAVE_OPEN_CL
         kernel = new OclSimulation();
@@ -118,7 +174,8 @@ Simulation::initializeSimulation(int& argc, char* argv[], bool initMPI) {
     } else {
         // Invalid simulator name.
         throw std::runtime_error("Invalid value for --simulator argument" \
-                                 "(muse be: default, mpi-mt, ocl or cmb)");
+                                 " (must be: default, mpi-mt, mpi-mt-shm, " \
+                                 "hc-cpu, ocl, cmb, or cmb-mt)");
     }
     // Now let the instantiated/derived kernel initialize further.
     ASSERT (kernel != NULL);
@@ -165,10 +222,25 @@ Simulation::initialize(int& argc, char* argv[], bool initMPI) {
     initSharedIOBuffers();
 }
 
+Communicator*
+Simulation::createCommunicator() {
+    if (transportName == "rma") {
+        return new Communicator(new RmaTransport());
+    } else if (transportName == "shm") {
+        return new Communicator(new ShmTransport());
+    }
+    return new Communicator(new MpiTransport());
+}
+
 void
 Simulation::parseCommandLineArgs(int &argc, char* argv[]) {
     // Make the arg_record
     bool saveState = false;
+    int mpiSendPool = 128;
+    int mpiRecvRing = 0, mpiRecvSize = 256;
+    int migrateInterval = 0, migrateMaxAgents = 8;
+    double migrateThresh = 0.25;
+    int idleSpin = 1000, idleParkUsec = 0;
     // Make sure simName has been set by the arg parser in "Initialize Simulation"
     // If simName is coming up as null, then the user must not have gotten the
     // kernel by calling Simulation::initializeSimulation
@@ -182,6 +254,23 @@ Simulation::parseCommandLineArgs(int &argc, char* argv[]) {
           &saveState, ArgParser::BOOLEAN},
         { "--max-mpi-msg-thresh", "Maximum consecutive MPI msgs to process",
           &maxMpiMsgThresh, ArgParser::INTEGER},
+        { "--mpi-send-pool", "Max in-flight non-blocking MPI sends "
+          "(0 for blocking sends)", &mpiSendPool, ArgParser::INTEGER},
+        { "--mpi-recv-ring", "Number of pre-posted MPI receives for events "
+          "(0 to disable)", &mpiRecvRing, ArgParser::INTEGER},
+        { "--mpi-recv-size", "Size (bytes) of buffers for pre-posted MPI "
+          "receives", &mpiRecvSize, ArgParser::INTEGER},
+        { "--migrate-interval", "GVT updates between checks to migrate "
+          "agents between processes (0 to disable)", &migrateInterval,
+          ArgParser::INTEGER},
+        { "--migrate-threshold", "Relative imbalance in committed events "
+          "that triggers agent migration", &migrateThresh, ArgParser::DOUBLE},
+        { "--migrate-max-agents", "Maximum agents migrated in each round",
+          &migrateMaxAgents, ArgParser::INTEGER},
+        { "--idle-spin", "Idle iterations before an idle thread is parked",
+          &idleSpin, ArgParser::INTEGER},
+        { "--idle-park-usec", "Max microseconds an idle thread is parked "
+          "(0 to disable parking)", &idleParkUsec, ArgParser::INTEGER},
         #ifdef POLLER
 	{ "--poll", "The polling policy to use (always, exp, avg, lstm)",
           &pollPolicyType, ArgParser::STRING},
@@ -193,7 +282,11 @@ Simulation::parseCommandLineArgs(int &argc, char* argv[]) {
     // and update instance variables
     ArgParser ap(arg_list);
     ap.parseArguments(argc, argv, false);
-    if (schedulerName == "hrm") {
+    // Derived classes (such as mpi-mt-shm) may have already setup a
+    // custom scheduler.  Otherwise create one based on the argument.
+    if (scheduler != NULL) {
+        // Use the scheduler setup by the derived class.
+    } else if (schedulerName == "hrm") {
         scheduler = new HRMScheduler();
     } else{
         scheduler = new Scheduler();
@@ -214,11 +307,60 @@ Simulation::parseCommandLineArgs(int &argc, char* argv[]) {
     }
     #endif
 
+    // Setup the pool of non-blocking sends in the communicator
+    if (mpiSendPool < 0) {
+        std::cerr << "Invalid value for --mpi-send-pool. Value must be "
+            ">= 0\n";
+        abort();
+    }
+    commManager->setMaxPendingSends(mpiSendPool);
+    // Setup the ring of pre-posted receives (if requested)
+    if ((mpiRecvRing < 0) ||
+        ((mpiRecvRing > 0) && (mpiRecvSize < (int) sizeof(Event)))) {
+        std::cerr << "Invalid value for --mpi-recv-ring or --mpi-recv-size."
+                  << " Size must be >= " << sizeof(Event) << " bytes\n";
+        abort();
+    }
+    if (numberOfProcesses > 1) {
+        commManager->setRecvRing(mpiRecvRing, mpiRecvSize);
+    }
+    // Let the communicator consume any specific arguments
+    commManager->parseCommandLineArgs(argc, argv);
+    // Share the directory of agents between scheduler and communicator
+    scheduler->setAgentDirectory(&commManager->getAgentDirectory());
     // Initialize the scheduler.
     scheduler->initialize(myID, numberOfProcesses, argc, argv);
-    // Setup flag to enable/disable state saving in agents
-    mustSaveState = (saveState || (numberOfProcesses > 1) ||
-                     (getNumberOfThreads() > 1));
+    // Setup flag to enable/disable state saving in agents.  Conservative
+    // simulations never rollback and hence never save state or retain
+    // events in input/output queues.
+    mustSaveState = !isConservative() &&
+        (saveState || (numberOfProcesses > 1) || (getNumberOfThreads() > 1));
+    // Setup migration of agents between processes (if requested)
+    if ((migrateInterval < 0) || (migrateThresh < 0) ||
+        (migrateMaxAgents < 1)) {
+        std::cerr << "Invalid value for --migrate-interval, "
+                  << "--migrate-threshold, or --migrate-max-agents.\n";
+        abort();
+    }
+    if ((migrateInterval > 0) && (numberOfProcesses > 1)) {
+        if (simName != "default") {
+            std::cerr << "Warning: Agent migration is supported only by "
+                      << "the default simulator. Ignoring "
+                      << "--migrate-interval.\n";
+        } else {
+            migrator = new AgentMigrator(this, migrateInterval,
+                                         migrateThresh, migrateMaxAgents);
+        }
+    }
+    // Setup parking of idle threads (if requested)
+    if ((idleSpin < 1) || (idleParkUsec < 0)) {
+        std::cerr << "Invalid value for --idle-spin (must be > 0) or "
+                  << "--idle-park-usec (must be >= 0)\n";
+        abort();
+    }
+    if (idleParkUsec > 0) {
+        idleParker = new IdleParker(idleSpin, idleParkUsec);
+    }
 }
 
 
@@ -230,15 +372,88 @@ Simulation::~Simulation() {
 bool
 Simulation::registerAgent(muse::Agent* agent, const int threadRank)  {
     UNUSED_PARAM(threadRank);
+    if ((agentGraph != NULL) && agentGraph->isPartitioned() &&
+        (agentGraph->getRank(agent->getAgentID()) != (int) myID)) {
+        std::cerr << "Error: Agent " << agent->getAgentID() << " was not "
+                  << "assigned to rank " << myID << " by partitionAgents."
+                  << std::endl;
+        return false;
+    }
+    if (agent->isConservative() && usingSharedEvents()) {
+        std::cerr << "Error: Conservative agent " << agent->getAgentID()
+                  << " cannot be used with --use-shared-events.\n";
+        return false;
+    }
     if (scheduler->addAgentToScheduler(agent)) {
         allAgents.push_back(agent);
-        agent->mustSaveState = this->mustSaveState;
+        // Conservative agents never rollback and never save state.
+        agent->mustSaveState = this->mustSaveState &&
+            !agent->isConservative();
         agent->setKernel(this);
         return true;
     }
     return false;
 }
 
+void
+Simulation::setAgentPartition(const AgentPartition kind,
+                              const AgentID numAgents) {
+    commManager->setAgentPartition(kind, numAgents);
+}
+
+void
+Simulation::declareAgent(const AgentID id, const double cost) {
+    if (agentGraph == NULL) {
+        agentGraph = new AgentGraph();
+    }
+    agentGraph->addAgent(id, cost);
+}
+
+void
+Simulation::declareEdge(const AgentID src, const AgentID dest,
+                        const double weight) {
+    if (agentGraph == NULL) {
+        agentGraph = new AgentGraph();
+    }
+    agentGraph->addEdge(src, dest, weight);
+}
+
+void
+Simulation::declareLookahead(const AgentID src, const AgentID dest,
+                             const Time lookahead) {
+    if (lookahead <= 0) {
+        std::cerr << "Error: Lookahead from agent " << src << " to agent "
+                  << dest << " must be positive (got " << lookahead
+                  << ").\n";
+        abort();
+    }
+    linkLookahead[std::make_pair(src, dest)] = lookahead;
+}
+
+void
+Simulation::partitionAgents(const double imbalance) {
+    if (agentGraph == NULL) {
+        std::cerr << "Error: Agents must be declared (via declareAgent) "
+                  << "prior to calling partitionAgents.\n";
+        abort();
+    }
+    agentGraph->partition(numberOfProcesses, getNumberOfThreads(),
+                          imbalance, getThreadDomains());
+    if (myID == ROOT_KERNEL) {
+        agentGraph->printSummary(std::cout);
+    }
+}
+
+int
+Simulation::getAssignedRank(const AgentID id) const {
+    return (agentGraph != NULL) ? agentGraph->getRank(id) : -1;
+}
+
+int
+Simulation::getAssignedThread(const AgentID id) const {
+    return (agentGraph != NULL) ? agentGraph->getThread(id) : -1;
+}
+
 bool 
 Simulation::scheduleEvent(Event* e) {
     ASSERT(e->getReceiveTime() >= getGVT());
@@ -258,6 +473,9 @@ Simulation::scheduleEvent(Event* e) {
     } else {
         // Remote events are sent via the GVTManager to aid tracking
         // GVT. The gvt manager calls communicator.
+        if (migrator != NULL) {
+            migrator->eventSent();
+        }
         gvtManager->sendRemoteEvent(e);
     }
     return true;
@@ -336,8 +554,18 @@ Simulation::processMpiMsgs() {
     int numMsgs;
     for (numMsgs = 0; (numMsgs < maxMpiMsgThresh); numMsgs++) {
         Event* incoming_event = commManager->receiveEvent();
-        if (incoming_event != NULL) {
+        if ((incoming_event != NULL) &&
+            MigrationMessage::isMigrationMessage(incoming_event)) {
+            // Messages used to migrate agents are handled separately.
+            ASSERT(migrator != NULL);
+            migrator->handleMessage(static_cast<MigrationMessage*>
+                                    (incoming_event));
+            EventRecycler::decreaseReference(incoming_event);
+        } else if (incoming_event != NULL) {
             ASSERT(incoming_event->getReferenceCount() == 1);
+            if (migrator != NULL) {
+                migrator->eventReceived();
+            }
             scheduleEvent(incoming_event);
             // Decrease the reference because if it was rejected,
             // the event will be properly deleted. However, if it
@@ -371,6 +599,18 @@ Simulation::processMpiMsgs() {
     return numMsgs;
 }
 
+bool
+Simulation::parkIdleThread() {
+    ASSERT(idleParker != NULL);
+    // Keep GVT advancing while idle; GVT may be all we are waiting on.
+    gvtManager->startGVTestimation();
+    const Time gvt = getGVT();
+    // With a single thread only MPI messages (or a GVT update) can
+    // bring in work.  So the park just bounds the time between checks.
+    return idleParker->park([this, gvt] {
+            return (processMpiMsgs() > 0) || (getGVT() != gvt); });
+}
+
 bool
 Simulation::processNextEvent() {
     // Update lgvt to the time of the next event to be processed.
@@ -400,6 +640,11 @@ Simulation::start() {
     if (allAgents.empty()) return;
     // Finish all the setup prior to starting simulation.
     preStartInit();
+    // Check if agents can be migrated (if requested)
+    if ((migrator != NULL) && !migrator->start()) {
+        delete migrator;
+        migrator = NULL;
+    }
     // Next initialize all the agents
     initAgents();
     // Start the core simulation loop.
@@ -432,9 +677,18 @@ Simulation::start() {
         processMpiMsgs();
 	#endif
 	// checkProcessMpiMsgs();
+        // Let the agent migrator (if any) perform pending operations.
+        // Events are not processed while agents are being migrated.
+        if ((migrator != NULL) && migrator->processPending()) {
+            continue;
+        }
         // Process the next event from the list of events managed by
         // the scheduler.
-        if (!processNextEvent()) {
+        const bool processed = processNextEvent();
+        // Ship remote events generated above right away, even if the
+        // polling policy defers receiving messages.
+        commManager->flush();
+        if (!processed) {
             // We did not have any events to process. So check MPI
             // more frequently.
             #ifdef POLLER
@@ -442,11 +696,22 @@ Simulation::start() {
 	    #else
 	    mpiMsgCheckCounter = 1;
 	    #endif
+            // If all our events have drained, start a GVT round right
+            // away so that termination is detected promptly.
+            if (LGVT == TIME_INFINITY) {
+                gvtManager->startGVTestimation();
+            }
+            // Park this thread if it has been idle for a while.
+            if ((idleParker != NULL) && idleParker->idle()) {
+                parkIdleThread();
+            }
+        } else if (idleParker != NULL) {
+            idleParker->busy();
         }
     }
     // Wait for all the parallel processes to complete the main
     // simulation loop.
-    MPI_BARRIER();
+    commManager->barrier();
 }
 
 void
@@ -480,6 +745,16 @@ Simulation::finalize(bool stopMPI, bool delCommMgr) {
         delete agent;
     }
 
+    // Agents are no longer migrated.
+    delete migrator;
+    migrator = NULL;
+    // Threads are no longer parked.
+    delete idleParker;
+    idleParker = NULL;
+    // The partition of agents is no longer needed.
+    delete agentGraph;
+    agentGraph = NULL;
+
     // Now delete GVT manager as we no longer need it.
     commManager->setGVTManager(NULL);
     delete gvtManager;
@@ -527,6 +802,10 @@ Simulation::garbageCollect() {
     }
     // Commit all shared streams (if any)
     commitSharedIOBuffers(gvt);
+    // Let the agent migrator (if any) track GVT updates
+    if (migrator != NULL) {
+        migrator->gvtUpdated(gvt);
+    }
     // Let listener know garbage collection for a given GVT value has
     // been completed.
     if (listener != NULL) {
@@ -628,10 +907,20 @@ Simulation::reportStatistics(std::ostream& os) {
           << "\nMax MPI msg check thres: " << maxMpiMsgCheckThresh
           << "\nAdaptive time window   : " << scheduler->adaptiveTimeWindow
           << std::endl;    
+    // Report statistics about agent migration (if any)
+    if (migrator != NULL) {
+        migrator->reportStats(stats);
+    }
+    // Report statistics about parking idle threads (if any)
+    if (idleParker != NULL) {
+        idleParker->reportStats(stats);
+    }
     // Let derived class(es) report statistics (if any)
     reportLocalStatistics(stats);
     // Finally, report statistics from the EventRecycler
     stats << EventRecycler::getStats();    
+    // Report statistics from the communicator
+    commManager->reportStats(stats);
     // Have the scheduler (and event queue) report statistics (if any)
     scheduler->reportStats(stats);
     // Report statistics
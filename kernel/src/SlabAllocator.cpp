@@ -0,0 +1,404 @@
+#ifndef MUSE_SLAB_ALLOCATOR_CPP
+#define MUSE_SLAB_ALLOCATOR_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include "SlabAllocator.h"
+#include "HugePageAllocator.h"
+
+#if USE_NUMA == 1
+#include <numa.h>
+#endif
+
+// Switch to muse namespace to streamline code
+using namespace muse;
+
+// The inboxes for all owners.  These are never deallocated so that
+// chunks can be returned to an owner even after its thread has
+// finished.
+SlabAllocator::Inbox SlabAllocator::inboxes[SlabAllocator::MaxOwners];
+
+// The number of owner IDs assigned so far.
+std::atomic<int> SlabAllocator::ownerCount(0);
+
+// The mutex to serialize changes to the list of slabs.
+std::mutex SlabAllocator::slabMutex;
+
+// The default size of slabs (changed via --event-arena-size)
+size_t SlabAllocator::defaultSlabSize = 65536;
+
+SlabAllocator::SlabAllocator() : ownerID(-1), slabSize(defaultSlabSize),
+                                 liveChunks(0), adoptedChunks(0),
+                                 allocCalls(0), deallocCalls(0),
+                                 recycleHits(0), remoteFrees(0),
+                                 remoteReclaims(0), slabBytes(0),
+                                 hugeBytes(0) {
+    // Slabs are allocated on demand
+}
+
+SlabAllocator::~SlabAllocator() {
+    DEBUG(std::cout << getStats() << std::endl);
+    std::lock_guard<std::mutex> lock(slabMutex);
+    for (const Slab& slab : slabs) {
+        freeSlab(slab);
+    }
+}
+
+void
+SlabAllocator::setSlabSize(const size_t size) {
+    // Ensure that at least 2 of the largest chunks fit in a slab
+    slabSize = std::max(size, 2 * (MaxChunkSize + sizeof(ChunkHeader)));
+}
+
+void
+SlabAllocator::registerOwner() {
+    ASSERT(ownerID == -1);
+    ownerID = ownerCount.fetch_add(1);
+    if (ownerID >= MaxOwners) {
+        std::cerr << "Error: More than " << MaxOwners << " threads have "
+                  << "allocated events. Increase SlabAllocator::MaxOwners.\n";
+        abort();
+    }
+    // Chunks carved by this allocator are returned to it.
+    inboxes[ownerID].head.store(NULL, std::memory_order_relaxed);
+    inboxes[ownerID].forward.store(ownerID, std::memory_order_release);
+}
+
+void
+SlabAllocator::addHeaps(const int heapIdx) {
+    ASSERT(heapIdx >= (int) heaps.size());
+    if (heapIdx > 255) {
+        std::cerr << "Error: NUMA node " << (heapIdx - 1) << " is too "
+                  << "large for SlabAllocator.\n";
+        abort();
+    }
+    while ((int) heaps.size() <= heapIdx) {
+        const int numaID = (int) heaps.size() - 1;
+        heaps.push_back(Heap{numaID, std::vector<FreeChunk*>(NumClasses,
+                                                             NULL), NULL, 0});
+    }
+}
+
+char*
+SlabAllocator::allocate(const int size, const int numaID) {
+    ASSERT(size > 0);
+    ASSERT(numaID >= -1);
+    allocCalls++;
+    if (size > MaxChunkSize) {
+        return allocateLarge(size, numaID);
+    }
+    const int heapIdx   = numaID + 1;
+    const int sizeClass = getSizeClass(size);
+    Heap& heap          = getHeap(heapIdx);
+    FreeChunk* chunk    = heap.freeList[sizeClass];
+    if ((chunk == NULL) && (ownerID != -1) &&
+        (inboxes[ownerID].head.load(std::memory_order_relaxed) != NULL)) {
+        // Reclaim chunks returned by other threads and check again.
+        drainInbox();
+        chunk = heap.freeList[sizeClass];
+    }
+    liveChunks++;
+    if (chunk == NULL) {
+        // No chunk to recycle.  Carve out a new one.
+        return carve(heapIdx, sizeClass);
+    }
+    // Recycle the chunk at the top of the free list.
+    heap.freeList[sizeClass] = chunk->next;
+    recycleHits++;
+    char* const mem = reinterpret_cast<char*>(chunk);
+    // The chunk may have been adopted from another allocator.
+    getHeader(mem)->owner = ownerID;
+    return mem;
+}
+
+char*
+SlabAllocator::carve(const int heapIdx, const int sizeClass) {
+    if (ownerID == -1) {
+        registerOwner();
+    }
+    Heap& heap          = heaps[heapIdx];
+    const size_t stride = sizeof(ChunkHeader) + getClassSize(sizeClass);
+    if (heap.avail < stride) {
+        // The current slab does not have sufficient space.  The
+        // remainder of the slab is left unused.
+        addSlab(heap);
+    }
+    ChunkHeader* const hdr = reinterpret_cast<ChunkHeader*>(heap.current);
+    hdr->owner     = ownerID;
+    hdr->heap      = heapIdx;
+    hdr->sizeClass = sizeClass;
+    hdr->largeSize = 0;
+    heap.current  += stride;
+    heap.avail    -= stride;
+    return reinterpret_cast<char*>(hdr + 1);
+}
+
+void
+SlabAllocator::addSlab(Heap& heap) {
+    // With huge pages, the size is rounded up to whole huge pages.
+    const size_t size = HugePageAllocator::roundUp(slabSize);
+    bool huge = false;
+    char* const mem = (HugePageAllocator::isEnabled() ?
+                       HugePageAllocator::allocate(size, heap.numaID, huge) :
+                       allocateMemory(size, heap.numaID));
+    {
+        std::lock_guard<std::mutex> lock(slabMutex);
+        slabs.push_back(Slab{mem, size, heap.numaID,
+                             HugePageAllocator::isEnabled()});
+    }
+    slabBytes   += size;
+    hugeBytes   += (huge ? size : 0);
+    heap.current = mem;
+    heap.avail   = size;
+}
+
+void
+SlabAllocator::freeSlab(const Slab& slab) {
+    if (slab.mapped) {
+        HugePageAllocator::release(slab.start, slab.size);
+    } else {
+        freeMemory(slab.start, slab.size, slab.numaID);
+    }
+}
+
+char*
+SlabAllocator::allocateLarge(const int size, const int numaID) {
+    const size_t netSize   = size + sizeof(ChunkHeader);
+    ChunkHeader* const hdr =
+        reinterpret_cast<ChunkHeader*>(allocateMemory(netSize, numaID));
+    hdr->owner     = 0;
+    hdr->heap      = numaID + 1;
+    hdr->sizeClass = LargeClass;
+    hdr->largeSize = netSize;
+    return reinterpret_cast<char*>(hdr + 1);
+}
+
+void
+SlabAllocator::deallocate(char* mem) {
+    ASSERT(mem != NULL);
+    deallocCalls++;
+    ChunkHeader* const hdr = getHeader(mem);
+    if (hdr->sizeClass == LargeClass) {
+        // Large chunks are freed right away by any thread.
+        freeMemory(reinterpret_cast<char*>(hdr), hdr->largeSize,
+                   hdr->heap - 1);
+        return;
+    }
+    ASSERT(hdr->sizeClass < NumClasses);
+    FreeChunk* const chunk = reinterpret_cast<FreeChunk*>(mem);
+    int owner = hdr->owner;
+    if (owner != ownerID) {
+        // The owner may have handed its slabs to another allocator.
+        owner = resolveOwner(owner);
+    }
+    if (owner == ownerID) {
+        // Fast path: Add the chunk to the local free list.
+        Heap& heap  = getHeap(hdr->heap);
+        chunk->next = heap.freeList[hdr->sizeClass];
+        heap.freeList[hdr->sizeClass] = chunk;
+        liveChunks--;
+        return;
+    }
+    // Add chunk to the batch to be returned to its owner.
+    if (owner >= (int) batches.size()) {
+        batches.resize(owner + 1, Batch{NULL, NULL, 0});
+    }
+    Batch& batch = batches[owner];
+    chunk->next  = batch.head;
+    if (batch.head == NULL) {
+        batch.tail = chunk;
+    }
+    batch.head = chunk;
+    remoteFrees++;
+    if (++batch.count >= BatchSize) {
+        pushToInbox(owner, batch.head, batch.tail);
+        batch = Batch{NULL, NULL, 0};
+    }
+}
+
+int
+SlabAllocator::resolveOwner(int owner) {
+    ASSERT((owner >= 0) && (owner < MaxOwners));
+    int next;
+    while ((next = inboxes[owner].forward.load(std::memory_order_acquire))
+           != owner) {
+        owner = next;
+    }
+    return owner;
+}
+
+void
+SlabAllocator::pushToInbox(int owner, FreeChunk* head, FreeChunk* tail) {
+    ASSERT((head != NULL) && (tail != NULL));
+    std::atomic<FreeChunk*>& inbox = inboxes[owner].head;
+    FreeChunk* top = inbox.load(std::memory_order_relaxed);
+    do {
+        tail->next = top;
+    } while (!inbox.compare_exchange_weak(top, head,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+}
+
+size_t
+SlabAllocator::drainInbox() {
+    ASSERT(ownerID != -1);
+    // Take all the chunks in one shot.  Since only the owner removes
+    // chunks, the ABA problem does not arise.
+    FreeChunk* chunk = inboxes[ownerID].head.exchange(NULL,
+                                                      std::memory_order_acquire);
+    size_t count = 0;
+    while (chunk != NULL) {
+        FreeChunk* const next  = chunk->next;
+        ChunkHeader* const hdr = getHeader(reinterpret_cast<char*>(chunk));
+        Heap& heap  = getHeap(hdr->heap);
+        chunk->next = heap.freeList[hdr->sizeClass];
+        heap.freeList[hdr->sizeClass] = chunk;
+        chunk = next;
+        count++;
+    }
+    liveChunks     -= count;
+    remoteReclaims += count;
+    return count;
+}
+
+void
+SlabAllocator::flushRemoteFrees() {
+    for (size_t owner = 0; (owner < batches.size()); owner++) {
+        Batch& batch = batches[owner];
+        if (batch.count > 0) {
+            pushToInbox(resolveOwner(owner), batch.head, batch.tail);
+            batch = Batch{NULL, NULL, 0};
+        }
+    }
+}
+
+bool
+SlabAllocator::releaseSlabs() {
+    flushRemoteFrees();
+    if (ownerID != -1) {
+        drainInbox();
+    }
+    std::lock_guard<std::mutex> lock(slabMutex);
+    if (liveChunks + adoptedChunks.load() != 0) {
+        return false;  // Some chunks are still in use.
+    }
+    for (const Slab& slab : slabs) {
+        freeSlab(slab);
+    }
+    slabs.clear();
+    heaps.clear();
+    return true;
+}
+
+void
+SlabAllocator::moveSlabsTo(SlabAllocator& mainAlloc) {
+    ASSERT(&mainAlloc != this);
+    flushRemoteFrees();
+    if (ownerID == -1) {
+        return;  // This allocator never carved out any chunks.
+    }
+    std::lock_guard<std::mutex> lock(slabMutex);
+    if (mainAlloc.ownerID == -1) {
+        mainAlloc.registerOwner();
+    }
+    mainAlloc.slabs.insert(mainAlloc.slabs.end(), slabs.begin(), slabs.end());
+    mainAlloc.adoptedChunks += liveChunks;
+    // From now on, chunks carved by this allocator are returned to
+    // the main allocator.  Chunks already returned to this allocator
+    // are passed on to the main allocator.
+    inboxes[ownerID].forward.store(mainAlloc.ownerID,
+                                   std::memory_order_release);
+    FreeChunk* const head =
+        inboxes[ownerID].head.exchange(NULL, std::memory_order_acquire);
+    if (head != NULL) {
+        FreeChunk* tail = head;
+        while (tail->next != NULL) {
+            tail = tail->next;
+        }
+        pushToInbox(mainAlloc.ownerID, head, tail);
+    }
+    // Free chunks in the local free lists are simply abandoned.
+    slabs.clear();
+    heaps.clear();
+    liveChunks = 0;
+    ownerID    = -1;
+}
+
+char*
+SlabAllocator::allocateMemory(const size_t size, const int numaID) {
+    void* mem = NULL;
+#if USE_NUMA == 1
+    if (numaID >= 0) {
+        mem = numa_alloc_onnode(size, numaID);
+        if (mem == NULL) {
+            std::cerr << "Error allocating " << size << " bytes on NUMA "
+                      << "node " << numaID << std::endl;
+            abort();
+        }
+        return static_cast<char*>(mem);
+    }
+#else
+    UNUSED_PARAM(numaID);
+#endif
+    if (posix_memalign(&mem, 64, size) != 0) {
+        std::cerr << "Error allocating " << size << " bytes for events\n";
+        abort();
+    }
+    return static_cast<char*>(mem);
+}
+
+void
+SlabAllocator::freeMemory(char* mem, const size_t size, const int numaID) {
+#if USE_NUMA == 1
+    if (numaID >= 0) {
+        numa_free(mem, size);
+        return;
+    }
+#else
+    UNUSED_PARAM(numaID);
+#endif
+    UNUSED_PARAM(size);
+    free(mem);
+}
+
+std::string
+SlabAllocator::getStats() const {
+    std::ostringstream os;
+    os << "  Slab Allocate calls     : "   << allocCalls
+       << "\n  Slab Deallocate calls   : " << deallocCalls
+       << "\n  Slab Recycler hits      : " << recycleHits
+       << "\n  Slab Recycler %hits     : "
+       << ((float) recycleHits / allocCalls)
+       << "\n  Slab Remote frees       : " << remoteFrees
+       << "\n  Slab Remote reclaims    : " << remoteReclaims
+       << "\n  Slabs                   : " << slabs.size() << " x "
+       << HugePageAllocator::roundUp(slabSize) << " bytes"
+       << "\n  Slab huge-page coverage : "
+       << HugePageAllocator::getCoverage(hugeBytes, slabBytes) << std::endl;
+    return os.str();
+}
+
+#endif
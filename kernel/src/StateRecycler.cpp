@@ -47,6 +47,9 @@ thread_local bool StateRecycler::useNuma = false;
 // The NUMA-node ID to be used for this thread.
 thread_local int StateRecycler::numaID = 0;
 
+// The size of NUMA memory blocks (changed via --state-arena-size)
+int StateRecycler::arenaSize = 32768;
+
 #if USE_NUMA == 1
 // The thread local NUMA memory manager.
 thread_local NumaMemoryManager StateRecycler::numaMemMgr;
@@ -59,7 +62,7 @@ StateRecycler::setup(bool enableNuma, int numaNodeID) {
     numaID  = numaNodeID;
 #if USE_NUMA == 1
     // Create initial blocks on all available numa nodes for now.
-    numaMemMgr.start({numaNodeID}, 32768);
+    numaMemMgr.start({numaNodeID}, arenaSize);
 #endif
 }
 
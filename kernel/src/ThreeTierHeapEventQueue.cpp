@@ -74,6 +74,44 @@ ThreeTierHeapEventQueue::removeAgent(muse::Agent* agent) {
     updateHeap(agent);
 }
 
+bool
+ThreeTierHeapEventQueue::detachAgent(muse::Agent* agent,
+                                     muse::EventContainer& events) {
+    ASSERT(agent != NULL);
+    ASSERT(agent->tier2 != &EmptyT2List);
+    // Hand-off events (with their references) to the caller.
+    for (muse::HOETier2Entry* bucket : *agent->tier2) {
+        const std::vector<muse::Event*>& eventList = bucket->getEventList();
+        events.insert(events.end(), eventList.begin(), eventList.end());
+        delete bucket;
+    }
+    delete agent->tier2;
+    agent->tier2 = NULL;
+    // Remove the agent from the heap by moving the last agent into
+    // its slot and fixing-up the heap from that position.
+    const size_t index = getIndex(agent);
+    muse::Agent* const last = agentList.back();
+    agentList.pop_back();
+    if (index < agentList.size()) {
+        agentList[index] = last;
+        last->fibHeapPtr = reinterpret_cast<void*>(index);
+        fixHeap(index);
+    }
+    agent->fibHeapPtr = NULL;
+    agent->oldTopTime = TIME_INFINITY;
+    return true;
+}
+
+size_t
+ThreeTierHeapEventQueue::getEventCount(muse::Agent* agent) const {
+    ASSERT(agent != NULL);
+    size_t count = 0;
+    for (const muse::HOETier2Entry* bucket : *agent->tier2) {
+        count += bucket->getEventList().size();
+    }
+    return count;
+}
+
 muse::Event*
 ThreeTierHeapEventQueue::front() {
     return (!top()->tier2->empty()) ? top()->tier2->front()->getEvent() : NULL;
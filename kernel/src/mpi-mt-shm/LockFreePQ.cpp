@@ -4,13 +4,23 @@
 
 
 
-// The ID associated with any thread that accesses this queue
+// The slots for threads that use queues of a given type
 template <class K, class V, class Compare>
-thread_local size_t LockFreePQ<K, V, Compare>::thread_id = THREAD_ID_NULL;
+typename LockFreePQ<K, V, Compare>::ThreadSlot
+LockFreePQ<K, V, Compare>::slots[MAX_PQ_THREADS];
 
-// A static value used to distribute unique IDs across multiple threads
+// The number of slots that have been assigned to threads so far
 template <class K, class V, class Compare>
-size_t* LockFreePQ<K, V, Compare>::lastId = new size_t(0);
+std::atomic<int> LockFreePQ<K, V, Compare>::slotCount(0);
+
+// The global epoch used to reclaim nodes
+template <class K, class V, class Compare>
+std::atomic<size_t> LockFreePQ<K, V, Compare>::globalEpoch(0);
+
+// The per-thread retired lists and node pool
+template <class K, class V, class Compare>
+thread_local typename LockFreePQ<K, V, Compare>::ThreadState
+LockFreePQ<K, V, Compare>::threadState;
 
 template <class K, class V, class Compare>
 LockFreePQ<K, V, Compare>::LockFreePQ() {
@@ -35,9 +45,11 @@ LockFreePQ<K, V, Compare>::LockFreePQ() {
     head->value     = NULL;
     tail->value     = NULL;
     
-    // At all levels of the skip list, connect head and tail
+    // At all levels of the skip list, connect head and tail. The tail's
+    // pointers must be unmarked as traversals check tail->next[0].
     for (size_t i = 0; i < NUM_LEVELS; i++) {
         head->next[i] = tail;
+        tail->next[i] = NULL;
     }
     
     maxOffset = MAX_OFFSET; // todo(deperomm): make this cmd line arg?
@@ -46,18 +58,17 @@ LockFreePQ<K, V, Compare>::LockFreePQ() {
 template <class K, class V, class Compare>
 LockFreePQ<K, V, Compare>::~LockFreePQ() {
     
-    // Clean up current elements of the queue
+    // Clean up current elements of the queue. No other thread is using
+    // this queue, so the nodes can be reused right away. Nodes that were
+    // removed earlier are reclaimed by the threads that retired them.
     Node_t *cur, *pred;
     cur = head;
     while (cur != tail) {
         pred = cur;
         cur = get_unmarked_ref(pred->next[0]);
-        freeNode(pred);
+        recycleNode(pred);
     }
-    freeNode(tail);
-    
-    // Clean up the garbage collection system
-    finalizeDeallocs();
+    recycleNode(tail);
 }
 
 template <class K, class V, class Compare>
@@ -86,30 +97,19 @@ LockFreePQ<K, V, Compare>::insert(K key, V val) {
     do {
         del = locatePreds(key, preds, succs);
         
-        // if key already exists
+        // if key already exists with a valid value, return it.  A
+        // node whose value is NULL has been logically deleted (via
+        // deleteEntry or deleteMin) and is never reused, as a
+        // concurrent deleteMin may be unlinking it.  Instead the new
+        // node is inserted just before it.
         if (!comp(succs[0]->key, key) && !comp(key, succs[0]->key)
                 && !is_marked_ref(preds[0]->next[0]) 
-                && preds[0]->next[0] == succs[0]) {
-            
+                && preds[0]->next[0] == succs[0]
+                && succs[0]->value != NULL) {
             V ret = succs[0]->value;
-            
-            if (ret == NULL) {
-                // this entry was popped off previously, re-use the entry
-                if(__sync_bool_compare_and_swap(&succs[0]->value, 
-                        NULL, val)) {
-                    // successfully inserted back into this old node
-                    exitCritical();
-                    return NULL;
-                } else {
-                    ret = succs[0]->value;
-                    assert(ret != NULL); // this is possible?...
-                }
-            }
-            freeNode(newNode); // we didn't insert anything
-            
+            recycleNode(newNode); // we didn't insert anything
             exitCritical();
             return ret; // return the entry that matches the key
-                                    // this could be null if it was deleted
         }
         
         // begin inserting
@@ -359,7 +359,7 @@ LockFreePQ<K, V, Compare>::getEntry(K key) {
 
     // return if key-id pair was NOT found (since it must exist in the
     // queue in order for us to delete it)
-    if ( ( !comp(succs[0]->key, key) && !comp(key, succs[0]->key) )
+    if ( comp(succs[0]->key, key) || comp(key, succs[0]->key)
             || is_marked_ref(preds[0]->next[0]) 
             || preds[0]->next[0] != succs[0]) {
 
@@ -545,7 +545,7 @@ LockFreePQ<K, V, Compare>::allocNode() {
     static thread_local std::geometric_distribution<int> distribution;
     
     int level = distribution(generator);
-    if (level > NUM_LEVELS) {
+    if (level >= NUM_LEVELS) {
         // wow, this should only happen 1 in 2^32 (4 trillion) times...
         level = NUM_LEVELS - 1;
     }
@@ -555,8 +555,13 @@ LockFreePQ<K, V, Compare>::allocNode() {
     // Allocate the new node w/ enough space to hold pointers to (level) ptrs
     // sizeof *new_node has enough space for bot level, then + space for others
     // note bottom level is 0, so any higher level adds space to the node
-    // todo(deperomm): Make this come from a garbage collector/recycler
-    newNode = new Node_t;
+    std::vector<Node_t*>& pool = threadState.pool;
+    if (!pool.empty()) {
+        newNode = pool.back();
+        pool.pop_back();
+    } else {
+        newNode = new Node_t;
+    }
     
     newNode->level     = level;
     newNode->inserting = 1; // nodes always start off as being inserted
@@ -567,132 +572,146 @@ LockFreePQ<K, V, Compare>::allocNode() {
 template <class K, class V, class Compare>
 void 
 LockFreePQ<K, V, Compare>::freeNode(Node_t *n) {
-    std::lock_guard<std::mutex> guard(freeMutex);
-    pendingDeallocs->push_back(n);
+    ThreadState& ts = threadState;
+    assert(ts.slot != -1);  // must be called from within critical section
+    ts.retired[ts.epoch % EPOCH_BUCKETS].push_back(n);
+    if ((++ts.pending % EPOCH_CHECK_RATE) == 0) {
+        tryAdvanceEpoch();
+    }
+}
+
+template <class K, class V, class Compare>
+void
+LockFreePQ<K, V, Compare>::recycleNode(Node_t *n) {
+    std::vector<Node_t*>& pool = threadState.pool;
+    if (pool.size() < NODE_POOL_SIZE) {
+        pool.push_back(n);
+    } else {
+        delete n;
+    }
 }
 
 template <class K, class V, class Compare>
 void
 LockFreePQ<K, V, Compare>::enterCritical() {
-    // Initialize thread id if neccessary
-    if (thread_id == THREAD_ID_NULL) {
+    ThreadState& ts = threadState;
+    if (ts.slot == -1) {
         // This is a new thread entering a critical section for the first time
-        
-        // Give this thread a thread_id
-        size_t candidateId = *lastId;
-        while (!__sync_bool_compare_and_swap(lastId, candidateId, candidateId+1)){
-            candidateId = *lastId;
-        }
-        // at this point, we guarantee candidateId is unique to this thread
-        thread_id = pow(2, candidateId);
-        std::cout << "New Thread - log2(ID) = " << candidateId << std::endl;
+        registerThread(ts);
     }
     
-    assert(thread_id != THREAD_ID_NULL);
-    
-    // Mark this thread as in a critical section
-    // Note: this is expensive-ish because of very high contention by threads
-    thread_curr_state->fetch_or(thread_id);
-    
+    // Announce the epoch this thread observed and mark it as active. The
+    // fence ensures the announcement is visible to other threads trying to
+    // advance the epoch before this thread reads any node in the queue.
+    const size_t epoch = globalEpoch.load(std::memory_order_acquire);
+    slots[ts.slot].state.store((epoch << 1) | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    if (epoch != ts.epoch) {
+        // Nodes retired two or more epochs ago can no longer be accessed
+        // by any thread. Move them to the pool for reuse.
+        if (epoch - ts.epoch >= 2) {
+            for (std::vector<Node_t*>& retired : ts.retired) {
+                ts.reclaim(retired);
+            }
+        } else {
+            // The list for epoch + 1 holds nodes retired in epoch - 2
+            ts.reclaim(ts.retired[(epoch + 1) % EPOCH_BUCKETS]);
+        }
+        ts.epoch = epoch;
+    }
 }
 
 template <class K, class V, class Compare>
 void
 LockFreePQ<K, V, Compare>::exitCritical() {
-    
+    ThreadState& ts = threadState;
     // Mark this thread as NOT in a critical section
-    thread_curr_state->fetch_and(~thread_id);
-    
-    // Mark the current epoch that this thread is no longer in a crit section
-    size_t old = thread_epoch_state->fetch_and(~thread_id);
-    
-    // If epoch_state has been zero'd out, try to switch epochs, else return
-    // We want minimal contention on the atomic state variables, which is why
-    // we use the old value instead of checking the value of epoch_state again
-    if (old != 0) {
-        return;
+    slots[ts.slot].state.store(ts.epoch << 1, std::memory_order_release);
+    // Periodically help advance the epoch so that nodes retired by this
+    // thread are eventually reused even if it retires no more nodes.
+    if ((ts.pending > 0) && ((++ts.ops % EPOCH_CHECK_RATE) == 0)) {
+        tryAdvanceEpoch();
     }
-    
-    // If we get the epochMutex, we are the thread changing epoch this time
-    // Else just let the other thread take care of it
-    if (!epochMutex.try_lock()) {
-        return;
+}
+
+template <class K, class V, class Compare>
+void
+LockFreePQ<K, V, Compare>::tryAdvanceEpoch() {
+    // Pairs with the fence in enterCritical()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    size_t epoch = globalEpoch.load(std::memory_order_acquire);
+    const int count = slotCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        const size_t state = slots[i].state.load(std::memory_order_acquire);
+        if ((state & 1) && ((state >> 1) != epoch)) {
+            return;  // An active thread has not yet observed this epoch
+        }
     }
-    
-    // we have the lock
-    
-    // Because another thread could have changed epochs since we last checked
-    // epoch_state and the mutex (if another thread switch epoch between 
-    // setting "old" and trying lock) check again now that we own the lock.
-    // If epoch_state was changed since we last check, just abort
-    if (thread_epoch_state->load() != 0) {
-        epochMutex.unlock();
+    // If another thread advanced the epoch first, this CAS fails harmlessly
+    globalEpoch.compare_exchange_strong(epoch, epoch + 1,
+                                        std::memory_order_acq_rel);
+}
+
+template <class K, class V, class Compare>
+void
+LockFreePQ<K, V, Compare>::registerThread(ThreadState& ts) {
+    for (int i = 0; i < MAX_PQ_THREADS; i++) {
+        bool expected = false;
+        if (slots[i].claimed.load(std::memory_order_relaxed) ||
+            !slots[i].claimed.compare_exchange_strong(expected, true)) {
+            continue;  // slot is in use by another thread
+        }
+        // Start inactive in the current epoch
+        ts.slot  = i;
+        ts.epoch = globalEpoch.load(std::memory_order_acquire);
+        slots[i].state.store(ts.epoch << 1, std::memory_order_release);
+        // Ensure threads advancing the epoch check this slot
+        int count = slotCount.load(std::memory_order_acquire);
+        while ((count <= i) &&
+               !slotCount.compare_exchange_weak(count, i + 1)) {}
         return;
     }
-    
-    // safe to call this, we have the epoch lock and epoch_state is definitely 0
-    garbageCollectAndChangeEpoch();
-    
-    epochMutex.unlock();
+    std::cerr << "Error: More than " << MAX_PQ_THREADS << " threads are "
+              << "using LockFreePQ. Increase MAX_PQ_THREADS.\n";
+    abort();
 }
 
 template <class K, class V, class Compare>
 void
-LockFreePQ<K, V, Compare>::garbageCollectAndChangeEpoch() {    
-    
-    assert(!epochMutex.try_lock()); // must be the only thread to run this method
-    assert(thread_epoch_state->load() == 0); // must be ready for new epoch
-    
-    int n = 0; // debug
-    
-    // First, garbage collect the waiting nodes
-    for (auto it = waitingDeallocs->begin(); it != waitingDeallocs->end(); it++) {
-        free(*it);
-        n++;
+LockFreePQ<K, V, Compare>::ThreadState::reclaim(std::vector<Node_t*>& nodes) {
+    pending -= nodes.size();
+    for (Node_t* n : nodes) {
+        if (pool.size() < NODE_POOL_SIZE) {
+            pool.push_back(n);
+        } else {
+            delete n;
+        }
     }
-    waitingDeallocs->clear();
-    
-    // Swap pointer for pendingDeallocs with waitingDeallocs (which is now
-    // empty) to trigger the start of the new epoch. Nodes that were in
-    // pendingDeallocs are now waiting for this epoch to end
-    // This is the critical moment at which the new epoch technically starts
-    freeMutex.lock(); // hold threads from deleting nodes until after swap
-    pendingDeallocs->swap(*waitingDeallocs);
-    freeMutex.unlock();
-    
-    // Threads probably exited and entered after the swap above happened, but
-    // we only care that all threads that were active at the moment we switched
-    // dealloc pointers exit at least once before we change epochs again. As
-    // a result, switching the epoch state now (after switching the pointers)
-    // guarantees that any thread that was active at the moment we switched
-    // will have exited once this epoch_state gets set to 0.
-    thread_epoch_state->store(thread_curr_state->load());
-    
-//    std::cout << "finished epoch, deleted " << n 
-//    << " cur state: " << thread_curr_state->load() << std::endl;
-    
+    nodes.clear();
 }
 
 template <class K, class V, class Compare>
-void
-LockFreePQ<K, V, Compare>::finalizeDeallocs() {    
-    // threads must not be active when this is called
-    assert(thread_curr_state->load()  == 0);
-    thread_curr_state->store(0); // todo(deperomm):this shouldn't need to be set
-    
-    // with no active threads, switching epochs twice will clear and garbage
-    // collect all dealloc queues
-    epochMutex.lock(); // prevents assert from throwing, serves no other purpose
-    garbageCollectAndChangeEpoch();
-    garbageCollectAndChangeEpoch();
-    epochMutex.unlock();
-    
-    delete thread_curr_state;
-    delete thread_epoch_state;
-    delete pendingDeallocs;
-    delete waitingDeallocs;
-    delete lastId;
-    
+LockFreePQ<K, V, Compare>::ThreadState::~ThreadState() {
+    if (slot != -1) {
+        // Wait for other threads to leave critical sections in which they
+        // may have accessed nodes retired by this thread. Threads that are
+        // not in critical sections do not hold up the epoch.
+        const size_t safeEpoch = epoch + 2;
+        while ((pending > 0) &&
+               (globalEpoch.load(std::memory_order_acquire) < safeEpoch)) {
+            tryAdvanceEpoch();
+            std::this_thread::yield();
+        }
+        for (std::vector<Node_t*>& nodes : retired) {
+            reclaim(nodes);
+        }
+        // Let another thread use this slot
+        slots[slot].claimed.store(false, std::memory_order_release);
+    }
+    for (Node_t* n : pool) {
+        delete n;
+    }
 }
 
 template <class K, class V, class Compare>
@@ -738,105 +757,3 @@ LockFreePQ<K, V, Compare>::print() {
     }
     
 }
-
-/* without deleteEntry validation */
-//void test(LockFreePQ *pq, std::vector<double> vals) {
-//    double out = 0;
-//    double in = 0;
-//    double x;
-//    for (size_t i = 0; i < vals.size(); i++) {
-//        x = vals[i];
-//        in += x;
-//        int *val = new int(x);
-//        pq->insert(x, (void *)val);
-//        val = (int *)pq->deleteMin();
-//        out += *val;
-//        delete  val;
-//    }
-//    std::cout << "Inserted: " << (long)in << " Got: " << (long)out << " Difference: " << ((long)in - (long)out) << std::endl;
-//}
-
-/* with delete entry validation */
-//void test(LockFreePQ<int, int*> *pq, std::vector<int> vals) {
-//    long out = 0;
-//    long in = 0;
-//    int x;
-//    for (size_t i = 0; (i+1) < vals.size(); i+=2) {
-//        x = vals[i];
-//        in += x;
-//        int *val = new int(x);
-//        pq->insert(x, val);
-//        val = pq->deleteEntry(x);
-//        if (val != NULL) {
-//            out += *val;
-//            delete  val;
-////            std::cout << "O "; // debug print if value was found
-//        } else {
-//            val = pq->deleteMin();
-//            out += *val;
-//            delete  val;
-////            std::cout << "XXXX "; // debug print if value was not found
-//        }
-//        x = vals[i+1];
-//        in += x;
-//        val = new int(x);
-//        pq->insert(x, val);
-//        val = pq->deleteMin();
-//        out += *val;
-//        delete  val;
-//    }
-//    std::cout << "Inserted: " << (long)in << " Got: " << (long)out << " Difference: " << ((long)in - (long)out) << std::endl;
-//}
-//
-//int main(int argc, char** argv) {
-//    
-//    LockFreePQ<int, int*> *pq = new LockFreePQ<int, int*>;
-//    
-//    std::vector<std::thread> threads;
-//    if (argc < 2) {
-//        std::cout << "Queue Test Usage: ./queue_test num_threads (num_vals)" << std::endl;
-//        abort();
-//    }
-//    size_t n = atoi(argv[1]);
-//    size_t k;
-//    if (argc > 2) {
-//        k = atoi(argv[2]);
-//    } else {
-//        k = 200000;
-//    }
-//    
-//    std::vector<std::vector<int>> vals(n);
-//    
-//    // generate large list of unique numbers for each thread
-//    for (size_t i = 0; i < n; i++) {
-//        for (size_t x = 1; x < k/n; x++) {
-//            vals[i].push_back(x*n+i);
-//        }
-//    }
-//    // shuffle the list
-//    for (size_t i = 0; i < n; i++) {
-//        std::random_shuffle(vals[i].begin(), vals[i].end());
-//    }
-//    
-//    std::cout << "Starting" << std::endl;
-//    auto start = std::chrono::high_resolution_clock::now();
-//    
-//    // spin of threads that constantly enqueue and dequeue, max contention
-//    // possible on the queue
-//    for (size_t i = 0; i < n; i++) {
-//        threads.push_back(std::thread(test, pq, vals[i]));
-//    }
-//    
-//    for (size_t i = 0; i < n; i++) {
-//        threads[i].join();
-//    }
-//    
-//    auto finish = std::chrono::high_resolution_clock::now();
-//    std::cout << "Done. Differences printed above should sum to 0" << std::endl;
-//    
-//    std::chrono::duration<double> elapsed = finish - start;
-//    std::cout << "Elapsed time: ~" << elapsed.count() << " s" << std::endl;
-//    
-//    delete pq;
-//    
-//}
@@ -0,0 +1,175 @@
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@muohio.edu
+//
+//---------------------------------------------------------------------------
+
+// A stand-alone stress benchmark for LockFreePQ.  It is not part of
+// libmuse but is built (as noinst_PROGRAMS) along with it.  To build
+// just the benchmark, from the kernel directory use:
+//
+// make lfpq_stress
+//
+// Usage: ./lfpq_stress [#values-per-thread] [max-threads] [#repetitions]
+//
+// For 2, 4, 8, ... up to max-threads (default: 64) threads, each
+// thread repeatedly inserts unique keys and removes entries via a
+// mix of deleteMin and deleteEntry, with maximum contention on the
+// queue.  The sum of keys removed (plus those left in the queue) must
+// equal the sum of keys inserted.  Throughput, and the number of
+// failed runs, are reported for each thread count.
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "mpi-mt-shm/LockFreePQ.h"
+
+// The queue type used by the benchmark
+typedef LockFreePQ<long, long*> StressPQ;
+
+// The sentinel keys for the queue
+template<> long StressPQ::keyMin         = -1;
+template<> long StressPQ::keyMax         = LONG_MAX;
+template<> long StressPQ::keyMaxMinusOne = LONG_MAX - 1;
+
+/**
+ * The operations performed by each thread
+ *
+ * Each value is inserted and then either the same key is deleted via
+ * deleteEntry (every 4th value) or the minimum entry is removed via
+ * deleteMin.  Every 8th value is left in the queue so that the queue
+ * does not remain empty.
+ *
+ * @param pq      - the queue shared by all the threads
+ * @param keys    - the unique keys to be inserted by this thread
+ * @param values  - the values associated with the keys
+ * @param in      - sum of keys inserted by this thread
+ * @param out     - sum of keys removed by this thread
+ */
+void stress(StressPQ *pq, const std::vector<long>& keys, long *values,
+            long& in, long& out) {
+    in = out = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        const long key = keys[i];
+        in += key;
+        long *dup = pq->insert(key, values + key);
+        assert(dup == NULL);
+        (void) dup;
+        if (i % 8 == 7) {
+            continue;  // leave this key in the queue
+        }
+        long *val = (i % 4 == 0) ? pq->deleteEntry(key) : NULL;
+        if (val == NULL) {
+            // Either deleteMin was intended or another thread
+            // removed our key first.
+            val = pq->deleteMin();
+        }
+        if (val != NULL) {
+            out += *val;
+        }
+    }
+}
+
+/**
+ * Runs the benchmark with a given number of threads
+ *
+ * @param numThreads - the number of concurrent threads
+ * @param perThread  - the number of keys inserted by each thread
+ * @param values     - the values for all keys
+ * @param seconds    - set to the elapsed time
+ *
+ * @return true if the sums of keys inserted and removed match
+ */
+bool run(const int numThreads, const long perThread, long *values,
+         double& seconds) {
+    // Generate unique, shuffled keys for each thread
+    std::vector<std::vector<long>> keys(numThreads);
+    std::mt19937 rng(numThreads);
+    for (int t = 0; t < numThreads; t++) {
+        for (long x = 0; x < perThread; x++) {
+            keys[t].push_back(x * numThreads + t);
+        }
+        std::shuffle(keys[t].begin(), keys[t].end(), rng);
+    }
+    std::vector<long> in(numThreads), out(numThreads);
+    StressPQ *pq = new StressPQ;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.push_back(std::thread(stress, pq, std::cref(keys[t]),
+                                      values, std::ref(in[t]),
+                                      std::ref(out[t])));
+    }
+    for (std::thread& thr : threads) {
+        thr.join();
+    }
+    const auto finish = std::chrono::high_resolution_clock::now();
+    seconds = std::chrono::duration<double>(finish - start).count();
+
+    // Drain the remaining entries and validate
+    long totalIn = 0, totalOut = 0;
+    for (int t = 0; t < numThreads; t++) {
+        totalIn  += in[t];
+        totalOut += out[t];
+    }
+    for (long *val = pq->deleteMin(); val != NULL; val = pq->deleteMin()) {
+        totalOut += *val;
+    }
+    delete pq;
+    if (totalIn != totalOut) {
+        std::cerr << "Error: With " << numThreads << " threads, inserted "
+                  << totalIn << " but removed " << totalOut << std::endl;
+    }
+    return (totalIn == totalOut);
+}
+
+int main(int argc, char** argv) {
+    const long perThread  = (argc > 1) ? atol(argv[1]) : 100000;
+    const int  maxThreads = (argc > 2) ? atoi(argv[2]) : 64;
+    const int  reps       = (argc > 3) ? atoi(argv[3]) : 3;
+    if ((perThread < 1) || (maxThreads < 2) || (reps < 1)) {
+        std::cerr << "Usage: " << argv[0] << " [#values-per-thread] "
+                  << "[max-threads >= 2] [#repetitions]\n";
+        return 1;
+    }
+    // The values (the key itself) referred to by entries in the queue
+    std::vector<long> values(perThread * maxThreads);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = i;
+    }
+    std::cout << "#Threads  #Ops/thread  Best time (s)  Mops/s  #Failed\n";
+    int failures = 0;
+    for (int numThreads = 2; numThreads <= maxThreads; numThreads *= 2) {
+        double best = -1;
+        int failed  = 0;
+        for (int r = 0; r < reps; r++) {
+            double seconds = 0;
+            failed += (run(numThreads, perThread, values.data(),
+                           seconds) ? 0 : 1);
+            best    = (best < 0) ? seconds : std::min(best, seconds);
+        }
+        // Each key is inserted and most are removed.  Count both.
+        const double ops = 2.0 * perThread * numThreads;
+        std::cout << numThreads << "\t  " << perThread << "\t       "
+                  << best << "\t      " << (ops / best / 1e6) << "\t  "
+                  << failed << std::endl;
+        failures += failed;
+    }
+    return (failures == 0) ? 0 : 2;
+}
@@ -23,12 +23,14 @@
 //---------------------------------------------------------------------------
 
 #include "mpi-mt-shm/MultiThreadedScheduler.h"
-#include <thread>
+#include "EventAdapter.h"
+#include "EventRecycler.h"
+#include "Agent.h"
 
 BEGIN_NAMESPACE(muse)
 
-MultiThreadedScheduler::MultiThreadedScheduler() {
-	std::cout << "Made an MT Scheduler" << std::endl;
+MultiThreadedScheduler::MultiThreadedScheduler() : mtAgentPQ(NULL) {
+    // Nothing else to be done.
 }
 
 MultiThreadedScheduler::~MultiThreadedScheduler() {}
@@ -44,14 +46,14 @@ MultiThreadedScheduler::initialize(int rank, int numProcesses, int& argc,
         {"--scheduler-queue",
          "Queue (3tSkipMT) to be used by multi threaded scheduler",
          &queueName, ArgParser::STRING},
+        {"--time-window", "Time window for scheduler to control optimism",
+         &timeWindow, ArgParser::DOUBLE},
         {"", "", NULL, ArgParser::INVALID}
     };
     // Use the argument parser to parse command-line arguments and
     // update local variables
     ArgParser ap(arg_list);
     ap.parseArguments(argc, argv, false);
-    // Set MaxRungs to be the same for 2tLadderQ as well
-    TwoTierLadderQueue::MaxRungs = LadderQueue::MaxRungs;
     // Create a queue based on the name specified.
     if (queueName == "3tSkipMT") {
         // set both priority queues here with the same reference.
@@ -63,61 +65,33 @@ MultiThreadedScheduler::initialize(int rank, int numProcesses, int& argc,
                   << "Aborting.\n";
         std::abort();  // throw an exception instead?
     }
-    
+    // Note: The base class initialize is not called as it would
+    // replace agentPQ with a single-threaded queue.
     ASSERT(mtAgentPQ == agentPQ);
-    
-    Scheduler::initialize(rank, numProcesses, argc, argv);
 }
 
 bool
 MultiThreadedScheduler::processNextAgentEvents(Time& simLGVT) {
-    
-    // === Dequeue next event set in thread safe way ===
-    
     // This removes the agent from the priority queue, preventing any
     // other thread from dequeuing events on it
     muse::Agent *agent = mtAgentPQ->popNextAgent();
+    if (agent == NULL) {
+        // All agents are currently being processed by other threads.
+        // So this thread does not have any events to process.
+        simLGVT = TIME_INFINITY;
+        return false;
+    }
     // ******** THE ABOVE AGENT MUST BE PUT BACK BEFORE EXITING METHOD *********
-    // (deperomm): bad practice above, need to fix, how?
-    
-    // this should only happen if all agents are popped
-    // not enough agents in this sim for the number of threads being used?
-    ASSERT(agent != NULL); 
     
     // Have the next agent (with lowest receive timestamp events) to
     // process its batch of events.
-    // Do this in one method call so as to avoid race conditions
     mtAgentPQ->dequeueNextEvents(agent, agentEvents);
     
-    // todo(deperomm): anti message support
-    // if we dequeue an anti message, we have no choice but to ignore it for
-    // now. Anti-messages are time sensitive, and must be handled immediately
-    // upon being received in order to clean the queue of invalid events before
-    // future valid events can be added, otherwise we have no way to
-    // differentiate between events that came before or after the anti message
-    // The solution to this would be to implement an epoch system where events
-    // include an epoch num, and anti messages can includes a new epoch number
-    // such that only events before that epoch would be invalid, so we know
-    // which future events to delete when we dequeue an anti message
-    size_t index = 0;
-    while (!agentEvents.empty() && (index < agentEvents.size())) {
-        Event* const evt = agentEvents[index];
-        ASSERT(evt != NULL);
-        // (deperomm): also assert that all events are valid and same time?
-        if (evt->isAntiMessage()) {
-            // Clean-up any pending future events (from the sender of the
-            // anti-message) in the scheduler's queue.
-//            handleFutureAntiMessage(e, agent); // this needs an epoch to work
-            
-            // (deperomm): for now, just delete the anti messages...
-            agentEvents[index] = agentEvents.back();
-            agentEvents.pop_back();
-//            std::cout << "Agent " << agent->getAgentID() << " ignored anti message" << std::endl;
-        } else {
-            index++;
-        }
-    }
-
+    // Anti-messages are handled first.  Rollback epochs in events
+    // (see EventAdapter::isCanceledBy) enable distinguishing events
+    // canceled by an anti-message from events that were resent
+    // after the corresponding rollback.
+    const bool rolledBack = handleAntiMessages(agent);
     
     // If the event queue is empty, do no further operations.
     if (agentEvents.empty()) {
@@ -125,15 +99,14 @@ MultiThreadedScheduler::processNextAgentEvents(Time& simLGVT) {
         simLGVT = TIME_INFINITY;
         // put the agent back
         mtAgentPQ->pushAgent(agent);
-        return false;
+        return rolledBack;
     }
     // Get the first of next batch of events to be scheduled.
     const muse::Event* const front = agentEvents.front();
     ASSERT(front != NULL);
-    ASSERT(EventRecycler::getInputRefCount(front) < 2);
     
     // simLGVT is the time of the top agent
-    simLGVT = agentEvents.front()->getReceiveTime()
+    simLGVT = front->getReceiveTime();
     
     // === Process similar to Scheduler::processNextAgentEvents()
     
@@ -141,29 +114,26 @@ MultiThreadedScheduler::processNextAgentEvents(Time& simLGVT) {
                     << std::endl);
     
     // Since we're running concurrently, check for rollbacks on dequeue
-    if(checkAndHandleRollback(front, agent)) {
+    if (rolledBack || checkAndHandleRollback(front, agent)) {
         // put the events we pulled out back since we needed to roll back and
         // time priority has changed
-        agentPQ->enqueue(agent, agentEvents);
+        mtAgentPQ->enqueue(agent, agentEvents);
         // put the agent back
         mtAgentPQ->pushAgent(agent);
-        // pretend like we processed events so the sim doesn't think we're
-        // out of events to process 
-        // (deperomm): hacky solution, but not worth the rework to change
-        // how return is handled
+        // Report events as processed as rollback was processed.
         return true;
     }
     
     // Check if the next lowest time-stamp event falls within time
     // window with respect to GVT.  If not, do not process events.
     if ((timeWindow > muse::Time(0)) && !withinTimeWindow(agent, front)) {
-        // (deperomm) Doesn't this result in lost events? sholdn't agentEvents be rescheduled and the container cleared?
-        // put agent back
+        // put the events and agent back for processing later on.
+        mtAgentPQ->enqueue(agent, agentEvents);
         mtAgentPQ->pushAgent(agent);
         return false;  // No events to schedule.
     }
     
-    // Let the agent process its events and then release its lock
+    // Let the agent process its events
     agent->processNextEvents(agentEvents);
     
     // put the agent back now that we're done with it
@@ -174,31 +144,81 @@ MultiThreadedScheduler::processNextAgentEvents(Time& simLGVT) {
     return true;
 }
 
+bool
+MultiThreadedScheduler::handleAntiMessages(muse::Agent* agent) {
+    bool rolledBack = false;
+    size_t index = 0;
+    while (index < agentEvents.size()) {
+        Event* const anti = agentEvents[index];
+        ASSERT(anti != NULL);
+        if (!anti->isAntiMessage()) {
+            index++;  // Regular events are processed later.
+            continue;
+        }
+        DEBUG(std::cout << "*Cancelling due to: " << *anti << std::endl);
+        // Remove the anti-message from the batch.
+        agentEvents[index] = agentEvents.back();
+        agentEvents.pop_back();
+        // Rollback (if needed) to undo processed events that have
+        // been canceled.
+        rolledBack |= checkAndHandleRollback(anti, agent);
+        // Clean-up pending canceled events in the scheduler's queue
+        mtAgentPQ->eraseAfter(agent, anti);
+        // Clean-up canceled events in the current batch.
+        for (size_t i = 0; (i < agentEvents.size());) {
+            Event* const evt = agentEvents[i];
+            if (!evt->isAntiMessage() && EventAdapter::isCanceledBy(evt, anti)) {
+                EventRecycler::decreaseInputRefCount(true, evt);
+                agentEvents[i] = agentEvents.back();
+                agentEvents.pop_back();
+            } else {
+                i++;
+            }
+        }
+        // The anti-message is no longer needed.
+        EventRecycler::decreaseInputRefCount(true, anti);
+        // Entries in the batch have been reordered. So start over.
+        index = 0;
+    }
+    return rolledBack;
+}
+
 bool
 MultiThreadedScheduler::scheduleEvent(Event* e) {
     // Make sure the recevier agent has an entry
     const AgentID agent_id = e->getReceiverAgentID();
-    AgentIDAgentPointerMap::iterator entry = agentMap.find(agent_id);
-    Agent* const agent = (entry != agentMap.end()) ? entry->second : NULL;
+    const AgentDirectory::Entry* const entry = agentDir->find(agent_id);
+    Agent* const agent = (entry != NULL) ? entry->agent : NULL;
     
     if (agent == NULL) {
         std::cerr << "Trying to schedule (" << *e <<") to unknown agent\n";
-        std::cerr << "Available agents are: \n";
-        AgentIDAgentPointerMap::iterator it = agentMap.begin();
-        for (; it!=agentMap.end(); it++) {
-            std::cerr << *(it->second) << std::endl;
-        }
         std::cerr << "Trying to schedule to local agent "
                   << "that doesn't exist" << std::endl;
         abort();
     }
-
+    // Rollbacks and anti-messages cannot be handled here as the
+    // receiving agent may be concurrently processing events on
+    // another thread.  Instead they are handled when the event is
+    // dequeued (see processNextAgentEvents).
     // Actually add the event (enqueue indirectly increments reference count)
-    agentPQ->enqueue(agent, e);
+    mtAgentPQ->enqueue(agent, e);
     // Event has been enqueued.
     return true;
 }
 
+Time
+MultiThreadedScheduler::getNextEventTime() const {
+    return mtAgentPQ->getNextEventTime();
+}
+
+void
+MultiThreadedScheduler::garbageCollect(const Time& gvt) {
+    UNUSED_PARAM(gvt);
+    // No threads are operating on the queue at this time.  So tier2
+    // entries retired by threads can be safely reused.
+    mtAgentPQ->recycleRetiredEntries();
+}
+
 END_NAMESPACE(muse)
 
 #endif
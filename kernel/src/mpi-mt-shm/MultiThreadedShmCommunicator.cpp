@@ -28,6 +28,7 @@
 #include "GVTMessage.h"
 #include "DataTypes.h"
 #include "Event.h"
+#include "EventAdapter.h"
 #include "Agent.h"
 
 using namespace muse;
@@ -93,28 +94,11 @@ MultiThreadedShmCommunicator::sendMessage(const GVTMessage *msg,
     ASSERT(msg != NULL);
     ASSERT(msg->getSenderAgentID() == -1);
     ASSERT(msg->getReceiverAgentID() == -destRank);
-    
-    // First check if this message needs to go another thread on the
-    // same node.
-    const unsigned int rank = destRank / threadsPerNode;
-    if (rank == myMPIrank) {
-        // This message must go to next logical thread.  Since it is
-        // going across thread boundaries, a copy needs to be made.
-        // Set destination rank as negative value to help reciever
-        // (see MultiThreadedSimulationManager::processMpiMsgs) to
-        // detect & route message to appropriate thread
-        GVTMessage* copy = GVTMessage::create(msg, -destRank,
-                                              destRank % threadsPerNode);
-        // simMgr->processIncomingEvent(copy); // Matt: This shouldn't happen, should be handled by the MTSimulation level, intentionally results in error as method is protected, part of event managemetn rework
-    } else {
-        // Msg needs to be sent to a remote thread.
-        // Let the base class dispatch it over MPI in a MT-safe
-        // operations.
-        // todo(deperomm): This lock seems like it could be a big bottleneck in
-        // multi threaded sims as every remote event must lock to send via mpi?
-        std::lock_guard<std::mutex> lock(mpiMutex);  // Ensure MT-safe
-        Communicator::sendMessage(msg, rank);
-    }
+    // All threads on a process share one GVT manager.  Hence GVT
+    // messages are always exchanged between processes.
+    ASSERT(destRank != (int) myMPIrank);
+    std::lock_guard<std::mutex> lock(mpiMutex);  // Ensure MT-safe
+    Communicator::sendMessage(msg, destRank);
 }
 
 void
@@ -145,43 +129,25 @@ MultiThreadedShmCommunicator::receiveEvent() {
 
 Event*
 MultiThreadedShmCommunicator::receiveOneEvent() {
-    // Now proceed with MPI operations
-    MPI_STATUS status;
-    try {
-        if (!MPI_IPROBE(MPI_ANY_SOURCE, MPI_ANY_TAG, status)) {
-            // No pending event.
-            return NULL;
-        }
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (receiveEvent): ";
-        std::cerr << e.Get_error_string() << std::endl;
-        return NULL;
+    // Let the transport (MPI, RMA, or shm) read the next message.
+    char* incoming_event = NULL;
+    int eventSize = 0, tag = -1, srcRank = -1;
+    if (!transport->receive(incoming_event, eventSize, tag, srcRank)) {
+        return NULL;  // No pending event.
     }
-    // Figure out the agent list size
-    int eventSize = MPI_GET_COUNT(status, MPI_TYPE_CHAR);
-    // Note we pass -1 to allocate event on this_thread's NUMA node.
-    char *incoming_event = Event::allocate(eventSize, -1);
-    ASSERT( incoming_event != NULL );
-    // Read the actual data.
-    try {
-        MPI_RECV(incoming_event, eventSize, MPI_TYPE_CHAR,
-                 status.MPI_SOURCE, status.MPI_TAG, status);
-    } catch (CONST_EXP MPI_EXCEPTION& e) {
-        std::cerr << "MPI ERROR (receiveEvent): ";
-        std::cerr << e.Get_error_string() << std::endl;
-        delete[] incoming_event;
-        return NULL;
-    }    
     // The logic of how incoming messages are handled here is
     // different than the base class implementation.
-    ASSERT((status.MPI_TAG == EVENT) || (status.MPI_TAG == GVT_MESSAGE));
+    ASSERT((tag == EVENT) || (tag == LARGE_EVENT) || (tag == GVT_MESSAGE));
     // Type cast does the trick as events are binary blobs
     Event* the_event = reinterpret_cast<Event*>(incoming_event);
-    // Since the event is from the network, the reference count must be 1
-    ASSERT(the_event->getReferenceCount() == 1);
+    if (tag != GVT_MESSAGE) {
+        // The sender may hold extra references on in-flight events.
+        // So reset reference count on our copy.
+        EventAdapter::setReferenceCount(the_event, 1);
+    }
     // Rest of the logic associated with GVT manager inspecting events
     // etc. is done in the MultiThreadedShmSimulation's
-    // processIncomingEvents() method instead of here.
+    // processMpiMsgs() method instead of here.
     return the_event;
 }
 
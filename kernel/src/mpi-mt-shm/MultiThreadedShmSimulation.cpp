@@ -35,7 +35,6 @@
 #include "EventAdapter.h"
 #include "EventRecycler.h"
 #include "StateRecycler.h"
-#include "mpi-mt/RedistributionMessage.h"
 
 // Switch to muse namespace to streamline code
 using namespace muse;
@@ -47,6 +46,16 @@ SpinLockThreadBarrier MultiThreadedShmSimulation::threadBarrier;
 // Shared mutex lock to allow thread safe pulling of mpi events from the wire
 std::mutex MultiThreadedShmSimulation::mpiMutex;
 
+// Shared lock used to quiesce all the threads for GVT operations
+SharedSpinLock MultiThreadedShmSimulation::simLock;
+
+// Shared mutex to serialize sending events to remote processes
+std::mutex MultiThreadedShmSimulation::gvtMutex;
+
+// GVT messages read from MPI that are yet to be processed by thread #0
+std::vector<GVTMessage*> MultiThreadedShmSimulation::gvtMsgs;
+std::atomic<bool> MultiThreadedShmSimulation::haveGVTMsgs(false);
+
 // The static/shared list of NUMA-node IDs for each thread.  This list
 // is static and is shared by multiple threads.  Entries are added by
 // the derived class, in MultiThreadedSimulationManager::createThreads
@@ -57,21 +66,14 @@ MultiThreadedShmSimulation::MultiThreadedShmSimulation(MultiThreadedShmSimulatio
     Simulation(usingSharedEvents), threadsPerNode(threadsPerNode),
     threadID(thrID), mtCommMgr(NULL),
     simMgr(mgr), mainPendingDeallocs(EventRecycler::pendingDeallocs),
-    cpuID(cpuID)
+    cpuID(cpuID), mainSlabs(EventRecycler::slabs)
 #if USE_NUMA == 1
-    , mainNumaManager(EventRecycler::numaMemMgr),
-    mainStateRecycler(StateRecycler::numaMemMgr)
+    , mainStateRecycler(StateRecycler::numaMemMgr)
 #endif
 {
     ASSERT(mgr != NULL);
     ASSERT(threadsPerNode > 0);
     ASSERT(thrID >= 0);
-    // Initialize counters used to dynamically adapt number of calls
-    // to processPendingDeallocs() method from garbageCollect() method
-    // in this class to keep simulations fast.
-    deallocThresh  = 0.1;
-    deallocRate    = 1;
-    deallocTicker  = deallocRate;
     // Nothing much to be done for now as base class does all the
     // necessary work.
 }
@@ -105,23 +107,32 @@ MultiThreadedShmSimulation::setMTScheduler(MultiThreadedScheduler* sch) {
 }
 
 void
-MultiThreadedShmSimulation::setGVTManager(GVTManager* gvtMan) {
+MultiThreadedShmSimulation::setGVTManager(GVTManagerBase* gvtMan) {
     gvtManager = gvtMan;
-    gvtManager->addMTSimKernel(this);
 }
 
 void
 MultiThreadedShmSimulation:: initialize(int& argc, char* argv[], bool initMPI) {
     UNUSED_PARAM(initMPI);
-    // Consume any specific command-line arguments used to setup and
-    // configure other components like the scheduler and GVT manager.
-    parseCommandLineArgs(argc, argv);
-    // make sure parseCommandLineArgs doens't set scheduler for MT sims
-    ASSERT(scheduler == NULL);
+    if (threadID == 0) {
+        // Consume any specific command-line arguments used to setup
+        // and configure other components like the scheduler and GVT
+        // manager. The shared scheduler must have been set already.
+        ASSERT(scheduler != NULL);
+        parseCommandLineArgs(argc, argv);
+    } else {
+        // The communicator and scheduler are shared and have already
+        // been configured by thread #0.  So just copy the settings.
+        gvtDelayRate    = simMgr->gvtDelayRate;
+        maxMpiMsgThresh = simMgr->maxMpiMsgThresh;
+        mustSaveState   = simMgr->mustSaveState;
+    }
 }
 
 void
 MultiThreadedShmSimulation::finalize(bool stopMPI, bool delCommMgr) {
+    UNUSED_PARAM(stopMPI);
+    UNUSED_PARAM(delCommMgr);
     // Only thread specific finalizing operations gets done here
     
     // Both of these recyclers use thread_local storage, so clear them
@@ -131,7 +142,6 @@ MultiThreadedShmSimulation::finalize(bool stopMPI, bool delCommMgr) {
     // These are thread local, so ensure they are empty on each thread
     // This also ensures there aren't any events accidently left in an
     // agent event queue
-    ASSERT(EventRecycler::Recycler.empty()); 
     ASSERT(EventRecycler::pendingDeallocs.empty());
 }
 
@@ -216,6 +226,7 @@ MultiThreadedShmSimulation::simulate() {
     // Start the core simulation loop.
     LGVT         = startTime;
     int gvtTimer = gvtDelayRate;
+    Time lastGVT = getGVT();
     // The main simulation loop
     while (gvtManager->getGVT() < endTime) {
         // See if a stat dump has been requested
@@ -223,41 +234,63 @@ MultiThreadedShmSimulation::simulate() {
             dumpStats();
             doDumpStats = false;
         }
-        // This should only be done on thread 0 to avoid race conditions
-        if (threadID == 0) {
-            if (--gvtTimer == 0) {
-                gvtTimer = gvtDelayRate;
-                // Initate another round of GVT calculations if needed.
-                gvtManager->startGVTestimation();
+        // Reclaim shared events retired two epochs ago (if any)
+        if (doShareEvents) {
+            const double fracReclaimed = EventRecycler::announceEpoch();
+            if (fracReclaimed >= 0) {
+                deallocsPerCall += fracReclaimed;
             }
         }
+        // Read incoming messages and process events while holding
+        // the shared lock so that GVT operations can quiesce threads.
+        simLock.lock_shared();
         // Process a block of events received via the network
         // (eventually goes to derived manager class when
         // processMpiMsgs() method is called by the base class).
         checkProcessMpiMsgs();
         // Process the next event from the list of events managed by
         // the scheduler.
-        if (!processNextEvent()) {
+        const bool processed = processNextEvent();
+        simLock.unlock_shared();
+        if (!processed) {
             // We did not have any events to process. So check MPI
             // more frequently.
             mpiMsgCheckCounter = 1;
         }
+        const bool timerExpired = (--gvtTimer == 0);
+        if (timerExpired) {
+            gvtTimer = gvtDelayRate;
+        }
+        if (threadID == 0) {
+            // GVT operations are done only on thread 0 to avoid race
+            // conditions.  Garbage collection is also done here.
+            if (timerExpired || haveGVTMsgs.load(std::memory_order_relaxed)) {
+                runGVTtasks(timerExpired);
+            }
+        } else if (timerExpired && (lastGVT != getGVT())) {
+            // GVT has advanced. Reclaim events on this thread.
+            lastGVT = getGVT();
+            if (doShareEvents) {
+                reclaimPendingDeallocs();
+            }
+        }
     }
     // Wait for all the threads to finish by waiting on a barrier.
     threadBarrier.wait();  // Important: wait for threads to finish
 
 #if USE_NUMA == 1    
     // Save NUMA statistics to report later on before cleaning up.
-    numaStats = EventRecycler::numaMemMgr.getStats();
+    numaStats = EventRecycler::getStats();
 #endif
     
     // Add any pending events to the main thread's pending event list
     if (threadID != 0) {
         // This is not the main thread.
         EventRecycler::movePendingDeallocsTo(mainPendingDeallocs);
+        // Add slabs with events that are still in use to the main
+        // thread, as this thread's allocator is about to be destroyed
+        EventRecycler::slabs.moveSlabsTo(mainSlabs);
 #if USE_NUMA == 1
-        // Add NUMA pages to the main thread's pending event list
-        EventRecycler::numaMemMgr.moveNumaBlocksTo(mainNumaManager);
         // Add NUMA pages for state to the main thread
         StateRecycler::moveNumaBlocksTo(mainStateRecycler);
 #endif
@@ -278,8 +311,6 @@ MultiThreadedShmSimulation::processNextEvent() {
     bool ret = mtScheduler->processNextAgentEvents(LGVT);
     // Do sanity checks.
     if (LGVT < getGVT()) {
-        std::cout << "Offending event: "
-                  << *scheduler->agentPQ->front() << std::endl;
         std::cout << "LGVT = " << LGVT << " is below GVT: " << getGVT()
                   << " which is serious error. Scheduled agents: \n";
         std::cout << "Rank " << myID << " Aborting.\n";
@@ -290,29 +321,33 @@ MultiThreadedShmSimulation::processNextEvent() {
     return ret;    
 }
 
-//muse::Event*
-//MultiThreadedShmSimulation::cloneEvent(const muse::Event* src,
-//                                    const muse::AgentID receiver) const {
-//    ASSERT(src != NULL);
-//    ASSERT(receiver >= 0);
-//    // First suitably allocate memory for the copy
-//    const int evtSize = EventAdapter::getEventSize(src);    
-//    char* mem;  // Initialized in if-else below.
-//    if (EventRecycler::numaSetting == EventRecycler::NUMA_SENDER) {
-//        // Override default memory management and allocate event on
-//        // the receiver's NUMA node.
-//        mem = EventRecycler::allocateNuma(EventRecycler::NUMA_RECEIVER,
-//                                          evtSize, receiver);
-//    } else {
-//        // Use default memory management of Event.
-//        mem = Event::allocate(evtSize, receiver);
-//    }
-//    ASSERT( mem != NULL );
-//    muse::Event* const copy = reinterpret_cast<muse::Event*>(mem);
-//    std::memcpy(copy, src, evtSize);
-//    ASSERT(copy->getReferenceCount() > 0);
-//    return copy;
-//}
+void
+MultiThreadedShmSimulation::runGVTtasks(const bool startEstimation) {
+    ASSERT(threadID == 0);
+    // Wait for all other threads to finish their current operations.
+    simLock.lock();
+    // Process any GVT messages deferred by processMpiMsgs
+    if (haveGVTMsgs.load(std::memory_order_relaxed)) {
+        for (GVTMessage* msg : gvtMsgs) {
+            gvtManager->recvGVTMessage(msg);
+        }
+        gvtMsgs.clear();
+        haveGVTMsgs.store(false, std::memory_order_relaxed);
+    }
+    if (startEstimation) {
+        // Initate another round of GVT calculations if needed.
+        gvtManager->startGVTestimation();
+    }
+    // Note: Don't skip this step -- Let the GVT Manager forward any
+    // pending control messages, if needed
+    gvtManager->checkWaitingCtrlMsg();
+    simLock.unlock();
+}
+
+Time
+MultiThreadedShmSimulation::getLGVT() const {
+    return mtScheduler->getNextEventTime();
+}
 
 bool 
 MultiThreadedShmSimulation::scheduleEvent(Event* e) {
@@ -329,13 +364,14 @@ MultiThreadedShmSimulation::scheduleEvent(Event* e) {
         abort();
     }
     // check if event is on this process or a remote one
-    if (commManager->isAgentLocal(myID)) {
+    if (commManager->isAgentLocal(e->getReceiverAgentID())) {
         // Event is on this process
         return mtScheduler->scheduleEvent(e);
     } else {
-        // The destination thread is on a remote process and event
+        // The destination agent is on a remote process and event
         // does not need to be cloned.  However, it does need
         // inspection by GVT manager.
+        std::lock_guard<std::mutex> lock(gvtMutex);
         gvtManager->sendRemoteEvent(e);
     }
     return true;
@@ -343,58 +379,24 @@ MultiThreadedShmSimulation::scheduleEvent(Event* e) {
 
 void
 MultiThreadedShmSimulation::garbageCollect() {
-    // Garbage collect in same fashion as base class but lock the agents
-    // (since this is multi threaded and agents must be locked before modified)
-    const Time gvt = getGVT();
-    // First let the scheduler know it can garbage collect.
-    scheduler->garbageCollect(gvt);
-    for (AgentContainer::iterator it = allAgents.begin();
-            (it != allAgents.end()); it++) { 
-        (*it)->garbageCollect(gvt);
-    }
-    // Let listener know garbage collection for a given GVT value has
-    // been completed.
-    if (listener != NULL) {
-        listener->garbageCollectionDone(gvt);
-    }
-    
-    
-#if USE_NUMA == 1
-    // With NUMA we periodically need to redistribute events to avoid
-    // unconstrained memory growth (depending on communication patterns)
-    if (getGVT() != TIME_INFINITY) {
-        MultiThreadedShmSimulationManager* const mgr =
-            static_cast<MultiThreadedShmSimulationManager*>(simMgr);
-        EventRecycler::numaMemMgr.redistribute(threadsPerNode, threadID,
-                                               numaIDofThread[threadID], mgr);
-    }
-#endif
+    // This method is called (via the GVT manager) only while all the
+    // threads are quiesced.  So the base class can safely garbage
+    // collect the shared scheduler and agents.
+    Simulation::garbageCollect();
     // Rest of the logic is needed only when using shared events
-    if (!doShareEvents) {
-        return;  // Not using shared events. Nothing further to do.
-    }
-    // Now reclaim/recycle any pending events in an adaptive manner so
-    // that we make the most effective use of calls to this method.
-    if (--deallocTicker <= 0) {
-        // Time to call processPendingDeallocs()
-        const double fracReclaimed = EventRecycler::processPendingDeallocs();
-        deallocsPerCall    += fracReclaimed;  // Track to report stats at end
-        if (fracReclaimed < deallocThresh) {
-            // Call processPendingDeallocs() less frequently
-            deallocRate *= 2;
-            DEBUG(std::cout << "DeallocsRate increased to: " << deallocRate
-                            << " using " << fracReclaimed    << std::endl);
-        } else if (fracReclaimed > (deallocThresh * 1.5)) {
-            // Call processPendingDeallocs() more frequently            
-            deallocRate = std::max(1, deallocRate / 2);
-            DEBUG(std::cout << "DeallocsRate decreased to: " << deallocRate
-                            << " using " << fracReclaimed    << std::endl);
-        }
-        // Reset the deallocTicker
-        deallocTicker = deallocRate;
+    if (doShareEvents) {
+        reclaimPendingDeallocs();
     }
 }
 
+void
+MultiThreadedShmSimulation::reclaimPendingDeallocs() {
+    // Let the reclamation epoch advance once all threads have
+    // reached it.  Retired events are reclaimed by each thread when
+    // it announces the new epoch in its main loop.
+    EventRecycler::tryAdvanceEpoch();
+}
+
 void
 MultiThreadedShmSimulation::parseCommandLineArgs(int &argc, char* argv[]) {
     
@@ -424,6 +426,8 @@ MultiThreadedShmSimulation::processMpiMsgs() {
     // wire as we can. A good magic number is 100.  However this
     // number could be dynamically adapted depending on behavior of
     // the simulation.
+    // Events are enqueued while holding mpiMutex so that the order
+    // of events and their anti-messages is preserved.
     ASSERT(mpiEvents.empty());
     if (mtCommMgr->receiveManyEvents(mpiEvents, maxMpiMsgThresh) <= 0) {
             return 0;  // No events were obtained from MPI
@@ -431,25 +435,7 @@ MultiThreadedShmSimulation::processMpiMsgs() {
     // Process the incoming MPI events.
     for (Event* incoming_event : mpiEvents) {
         ASSERT(incoming_event->getReferenceCount() == 1);
-        // Enqueue the incoming event to the appropriate thread.
-        if (incoming_event->getSenderAgentID() == -1) {
-            // This must be a GVT message.
-            ASSERT(incoming_event->getReceiverAgentID() <= 0);
-            ASSERT(dynamic_cast<GVTMessage*>(incoming_event) != NULL);
-            processIncomingEvent(incoming_event);
-        }
-        else {
-            // Increment input reference counter for this event to
-            // balance decrement in MultiThreadedSimulation::
-            // processIncomingEvents() -- this is to balance
-            // expectation between locally-shared events versus events
-            // received over the wire
-            if (doShareEvents) {
-                EventRecycler::increaseInputRefCount(doShareEvents,
-                        incoming_event);
-            }
-            processIncomingEvent(incoming_event);
-        }
+        processIncomingEvent(incoming_event);
     }
     // Save events received over mpi to return
     const int msgCount = mpiEvents.size();
@@ -472,52 +458,31 @@ MultiThreadedShmSimulation::processIncomingEvent(Event* event) {
         ASSERT(dynamic_cast<GVTMessage*>(event) != NULL);
         GVTMessage *msg = static_cast<GVTMessage*>(event);
         ASSERT(msg != NULL);
-        gvtManager->recvGVTMessage(msg);
-    }
-    else if (event->getSenderAgentID() == REDISTR_MSG_SENDER) {
-#if USE_NUMA == 1
-    // This is a redistribution message to redistribute NUMA
-    // operations.
-    ASSERT(dynamic_cast<RedistributionMessage*>(event) != NULL);
-    RedistributionMessage *rdm =
-            static_cast<RedistributionMessage*>(event);
-    // Add entries to our thread-local recycler.
-    EventRecycler::numaMemMgr.redistribute(rdm);
-    // Get rid of this message
-    RedistributionMessage::destroy(rdm);
-#endif            
+        // GVT messages are processed by thread #0 (in runGVTtasks)
+        // only after all threads have been quiesced.
+        gvtMsgs.push_back(msg);
+        haveGVTMsgs.store(true, std::memory_order_relaxed);
     }
     else {
         // This is a regular event.  All incoming events must be
         // inspected by the GVT manager (for tracking GVT) prior
         // to further processing.
+        // The caller holds mpiMutex.  So inspection is serialized.
         gvtManager->inspectRemoteEvent(event);
-        scheduleEvent(event);
-        if (!doShareEvents) {
-            // Decrease the reference because if it was rejected,
-            // the event will be properly deleted. However, if it
-            // is in the eventPQ, it will be unharmed (reference
-            // count will actually be fixed to correct for lack of
-            // entry of this event in a output queue on this
-            // process)
-            ASSERT(EventRecycler::getReferenceCount(event) < 3);
-            EventRecycler::decreaseOutputRefCount(doShareEvents, event);
-        }
-        else {
-            // Decrease reference count to counter the temporary
-            // increase (see: MultiThreadedSimulation::
-            // scheduleEvent(Event* e)
-            EventRecycler::decreaseInputRefCount(doShareEvents, event);
-        }
+        mtScheduler->scheduleEvent(event);
+        // Events received over the wire are not in any output queue
+        // on this process.  So release the sender's reference that
+        // was setup by the communicator.  With shared events the
+        // event is deallocated (via pending deallocs) once the
+        // receiver releases it.
+        ASSERT(EventRecycler::getReferenceCount(event) < 3);
+        EventRecycler::decreaseOutputRefCount(doShareEvents, event);
     }
-    // Note: Don't skip this step -- Let the GVT Manager
-    // forward any pending control messages, if needed
-    gvtManager->checkWaitingCtrlMsg();
 }
 
 void
 MultiThreadedShmSimulation::reportLocalStatistics(std::ostream& os) {
-    os << "#Deallocs cleared/call : "   << deallocsPerCall
+    os << "#Reclaimed/epoch       : "   << deallocsPerCall
 //       << "\nAvg sharedQ size       : " << shrQevtCount
 //       << "\n#processing of sharedQ : " << shrQcheckCount
        << "\nCPU & Numa node used   : " << cpuID
@@ -33,6 +33,7 @@
 #include "mpi-mt-shm/MultiThreadedShmCommunicator.h"
 #include "GVTMessage.h"
 #include "ArgParser.h"
+#include "StateRecycler.h"
 #include "EventQueue.h"
 #include "Scheduler.h"
 
@@ -61,8 +62,6 @@ MultiThreadedShmSimulationManager::initialize(int& argc, char* argv[],
           &threadsPerNode, ArgParser::INTEGER},
         { "--use-shared-events", "Share events between threads on node",
           &doShareEvents, ArgParser::BOOLEAN},
-        { "--dealloc-thresh", "Desired % (0.01 to 1.0) of reclaiming shared-events",
-          &deallocThresh, ArgParser::DOUBLE},
 #ifdef USE_NUMA        
         {"--no-numa", "Disable use of NUMA-aware memory management",
          &noNuma, ArgParser::BOOLEAN},
@@ -74,58 +73,47 @@ MultiThreadedShmSimulationManager::initialize(int& argc, char* argv[],
     ArgParser ap(arg_list);
     ap.parseArguments(argc, argv, false);
     ASSERT( threadsPerNode > 0 );
-    if ((deallocThresh  <= 0) || (deallocThresh > 1.0)) {
-        std::cerr << "Invalid value for --dealloc-thresh. Value must be "
-            "> 0 and <= 1\n";
-        abort();
-    }
-    
-    doShareEvents = true; // For shared multi threading, always share events (remove later (deperomm))
     
+    // Threads share a scheduler and hence always share events.
+    doShareEvents = true;
     // Setup the global/static flag in EventQueue if we would like to
     // directly share events between threads.
     EventQueue::setUsingSharedEvents(doShareEvents);
     // Setup the NUMA mode of operation based on command-line arguments.
-    EventRecycler::NumaSetting numaMode = EventRecycler::NUMA_NONE;
-    if (!noNuma) {
-        // If NUMA is enabled, then setup default mode depending on
-        // whether we are sharing events or not.
-        numaMode = (doShareEvents ? EventRecycler::NUMA_RECEIVER :
-                    EventRecycler::NUMA_SENDER);
-        // Enable per-thread NUMA-aware memory manager for the main
-        // thread.
-#if USE_NUMA == 1
-        StateRecycler::setup(true, numa_preferred());
-#endif
-    }
-    // To repeatedly and consistently initialize each thread class,
-    // the command-line arguments are saved and restored.
-    std::vector<char*> cmdArgs(argv, argv + argc);
-    // First initialize & setup this sim class that runs as thread zero
-    MultiThreadedShmSimulation::initialize(argc, argv, initMPI);
+    // Events are shared between threads via a common scheduler and
+    // are not owned by any one thread.  Consequently, NUMA-aware
+    // memory management (which redistributes memory between threads)
+    // is not used -- EventRecycler::setupNUMA (which requires a
+    // MultiThreadedCommunicator) is not called and the recycler
+    // retains its default (EventRecycler::NUMA_NONE) setting.
+    UNUSED_PARAM(noNuma);
+    StateRecycler::setup(false, -1);
     // Next, initialize the communicator shared by multiple threads
     MultiThreadedShmCommunicator* mtc =
         new MultiThreadedShmCommunicator(this, threadsPerNode);
     // Let comm-manager use command-line arguments to configure itself.
     mtc->initialize(argc, argv, initMPI);
     // set comm-manager and process data for this sim thread
-    setCommManager(mtc); 
-    // Setup shared scheduler object
-    // TODO (deperomm): Have this be command args, generic, which mt scheduler?
+    setCommManager(mtc);
+    // Setup shared scheduler object.  It is configured (using
+    // command-line arguments) when the base class parses arguments.
     MultiThreadedScheduler* mts = new MultiThreadedScheduler();
-    mts->initialize(myID, numberOfProcesses, argc, argv);
     setMTScheduler(mts);
+    // To repeatedly and consistently initialize each thread class,
+    // the command-line arguments are saved and restored.
+    std::vector<char*> cmdArgs(argv, argv + argc);
+    // First initialize & setup this sim class that runs as thread zero
+    MultiThreadedShmSimulation::initialize(argc, argv, initMPI);
+    // Only the manager explicitly initializes parent class to hijack streams
+    Simulation::initialize(argc, argv, initMPI);
     // Now create the necessary number of threads and initialize them.
     // Initialize the barrier in MultiThreadedShmSimulation used for
     // coordinating the number of threads being used.
     threadBarrier.setThreadCount(threadsPerNode);
     // Create the necessary number of threads.
     createThreads(threadsPerNode, mtc, mts, cmdArgs);
-    // Finally, let the base-class perform generic initialization
-    // Only the manager explicitly initializes parent class to hijack streams
-    Simulation::initialize(argc, argv, initMPI);
-    // Enable/disable NUMA-aware memory management.
-    EventRecycler::setupNUMA(NULL, numaIDofThread, numaMode); // (deperomm) mt-mpi-shm does not use NUMA
+    // Setup epochs used to reclaim events shared between threads.
+    EventRecycler::setupEpochs(threadsPerNode);
 }
 
 void
@@ -155,23 +143,24 @@ MultiThreadedShmSimulationManager::createThreads(const int threadCount,
         MultiThreadedShmSimulation* tsm =
             new MultiThreadedShmSimulation(this, thrID, threadCount, 
 				                        doShareEvents, cpuNum);
+        // Setup shared comm-manager pointers and get proc data
+        tsm->setCommManager(mtc);
+        // Setup shared scheduler pointer
+        tsm->setMTScheduler(mts);
         // Setup command-line arguments from a copy to preserve original
         int argc = cmdArgs.size();
         std::vector<char*> cmdArgsCopy = cmdArgs;
         char** argv = cmdArgsCopy.data();
-	// Let the thread initialize itself based on parameters.
-	tsm->initialize(argc, argv, false);
+        // Let the thread initialize itself based on parameters.
+        tsm->initialize(argc, argv, false);
         // Setup NUMA node information for this thread/CPU.
         numaIDofThread[thrID] = getNumaNodeOfCpu(cpuNum);
-        // Setup shared comm-manager pointers and get proc data
-        tsm->setCommManager(mtc);
-        // Setup shared scheduler pointer
-        tsm->setMTScheduler(mts);
         // Add the newly created thread to the list
         threads.push_back(tsm);
     }
     for (int thr = 0; (thr < threadCount); thr++) {
-        std::cout << "Thread #" << thr << ": CPU=" << cpuList.at(thr)
+        std::cout << "Thread #" << thr << ": CPU="
+                  << cpuList.at(thr % cpuList.size())
                   << ", NUMA node: " << numaIDofThread.at(thr) << std::endl;
     }
 }
@@ -254,33 +243,10 @@ MultiThreadedShmSimulationManager::start() {
 
 void
 MultiThreadedShmSimulationManager::finalize(bool stopMPI, bool delCommMgr) {
-    // Inform the scheduler that the simulation is complete
-    scheduler->stop();
-    // Finalize all the agents on this process while accumulating stats
-    for (AgentContainer::iterator it = allAgents.begin();
-	 it != allAgents.end(); it++) {
-	Agent* const agent = *it;
-        agent->finalize();
-        agent->cleanStateQueue();
-        agent->cleanInputQueue();
-        // Don't clean output queue yet as we need stats from it.
-    }
-    // Report aggregate statistics from this kernel
-    reportStatistics(); 
-    
-    // Clean up all the agents
-    for (AgentContainer::iterator it = allAgents.begin();
-	 it != allAgents.end(); it++) {
-        Agent* const agent = *it;
-        agent->cleanOutputQueue();
-        ASSERT(agent->inputQueue.empty());
-        ASSERT(agent->outputQueue.empty());
-        // Remove agent from scheduler
-        scheduler->removeAgentFromScheduler(agent);
-        // Bye byte agent!
-        delete agent;
-    }
-    
+    // Agents, the GVT manager, the communicator, and the scheduler
+    // are shared by all the threads.  So the base class finalizes
+    // them just as in the single-threaded case.
+    Simulation::finalize(stopMPI, delCommMgr);
     // Now that agents are cleared, let all the threads finalize
     // Agents may hold leftover events in their queues, so must finalize
     // them first before the thread's recyclers can be finalized
@@ -288,43 +254,6 @@ MultiThreadedShmSimulationManager::finalize(bool stopMPI, bool delCommMgr) {
         threads[thrIdx]->finalize(false, false);
     }
     MultiThreadedShmSimulation::finalize(false, false);
-    
-    // This also ensures there aren't any events accidently left in an
-    // agent event queue
-    ASSERT(EventRecycler::pendingDeallocs.empty());
-    ASSERT(EventRecycler::Recycler.empty());
-
-    // Now delete GVT manager as we no longer need it.
-    commManager->setGVTManager(NULL);
-    delete gvtManager;
-    gvtManager = NULL;
-    
-    // Finalize the communicator 
-    commManager->finalize(stopMPI);
-    // Delete it if requested
-    if (delCommMgr) {
-        delete commManager;
-    }
-    commManager = NULL;
-
-    // Invalidate the  kernel ID
-    myID = -1u;
-
-    DEBUG({
-            if (logFile != NULL) {
-                // Un-hijack cout
-                std::cout.rdbuf(oldstream);
-                // Get rid of the log file.
-                delete logFile;
-                logFile = NULL;
-            }
-    });
-    // Get rid of scheduler as we no longer need it
-    delete scheduler;
-    scheduler = NULL;
-    // Clear out the list of agents in this simulation
-    allAgents.clear();
-
     // Finally, get rid of all the thread helper classes as they are no
     // longer needed.  The thread #0 will be deleted in
     // Simulation::finalizeSimulation() method if user requests it.
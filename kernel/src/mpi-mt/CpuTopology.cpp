@@ -0,0 +1,208 @@
+#ifndef MUSE_CPU_TOPOLOGY_CPP
+#define MUSE_CPU_TOPOLOGY_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <dirent.h>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include "mpi-mt/CpuTopology.h"
+
+// Switch to muse namespace to streamline code
+using namespace muse;
+
+// The directory in sysfs with information about each CPU
+static const std::string SysCpuDir = "/sys/devices/system/cpu/cpu";
+
+CpuTopology::CpuTopology(const std::vector<int>& cpuList) {
+    // Physical cores are identified by (package, core) pairs
+    std::map<std::pair<int, int>, int> coreIndex;
+    for (const int cpu : cpuList) {
+        const std::string dir = SysCpuDir + std::to_string(cpu);
+        CpuInfo info{cpu, -1, 0, 0, 0};
+        // Determine the physical core of the CPU.
+        const std::string pkg  = readLine(dir +
+                                          "/topology/physical_package_id");
+        const std::string core = readLine(dir + "/topology/core_id");
+        if (!core.empty()) {
+            const std::pair<int, int> key(pkg.empty() ? 0 : std::stoi(pkg),
+                                          std::stoi(core));
+            const auto entry = coreIndex.emplace(key, coreIndex.size());
+            info.core = entry.first->second;
+        } else {
+            // Each CPU is treated as a separate core.
+            info.core = coreIndex.size();
+            coreIndex.emplace(std::make_pair(-1, cpu), info.core);
+        }
+        // The position of this CPU among its SMT siblings.
+        const std::vector<int> sibs =
+            parseCpuList(readLine(dir + "/topology/thread_siblings_list"));
+        info.smt = std::count_if(sibs.begin(), sibs.end(),
+                                 [cpu](int sib) { return sib < cpu; });
+        // Find the lowest CPU sharing the L3 cache (if any).
+        info.l3 = (pkg.empty() ? 0 : std::stoi(pkg));
+        for (int idx = 0; (idx < 10); idx++) {
+            const std::string cache = dir + "/cache/index" +
+                std::to_string(idx);
+            const std::string level = readLine(cache + "/level");
+            if (level.empty()) {
+                break;  // No more cache levels.
+            }
+            if (level == "3") {
+                const std::vector<int> shared =
+                    parseCpuList(readLine(cache + "/shared_cpu_list"));
+                if (!shared.empty()) {
+                    info.l3 = *std::min_element(shared.begin(),
+                                                shared.end());
+                }
+            }
+        }
+        // The NUMA node is given by a nodeX entry in the directory.
+        if (DIR* const dp = opendir(dir.c_str())) {
+            while (const struct dirent* const de = readdir(dp)) {
+                const std::string name = de->d_name;
+                if ((name.size() > 4) && (name.compare(0, 4, "node") == 0) &&
+                    std::isdigit(name[4])) {
+                    info.numa = std::stoi(name.substr(4));
+                }
+            }
+            closedir(dp);
+        }
+        cpus.push_back(info);
+    }
+}
+
+bool
+CpuTopology::isValidPolicy(const std::string& policy) {
+    return ((policy == "linear") || (policy == "core") ||
+            (policy == "compact") || (policy == "scatter"));
+}
+
+std::vector<int>
+CpuTopology::getPlacement(const std::string& policy) const {
+    ASSERT(isValidPolicy(policy));
+    // The rank of each core within its L3 domain and the rank of each
+    // L3 domain within its NUMA node (used for scatter).
+    std::map<int, std::set<int>> coresOfL3, l3sOfNuma;
+    for (const CpuInfo& info : cpus) {
+        coresOfL3[info.l3].insert(info.core);
+        l3sOfNuma[info.numa].insert(info.l3);
+    }
+    auto rankOf = [](const std::set<int>& values, const int value) {
+        return (int) std::distance(values.begin(), values.find(value));
+    };
+    // Compute a sort key for each CPU based on the policy.
+    using Key = std::tuple<int, int, int, int, int, size_t>;
+    std::vector<std::pair<Key, int>> order;
+    for (size_t idx = 0; (idx < cpus.size()); idx++) {
+        const CpuInfo& info = cpus[idx];
+        Key key(0, 0, 0, 0, 0, idx);  // linear: affinity mask order
+        if (policy == "core") {
+            key = Key(info.smt, 0, 0, 0, 0, idx);
+        } else if (policy == "compact") {
+            key = Key(info.numa, info.l3, info.smt, info.core, 0, idx);
+        } else if (policy == "scatter") {
+            key = Key(info.smt, rankOf(coresOfL3[info.l3], info.core),
+                      rankOf(l3sOfNuma[info.numa], info.l3), info.numa,
+                      info.l3, idx);
+        }
+        order.push_back(std::make_pair(key, info.cpu));
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<int> cpuList;
+    for (const auto& entry : order) {
+        cpuList.push_back(entry.second);
+    }
+    return cpuList;
+}
+
+int
+CpuTopology::getDomain(const int cpu) const {
+    const bool useNuma = (countDistinct(&CpuInfo::numa) > 1);
+    for (const CpuInfo& info : cpus) {
+        if (info.cpu == cpu) {
+            return (useNuma ? info.numa : info.l3);
+        }
+    }
+    return 0;  // Unknown CPU
+}
+
+std::vector<int>
+CpuTopology::getSiblings(const int cpu) {
+    std::vector<int> sibs = parseCpuList(readLine(SysCpuDir +
+        std::to_string(cpu) + "/topology/thread_siblings_list"));
+    sibs.erase(std::remove(sibs.begin(), sibs.end(), cpu), sibs.end());
+    return sibs;
+}
+
+void
+CpuTopology::printSummary(std::ostream& os) const {
+    os << "CPU topology: " << cpus.size() << " CPUs, "
+       << countDistinct(&CpuInfo::core) << " cores, "
+       << countDistinct(&CpuInfo::l3)   << " L3 domains, "
+       << countDistinct(&CpuInfo::numa) << " NUMA nodes\n";
+}
+
+std::vector<int>
+CpuTopology::parseCpuList(const std::string& list) {
+    std::vector<int> cpuList;
+    std::istringstream is(list);
+    std::string entry;
+    // Each entry is of the form "0" or "0-3".
+    while (std::getline(is, entry, ',')) {
+        std::istringstream es(entry);
+        int first = -1, last = -1;
+        char dash;
+        if (!(es >> first)) {
+            continue;  // Empty or invalid entry.
+        }
+        last = ((es >> dash >> last) ? last : first);
+        for (int cpu = first; (cpu <= last); cpu++) {
+            cpuList.push_back(cpu);
+        }
+    }
+    return cpuList;
+}
+
+std::string
+CpuTopology::readLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+int
+CpuTopology::countDistinct(int CpuInfo::*field) const {
+    std::set<int> values;
+    for (const CpuInfo& info : cpus) {
+        values.insert(info.*field);
+    }
+    return values.size();
+}
+
+#endif
@@ -22,10 +22,13 @@
 //
 //---------------------------------------------------------------------------
 
+#include <cstring>
 #include "mpi-mt/MultiThreadedCommunicator.h"
 #include "mpi-mt/MultiThreadedSimulationManager.h"
+#include "mpi-mt/SpscRingMTQueue.h"
 #include "GVTManager.h"
 #include "GVTMessage.h"
+#include "EventAdapter.h"
 #include "DataTypes.h"
 #include "Event.h"
 #include "Agent.h"
@@ -34,14 +37,15 @@ using namespace muse;
 
 MultiThreadedCommunicator::MultiThreadedCommunicator(MultiThreadedSimulationManager* simMgr,
                                                      const int thrPerNode)
-    : simMgr(simMgr), threadsPerNode(thrPerNode), numMpiProcesses(0) {
+    : simMgr(simMgr), threadsPerNode(thrPerNode), numMpiProcesses(0),
+      outbound(NULL) {
     ASSERT( simMgr != NULL );
     ASSERT( threadsPerNode > 0 );
     // Nothing else to be done here for now
 }
 
 MultiThreadedCommunicator::~MultiThreadedCommunicator() {
-    // Nothing else to be done here for now
+    delete outbound;
 }
 
 SimulatorID
@@ -56,85 +60,36 @@ MultiThreadedCommunicator::initialize(int argc, char* argv[],
     return simID;
 }
 
-// Method run only on MPI process with rank zero
-void
-MultiThreadedCommunicator::gatherBroadcastAgentInfo(VecUint& idThrList) {
-    ASSERT(myMPIrank == ROOT_KERNEL);
-    // First we collect id<->thread mapping from all other processes
-    for (size_t proc = 1; (proc < numMpiProcesses); proc++) {
-        MPI_STATUS status;  // information on incoming message
-        // Probe for a message from another MPI process to figure out size.
-        MPI_PROBE(MPI_ANY_SOURCE, AGENT_LIST, status);
-        // Figure out the agent list size
-        size_t listSize = MPI_GET_COUNT(status, MPI_TYPE_UNSIGNED);
-        // Grow idThrList by the list size.
-        const size_t currSize = idThrList.size();
-        idThrList.resize(currSize + listSize);
-        // Read the actual data from the MPI process.
-        MPI_RECV(&idThrList[currSize], listSize, MPI_TYPE_UNSIGNED,
-                 status.MPI_SOURCE, AGENT_LIST, status);
-    }
-    // Now we have the full mapping aggregated in idThrList. It is
-    // time to broadcast it to all the processes.  First send size of
-    // the full list so that other processes can allocate memory
-    // needed to receive the data.
-    unsigned int listSize = idThrList.size();
-    ASSERT( listSize % 2 == 0 );
-    MPI_BCAST(&listSize, 1, MPI_TYPE_UNSIGNED, ROOT_KERNEL);
-    // Next broadcast the actual mapping
-    MPI_BCAST(idThrList.data(), listSize, MPI_TYPE_UNSIGNED, ROOT_KERNEL);
-    std::cout << "Registration of " << (listSize / 2) << " agents complete!\n";
-}
-
-// Method run only on MPI process other than rank zero
-void
-MultiThreadedCommunicator::sendGatherAgentInfo(VecUint& idThrList) {
-    ASSERT(myMPIrank != ROOT_KERNEL);
-    // First send local id<->thread mapping to process with Rank #0
-    MPI_SEND(idThrList.data(), idThrList.size(), MPI_TYPE_UNSIGNED,
-             ROOT_KERNEL, AGENT_LIST);
-    // Next, get broadcasted full size of mapping from rank #0
-    int listSize = 0;
-    MPI_BCAST(&listSize, 1, MPI_TYPE_UNSIGNED, ROOT_KERNEL);
-    ASSERT( listSize % 2 == 0 );  // must be even number
-    // Allocate necessary space to receive the data
-    idThrList.resize(listSize);
-    // Receive the full list from the root kernel
-    MPI_BCAST(idThrList.data(), listSize, MPI_TYPE_UNSIGNED, ROOT_KERNEL);    
-}
-
 void
 MultiThreadedCommunicator::registerAllAgents() {
-    // Build the list of pairs of values in the form <agent_id,
+    // Build the list of local agents managed by each thread so that
+    // they can be compressed into ranges of <agent_id,
     // global_thread_id>.
-    const int mpiRank = myMPIrank;
-    VecUint idList(agentThreadMap.size() * 2);
+    std::vector<std::vector<AgentID>> thrAgents(threadsPerNode);
+    agentDir.forEach([&thrAgents](const AgentDirectory::Entry& entry) {
+            if (entry.thread != -1) {
+                thrAgents[entry.thread].push_back(entry.id);
+            }
+        });
     // The global thread ID of thread #0 on this process
-    const int glblThrStartIdx = threadsPerNode * mpiRank;
-    size_t idx = 0;  // index in idList
-    for (AgentIDSimulatorIDMap::value_type& entry : agentThreadMap) {
-        idList[idx++] = entry.first;   // agent ID
-        idList[idx++] = (glblThrStartIdx + entry.second);  // thread ID
+    const int glblThrStartIdx = threadsPerNode * myMPIrank;
+    std::vector<AgentID> localRanges;
+    for (int thr = 0; (thr < threadsPerNode); thr++) {
+        AgentRangeMap::encode(thrAgents[thr], glblThrStartIdx + thr,
+                              localRanges);
     }
-    // We need to merge agent<->thread mapping from all MPI proceses
-    if (numMpiProcesses > 1) {
-        // We need to merge mappings. Rank #0 first receives mappings
-        // from all processes, merges them, and then broadcasts the
-        // merged/full list to all the processes.
-        if (mpiRank == ROOT_KERNEL) {
-            // Do operations for Rank #0 -- modifies idList
-            gatherBroadcastAgentInfo(idList);
-        } else {
-            // Do operations for all other ranks
-            sendGatherAgentInfo(idList);
+    // Have the transport exchange ranges from all processes. Now
+    // ownerMap in base class has the full agent<->threadID mapping.
+    ownerMap.clear();
+    transport->allGatherAgentRanges(localRanges, ownerMap);
+    // Record the global thread ID of local agents in the directory.
+    // Owners of remote agents are looked up in ownerMap.
+    for (int thr = 0; (thr < threadsPerNode); thr++) {
+        for (const AgentID id : thrAgents[thr]) {
+            agentDir.find(id)->owner = glblThrStartIdx + thr;
         }
     }
-    // Now idList has the full list of agent<->threadID
-    // mapping. Update agentMap in base class with the information.
-    ASSERT(idList.size() % 2 == 0);
-    for (size_t i = 0; (i < idList.size()); i += 2) {
-        agentMap[idList[i]] = idList[i + 1];
-    }
+    transport->agentsRegistered();
 }
 
 void
@@ -159,12 +114,22 @@ MultiThreadedCommunicator::sendEvent(Event* e, const int eventSize){
     ASSERT( e != NULL );
     // First check to see if the reciever is on this process. If so,
     // directly insert the event into its incoming queue.    
+    // Note: events forwarded to an agent that was stolen by another
+    // thread may be delivered to the sender's thread.
     const int thrID = getThreadID(e->getReceiverAgentID());
-    ASSERT( thrID != getThreadID(e->getSenderAgentID()) );
     if (thrID != -1) {
         // This is a local event. Insert it into the receiver agent's
         // incoming queue in a MT-safe manner.
         simMgr->addIncomingEvent(thrID, e);
+    } else if (outbound != NULL) {
+        // The MPI progress thread sends remote events.  The progress
+        // thread cannot use reference counters on the event (as they
+        // are not MT-safe).  So a copy of the event is queued.
+        char* const mem = Event::allocate(eventSize, -1);
+        std::memcpy(mem, e, eventSize);
+        outbound->add(EventRecycler::threadID, -1,
+                      reinterpret_cast<Event*>(mem));
+        simMgr->wakeupProgressThread();
     } else {
         // This is a remote event. Let the base class dispatch it over
         // MPI in a MT-safe operations
@@ -192,6 +157,13 @@ MultiThreadedCommunicator::sendMessage(const GVTMessage *msg,
         GVTMessage* copy = GVTMessage::create(msg, -destRank,
                                               destRank % threadsPerNode);
         simMgr->addIncomingEvent(destRank % threadsPerNode, copy);
+    } else if (outbound != NULL) {
+        // The caller destroys (or reuses) the message right after
+        // this call.  So queue a copy for the MPI progress thread.
+        GVTMessage* copy = GVTMessage::create(msg, -destRank,
+                                              destRank % threadsPerNode);
+        outbound->add(EventRecycler::threadID, -1, copy);
+        simMgr->wakeupProgressThread();
     } else {
         // Msg needs to be sent to a remote thread.
         // Let the base class dispatch it over MPI in a MT-safe
@@ -302,4 +274,46 @@ MultiThreadedCommunicator::receiveManyEvents(EventContainer& eventList,
     return eventCount;
 }
 
+void
+MultiThreadedCommunicator::enableOutboundQueue() {
+    ASSERT(outbound == NULL);
+    outbound = new SpscRingMTQueue(threadsPerNode);
+}
+
+void
+MultiThreadedCommunicator::disableOutboundQueue() {
+    ASSERT(outbound != NULL);
+    ASSERT(outEvents.empty());
+    delete outbound;
+    outbound = NULL;
+}
+
+int
+MultiThreadedCommunicator::sendOutbound() {
+    ASSERT(outbound != NULL);
+    outbound->removeAll(outEvents, -1);
+    if (outEvents.empty()) {
+        return 0;  // Nothing to be sent.
+    }
+    // Only the progress thread uses MPI now. However, string
+    // messages could still be sent by other threads.
+    std::lock_guard<std::mutex> lock(mpiMutex);
+    for (Event* event : outEvents) {
+        if (event->getSenderAgentID() == -1) {
+            // This is a copy of a GVT message. Its receiver is the
+            // negative of the global thread ID of the destination.
+            GVTMessage* const msg = static_cast<GVTMessage*>(event);
+            const int destRank    = -msg->getReceiverAgentID();
+            Communicator::sendMessage(msg, destRank / threadsPerNode);
+            GVTMessage::destroy(msg);
+        } else {
+            Communicator::sendEvent(event, EventAdapter::getEventSize(event));
+            Event::deallocate(event);
+        }
+    }
+    const int count = outEvents.size();
+    outEvents.clear();
+    return count;
+}
+
 #endif
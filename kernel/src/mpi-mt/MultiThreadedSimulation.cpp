@@ -23,21 +23,24 @@
 //---------------------------------------------------------------------------
 
 #include <string>
+#include <thread>
 #include "NumaMemoryManager.h"
 #include "mpi-mt/MultiThreadedSimulationManager.h"
 #include "mpi-mt/MultiThreadedCommunicator.h"
 #include "mpi-mt/SingleBlockingMTQueue.h"
 #include "mpi-mt/MultiBlockingMTQueue.h"
 #include "mpi-mt/MultiNonBlockingMTQueue.h"
+#include "mpi-mt/SpscRingMTQueue.h"
 #include "SpinLock.h"
 #include "GVTManager.h"
+#include "SimpleGVTManager.h"
 #include "GVTMessage.h"
 #include "Scheduler.h"
 #include "ArgParser.h"
+#include "IdleParker.h"
 #include "EventAdapter.h"
 #include "EventRecycler.h"
 #include "StateRecycler.h"
-#include "mpi-mt/RedistributionMessage.h"
 
 // Switch to muse namespace to streamline code
 using namespace muse;
@@ -51,6 +54,16 @@ SpinLockThreadBarrier MultiThreadedSimulation::threadBarrier;
 // the derived class, in MultiThreadedSimulationManager::createThreads
 std::vector<int> MultiThreadedSimulation::numaIDofThread;
 
+// The shared variables used to coordinate stealing of agents between
+// threads on this process.
+std::atomic<int> MultiThreadedSimulation::stealRequest(-1);
+std::atomic<int> MultiThreadedSimulation::doneThreads(0);
+std::atomic<int> MultiThreadedSimulation::drainActivity(0);
+bool MultiThreadedSimulation::stealingSupported = true;
+
+// The optimistic strategy is used unless cmb-mt simulator is used.
+bool MultiThreadedSimulation::conservative = false;
+
 MultiThreadedSimulation::MultiThreadedSimulation(MultiThreadedSimulationManager* mgr,
                                                  int thrID, int globalThrID,
                                                  int threadsPerNode,
@@ -59,30 +72,31 @@ MultiThreadedSimulation::MultiThreadedSimulation(MultiThreadedSimulationManager*
     Simulation(usingSharedEvents), threadsPerNode(threadsPerNode),
     threadID(thrID), globalThreadID(globalThrID), mtCommMgr(NULL),
     simMgr(mgr), mainPendingDeallocs(EventRecycler::pendingDeallocs),
-    cpuID(cpuID)
+    cpuID(cpuID), mainSlabs(EventRecycler::slabs)
 #if USE_NUMA == 1
-    , mainNumaManager(EventRecycler::numaMemMgr),
-    mainStateRecycler(StateRecycler::numaMemMgr)
+    , mainStateRecycler(StateRecycler::numaMemMgr)
 #endif
 {
     ASSERT(mgr != NULL);
     ASSERT(threadsPerNode > 0);
     ASSERT(thrID >= 0);
-    // Initialize counters used to dynamically adapt number of calls
-    // to processPendingDeallocs() method from garbageCollect() method
-    // in this class to keep simulations fast.
-    deallocThresh  = 0.1;
-    deallocRate    = 1;
-    deallocTicker  = deallocRate;
     // Counter to track number of times the incomingEvents queue's
     // removeAll method was called in the processIncomingEvents()
     // method.
     shrQcheckCount = 0;
     
-    // Default flag for redistributing unused NUMA-chunks
-    doRedist       = true;
     // The rate at which incoming messages are to be checked
     msgCheckRate   = 1;
+    // Work-stealing is disabled by default
+    doWorkStealing  = false;
+    stealIdleThresh = 100;
+    idleCount       = 0;
+    stealPending    = false;
+    doneSimulating  = false;
+    stealCount      = agentsStolen = agentsLost = eventsStolen = 0;
+    // Lookahead and windows used only by the conservative strategy
+    lookAhead       = 1;
+    numWindows      = 0;
     // Nothing much to be done for now as base class does all the
     // necessary work.
 }
@@ -114,6 +128,21 @@ MultiThreadedSimulation:: initialize(int& argc, char* argv[], bool initMPI) {
 
 void
 MultiThreadedSimulation::finalize(bool stopMPI, bool delCommMgr) {
+    // Release events still in our incoming queue when simulation
+    // ended.  This is done first so that the base class (on thread
+    // #0) can reclaim events shared with other threads.
+    if (incomingEvents != NULL) {
+        incomingEvents->removeAll(shrEvents, threadID);
+        for (Event* event : shrEvents) {
+            if (event->getSenderAgentID() == -1) {
+                // This is a copy of a GVT message.
+                GVTMessage::destroy(static_cast<GVTMessage*>(event));
+            } else {
+                EventRecycler::decreaseInputRefCount(doShareEvents, event);
+            }
+        }
+        shrEvents.clear();
+    }
     // The base class does all the necessary work
     Simulation::finalize(stopMPI, delCommMgr);
     // Delete our incoming queue as we no longer need it.
@@ -123,8 +152,10 @@ MultiThreadedSimulation::finalize(bool stopMPI, bool delCommMgr) {
     }
 }
 
-void
+int
 MultiThreadedSimulation::processIncomingEvents() {
+    // Number of regular events scheduled (or forwarded) by this method
+    int eventCount = 0;
     // Get all incoming events in an MT-safe manner.
     incomingEvents->removeAll(shrEvents, threadID);
     // Update queue statistics for reporting at the end
@@ -142,38 +173,37 @@ MultiThreadedSimulation::processIncomingEvents() {
             GVTMessage *msg = static_cast<GVTMessage*>(event);
             ASSERT(msg != NULL);
             gvtManager->recvGVTMessage(msg);
-        } else if (event->getSenderAgentID() == REDISTR_MSG_SENDER) {
-#if USE_NUMA == 1
-            // This is a redistribution message to redistribute NUMA
-            // operations.
-            ASSERT(dynamic_cast<RedistributionMessage*>(event) != NULL);
-            RedistributionMessage *rdm =
-                static_cast<RedistributionMessage*>(event);
-            // Add entries to our thread-local recycler.
-            EventRecycler::numaMemMgr.redistribute(rdm);
-            // Get rid of this message
-            RedistributionMessage::destroy(rdm);
-#endif            
         } else {
             // This is a regular event.  All incoming events must be
             // inspected by the GVT manager (for tracking GVT) prior
             // to further processing.
             gvtManager->inspectRemoteEvent(event);
-            scheduleEvent(event);
-            if (!doShareEvents) {
-                // Decrease the reference because if it was rejected,
-                // the event will be properly deleted. However, if it
-                // is in the eventPQ, it will be unharmed (reference
-                // count will actually be fixed to correct for lack of
-                // entry of this event in a output queue on this
-                // process)
-                ASSERT(EventRecycler::getReferenceCount(event) < 3);
-                EventRecycler::decreaseOutputRefCount(doShareEvents, event);
+            eventCount++;
+            if (doWorkStealing && (mtCommMgr->getOwnerThreadRank(event->
+                                   getReceiverAgentID()) != globalThreadID)) {
+                // The receiver has been stolen by another thread.
+                // Forward the event as-is (along with its references)
+                // to the receiver's current thread.
+                gvtManager->sendRemoteEvent(event);
             } else {
-                // Decrease reference count to counter the temporary
-                // increase (see: MultiThreadedSimulation::
-                // scheduleEvent(Event* e)
-                EventRecycler::decreaseInputRefCount(doShareEvents, event);
+                scheduleEvent(event);
+                if (!doShareEvents) {
+                    // Decrease the reference because if it was
+                    // rejected, the event will be properly
+                    // deleted. However, if it is in the eventPQ, it
+                    // will be unharmed (reference count will actually
+                    // be fixed to correct for lack of entry of this
+                    // event in a output queue on this process)
+                    ASSERT(EventRecycler::getReferenceCount(event) < 3);
+                    EventRecycler::decreaseOutputRefCount(doShareEvents,
+                                                          event);
+                } else {
+                    // Decrease reference count to counter the
+                    // temporary increase (see: MultiThreadedSimulation::
+                    // scheduleEvent(Event* e)
+                    EventRecycler::decreaseInputRefCount(doShareEvents,
+                                                         event);
+                }
             }
         }
         // Note: Don't skip this step -- Let the GVT Manager
@@ -189,6 +219,7 @@ MultiThreadedSimulation::processIncomingEvents() {
         // preparation for next round of calls ot this emthod.
         shrEvents.clear();
     }
+    return eventCount;
 }
 
 void
@@ -278,6 +309,11 @@ MultiThreadedSimulation::simulate() {
     // Start the core simulation loop.
     LGVT         = startTime;
     int gvtTimer = gvtDelayRate;
+    // The conservative loop returns only after GVT has reached the
+    // end time. So the optimistic loop below does not run.
+    if (conservative) {
+        simulateWindows();
+    }
     // Counter to track if incoming events are to be processed
     int msgCheckCount = msgCheckRate;
     // The main simulation loop
@@ -287,6 +323,13 @@ MultiThreadedSimulation::simulate() {
             dumpStats();
             doDumpStats = false;
         }
+        // Reclaim shared events retired two epochs ago (if any)
+        if (doShareEvents) {
+            const double fracReclaimed = EventRecycler::announceEpoch();
+            if (fracReclaimed >= 0) {
+                deallocsPerCall += fracReclaimed;
+            }
+        }
         if (--gvtTimer == 0) {
             gvtTimer = gvtDelayRate;
             // Initate another round of GVT calculations if needed.
@@ -306,7 +349,41 @@ MultiThreadedSimulation::simulate() {
         if (!processNextEvent()) {
             // We did not have any events to process. So check MPI
             // more frequently.
-            mpiMsgCheckCounter = 1;            
+            mpiMsgCheckCounter = 1;
+            idleCount++;
+            // If all our events have drained, start a GVT round right
+            // away so that termination is detected promptly.
+            if (LGVT == TIME_INFINITY) {
+                gvtManager->startGVTestimation();
+            }
+            // Park this thread if it has been idle for a while.
+            if ((idleParker != NULL) && idleParker->idle()) {
+                parkIdleThread();
+            }
+        } else if (idleParker != NULL) {
+            idleParker->busy();
+        }
+        // Participate in (or request) stealing of agents between threads
+        if (doWorkStealing) {
+            if (stealRequest != -1) {
+                serviceStealRequest();
+            } else if (stealPending) {
+                requestSteal();
+            }
+        }
+    }
+    if (doWorkStealing) {
+        // Other threads may still request to steal agents (and they
+        // need all threads to participate).  So continue to service
+        // steal requests until all threads are done simulating.
+        doneSimulating = true;
+        doneThreads++;
+        while (doneThreads < (int) threadsPerNode) {
+            if (stealRequest != -1) {
+                serviceStealRequest();
+            } else {
+                std::this_thread::yield();
+            }
         }
     }
     // Wait for all the threads to finish by waiting on a barrier.
@@ -318,21 +395,16 @@ MultiThreadedSimulation::simulate() {
     numaStats += EventRecycler::getStats();
 #endif
     EventRecycler::deleteRecycledEvents();
-    ASSERT(EventRecycler::Recycler.empty());
     threadBarrier.wait();  // Important: wait for threads to finish
 
-#if USE_NUMA == 1    
-    // Also, save NUMA statistics to report later on before cleaning up.
-    numaStats += EventRecycler::numaMemMgr.getStats();
-#endif
-    
     // Add any pending events to the main thread's pending event list
     if (threadID != 0) {
         // This is not the main thread.
         EventRecycler::movePendingDeallocsTo(mainPendingDeallocs);
+        // Add slabs with events that are still in use to the main
+        // thread, as this thread's allocator is about to be destroyed
+        EventRecycler::slabs.moveSlabsTo(mainSlabs);
 #if USE_NUMA == 1
-        // Add NUMA pages to the main thread's pending event list
-        EventRecycler::numaMemMgr.moveNumaBlocksTo(mainNumaManager);
         // Add NUMA pages for state to the main thread
         StateRecycler::moveNumaBlocksTo(mainStateRecycler);
 #endif
@@ -344,6 +416,42 @@ MultiThreadedSimulation::simulate() {
     threadBarrier.wait();
 }
 
+void
+MultiThreadedSimulation::simulateWindows() {
+    MultiThreadedSimulationManager* const mgr =
+        static_cast<MultiThreadedSimulationManager*>(simMgr);
+    while (true) {
+        // Wait for all threads to finish the previous window so that
+        // events exchanged between threads are in our incoming queue.
+        threadBarrier.wait();
+        processIncomingEvents();
+        LGVT = scheduler->getNextEventTime();
+        threadBarrier.wait();
+        // Thread #0 computes GVT for all the threads and receives the
+        // events sent to this process over MPI.
+        if (threadID == 0) {
+            mgr->updateWindow();
+        }
+        threadBarrier.wait();
+        if (getGVT() >= endTime) {
+            break;
+        }
+        if ((threadID == 0) && doDumpStats) {
+            dumpStats();
+            doDumpStats = false;
+        }
+        // Schedule events received over MPI and then process all the
+        // events in the window [GVT, GVT + lookAhead)
+        processIncomingEvents();
+        const Time windowEnd = getGVT() + lookAhead;
+        while (scheduler->getNextEventTime() < windowEnd) {
+            processNextEvent();
+            checkProcessMpiMsgs();
+        }
+        numWindows++;
+    }
+}
+
 muse::Event*
 MultiThreadedSimulation::cloneEvent(const muse::Event* src,
                                     const muse::AgentID receiver) const {
@@ -431,41 +539,19 @@ void
 MultiThreadedSimulation::garbageCollect() {
     // First let base class do its standard garbage collection
     Simulation::garbageCollect();
-#if USE_NUMA == 1
-    // With NUMA we periodically need to redistribute events to avoid
-    // unconstrained memory growth (depending on communication patterns)
-    if ((EventRecycler::numaSetting != EventRecycler::NUMA_NONE) &&
-        doRedist && (getGVT() != TIME_INFINITY)) {
-        MultiThreadedSimulationManager* const mgr =
-            static_cast<MultiThreadedSimulationManager*>(simMgr);
-        EventRecycler::numaMemMgr.redistribute(threadsPerNode, threadID,
-                                               numaIDofThread[threadID], mgr);
+    // Decide if this thread has been idle frequently enough since the
+    // last garbage collection to request stealing agents.
+    if (doWorkStealing) {
+        stealPending = (idleCount >= stealIdleThresh);
+        idleCount    = 0;
     }
-#endif
     // Rest of the logic is needed only when using shared events
     if (!doShareEvents) {
         return;  // Not using shared events. Nothing further to do.
     }
-    // Now reclaim/recycle any pending events in an adaptive manner so
-    // that we make the most effective use of calls to this method.
-    if (--deallocTicker <= 0) {
-        // Time to call processPendingDeallocs()
-        const double fracReclaimed = EventRecycler::processPendingDeallocs();
-        deallocsPerCall    += fracReclaimed;  // Track to report stats at end
-        if (fracReclaimed < deallocThresh) {
-            // Call processPendingDeallocs() less frequently
-            deallocRate *= 2;
-            DEBUG(std::cout << "DeallocsRate increased to: " << deallocRate
-                            << " using " << fracReclaimed    << std::endl);
-        } else if (fracReclaimed > (deallocThresh * 1.5)) {
-            // Call processPendingDeallocs() more frequently            
-            deallocRate = std::max(1, deallocRate / 2);
-            DEBUG(std::cout << "DeallocsRate decreased to: " << deallocRate
-                            << " using " << fracReclaimed    << std::endl);
-        }
-        // Reset the deallocTicker
-        deallocTicker = deallocRate;
-    }
+    // Let the reclamation epoch advance once all threads have
+    // reached it, so that retired events can be reclaimed.
+    EventRecycler::tryAdvanceEpoch();
 }
 
 void
@@ -473,16 +559,22 @@ MultiThreadedSimulation::parseCommandLineArgs(int &argc, char* argv[]) {
     // Make the arg_record
     std::string mtQueue = "single-blocking";
     int subQueues       = 2;  // #sub-queues in multi-blocking queue
-    bool disableRedist  = false;
+    int ringSize        = 1024;  // #entries in each spsc-ring
     ArgParser::ArgRecord arg_list[] = {
         {"--mt-queue", "MT-safe queue to use for events from other threads",
           &mtQueue, ArgParser::STRING },
         {"--multi-mt-queues", "#sub-queues in multi-blocking queue",
          &subQueues, ArgParser::INTEGER},
-        {"--no-redist", "Disable NUMA-chunk redistribution",
-         &disableRedist, ArgParser::BOOLEAN},
+        {"--mt-ring-size", "#entries in each ring of spsc-ring queue",
+         &ringSize, ArgParser::INTEGER},
         {"--msg-check-rate", "Rate for processing events from shared queues",
          &msgCheckRate, ArgParser::INTEGER},
+        {"--work-stealing", "Enable idle threads to steal agents from others",
+         &doWorkStealing, ArgParser::BOOLEAN},
+        {"--steal-idle-thresh", "#idle iterations between GC to steal agents",
+         &stealIdleThresh, ArgParser::INTEGER},
+        {"--cmbLookahead", "The constant lookahead value for cmb-mt",
+         &lookAhead, ArgParser::DOUBLE},
         {"", "", NULL, ArgParser::INVALID}
     };
     // Use the MUSE argument parser to parse command-line arguments
@@ -500,20 +592,102 @@ MultiThreadedSimulation::parseCommandLineArgs(int &argc, char* argv[]) {
         incomingEvents = new MultiBlockingMTQueue<muse::SpinLock>(subQueues);
     } else if (mtQueue == "multi-non-blocking") {
         incomingEvents = new MultiNonBlockingMTQueue(subQueues);
+    } else if (mtQueue == "spsc-ring") {
+        if (ringSize < 1) {
+            std::cerr << "Invalid --mt-ring-size (must be positive).\n";
+            abort();
+        }
+        incomingEvents = new SpscRingMTQueue(threadsPerNode, ringSize);
     } else {
         // Invalid mt-queue name.
         throw std::runtime_error("Invalid value for --mt-queue argument" \
                                  "(muse be: single-blocking");        
     }
-    // Disable NUMA-chunk redistribution based on command-line argument
-    doRedist = !disableRedist;
+    // The conservative strategy never rolls back.  So events are
+    // released right after they are processed and agents never move.
+    if (conservative) {
+        if (lookAhead <= 0) {
+            throw std::runtime_error("The --cmbLookahead value must be " \
+                                     "positive");
+        }
+        if (doShareEvents || doWorkStealing) {
+            throw std::runtime_error("The --use-shared-events and " \
+                                     "--work-stealing arguments cannot be " \
+                                     "used with cmb-mt");
+        }
+    }
+    // Work-stealing moves agents between threads. Hence events must
+    // use the per-thread reference counters used with shared events.
+    if (doWorkStealing && !doShareEvents) {
+        std::cerr << "--work-stealing requires --use-shared-events\n";
+        abort();
+    }
+    // Stealing is meaningless with just one thread.
+    doWorkStealing = doWorkStealing && (threadsPerNode > 1);
     DEBUG(std::cout << "mtQueue set to: " << mtQueue << std::endl);
     // Let base class process consume other arguments as appropriate
     Simulation::parseCommandLineArgs(argc, argv);
 }
 
+void
+MultiThreadedSimulation::requestSteal() {
+    stealPending = false;
+    // Post a request only if no other thread has posted one and no
+    // thread has finished simulating.
+    int noRequest = -1;
+    if (stealingSupported && (doneThreads == 0) &&
+        stealRequest.compare_exchange_strong(noRequest, threadID)) {
+        // All threads must participate. So wake-up parked threads.
+        static_cast<MultiThreadedSimulationManager*>(simMgr)->
+            wakeupThreads();
+        serviceStealRequest();
+    }
+}
+
+void
+MultiThreadedSimulation::serviceStealRequest() {
+    // Drain all pending incoming events (including any anti-messages
+    // generated by rollbacks due to them) until no events are in
+    // transit between threads. Otherwise, after agents move, an
+    // anti-message sent directly to a moved agent could overtake its
+    // corresponding positive event still pending in another queue.
+    int activity = 0;
+    do {
+        // Wait for all threads to stop processing (and sending) events
+        threadBarrier.wait();
+        if (processIncomingEvents() > 0) {
+            drainActivity++;
+        }
+        threadBarrier.wait();
+        activity = drainActivity;
+        threadBarrier.wait();
+        if (stealRequest == threadID) {
+            drainActivity = 0;  // Reset for next round of draining
+        }
+    } while (activity > 0);
+    if (stealRequest == threadID) {
+        // This thread requested stealing. Have the manager move agents
+        // to this thread while all other threads are quiescent.
+        MultiThreadedSimulationManager* const mgr =
+            static_cast<MultiThreadedSimulationManager*>(simMgr);
+        mgr->stealAgents(this);
+        stealRequest = -1;
+    }
+    // Wait for the thief to finish moving agents.
+    threadBarrier.wait();
+}
+
 void
 MultiThreadedSimulation::preStartInit() {
+    if (conservative) {
+        // GVT is computed once per window (see simulateWindows) by
+        // the manager using the information in SimpleGVTManager.
+        gvtManager = new SimpleGVTManager(this);
+        gvtManager->initialize(startTime, commManager);
+        commManager->setGVTManager(gvtManager);
+        scheduler->start(startTime);
+        return;
+    }
     // First let the base class do the necessary setup
     Simulation::preStartInit();
     // Now override the GVT manager's rank with thread-based rank
@@ -521,6 +695,20 @@ MultiThreadedSimulation::preStartInit() {
     gvtManager->setThreadedRank(globalThreadID);
 }
 
+bool
+MultiThreadedSimulation::parkIdleThread() {
+    ASSERT(idleParker != NULL);
+    // Keep GVT advancing while idle; GVT may be all we are waiting on.
+    gvtManager->startGVTestimation();
+    const Time gvt = getGVT();
+    // Recheck for events (and GVT messages) that may have been added
+    // to our incoming queue before we were announced as parked.
+    return idleParker->park([this, gvt] {
+            const long msgs = shrQevtCount.getCount();
+            return (processIncomingEvents() > 0) || (getGVT() != gvt) ||
+                (shrQevtCount.getCount() != msgs) || (stealRequest != -1); });
+}
+
 int
 MultiThreadedSimulation::processMpiMsgs() {
     ASSERT(simMgr != NULL);
@@ -534,12 +722,21 @@ MultiThreadedSimulation::processMpiMsgs() {
 
 void
 MultiThreadedSimulation::reportLocalStatistics(std::ostream& os) {
-    os << "#Deallocs cleared/call : "   << deallocsPerCall
+    os << "#Reclaimed/epoch       : "   << deallocsPerCall
        << "\nAvg sharedQ size       : " << shrQevtCount
        << "\n#processing of sharedQ : " << shrQcheckCount
        << "\nCPU & Numa node used   : " << cpuID
        << " [numa: "                    << getNumaNodeOfCpu(cpuID) << "]"
        << std::endl;
+    if (conservative) {
+        os << "Synchronization windows: " << numWindows << std::endl;
+    }
+    if (doWorkStealing) {
+        os << "#Steals by thread      : "   << stealCount
+           << "\n#Agents stolen/lost    : " << agentsStolen << " / "
+           << agentsLost
+           << "\n#Events stolen         : " << eventsStolen << std::endl;
+    }
     // Get stats for the thread-local default & NUMA memory manager.
 #if USE_NUMA == 1
     os << numaStats;
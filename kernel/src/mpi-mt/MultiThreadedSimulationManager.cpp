@@ -29,19 +29,27 @@
 
 #include <thread>
 #include <algorithm>
+#include <stdexcept>
 #include <functional>
 #include "mpi-mt/MultiThreadedSimulationManager.h"
 #include "mpi-mt/MultiThreadedCommunicator.h"
+#include "GVTManagerBase.h"
 #include "GVTMessage.h"
+#include "SimpleGVTManager.h"
 #include "ArgParser.h"
 #include "EventQueue.h"
+#include "Scheduler.h"
 #include "StateRecycler.h"
+#include "mpi-mt/CpuTopology.h"
 
 // Switch to muse namespace to streamline code
 using namespace muse;
 
 MultiThreadedSimulationManager::MultiThreadedSimulationManager()
-    : MultiThreadedSimulation(this) {
+    : MultiThreadedSimulation(this), mpiEventsRecvd(0),
+      useProgressThread(false), progressCpu(-1), stopProgress(false),
+      progressParkUsec(50), progressParker(NULL), yieldToProgress(false),
+      threadPlacement("linear") {
     // Nothing much to be done for now as base class does all the
     // necessary work.
 }
@@ -62,12 +70,18 @@ MultiThreadedSimulationManager::initialize(int& argc, char* argv[],
           &threadsPerNode, ArgParser::INTEGER},
         { "--use-shared-events", "Share events between threads on node",
           &doShareEvents, ArgParser::BOOLEAN},
-        { "--dealloc-thresh", "Desired % (0.01 to 1.0) of reclaiming shared-events",
-          &deallocThresh, ArgParser::DOUBLE},
 #ifdef USE_NUMA        
         {"--no-numa", "Disable use of NUMA-aware memory management",
          &noNuma, ArgParser::BOOLEAN},
 #endif        
+        {"--mpi-progress-thread", "Use a dedicated thread for all MPI calls",
+         &useProgressThread, ArgParser::BOOLEAN},
+        {"--mpi-progress-cpu", "CPU for MPI thread (default: SMT sibling)",
+         &progressCpu, ArgParser::INTEGER},
+        {"--mpi-progress-park-usec", "Max usec MPI thread sleeps when idle",
+         &progressParkUsec, ArgParser::INTEGER},
+        {"--thread-placement", "Order of CPUs for threads; one of: linear, "
+         "core, compact, scatter", &threadPlacement, ArgParser::STRING},
         {"", "", NULL, ArgParser::INVALID}
     };
     // Use the MUSE argument parser to parse command-line arguments
@@ -75,10 +89,21 @@ MultiThreadedSimulationManager::initialize(int& argc, char* argv[],
     ArgParser ap(arg_list);
     ap.parseArguments(argc, argv, false);
     ASSERT( threadsPerNode > 0 );
-    if ((deallocThresh  <= 0) || (deallocThresh > 1.0)) {
-        std::cerr << "Invalid value for --dealloc-thresh. Value must be "
-            "> 0 and <= 1\n";
-        abort();
+    // The cmb-mt simulator uses the conservative strategy on threads
+    conservative = (simName == "cmb-mt");
+    if (conservative && useProgressThread) {
+        std::cerr << "Warning: --mpi-progress-thread is not supported by "
+                  << "cmb-mt. Ignoring it.\n";
+        useProgressThread = false;
+    }
+    if (progressParkUsec < 1) {
+        throw std::runtime_error("Invalid value for --mpi-progress-park-usec "
+                                 "(must be positive)");
+    }
+    if (!CpuTopology::isValidPolicy(threadPlacement)) {
+        throw std::runtime_error("Invalid value for --thread-placement " \
+                                 "(must be: linear, core, compact, or " \
+                                 "scatter)");
     }
     // Setup the global/static flag in EventQueue if we would like to
     // directly share events between threads.
@@ -121,16 +146,26 @@ MultiThreadedSimulationManager::initialize(int& argc, char* argv[],
     threadBarrier.setThreadCount(threadsPerNode);
     // Create the necessary number of threads.
     createThreads(threadsPerNode, mtc, cmdArgs);
+    // The MPI progress thread uses the recycler slot after the last
+    // worker thread (see progressLoop).  So add its NUMA node.
+    if (useProgressThread) {
+        const int cpu = getProgressThreadCpu(threadCpus);
+        numaIDofThread.push_back(getNumaNodeOfCpu(cpu != -1 ? cpu : cpuID));
+    }
     // Enable/disable NUMA-aware memory management.
     EventRecycler::setupNUMA(mtc, numaIDofThread, numaMode);
+    // Setup epochs used to reclaim events shared between threads.
+    EventRecycler::setupEpochs(threadsPerNode);
 }
 
 void
 MultiThreadedSimulationManager::createThreads(const int threadCount,
                                               MultiThreadedCommunicator* mtc,
                                               std::vector<char*> cmdArgs) {
-    // Get the list of CPUs to be used.
-    const std::vector<int> cpuList = getAvailableCPUs();
+    // Get the list of CPUs to be used, ordered by placement policy.
+    const CpuTopology topology(getAvailableCPUs());
+    threadCpus = topology.getPlacement(threadPlacement);
+    const std::vector<int>& cpuList = threadCpus;
     ASSERT(!cpuList.empty());
     // If we have more threads than CPU's report a warning
     if ((int) cpuList.size() < threadCount) {
@@ -140,11 +175,13 @@ MultiThreadedSimulationManager::createThreads(const int threadCount,
     }
     // Re-size the numaIDs list to accommodate local thread information
     numaIDofThread.resize(threadCount);
+    threadDomains.resize(threadCount);
     // Add this class as thread zero to the list of threads.
     threads.push_back(this);
     cpuID = cpuList.at(0);
     // Setup NUMA node information for this thread/CPU.
     numaIDofThread[0] = getNumaNodeOfCpu(cpuID);
+    threadDomains[0]  = topology.getDomain(cpuID);
     // Create the other thread classes.
     for (int thrID = 1; (thrID < threadCount); thrID++) {
         const int globalThrID = (myID * threadCount) + thrID;
@@ -154,6 +191,7 @@ MultiThreadedSimulationManager::createThreads(const int threadCount,
                                         threadCount, doShareEvents, cpuNum);
         // Setup NUMA node information for this thread/CPU.
         numaIDofThread[thrID] = getNumaNodeOfCpu(cpuNum);
+        threadDomains[thrID]  = topology.getDomain(cpuNum);
         // Setup the pointer to shared comm-manager to be used
         tsm->setCommManager(mtc);
         // Setup command-line arguments from a copy to preserve original
@@ -165,9 +203,14 @@ MultiThreadedSimulationManager::createThreads(const int threadCount,
         // Add the newly created thread to the list
         threads.push_back(tsm);
     }
+    if (myID == ROOT_KERNEL) {
+        topology.printSummary(std::cout);
+    }
     for (int thr = 0; (thr < threadCount); thr++) {
-        std::cout << "Thread #" << thr << ": CPU=" << cpuList.at(thr)
-                  << ", NUMA node: " << numaIDofThread.at(thr) << std::endl;
+        std::cout << "Thread #" << thr << ": CPU="
+                  << cpuList.at(thr % cpuList.size())
+                  << ", NUMA node: " << numaIDofThread.at(thr)
+                  << ", domain: " << threadDomains.at(thr) << std::endl;
     }
 }
 
@@ -203,6 +246,10 @@ MultiThreadedSimulationManager::registerAgent(Agent* agent,
 
     // Setup the rank of the thread with which the agent should register
     int thrIdx = threadRank;
+    if (thrIdx == -1) {
+        // Use thread assigned by partitionAgents (if any)
+        thrIdx = getAssignedThread(agent->getAgentID());
+    }
     if (thrIdx == -1) {
         // Do round-robin assignment to threads in this case
         thrIdx = nextThreadIdx;
@@ -245,6 +292,28 @@ MultiThreadedSimulationManager::start() {
     preStartInit();
     // Now spwan threadsPerNode - 1 threads (this is thread #0 already)
     ASSERT( threadsPerNode > 0 );
+    // Reset shared flags used to coordinate work-stealing.
+    stealRequest = -1;
+    doneThreads  = 0;
+    // Reset count of MPI events used to compute conservative windows
+    mpiEventsRecvd = 0;
+    // Start the dedicated MPI progress thread (if requested) before
+    // the worker threads start sending events.
+    std::thread progressThread;
+    if (useProgressThread && (numberOfProcesses > 1)) {
+        mtCommMgr->enableOutboundQueue();
+        stopProgress   = false;
+        progressParker = new IdleParker(100, progressParkUsec);
+        // Check if the progress thread shares a CPU with a worker.
+        const int cpu   = getProgressThreadCpu(threadCpus);
+        yieldToProgress = (cpu == -1);
+        for (int thr = 0; (thr < threadsPerNode); thr++) {
+            yieldToProgress |= (threadCpus.at(thr % threadCpus.size()) == cpu);
+        }
+        progressThread =
+            std::thread(&MultiThreadedSimulationManager::progressLoop, this,
+                        cpu);
+    }
     std::vector<std::thread> thrList;
     for (int thrIdx = 1; (thrIdx < threadsPerNode); thrIdx++) {
         // Setup most up to date parameter/options
@@ -259,6 +328,17 @@ MultiThreadedSimulationManager::start() {
     // Now that the simulation is done, wind-up the threads
     std::for_each(thrList.begin(), thrList.end(),
                   std::mem_fn(&std::thread::join));
+    // Stop the MPI progress thread (after it sends out pending events
+    // and GVT messages) so that this thread can use MPI again.
+    if (progressThread.joinable()) {
+        stopProgress = true;
+        progressParker->wakeup();
+        progressThread.join();
+        mtCommMgr->disableOutboundQueue();
+        yieldToProgress = false;
+        delete progressParker;
+        progressParker = NULL;
+    }
     // Wait for all the parallel processes to complete the main
     // simulation loop.
     MPI_BARRIER();    
@@ -278,7 +358,6 @@ MultiThreadedSimulationManager::finalize(bool stopMPI, bool delCommMgr) {
     // the thread #0's pendingDeallocs list by other threads before
     // they join thread #0 in simulate() method in this class.
     ASSERT(EventRecycler::pendingDeallocs.empty());
-    ASSERT(EventRecycler::Recycler.empty());    
     // Finally, get rid of all the thread helper classes as they are no
     // longer needed.  The thread #0 will be deleted in
     // Simulation::finalizeSimulation() method if user requests it.
@@ -288,12 +367,113 @@ MultiThreadedSimulationManager::finalize(bool stopMPI, bool delCommMgr) {
     threads.clear();  // Clear out the vector as a sanity check.
 }
 
+void
+MultiThreadedSimulationManager::stealAgents(MultiThreadedSimulation* thief) {
+    ASSERT(thief != NULL);
+    ASSERT(thief->doWorkStealing);
+    // Compute the backlog of pending events on each thread.
+    std::vector<size_t> backlog(threads.size(), 0);
+    for (size_t thrIdx = 0; (thrIdx < threads.size()); thrIdx++) {
+        const MultiThreadedSimulation* const thr = threads[thrIdx];
+        for (Agent* agent : thr->allAgents) {
+            backlog[thrIdx] += thr->scheduler->getEventCount(agent);
+        }
+    }
+    // Pick the busiest thread that can spare an agent as the victim.
+    int victimIdx = -1;
+    for (size_t thrIdx = 0; (thrIdx < threads.size()); thrIdx++) {
+        const MultiThreadedSimulation* const thr = threads[thrIdx];
+        if ((thr != thief) && !thr->doneSimulating &&
+            (thr->allAgents.size() > 1) &&
+            ((victimIdx == -1) || (backlog[thrIdx] > backlog[victimIdx]))) {
+            victimIdx = thrIdx;
+        }
+    }
+    const size_t thiefLoad = backlog[thief->threadID];
+    if ((victimIdx == -1) || (backlog[victimIdx] <= thiefLoad + 1)) {
+        return;  // No thread is sufficiently busier than the thief.
+    }
+    MultiThreadedSimulation* const victim = threads[victimIdx];
+    // Choose the agents with the most pending events until about half
+    // the difference in backlog has been moved. The victim always
+    // retains at least one agent.
+    std::vector<std::pair<size_t, Agent*>> candidates;
+    for (Agent* agent : victim->allAgents) {
+        candidates.push_back({victim->scheduler->getEventCount(agent),
+                              agent});
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<size_t, Agent*>& a1,
+                 const std::pair<size_t, Agent*>& a2) {
+                  return a1.first > a2.first; });
+    const size_t target = (backlog[victimIdx] - thiefLoad) / 2;
+    size_t moved        = 0;
+    Time minTime        = TIME_INFINITY;
+    EventContainer events;
+    for (const auto& cand : candidates) {
+        if ((victim->allAgents.size() < 2) || (moved >= target)) {
+            break;  // Moved sufficient number of agents.
+        }
+        if ((cand.first == 0) || (moved + cand.first > target)) {
+            continue;  // Agent not suitable to be moved.
+        }
+        Agent* const agent = cand.second;
+        events.clear();
+        if (!victim->scheduler->detachAgent(agent, events)) {
+            std::cerr << "Warning: The scheduler queue does not support "
+                      << "detaching agents. Disabling work-stealing.\n";
+            stealingSupported = false;
+            break;
+        }
+        for (const Event* event : events) {
+            minTime = std::min(minTime, event->getReceiveTime());
+        }
+        moved += events.size();
+        // Move the agent to the thief.
+        thief->scheduler->attachAgent(agent, events);
+        agent->setKernel(thief);
+        mtCommMgr->moveAgent(agent->getAgentID(), thief->threadID);
+        AgentContainer& victimAgents = victim->allAgents;
+        victimAgents.erase(std::find(victimAgents.begin(),
+                                     victimAgents.end(), agent));
+        thief->allAgents.push_back(agent);
+        // Track statistics
+        thief->agentsStolen++;
+        victim->agentsLost++;
+    }
+    if (moved == 0) {
+        return;  // No agents were moved.
+    }
+    // Account for the moved events as a message from the victim to
+    // the thief to ensure GVT estimates remain correct.
+    const int color = victim->gvtManager->sendMigration(thief->globalThreadID,
+                                                        minTime);
+    thief->gvtManager->recvMigration(color);
+    // Refresh LGVT of both threads to reflect the moved events.
+    victim->LGVT = victim->scheduler->getNextEventTime();
+    thief->LGVT  = thief->scheduler->getNextEventTime();
+    thief->stealCount++;
+    thief->eventsStolen += moved;
+}
+
 int
 MultiThreadedSimulationManager::processMpiMsgs() {
     // If we have only one process then there is nothing to be done
     if (numberOfProcesses < 2) {
         return 0;  // no other process to communicate with.
     }
+    if (useProgressThread) {
+        // The MPI progress thread reads messages.  Give it a chance
+        // to run if it shares a CPU with this thread.  The yield is
+        // reported as work so that checkProcessMpiMsgs does not back
+        // off.  Otherwise, busy threads run far ahead of remote
+        // events (as they yield rarely) causing rollback storms.
+        if (yieldToProgress) {
+            std::this_thread::yield();
+            return 1;
+        }
+        return 0;
+    }
     // First try to lock the shared MPI mutex.  If it is not lockable,
     // then some other thread is pumping MPI messages for all
     // threads. So skip rest of the operation.
@@ -312,6 +492,11 @@ MultiThreadedSimulationManager::processMpiMsgs() {
     if (mtCommMgr->receiveManyEvents(mpiEvents, maxMpiMsgThresh) <= 0) {
         return 0;  // No events were obtained from MPI
     }
+    return dispatchMpiEvents();
+}
+
+int
+MultiThreadedSimulationManager::dispatchMpiEvents() {
     // Process the incoming MPI events.
     for (Event* incoming_event : mpiEvents) {
         ASSERT(incoming_event->getReferenceCount() == 1);
@@ -327,10 +512,19 @@ MultiThreadedSimulationManager::processMpiMsgs() {
             ASSERT(glblThrId >= (myID + 0) * threadsPerNode);
             ASSERT(glblThrId <  (myID + 1) * threadsPerNode);
             // Always send incoming GVT messages to thread index #0.
-            addIncomingEvent(glblThrId % threadsPerNode, incoming_event);
+            // Events from MPI are added with source index -1 (see
+            // addIncomingEvent).
+            addIncomingEvent(glblThrId % threadsPerNode, incoming_event,
+                             -1);
         } else {
-            // Get the thread ID for the receiver agent.
-            const int thrIdx = mtCommMgr->getThreadID(receiver);
+            // Get the thread ID for the receiver agent.  With
+            // work-stealing, events are always sent to the agent's
+            // home thread (the thread to which remote processes
+            // attribute the event for GVT) which forwards it, if
+            // the agent has been stolen by another thread.
+            const int thrIdx = (doWorkStealing ?
+                                mtCommMgr->getHomeThreadID(receiver) :
+                                mtCommMgr->getThreadID(receiver));
             ASSERT( thrIdx != -1 );
             // Increment input reference counter for this event to
             // balance decrement in MultiThreadedSimulation::
@@ -341,7 +535,8 @@ MultiThreadedSimulationManager::processMpiMsgs() {
                 EventRecycler::increaseInputRefCount(doShareEvents,
                                                      incoming_event);
             }
-            addIncomingEvent(thrIdx, incoming_event);
+            addIncomingEvent(thrIdx, incoming_event, -1);
+            mpiEventsRecvd++;
         }
     }
     // Save events received over mpi to return
@@ -356,4 +551,109 @@ MultiThreadedSimulationManager::processMpiMsgs() {
     return msgCount;
 }
 
+void
+MultiThreadedSimulationManager::updateWindow() {
+    ASSERT(conservative);
+    const unsigned int numProcs = numberOfProcesses;
+    // See SimpleGVTManager::updateWindow for the layout of values.
+    std::vector<Time> values(numProcs * 2, 0);
+    values[numProcs + myID] = TIME_INFINITY;
+    for (MultiThreadedSimulation* const thr : threads) {
+        static_cast<SimpleGVTManager*>(thr->gvtManager)->
+            addWindowInfo(values);
+    }
+    // Events sent between threads on this process have already been
+    // received by the threads.
+    const long localEvents = static_cast<long>(values[myID]);
+    if (numProcs > 1) {
+        mtCommMgr->allReduceSum(values);
+    }
+    // Receive all the events sent to this process over MPI.
+    const long mpiEvents = static_cast<long>(values[myID]) - localEvents;
+    while (mpiEventsRecvd < mpiEvents) {
+        processMpiMsgs();
+    }
+    for (MultiThreadedSimulation* const thr : threads) {
+        static_cast<SimpleGVTManager*>(thr->gvtManager)->setWindow(values);
+    }
+}
+
+void
+MultiThreadedSimulationManager::wakeupThreads() {
+    for (MultiThreadedSimulation* const thr : threads) {
+        if (thr->idleParker != NULL) {
+            thr->idleParker->wakeup();
+        }
+    }
+}
+
+void
+MultiThreadedSimulationManager::progressLoop(const int cpu) {
+    // This thread uses its own recycler slot, after the worker
+    // threads (see initialize).
+    EventRecycler::threadID = threadsPerNode;
+    if (cpu != -1) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        int err = 0;
+        if ((err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                          &cpuset)) != 0) {
+            std::cerr << "Error pinning MPI progress thread: " << err
+                      << std::endl;
+        }
+    }
+    EventRecycler::startNUMA();
+    while (!stopProgress.load(std::memory_order_acquire)) {
+        int work = mtCommMgr->sendOutbound();
+        processMpiMsgCalls++;
+        if (mtCommMgr->receiveManyEvents(mpiEvents, maxMpiMsgThresh) > 0) {
+            work += dispatchMpiEvents();
+        }
+        // Park this thread (freeing its CPU, which may be shared with
+        // a worker thread) if there has been no work for a while.
+        // Worker threads wake it up when they queue outbound events.
+        if (work > 0) {
+            progressParker->busy();
+        } else if (progressParker->idle()) {
+            progressParker->park([this] {
+                    return stopProgress.load(std::memory_order_acquire) ||
+                        (mtCommMgr->sendOutbound() > 0); });
+        }
+    }
+    // Send out events and GVT messages queued by worker threads just
+    // before they finished.
+    mtCommMgr->sendOutbound();
+    // Clean-up the thread-local recyclers of this thread and hand
+    // slabs with events that are still in use to the main thread.
+    EventRecycler::deleteRecycledEvents();
+    EventRecycler::slabs.moveSlabsTo(mainSlabs);
+}
+
+int
+MultiThreadedSimulationManager::getProgressThreadCpu(const std::vector<int>&
+                                                     cpuList) const {
+    if (progressCpu != -1) {
+        return progressCpu;  // CPU specified by the user.
+    }
+    // The CPUs used by the worker threads.
+    std::vector<int> workerCpus;
+    for (int thr = 0; (thr < threadsPerNode); thr++) {
+        workerCpus.push_back(cpuList.at(thr % cpuList.size()));
+    }
+    // Check for a sibling of a worker CPU that is available and not
+    // used by a worker thread.
+    for (const int cpu : workerCpus) {
+        for (const int sib : CpuTopology::getSiblings(cpu)) {
+            if ((std::find(cpuList.begin(), cpuList.end(), sib) !=
+                 cpuList.end()) &&
+                (std::find(workerCpus.begin(), workerCpus.end(), sib) ==
+                 workerCpus.end())) {
+                return sib;
+            }
+        }
+    }
+    return -1;  // No suitable CPU found.
+}
+
 #endif
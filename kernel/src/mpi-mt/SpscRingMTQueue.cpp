@@ -0,0 +1,203 @@
+#ifndef MUSE_SPSC_RING_MT_QUEUE_CPP
+#define MUSE_SPSC_RING_MT_QUEUE_CPP
+
+//---------------------------------------------------------------------------
+//
+// Copyright (c) Miami University, Oxford, OHIO.
+// All rights reserved.
+//
+// Miami University (MU) makes no representations or warranties about
+// the suitability of the software, either express or implied,
+// including but not limited to the implied warranties of
+// merchantability, fitness for a particular purpose, or
+// non-infringement.  MU shall not be liable for any damages suffered
+// by licensee as a result of using, result of using, modifying or
+// distributing this software or its derivatives.
+//
+// By using or copying this Software, Licensee agrees to abide by the
+// intellectual property laws, and all other applicable laws of the
+// U.S., and the terms of this license.
+//
+// Authors: Dhananjai M. Rao       raodm@miamiOH.edu
+//
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <new>
+#include "Event.h"
+#include "mpi-mt/SpscRingMTQueue.h"
+
+// Switch to muse namespace to streamline code below
+using namespace muse;
+
+SpscRingMTQueue::SpscRingMTQueue(int numThreads, int ringSize) :
+    numRings(numThreads) {
+    ASSERT(numThreads > 0);
+    ASSERT(ringSize > 0);
+    // Round up the ring size to a power of 2 so that bit-wise
+    // operations can be used instead of modulo.
+    capacity = 1;
+    while (capacity < (size_t) ringSize) {
+        capacity <<= 1;
+    }
+    mask  = capacity - 1;
+    // Allocate cache-line aligned memory for the rings -- one for
+    // each thread, one for events received over MPI, and one for the
+    // shared list -- and construct them in place.
+    slots = new muse::Event*[(numRings + 1) * capacity];
+    void* memory = NULL;
+    if (posix_memalign(&memory, 64, sizeof(Ring) * (numRings + 2)) != 0) {
+        std::cerr << "Error allocating memory for SPSC rings.\n";
+        abort();
+    }
+    rings = static_cast<Ring*>(memory);
+    for (int i = 0; (i < numRings + 2); i++) {
+        new (rings + i) Ring();
+    }
+    for (int i = 0; (i <= numRings); i++) {
+        rings[i].slots = slots + (i * capacity);
+    }
+}
+
+SpscRingMTQueue::~SpscRingMTQueue() {
+    // Events still in the rings (if any) are owned by the user of this
+    // queue, which removes them prior to deleting the queue.
+    for (int i = 0; (i < numRings + 2); i++) {
+        rings[i].~Ring();
+    }
+    free(rings);
+    delete [] slots;
+}
+
+size_t
+SpscRingMTQueue::copyToRing(Ring& ring, muse::Event* const* events,
+                            const size_t count, size_t& tail) {
+    size_t copied = 0;
+    while (copied < count) {
+        if (tail - ring.cachedHead >= capacity) {
+            // The ring appears full.  Check if the consumer has made
+            // space since the cached head was last updated.
+            ring.cachedHead = ring.head.load(std::memory_order_acquire);
+            if (tail - ring.cachedHead >= capacity) {
+                break;  // The ring is full.
+            }
+        }
+        ring.slots[tail & mask] = events[copied++];
+        tail++;
+    }
+    return copied;
+}
+
+void
+SpscRingMTQueue::spill(Ring& ring, muse::Event* const* events,
+                       const size_t count) {
+    std::lock_guard<std::mutex> lock(ring.spillMutex);
+    size_t copied = 0;
+    if ((ring.slots != NULL) &&
+        !ring.spilled.load(std::memory_order_relaxed)) {
+        // The consumer drained the spill list after the caller
+        // checked.  So the ring can be used again.
+        size_t tail = ring.tail.load(std::memory_order_relaxed);
+        copied = copyToRing(ring, events, count, tail);
+        ring.tail.store(tail, std::memory_order_release);
+    }
+    if (copied < count) {
+        ring.spill.insert(ring.spill.end(), events + copied, events + count);
+        ring.spilled.store(true, std::memory_order_release);
+    }
+}
+
+void
+SpscRingMTQueue::add(int srcThrIdx, int destThrIdx, muse::Event* event) {
+    UNUSED_PARAM(destThrIdx);
+    ASSERT(event != NULL);
+    Ring& ring = getRing(srcThrIdx);
+    // Only the producer sets the spilled flag.  So if it is clear, the
+    // event can be added to the ring without any locks.
+    if ((ring.slots != NULL) &&
+        !ring.spilled.load(std::memory_order_relaxed)) {
+        size_t tail = ring.tail.load(std::memory_order_relaxed);
+        if (copyToRing(ring, &event, 1, tail) == 1) {
+            ring.tail.store(tail, std::memory_order_release);
+            return;
+        }
+    }
+    spill(ring, &event, 1);
+}
+
+void
+SpscRingMTQueue::add(int srcThrIdx, int destThrIdx,
+                     EventContainer& eventList) {
+    UNUSED_PARAM(destThrIdx);
+    if (eventList.empty()) {
+        return;  // nothing to be done.
+    }
+    Ring& ring    = getRing(srcThrIdx);
+    size_t copied = 0;
+    if ((ring.slots != NULL) &&
+        !ring.spilled.load(std::memory_order_relaxed)) {
+        // Copy as many events as possible and publish them together.
+        size_t tail = ring.tail.load(std::memory_order_relaxed);
+        copied = copyToRing(ring, eventList.data(), eventList.size(), tail);
+        ring.tail.store(tail, std::memory_order_release);
+    }
+    if (copied < eventList.size()) {
+        spill(ring, eventList.data() + copied, eventList.size() - copied);
+    }
+}
+
+size_t
+SpscRingMTQueue::drainRing(Ring& ring, EventContainer& eventList,
+                           const size_t maxEvents) {
+    if (ring.slots == NULL) {
+        return 0;  // The shared list does not have a ring.
+    }
+    const size_t head  = ring.head.load(std::memory_order_relaxed);
+    const size_t tail  = ring.tail.load(std::memory_order_acquire);
+    const size_t count = std::min(tail - head, maxEvents);
+    for (size_t i = 0; (i < count); i++) {
+        eventList.push_back(ring.slots[(head + i) & mask]);
+    }
+    if (count > 0) {
+        ring.head.store(head + count, std::memory_order_release);
+    }
+    return count;
+}
+
+void
+SpscRingMTQueue::removeAll(EventContainer& eventList, int destThrIdx,
+                           int maxEvents) {
+    UNUSED_PARAM(destThrIdx);
+    size_t budget = (maxEvents < 0) ? std::numeric_limits<size_t>::max() :
+        maxEvents;
+    for (int i = 0; (i < numRings + 2) && (budget > 0); i++) {
+        Ring& ring = rings[i];
+        budget    -= drainRing(ring, eventList, budget);
+        if ((budget == 0) || !ring.spilled.load(std::memory_order_acquire)) {
+            continue;  // Fast path: No spilled events to process
+        }
+        // Events in the ring were added before those in the spill
+        // list.  The producer may have published more events to the
+        // ring just before spilling.  So drain the ring again while
+        // holding the lock before moving the spilled events.
+        std::lock_guard<std::mutex> lock(ring.spillMutex);
+        budget -= drainRing(ring, eventList, budget);
+        const size_t count = std::min(budget, ring.spill.size());
+        if (count == 0) {
+            continue;  // Ring still has events.  Spill next time.
+        }
+        eventList.insert(eventList.end(), ring.spill.begin(),
+                         ring.spill.begin() + count);
+        ring.spill.erase(ring.spill.begin(), ring.spill.begin() + count);
+        budget -= count;
+        if (ring.spill.empty()) {
+            // Let the producer resume using the ring.
+            ring.spilled.store(false, std::memory_order_relaxed);
+        }
+    }
+}
+
+#endif